@@ -25,6 +25,8 @@ constexpr char EthosNConfig::PERF_WEIGHT_COMPRESSION_SAVING[];
 constexpr char EthosNConfig::PERF_ACTIVATION_COMPRESSION_SAVING[];
 constexpr char EthosNConfig::PERF_CURRENT[];
 constexpr char EthosNConfig::COMPILER_ALGORITHM[];
+constexpr char EthosNConfig::COMPILED_NETWORK_CACHE_DIR[];
+constexpr char EthosNConfig::COMPILED_NETWORK_CACHE_MAX_SIZE_MB[];
 
 EthosNConfig GetEthosNConfig()
 {
@@ -62,6 +64,10 @@ std::ostream& operator<<(std::ostream& configFile, const armnn::EthosNConfig& co
         configFile << armnn::EthosNConfig::COMPILER_ALGORITHM << " = "
                    << ethosn::support_library::EthosNCompilerAlgorithmAsString(config.m_CompilerAlgorithm) << std::endl;
     }
+    configFile << armnn::EthosNConfig::COMPILED_NETWORK_CACHE_DIR << " = " << config.m_CompiledNetworkCacheDir
+               << std::endl;
+    configFile << armnn::EthosNConfig::COMPILED_NETWORK_CACHE_MAX_SIZE_MB << " = "
+               << config.m_CompiledNetworkCacheMaxSizeMb << std::endl;
     configFile.flush();
 
     return configFile;
@@ -153,6 +159,14 @@ std::istream& operator>>(std::istream& configFile, armnn::EthosNConfig& config)
                         );
                     }
                 }
+                else if (m[1] == armnn::EthosNConfig::COMPILED_NETWORK_CACHE_DIR)
+                {
+                    config.m_CompiledNetworkCacheDir = m[2];
+                }
+                else if (m[1] == armnn::EthosNConfig::COMPILED_NETWORK_CACHE_MAX_SIZE_MB)
+                {
+                    config.m_CompiledNetworkCacheMaxSizeMb = boost::lexical_cast<uint32_t>(m[2]);
+                }
                 else
                 {
                     throw armnn::Exception("Unknown var in config file: line " + std::to_string(lineNo) + ": " + line);
@@ -29,6 +29,8 @@ struct EthosNConfig
     static constexpr char PERF_ACTIVATION_COMPRESSION_SAVING[]  = "PERFORMANCE_ACTIVATION_COMPRESSION_SAVING";    // float
     static constexpr char PERF_CURRENT[]                        = "PERFORMANCE_CURRENT";                          // boolean
     static constexpr char COMPILER_ALGORITHM[]                  = "COMPILER_ALGORITHM";                           // enum
+    static constexpr char COMPILED_NETWORK_CACHE_DIR[]          = "COMPILED_NETWORK_CACHE_DIR";                   // string
+    static constexpr char COMPILED_NETWORK_CACHE_MAX_SIZE_MB[]  = "COMPILED_NETWORK_CACHE_MAX_SIZE_MB";           // uint32
     // clang-format on
 
     bool m_PerfOnly                                      = false;
@@ -43,6 +45,12 @@ struct EthosNConfig
     bool m_PerfCurrent                                   = false;
     ethosn::support_library::CompilerAlgorithm m_CompilerAlgorithm =
         ethosn::support_library::CompilerAlgorithm::NonCascadingOnly;
+    /// If set, compiled networks are saved in this directory and loaded from it rather than compiling the same
+    /// network again, e.g. when the process is restarted. The directory is created if it doesn't exist.
+    std::string m_CompiledNetworkCacheDir = "";
+    /// Once the entries in m_CompiledNetworkCacheDir take up more than this many megabytes, the least recently used
+    /// ones are removed. 0 means there is no limit.
+    uint32_t m_CompiledNetworkCacheMaxSizeMb = 1024;
 };
 
 /// Reads the configuration for the Ethos-N backend from the file pointed by the environment
@@ -22,12 +22,160 @@
 #include <ethosn_driver_library/Network.hpp>
 
 #include <algorithm>
+#include <ctime>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace armnn
 {
 
 using namespace ethosntensorutils;
 
+namespace
+{
+
+/// Returns a string which identifies the build of the support library in use, or an empty string if this can't be
+/// determined. It is based on the size and modification time of the file which the library was loaded from, so it
+/// changes whenever the library is rebuilt, even if its version number doesn't.
+const std::string& GetSupportLibraryBuildId()
+{
+    static const std::string buildId = []() {
+        Dl_info info;
+        struct stat fileStat;
+        if (dladdr(reinterpret_cast<void*>(&ethosn_lib::GetCompilationCacheKey), &info) == 0 ||
+            info.dli_fname == nullptr || stat(info.dli_fname, &fileStat) != 0)
+        {
+            return std::string();
+        }
+        std::stringstream ss;
+        ss << std::hex << fileStat.st_size << "-" << fileStat.st_mtime;
+        return ss.str();
+    }();
+    return buildId;
+}
+
+/// Loads a compiled network saved by SaveCompiledNetworkToCache(). The file is mapped into memory rather than read, so
+/// that the constant data (mostly the weights) isn't copied. Returns null if there is no such file, or it can't be
+/// used (e.g. it was saved by a different version of the support library).
+/// The modification time of the file is updated, so that it counts as recently used (see TrimCache()).
+EthosNCompiledNetworkPtr LoadCompiledNetworkFromCache(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    // This fails if the cache is read-only for this process, in which case the entry is still used.
+    futimens(fd, nullptr);
+    struct stat fileStat;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0)
+    {
+        data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    // The mapping stays valid once the file is closed
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        ARMNN_LOG(warning) << "Unable to read compiled network from " << path;
+        return nullptr;
+    }
+
+    const size_t size = static_cast<size_t>(fileStat.st_size);
+    std::shared_ptr<const void> owner(data, [size](const void* p) { munmap(const_cast<void*>(p), size); });
+    try
+    {
+        return ethosn_lib::DeserializeCompiledNetwork(data, size, owner);
+    }
+    catch (const std::exception& e)
+    {
+        ARMNN_LOG(warning) << "Ignoring compiled network in " << path << ": " << e.what();
+        return nullptr;
+    }
+}
+
+/// Saves a compiled network so it can be loaded by LoadCompiledNetworkFromCache(). It is written to a temporary
+/// file which is then renamed, so that other processes sharing the cache never see a partly written file.
+void SaveCompiledNetworkToCache(const ethosn_lib::CompiledNetwork& compiledNetwork, const std::string& path)
+{
+    const std::string tempPath = path + "." + boost::filesystem::unique_path().string() + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        compiledNetwork.Serialize(file);
+        if (!file.good())
+        {
+            file.close();
+            boost::system::error_code error;
+            boost::filesystem::remove(tempPath, error);
+            ARMNN_LOG(warning) << "Unable to write compiled network to " << tempPath;
+            return;
+        }
+    }
+    boost::system::error_code error;
+    boost::filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        boost::filesystem::remove(tempPath, error);
+        ARMNN_LOG(warning) << "Unable to write compiled network to " << path;
+    }
+}
+
+/// Removes the least recently used entries from the cache directory until the entries take up at most maxSizeBytes,
+/// apart from the given entry which is always kept.
+void TrimCache(const std::string& cacheDir, uint64_t maxSizeBytes, const std::string& keepPath)
+{
+    struct CacheEntry
+    {
+        std::time_t m_LastUsed;
+        uintmax_t m_Size;
+        boost::filesystem::path m_Path;
+    };
+    std::vector<CacheEntry> entries;
+    uintmax_t totalSize = 0;
+
+    boost::system::error_code error;
+    for (boost::filesystem::directory_iterator it(cacheDir, error), end; !error && it != end; it.increment(error))
+    {
+        // Partly written entries (see SaveCompiledNetworkToCache()) are left to the process writing them
+        if (it->path().extension() != ".ethosn")
+        {
+            continue;
+        }
+        boost::system::error_code entryError;
+        const uintmax_t size       = boost::filesystem::file_size(it->path(), entryError);
+        const std::time_t lastUsed = boost::filesystem::last_write_time(it->path(), entryError);
+        if (!entryError)
+        {
+            entries.push_back({ lastUsed, size, it->path() });
+            totalSize += size;
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const CacheEntry& a, const CacheEntry& b) { return a.m_LastUsed < b.m_LastUsed; });
+    for (const CacheEntry& entry : entries)
+    {
+        if (totalSize <= maxSizeBytes)
+        {
+            break;
+        }
+        if (entry.m_Path == keepPath)
+        {
+            continue;
+        }
+        // Another process sharing the cache may have removed it already, in which case it no longer counts either
+        boost::filesystem::remove(entry.m_Path, error);
+        totalSize -= entry.m_Size;
+    }
+}
+
+}    // namespace
+
 uint32_t EthosNSubgraphViewConverter::ms_NextInstanceId = 0;
 
 EthosNSubgraphViewConverter::EthosNSubgraphViewConverter(const SubgraphView& subgraph)
@@ -736,7 +884,9 @@ std::vector<CompiledBlobPtr>
 {
     std::vector<CompiledBlobPtr> compiledBlobs;
 
-    std::vector<EthosNCompiledNetworkPtr> compiledNetworks = ethosn_lib::Compile(*m_Network, ethosnCompilationOpts);
+    std::vector<EthosNCompiledNetworkPtr> compiledNetworks =
+        m_EthosNConfig.m_CompiledNetworkCacheDir.empty() ? ethosn_lib::Compile(*m_Network, ethosnCompilationOpts)
+                                                         : CompileWithCache(ethosnCompilationOpts);
 
     // Create a list of generic type-agnostic compiled "blobs"
     for (EthosNCompiledNetworkPtr& compiledNetwork : compiledNetworks)
@@ -778,4 +928,45 @@ std::vector<CompiledBlobPtr>
     return compiledBlobs;
 }
 
+std::vector<EthosNCompiledNetworkPtr>
+    EthosNSubgraphViewConverter::CompileWithCache(const ethosn_lib::CompilationOptions& ethosnCompilationOpts)
+{
+    // The key covers everything which affects the compiled network, including the capabilities of the firmware and
+    // hardware, so a cache can be shared between different devices and versions of the support library.
+    // The build of the support library is added, as a rebuilt library may compile differently without a new version.
+    const std::string& buildId = GetSupportLibraryBuildId();
+    if (buildId.empty())
+    {
+        ARMNN_LOG(warning) << "Unable to identify the Ethos-N support library. Not using the compiled network cache.";
+        return ethosn_lib::Compile(*m_Network, ethosnCompilationOpts);
+    }
+    const std::string key  = ethosn_lib::GetCompilationCacheKey(*m_Network, ethosnCompilationOpts);
+    const std::string path = m_EthosNConfig.m_CompiledNetworkCacheDir + "/" + key + "-" + buildId + ".ethosn";
+
+    std::vector<EthosNCompiledNetworkPtr> compiledNetworks;
+    EthosNCompiledNetworkPtr cachedNetwork = LoadCompiledNetworkFromCache(path);
+    if (cachedNetwork)
+    {
+        compiledNetworks.push_back(std::move(cachedNetwork));
+        return compiledNetworks;
+    }
+
+    compiledNetworks = ethosn_lib::Compile(*m_Network, ethosnCompilationOpts);
+
+    // Only a network which is compiled into a single compiled network (i.e. the whole network is supported) is
+    // saved, as the cache holds one compiled network for each key.
+    if (compiledNetworks.size() == 1)
+    {
+        boost::system::error_code error;
+        boost::filesystem::create_directories(m_EthosNConfig.m_CompiledNetworkCacheDir, error);
+        SaveCompiledNetworkToCache(*compiledNetworks[0], path);
+        if (m_EthosNConfig.m_CompiledNetworkCacheMaxSizeMb != 0)
+        {
+            TrimCache(m_EthosNConfig.m_CompiledNetworkCacheDir,
+                      uint64_t{ m_EthosNConfig.m_CompiledNetworkCacheMaxSizeMb } * 1024 * 1024, path);
+        }
+    }
+    return compiledNetworks;
+}
+
 }    // namespace armnn
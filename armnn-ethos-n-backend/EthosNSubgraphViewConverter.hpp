@@ -59,6 +59,10 @@ protected:
 private:
     std::vector<CompiledBlobPtr> Estimate(const ethosn_lib::CompilationOptions& ethosnCompilationOpts);
     std::vector<CompiledBlobPtr> Compile(const ethosn_lib::CompilationOptions& ethosnCompilationOpts);
+    /// Compiles the network, unless it has already been compiled with the same options and saved in
+    /// EthosNConfig::m_CompiledNetworkCacheDir, in which case the saved compiled network is loaded instead.
+    std::vector<EthosNCompiledNetworkPtr>
+        CompileWithCache(const ethosn_lib::CompilationOptions& ethosnCompilationOpts);
 
     /// Adds operation(s) to the Ethos-N network that correspond to the given Arm NN layer.
     /// This will update m_ConvertedOutputSlots.
@@ -35,6 +35,8 @@ BOOST_AUTO_TEST_CASE(ParseEthosNConfig)
         os << armnn::EthosNConfig::PERF_ACTIVATION_COMPRESSION_SAVING << " = 0.5\n";
         os << armnn::EthosNConfig::PERF_CURRENT << " = 0\n";
         os << armnn::EthosNConfig::COMPILER_ALGORITHM << " = Auto\n";
+        os << armnn::EthosNConfig::COMPILED_NETWORK_CACHE_DIR << " = cache\n";
+        os << armnn::EthosNConfig::COMPILED_NETWORK_CACHE_MAX_SIZE_MB << " = 16\n";
     }
     SetEnv(armnn::EthosNConfig::CONFIG_FILE_ENV, configFile.c_str());
 
@@ -48,6 +50,8 @@ BOOST_AUTO_TEST_CASE(ParseEthosNConfig)
     BOOST_CHECK(config.m_PerfWeightCompressionSaving == 0.5f);
     BOOST_CHECK(config.m_PerfCurrent == false);
     BOOST_CHECK(config.m_CompilerAlgorithm == ethosn::support_library::CompilerAlgorithm::Auto);
+    BOOST_CHECK(config.m_CompiledNetworkCacheDir == "cache");
+    BOOST_CHECK(config.m_CompiledNetworkCacheMaxSizeMb == 16);
 }
 
 BOOST_AUTO_TEST_CASE(ParseEthosNConfigCascadingOk)
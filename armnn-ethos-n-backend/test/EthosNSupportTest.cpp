@@ -15,6 +15,9 @@
 #include <boost/test/unit_test.hpp>
 #include <ethosn_support_library/Support.hpp>
 
+#include <fstream>
+#include <sys/stat.h>
+
 using namespace armnn;
 
 namespace
@@ -71,7 +74,7 @@ BOOST_AUTO_TEST_SUITE(EthosNSupport)
 BOOST_AUTO_TEST_CASE(LibraryAccess)
 {
     const std::string version = ethosn_lib::GetLibraryVersion().ToString();
-    BOOST_TEST(version == "0.1.1");
+    BOOST_TEST(version == "1.0.0");
 }
 
 BOOST_AUTO_TEST_CASE(ConvertAdditionLayer)
@@ -110,6 +113,96 @@ BOOST_AUTO_TEST_CASE(ConvertAdditionLayer)
     BOOST_CHECK_NO_THROW(converter.CompileNetwork());
 }
 
+// Checks that a compiled network is saved in the cache directory, and loaded from it when the same sub-graph is
+// compiled again.
+BOOST_AUTO_TEST_CASE(CompiledNetworkCache)
+{
+    using namespace testing_utils;
+
+    const TempDir tmpDir;
+    const std::string configFile = tmpDir.Str() + "/config.txt";
+    const std::string cacheDir   = tmpDir.Str() + "/cache";
+
+    EthosNConfig config{};
+    config.m_PerfOutDir              = tmpDir.Str();
+    config.m_CompiledNetworkCacheDir = cacheDir;
+    CreateConfigFile(configFile, config);
+    SetEnv(EthosNConfig::CONFIG_FILE_ENV, configFile.c_str());
+
+    Graph graph;
+    SubgraphView::SubgraphViewPtr subgraphPtr = BuildActivationSubgraph(graph, ActivationFunction::ReLu);
+
+    auto countCacheEntries = [&cacheDir]() {
+        return std::distance(boost::filesystem::directory_iterator(cacheDir), boost::filesystem::directory_iterator());
+    };
+
+    // The first compilation creates the cache entry
+    TestEthosNSubgraphViewConverter converter(*subgraphPtr);
+    std::vector<CompiledBlobPtr> compiledBlobs = converter.CompileNetwork();
+    BOOST_CHECK(compiledBlobs.size() == 1);
+    BOOST_REQUIRE(countCacheEntries() == 1);
+
+    // Make the entry look as if it was last used an hour ago
+    const boost::filesystem::path entryPath = boost::filesystem::directory_iterator(cacheDir)->path();
+    const std::time_t lastUsed              = boost::filesystem::last_write_time(entryPath) - 60 * 60;
+    boost::filesystem::last_write_time(entryPath, lastUsed);
+    struct stat entryStat;
+    BOOST_REQUIRE(stat(entryPath.c_str(), &entryStat) == 0);
+
+    // The second one uses it, rather than compiling again. Compiling would have replaced the entry with a new file.
+    TestEthosNSubgraphViewConverter cachedConverter(*subgraphPtr);
+    std::vector<CompiledBlobPtr> cachedCompiledBlobs = cachedConverter.CompileNetwork();
+    BOOST_CHECK(cachedCompiledBlobs.size() == 1);
+    BOOST_CHECK(countCacheEntries() == 1);
+    struct stat cachedEntryStat;
+    BOOST_REQUIRE(stat(entryPath.c_str(), &cachedEntryStat) == 0);
+    BOOST_CHECK(cachedEntryStat.st_ino == entryStat.st_ino);
+    // Using the entry marks it as recently used
+    BOOST_CHECK(boost::filesystem::last_write_time(entryPath) > lastUsed);
+
+    // A different sub-graph gets its own entry
+    Graph otherGraph;
+    SubgraphView::SubgraphViewPtr otherSubgraphPtr = BuildActivationSubgraph(otherGraph, ActivationFunction::Sigmoid);
+    TestEthosNSubgraphViewConverter otherConverter(*otherSubgraphPtr);
+    BOOST_CHECK(otherConverter.CompileNetwork().size() == 1);
+    BOOST_CHECK(countCacheEntries() == 2);
+}
+
+// Checks that the least recently used entries are removed from the compiled network cache when it gets too large.
+BOOST_AUTO_TEST_CASE(CompiledNetworkCacheMaxSize)
+{
+    using namespace testing_utils;
+
+    const TempDir tmpDir;
+    const std::string configFile = tmpDir.Str() + "/config.txt";
+    const std::string cacheDir   = tmpDir.Str() + "/cache";
+
+    EthosNConfig config{};
+    config.m_PerfOutDir                    = tmpDir.Str();
+    config.m_CompiledNetworkCacheDir       = cacheDir;
+    config.m_CompiledNetworkCacheMaxSizeMb = 1;
+    CreateConfigFile(configFile, config);
+    SetEnv(EthosNConfig::CONFIG_FILE_ENV, configFile.c_str());
+
+    // An old entry which takes up the whole cache, and a file which isn't an entry
+    boost::filesystem::create_directories(cacheDir);
+    const std::string oldEntry = cacheDir + "/old.ethosn";
+    const std::string notEntry = cacheDir + "/other.txt";
+    std::ofstream(oldEntry, std::ios::binary) << std::string(1024 * 1024, 'x');
+    std::ofstream(notEntry, std::ios::binary) << std::string(1024 * 1024, 'x');
+    boost::filesystem::last_write_time(oldEntry, boost::filesystem::last_write_time(oldEntry) - 60 * 60);
+
+    Graph graph;
+    SubgraphView::SubgraphViewPtr subgraphPtr = BuildActivationSubgraph(graph, ActivationFunction::ReLu);
+    TestEthosNSubgraphViewConverter converter(*subgraphPtr);
+    BOOST_CHECK(converter.CompileNetwork().size() == 1);
+
+    BOOST_CHECK(!boost::filesystem::exists(oldEntry));
+    BOOST_CHECK(boost::filesystem::exists(notEntry));
+    BOOST_CHECK(std::distance(boost::filesystem::directory_iterator(cacheDir),
+                              boost::filesystem::directory_iterator()) == 2);
+}
+
 BOOST_AUTO_TEST_CASE(ConvertConcatLayer)
 {
     Graph graph;
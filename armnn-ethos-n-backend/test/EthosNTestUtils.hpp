@@ -66,6 +66,9 @@ inline void CreateConfigFile(const std::string& configFile, const armnn::EthosNC
            << "\n";
     }
     os << armnn::EthosNConfig::PERF_CURRENT << " = " << config.m_PerfCurrent << "\n";
+    os << armnn::EthosNConfig::COMPILED_NETWORK_CACHE_DIR << " = " << config.m_CompiledNetworkCacheDir << "\n";
+    os << armnn::EthosNConfig::COMPILED_NETWORK_CACHE_MAX_SIZE_MB << " = " << config.m_CompiledNetworkCacheMaxSizeMb
+       << "\n";
 }
 
 inline std::string ReadFile(const std::string& file)
@@ -104,8 +104,8 @@ KmodNetworkImpl::KmodNetworkImpl(support_library::CompiledNetwork& compiledNetwo
 
     netReq.dma_buffers.num  = static_cast<uint32_t>(constantDmaInfos.size());
     netReq.dma_buffers.info = constantDmaInfos.data();
-    netReq.dma_data.size    = static_cast<uint32_t>(compiledNetwork.GetConstantDmaData().size());
-    netReq.dma_data.data    = compiledNetwork.GetConstantDmaData().data();
+    netReq.dma_data.size    = static_cast<uint32_t>(compiledNetwork.GetConstantDmaDataView().m_Size);
+    netReq.dma_data.data    = compiledNetwork.GetConstantDmaDataView().m_Data;
 
     netReq.intermediate_buffers.num  = static_cast<uint32_t>(intermediateInfos.size());
     netReq.intermediate_buffers.info = intermediateInfos.data();
@@ -120,8 +120,8 @@ KmodNetworkImpl::KmodNetworkImpl(support_library::CompiledNetwork& compiledNetwo
 
     netReq.cu_buffers.num  = static_cast<uint32_t>(constantCuInfos.size());
     netReq.cu_buffers.info = constantCuInfos.data();
-    netReq.cu_data.size    = static_cast<uint32_t>(compiledNetwork.GetConstantControlUnitData().size());
-    netReq.cu_data.data    = compiledNetwork.GetConstantControlUnitData().data();
+    netReq.cu_data.size    = static_cast<uint32_t>(compiledNetwork.GetConstantControlUnitDataView().m_Size);
+    netReq.cu_data.data    = compiledNetwork.GetConstantControlUnitDataView().m_Data;
 
     int ethosnFd = open(STRINGIZE_VALUE_OF(DEVICE_NODE), O_RDONLY);
     if (ethosnFd < 0)
@@ -162,7 +162,7 @@ void NetworkImpl::DumpCmm(Buffer* const inputBuffers[], uint32_t numInputBuffers
     // Other buffer types need allocations in the functional model's address space.
     uint64_t constantDmaDataBaseAddress = ethosn::driver_library::RoundUpToNearestMultiple(baseAddress, 64);
     uint64_t inputBuffersBaseAddress    = ethosn::driver_library::RoundUpToNearestMultiple(
-        constantDmaDataBaseAddress + m_CompiledNetwork.GetConstantDmaData().size(), 64);
+        constantDmaDataBaseAddress + m_CompiledNetwork.GetConstantDmaDataView().m_Size, 64);
     uint64_t outputBuffersBaseAddress = ethosn::driver_library::RoundUpToNearestMultiple(
         inputBuffersBaseAddress + GetLastAddressedMemory(m_CompiledNetwork.GetInputBufferInfos()), 64);
     uint64_t intermediateDataBaseAddress = ethosn::driver_library::RoundUpToNearestMultiple(
@@ -179,9 +179,13 @@ void NetworkImpl::DumpCmm(Buffer* const inputBuffers[], uint32_t numInputBuffers
     MemoryMap cmm = GetFirmwareMemMap(firmwareFile);
 
     // Add "memory map"
-    AddToMemoryMap(cmm, static_cast<uint32_t>(constantDmaDataBaseAddress), m_CompiledNetwork.GetConstantDmaData());
-    AddToMemoryMap(cmm, static_cast<uint32_t>(cmmConstantControlUnitDataBaseAddress),
-                   m_CompiledNetwork.GetConstantControlUnitData());
+    // The views are used so that the constant data isn't copied if it is referred to in place.
+    const support_library::DataView constantDmaData         = m_CompiledNetwork.GetConstantDmaDataView();
+    const support_library::DataView constantControlUnitData = m_CompiledNetwork.GetConstantControlUnitDataView();
+    AddToMemoryMap(cmm, static_cast<uint32_t>(constantDmaDataBaseAddress), constantDmaData.m_Data,
+                   constantDmaData.m_Size);
+    AddToMemoryMap(cmm, static_cast<uint32_t>(cmmConstantControlUnitDataBaseAddress), constantControlUnitData.m_Data,
+                   constantControlUnitData.m_Size);
 
     // Write the inference data. It includes the binding table and the command stream.
     const uint32_t inferenceAddr = static_cast<uint32_t>(mailboxAddress) + 16;
@@ -23,9 +23,9 @@
 #include <vector>
 
 // Version information
-#define ETHOSN_SUPPORT_LIBRARY_VERSION_MAJOR 0
-#define ETHOSN_SUPPORT_LIBRARY_VERSION_MINOR 1
-#define ETHOSN_SUPPORT_LIBRARY_VERSION_PATCH 1
+#define ETHOSN_SUPPORT_LIBRARY_VERSION_MAJOR 1
+#define ETHOSN_SUPPORT_LIBRARY_VERSION_MINOR 0
+#define ETHOSN_SUPPORT_LIBRARY_VERSION_PATCH 0
 
 namespace ethosn
 {
@@ -36,6 +36,7 @@ class Input;
 class Output;
 class Operand;
 class Constant;
+class WeightEncoderCache;
 
 struct Version
 {
@@ -73,6 +74,9 @@ struct CompilationOptions
         std::string m_DebugDir = ".";
         bool m_DumpRam         = false;
         bool m_InitialSramDump = false;
+        /// Writes SramUsage.json to m_DebugDir, describing how much SRAM each pass uses and which allocations
+        /// failed, causing parts of the network to be moved to DRAM. This is also written if m_DumpDebugFiles is set.
+        bool m_DumpSramUsage = false;
     };
     explicit CompilationOptions(const std::vector<char>& fwAndHwCapabilities)
         : m_FwAndHwCapabilities(fwAndHwCapabilities)
@@ -96,6 +100,12 @@ struct CompilationOptions
     bool m_BlockConfig8x8                = true;
     bool m_EnableIntermediateCompression = true;
     bool m_DisableWinograd               = false;
+    /// If enabled, the strategy and block config of each MCE/PLE pass are those with the least estimated DRAM traffic
+    /// (bytes of input, output and weights read from or written to DRAM) of all the pairs which fit in SRAM, rather
+    /// than the first pair which fits, trying the strategies and block configs in a fixed order of preference.
+    /// This takes longer to compile.
+    /// The choice made for each pass is shown in the debug files.
+    bool m_SelectStrategiesByCost = false;
     /// If enabled, files containing details of the compilation process will be dumped to m_DebugDir.
     /// These can be helpful for debugging compilation issues.
     DebugInfo m_DebugInfo;
@@ -107,6 +117,44 @@ struct CompilationOptions
     /// - for estimation: executing cascaded and non cascaded approach and returning
     ///                   the one which is the more performant
     CompilerAlgorithm m_CompilerAlgorithm = CompilerAlgorithm::NonCascadingOnly;
+    /// Limits the search for the best cascaded combination of plans, which can otherwise take a very long time and a
+    /// lot of memory for large networks.
+    /// The combinations are built up one Part at a time, and after each step only the m_CascadingBeamWidth
+    /// combinations with the least DRAM traffic known so far are kept, which also bounds the memory used.
+    /// If none of the combinations kept can be completed and estimated, the search is repeated with twice the limits
+    /// (see also m_CascadingMaxCombinations), and so on, ending with a full search if necessary.
+    /// "0" (the default) keeps them all, so that the best combination is always found.
+    uint32_t m_CascadingBeamWidth = 0;
+    /// A limit on the number of combinations of plans created while searching for the best cascaded combination,
+    /// counting those created by every step. Once it is reached, the search is finished by only extending the most
+    /// promising combination, and the best of the complete combinations found is chosen.
+    /// The number is checked between the steps of the search, so a step which creates a very large number of
+    /// combinations can overrun it unless m_CascadingBeamWidth is also set.
+    /// Unlike a time limit, this gives the same result on every machine and for any number of threads.
+    /// "0" (the default) means no limit.
+    uint32_t m_CascadingMaxCombinations = 0;
+    /// If enabled, the search for the best cascaded combination of plans chooses the plans for each chain of
+    /// operations in the network (i.e. where each operation's output is only used by the next) by dynamic programming,
+    /// in time linear in the length of the chain, rather than by trying every combination of them.
+    /// For each way into and out of the chain, only the choice with the least DRAM traffic as calculated while
+    /// combining plans is kept. The complete combinations are still ranked by estimating their performance, but the
+    /// result can differ from that of the full search, which may find a better choice inside a chain.
+    /// Chains for which no choice is found are searched as usual, as is the whole network if none of the combinations
+    /// found can be estimated.
+    bool m_CascadingDynamicProgramming = false;
+    /// The maximum number of threads the compiler may use, including the calling thread.
+    /// This is used to encode the weights for different OFMs concurrently and, when estimating performance with
+    /// cascading, to create the plans of different Parts and estimate different combinations of plans concurrently.
+    /// The compiled network and the performance estimate are identical regardless of the number of threads used.
+    /// "1" (the default) means that all work is done on the calling thread.
+    /// "0" means use as many threads as the hardware supports.
+    uint32_t m_NumThreads = 1;
+    /// An optional cache of encoded weights, created with CreateWeightEncoderCache().
+    /// Weights are encoded many times during compilation, so the compiler always caches them internally, but giving
+    /// a cache here allows the results to be reused by later calls to Compile() or EstimatePerformance(), for example
+    /// when compiling the same network again with different options. Such calls may run concurrently.
+    /// If this is null (the default) then a new cache is used for each call.
+    std::shared_ptr<WeightEncoderCache> m_WeightEncoderCache;
 };
 
 /// Contains options for performance estimation
@@ -1058,6 +1106,13 @@ inline std::ostream& operator<<(std::ostream& os, const OutputBufferInfo& value)
     return os;
 }
 
+/// A read-only view of a block of bytes which is owned by something else.
+struct DataView
+{
+    const uint8_t* m_Data = nullptr;
+    size_t m_Size         = 0;
+};
+
 /// The result of compiling a network using Compile(...).
 class CompiledNetwork
 {
@@ -1085,6 +1140,22 @@ public:
     /// All the constant data to be DMA'd by the firmware, e.g. weights
     virtual const std::vector<uint8_t>& GetConstantDmaData() const = 0;
 
+    /// The same data as GetConstantControlUnitData() and GetConstantDmaData(), valid for as long as this object.
+    /// A CompiledNetwork deserialized from memory refers to its constant data in place, and only copies it into a
+    /// std::vector if GetConstantControlUnitData() or GetConstantDmaData() are called, so these should be preferred.
+    /// @{
+    virtual DataView GetConstantControlUnitDataView() const
+    {
+        const std::vector<uint8_t>& data = GetConstantControlUnitData();
+        return { data.data(), data.size() };
+    }
+    virtual DataView GetConstantDmaDataView() const
+    {
+        const std::vector<uint8_t>& data = GetConstantDmaData();
+        return { data.data(), data.size() };
+    }
+    /// @}
+
     /// Details of the individual buffers contained in the data returned by GetConstantControlUnitData().
     virtual const std::vector<BufferInfo>& GetConstantControlUnitDataBufferInfos() const = 0;
     /// Details of the individual buffers contained in the data returned by GetConstantDmaData().
@@ -1095,6 +1166,9 @@ public:
 
     virtual uint32_t GetIntermediateDataSize() const = 0;
 
+    /// Writes everything but the operation IDs in a versioned binary format, which consists of a header, a table of
+    /// sections and then the data of each section starting at a 64-byte aligned offset.
+    /// The data can be read back with either overload of DeserializeCompiledNetwork.
     virtual void Serialize(std::ostream&) const = 0;
 };
 
@@ -1189,14 +1263,41 @@ std::vector<char> GetPerformanceEstimatorFwAndHwCapabilities(EthosNVariant varia
 // Deserialize a serialized CompiledNetwork from the specified input stream
 // If the versions used for serialization and deserialization are different
 //      an exception of type VersionMismatchException will be thrown.
+// Data written by 0.x versions, in the format used before the current one, can still be read.
+// If the data is truncated or malformed then std::invalid_argument is thrown.
 std::unique_ptr<CompiledNetwork> DeserializeCompiledNetwork(std::istream&);
 
+/// Deserializes a CompiledNetwork from a block of memory holding the output of CompiledNetwork::Serialize, for
+/// example a file mapped into memory with mmap. The constant data is referred to in place rather than copied, so the
+/// memory must stay valid and unchanged for as long as the returned CompiledNetwork exists. The owner (if given) is
+/// kept alive for that long, so it can be used to free or unmap the memory once it is no longer needed.
+/// Data written by versions of the support library which used an older format is copied instead.
+/// If the versions used for serialization and deserialization are different an exception of type
+/// VersionMismatchException will be thrown, and if the data is malformed then std::invalid_argument is thrown.
+std::unique_ptr<CompiledNetwork>
+    DeserializeCompiledNetwork(const void* data, size_t size, std::shared_ptr<const void> owner = nullptr);
+
+/// Returns a key which identifies the result of compiling the given network with the given options, so that a
+/// compiled network can be saved (see CompiledNetwork::Serialize) and reused rather than compiling the same network
+/// again, for example by a cache of compiled networks kept on disk.
+/// The key covers every operation in the network and its parameters, the contents of the constants, the options
+/// which affect the compiled network (including the capabilities), the version of this library and the version of
+/// the format written by CompiledNetwork::Serialize. It is the SHA-256 digest of all these, as a hexadecimal string
+/// which can be used as a file name.
+/// Note that it does not identify the build of this library, so a cache which may be used by different builds with
+/// the same version number must also be keyed on something which does (see the Arm NN backend for an example).
+std::string GetCompilationCacheKey(const Network& network, const CompilationOptions& options);
+
 // Create a new Network
 std::shared_ptr<Network> CreateNetwork();
 
 // Create a new Network for performance estimation
 std::shared_ptr<Network> CreateEstimationNetwork();
 
+// Create a new cache of encoded weights, which can be shared between compilations (see CompilationOptions).
+// Once the encoded weights held take up more than about maxSizeBytes, the least recently used ones are discarded.
+std::shared_ptr<WeightEncoderCache> CreateWeightEncoderCache(size_t maxSizeBytes = 256 * 1024 * 1024);
+
 // Add Input to a Network. The returned shared_ptr ref-counts the network.
 TensorAndId<Operand> AddInput(const std::shared_ptr<Network>& network, const TensorInfo& info);
 
@@ -9,7 +9,9 @@
 
 #include <ethosn_command_stream/CommandStreamBuffer.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 namespace ethosn
 {
@@ -21,22 +23,25 @@ BufferManager::BufferManager()
     : m_NextDramBufferId(1)
     // Use a separate ID space for SRAM buffers because they are not needed at runtime.
     , m_NextSramBufferId(0x8000000)
+    , m_ConstantDmaDataStats()
+    , m_ConstantControlUnitDataStats()
 {}
 
 uint32_t BufferManager::AddDram(BufferType type, uint32_t size)
 {
     assert(type == BufferType::Input || type == BufferType::Intermediate || type == BufferType::Output);
-    CompilerBufferInfo buffer(type, 0, size, BufferLocation::Dram, std::vector<uint8_t>(), 0xFFFFFFFF, 0xFFFFFFFF);
+    CompilerBufferInfo buffer(type, 0, size, BufferLocation::Dram, nullptr, 0xFFFFFFFF, 0xFFFFFFFF);
     m_Buffers.insert({ m_NextDramBufferId, buffer });
     ++m_NextDramBufferId;
     return m_NextDramBufferId - 1;
 }
 
-uint32_t BufferManager::AddDramConstant(BufferType type, const std::vector<uint8_t>& constantData)
+uint32_t BufferManager::AddDramConstant(BufferType type, std::shared_ptr<const std::vector<uint8_t>> constantData)
 {
     assert(type == BufferType::ConstantDma || type == BufferType::ConstantControlUnit);
-    CompilerBufferInfo buffer(type, 0, static_cast<uint32_t>(constantData.size()), BufferLocation::Dram, constantData,
-                              0xFFFFFFFF, 0xFFFFFFFF);
+    assert(constantData);
+    const uint32_t size = static_cast<uint32_t>(constantData->size());
+    CompilerBufferInfo buffer(type, 0, size, BufferLocation::Dram, std::move(constantData), 0xFFFFFFFF, 0xFFFFFFFF);
     m_Buffers.insert({ m_NextDramBufferId, buffer });
     ++m_NextDramBufferId;
     return m_NextDramBufferId - 1;
@@ -46,8 +51,7 @@ uint32_t BufferManager::AddDramInput(uint32_t size, uint32_t sourceOperationId)
 {
     // Input index will always be index 0 because it is the output of the Input layer
     //      and this layer cannot have more than one output. (CompilerBufferInfo last argument)
-    CompilerBufferInfo buffer(BufferType::Input, 0, size, BufferLocation::Dram, std::vector<uint8_t>(),
-                              sourceOperationId, 0);
+    CompilerBufferInfo buffer(BufferType::Input, 0, size, BufferLocation::Dram, nullptr, sourceOperationId, 0);
     m_Buffers.insert({ m_NextDramBufferId, buffer });
     ++m_NextDramBufferId;
     return m_NextDramBufferId - 1;
@@ -55,22 +59,92 @@ uint32_t BufferManager::AddDramInput(uint32_t size, uint32_t sourceOperationId)
 
 uint32_t BufferManager::AddSram(uint32_t size, uint32_t offset)
 {
-    CompilerBufferInfo buffer(BufferType::Intermediate, offset, size, BufferLocation::Sram, std::vector<uint8_t>(),
-                              0xFFFFFFFF, 0xFFFFFFFF);
+    CompilerBufferInfo buffer(BufferType::Intermediate, offset, size, BufferLocation::Sram, nullptr, 0xFFFFFFFF,
+                              0xFFFFFFFF);
     m_Buffers.insert({ m_NextSramBufferId, buffer });
     ++m_NextSramBufferId;
     return m_NextSramBufferId - 1;
 }
 
+namespace
+{
+
+/// Gets the IDs of the DRAM buffers which the given command may read or write.
+/// Tensors in SRAM may also have a buffer ID set, which is included, as using a buffer for longer than it is
+/// really needed is harmless.
+std::vector<uint32_t> GetDramBufferIds(const command_stream::CommandHeader& header)
+{
+    using namespace command_stream;
+    switch (header.m_Opcode())
+    {
+        case Opcode::OPERATION_MCE_PLE:
+        {
+            const auto& data = header.GetCommand<Opcode::OPERATION_MCE_PLE>()->m_Data();
+            return { data.m_InputInfo().m_DramBufferId(), data.m_WeightInfo().m_DramBufferId(),
+                     data.m_OutputInfo().m_DramBufferId() };
+        }
+        case Opcode::OPERATION_PLE_ONLY:
+        {
+            const auto& data = header.GetCommand<Opcode::OPERATION_PLE_ONLY>()->m_Data();
+            return { data.m_InputInfo().m_DramBufferId(), data.m_InputInfo2().m_DramBufferId(),
+                     data.m_OutputInfo().m_DramBufferId() };
+        }
+        case Opcode::OPERATION_SOFTMAX:
+        {
+            const auto& data = header.GetCommand<Opcode::OPERATION_SOFTMAX>()->m_Data();
+            return { data.m_InputInfo().m_DramBufferId(), data.m_OutputInfo().m_DramBufferId() };
+        }
+        case Opcode::OPERATION_CONVERT:
+        {
+            const auto& data = header.GetCommand<Opcode::OPERATION_CONVERT>()->m_Data();
+            return { data.m_InputInfo().m_DramBufferId(), data.m_OutputInfo().m_DramBufferId() };
+        }
+        case Opcode::OPERATION_SPACE_TO_DEPTH:
+        {
+            const auto& data = header.GetCommand<Opcode::OPERATION_SPACE_TO_DEPTH>()->m_Data();
+            return { data.m_InputInfo().m_DramBufferId(), data.m_OutputInfo().m_DramBufferId() };
+        }
+        case Opcode::DUMP_DRAM:
+            return { header.GetCommand<Opcode::DUMP_DRAM>()->m_Data().m_DramBufferId() };
+        default:
+            return {};
+    }
+}
+
+}    // namespace
+
 void BufferManager::AddCommandStream(const ethosn::command_stream::CommandStreamBuffer& cmdStream)
 {
     assert(m_Buffers.find(0) == m_Buffers.end());
-    std::vector<uint8_t> cmdStreamData;
-    cmdStreamData.assign(reinterpret_cast<const uint8_t*>(cmdStream.GetData().data()),
-                         reinterpret_cast<const uint8_t*>(cmdStream.GetData().data() + cmdStream.GetData().size()));
-    CompilerBufferInfo buffer(BufferType::ConstantControlUnit, 0, static_cast<uint32_t>(cmdStreamData.size()),
-                              BufferLocation::Dram, cmdStreamData, 0xFFFFFFFF, 0xFFFFFFFF);
+    auto cmdStreamData = std::make_shared<std::vector<uint8_t>>(
+        reinterpret_cast<const uint8_t*>(cmdStream.GetData().data()),
+        reinterpret_cast<const uint8_t*>(cmdStream.GetData().data() + cmdStream.GetData().size()));
+    const uint32_t size = static_cast<uint32_t>(cmdStreamData->size());
+    CompilerBufferInfo buffer(BufferType::ConstantControlUnit, 0, size, BufferLocation::Dram, std::move(cmdStreamData),
+                              0xFFFFFFFF, 0xFFFFFFFF);
     m_Buffers.insert({ 0, buffer });    // Command stream is always buffer 0.
+
+    uint32_t time = 0;
+    for (const command_stream::CommandHeader& header : cmdStream)
+    {
+        for (uint32_t bufferId : GetDramBufferIds(header))
+        {
+            MarkBufferUsedAtTime(bufferId, time, time + 1);
+        }
+        ++time;
+    }
+}
+
+void BufferManager::MarkBufferUsedAtTime(uint32_t bufferId, uint32_t startTime, uint32_t endTime)
+{
+    auto it = m_Buffers.find(bufferId);
+    if (it == m_Buffers.end() || startTime >= endTime)
+    {
+        return;
+    }
+    CompilerBufferInfo& buffer = it->second;
+    buffer.m_LifetimeStart     = std::min(buffer.m_LifetimeStart, startTime);
+    buffer.m_LifetimeEnd       = std::max(buffer.m_LifetimeEnd, endTime);
 }
 
 void BufferManager::ChangeToOutput(uint32_t bufferId, uint32_t sourceOperationId, uint32_t sourceOperationOutputIndex)
@@ -97,6 +171,63 @@ uint32_t AppendBufferAligned(uint32_t& cumulativeOffset, uint32_t alignment, uin
     return offset;
 }
 
+/// Gets the range of commands which use the given buffer. A buffer which isn't used by any command is treated as
+/// being in use throughout.
+std::pair<uint32_t, uint32_t> GetLifetime(const CompilerBufferInfo& buffer)
+{
+    return buffer.m_LifetimeStart < buffer.m_LifetimeEnd
+               ? std::make_pair(buffer.m_LifetimeStart, buffer.m_LifetimeEnd)
+               : std::make_pair(0U, UINT32_MAX);
+}
+
+bool AreLifetimesOverlapping(const CompilerBufferInfo& a, const CompilerBufferInfo& b)
+{
+    const std::pair<uint32_t, uint32_t> lifetimeA = GetLifetime(a);
+    const std::pair<uint32_t, uint32_t> lifetimeB = GetLifetime(b);
+    return lifetimeA.first < lifetimeB.second && lifetimeB.first < lifetimeA.second;
+}
+
+/// Sets the offsets of the given intermediate buffers so that buffers which are in use at the same time don't
+/// overlap, while buffers which are not may share memory.
+/// The command stream is executed one command after another, so buffers only used by different commands are never
+/// in use at the same time. The buffers are placed from the biggest to the smallest, each in the smallest gap
+/// between the buffers already placed which it overlaps in time (or after all of them, if none is big enough).
+void AllocateIntermediates(std::vector<CompilerBufferInfo*> buffers, uint32_t alignment)
+{
+    // The sort is stable so that buffers of the same size are placed in the order they were added.
+    std::stable_sort(buffers.begin(), buffers.end(),
+                     [](const CompilerBufferInfo* a, const CompilerBufferInfo* b) { return a->m_Size > b->m_Size; });
+
+    std::vector<const CompilerBufferInfo*> placed;
+    std::vector<const CompilerBufferInfo*> neighbours;
+    for (CompilerBufferInfo* buffer : buffers)
+    {
+        neighbours.clear();
+        std::copy_if(placed.begin(), placed.end(), std::back_inserter(neighbours),
+                     [&](const CompilerBufferInfo* p) { return AreLifetimesOverlapping(*buffer, *p); });
+        std::sort(neighbours.begin(), neighbours.end(),
+                  [](const CompilerBufferInfo* a, const CompilerBufferInfo* b) { return a->m_Offset < b->m_Offset; });
+
+        uint32_t bestOffset  = UINT32_MAX;
+        uint32_t bestGapSize = UINT32_MAX;
+        // The start of the free memory currently being considered.
+        uint32_t gapStart = 0;
+        for (const CompilerBufferInfo* neighbour : neighbours)
+        {
+            const uint32_t offset = utils::RoundUpToNearestMultiple(gapStart, alignment);
+            if (offset + buffer->m_Size <= neighbour->m_Offset && neighbour->m_Offset - gapStart < bestGapSize)
+            {
+                bestOffset  = offset;
+                bestGapSize = neighbour->m_Offset - gapStart;
+            }
+            gapStart = std::max(gapStart, neighbour->m_Offset + neighbour->m_Size);
+        }
+        buffer->m_Offset =
+            bestOffset != UINT32_MAX ? bestOffset : utils::RoundUpToNearestMultiple(gapStart, alignment);
+        placed.push_back(buffer);
+    }
+}
+
 uint32_t AppendBufferAligned(std::vector<uint8_t>& dest, uint32_t alignment, const std::vector<uint8_t>& src)
 {
     // Pad to the required alignment
@@ -113,15 +244,76 @@ uint32_t AppendBufferAligned(std::vector<uint8_t>& dest, uint32_t alignment, con
 
 }    // namespace
 
+ConstantDataAppender::ConstantDataAppender(std::vector<uint8_t>& dest,
+                                           uint32_t alignment,
+                                           BufferManager::ConstantDataStats& stats,
+                                           HashFunction hash)
+    : m_Dest(dest)
+    , m_Alignment(alignment)
+    , m_Stats(stats)
+    , m_Hash(hash)
+    , m_OffsetsByHash()
+{}
+
+uint32_t ConstantDataAppender::Append(const std::vector<uint8_t>& data)
+{
+    ++m_Stats.m_NumBuffers;
+
+    // The hash is only used to find candidates quickly. The data is compared as well, so a collision can't
+    // cause the wrong data to be used. The size is part of the key, so the comparison never reads past the end
+    // of the data appended before.
+    const Key key   = { m_Hash(data.data(), data.size()), data.size() };
+    auto candidates = m_OffsetsByHash.equal_range(key);
+    for (auto it = candidates.first; it != candidates.second; ++it)
+    {
+        const uint32_t offset = it->second;
+        if (std::memcmp(m_Dest.data() + offset, data.data(), data.size()) == 0)
+        {
+            ++m_Stats.m_NumDuplicateBuffers;
+            m_Stats.m_DuplicateBytes += static_cast<uint32_t>(data.size());
+            return offset;
+        }
+    }
+
+    const uint32_t offset = AppendBufferAligned(m_Dest, m_Alignment, data);
+    m_OffsetsByHash.emplace(key, offset);
+    m_Stats.m_StoredBytes = static_cast<uint32_t>(m_Dest.size());
+    return offset;
+}
+
 void BufferManager::Allocate()
 {
     // There is a restriction on the alignment of DRAM accesses for NHWCB and NHWCB_COMPRESSED formats.
     // NHWCB needs to be 16 byte aligned.
     // NHWCB_COMPRESSED needs to be 64 byte aligned.
     constexpr uint32_t alignment = 64;
-    uint32_t intermediatesOffset = 0;
     uint32_t inputsOffset        = 0;
     uint32_t outputsOffset       = 0;
+
+    // Reserve enough space for all the constant data up front (assuming none of it is duplicated), so that it is
+    // copied exactly once.
+    uint32_t constantControlUnitSize = 0;
+    uint32_t constantDmaSize         = 0;
+    for (const auto& internalBufferIt : m_Buffers)
+    {
+        const CompilerBufferInfo& buffer = internalBufferIt.second;
+        if (buffer.m_Type == BufferType::ConstantControlUnit)
+        {
+            AppendBufferAligned(constantControlUnitSize, alignment, buffer.m_Size);
+        }
+        else if (buffer.m_Type == BufferType::ConstantDma)
+        {
+            AppendBufferAligned(constantDmaSize, alignment, buffer.m_Size);
+        }
+    }
+    m_ConstantControlUnitData.reserve(constantControlUnitSize);
+    m_ConstantDmaData.reserve(constantDmaSize);
+    m_ConstantControlUnitDataStats = ConstantDataStats();
+    m_ConstantDmaDataStats          = ConstantDataStats();
+    ConstantDataAppender constantControlUnitData(m_ConstantControlUnitData, alignment, m_ConstantControlUnitDataStats);
+    ConstantDataAppender constantDmaData(m_ConstantDmaData, alignment, m_ConstantDmaDataStats);
+
+    std::vector<CompilerBufferInfo*> intermediates;
     for (auto& internalBufferIt : m_Buffers)
     {
         CompilerBufferInfo& buffer = internalBufferIt.second;
@@ -134,13 +326,15 @@ void BufferManager::Allocate()
         switch (buffer.m_Type)
         {
             case BufferType::Intermediate:
-                buffer.m_Offset = AppendBufferAligned(intermediatesOffset, alignment, buffer.m_Size);
+                intermediates.push_back(&buffer);
                 break;
             case BufferType::ConstantControlUnit:
-                buffer.m_Offset = AppendBufferAligned(m_ConstantControlUnitData, alignment, buffer.m_ConstantData);
+                buffer.m_Offset = constantControlUnitData.Append(*buffer.m_ConstantData);
+                buffer.m_ConstantData.reset();
                 break;
             case BufferType::ConstantDma:
-                buffer.m_Offset = AppendBufferAligned(m_ConstantDmaData, alignment, buffer.m_ConstantData);
+                buffer.m_Offset = constantDmaData.Append(*buffer.m_ConstantData);
+                buffer.m_ConstantData.reset();
                 break;
             case BufferType::Input:
                 buffer.m_Offset = AppendBufferAligned(inputsOffset, alignment, buffer.m_Size);
@@ -152,6 +346,35 @@ void BufferManager::Allocate()
                 assert(false);
         }
     }
+    AllocateIntermediates(intermediates, alignment);
+}
+
+bool BufferManager::HasOverlappingIntermediates() const
+{
+    std::vector<const CompilerBufferInfo*> intermediates;
+    for (const auto& internalBufferIt : m_Buffers)
+    {
+        const CompilerBufferInfo& buffer = internalBufferIt.second;
+        if (buffer.m_Location == BufferLocation::Dram && buffer.m_Type == BufferType::Intermediate)
+        {
+            intermediates.push_back(&buffer);
+        }
+    }
+    for (size_t i = 0; i < intermediates.size(); ++i)
+    {
+        for (size_t j = i + 1; j < intermediates.size(); ++j)
+        {
+            const CompilerBufferInfo& a = *intermediates[i];
+            const CompilerBufferInfo& b = *intermediates[j];
+            const bool isMemoryOverlapping =
+                a.m_Offset < b.m_Offset + b.m_Size && b.m_Offset < a.m_Offset + a.m_Size;
+            if (isMemoryOverlapping && AreLifetimesOverlapping(a, b))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
 const std::map<uint32_t, CompilerBufferInfo>& BufferManager::GetBuffers() const
@@ -159,14 +382,24 @@ const std::map<uint32_t, CompilerBufferInfo>& BufferManager::GetBuffers() const
     return m_Buffers;
 }
 
-const std::vector<uint8_t>& BufferManager::GetConstantDmaData() const
+const BufferManager::ConstantDataStats& BufferManager::GetConstantDmaDataStats() const
+{
+    return m_ConstantDmaDataStats;
+}
+
+const BufferManager::ConstantDataStats& BufferManager::GetConstantControlUnitDataStats() const
+{
+    return m_ConstantControlUnitDataStats;
+}
+
+std::vector<uint8_t> BufferManager::TakeConstantDmaData()
 {
-    return m_ConstantDmaData;
+    return std::move(m_ConstantDmaData);
 }
 
-const std::vector<uint8_t>& BufferManager::GetConstantControlUnitData() const
+std::vector<uint8_t> BufferManager::TakeConstantControlUnitData()
 {
-    return m_ConstantControlUnitData;
+    return std::move(m_ConstantControlUnitData);
 }
 
 }    // namespace support_library
@@ -5,8 +5,11 @@
 
 #pragma once
 
+#include "Sha256.hpp"
+
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <vector>
 
 namespace ethosn
@@ -43,44 +46,70 @@ public:
                        uint32_t offset,
                        uint32_t size,
                        BufferLocation location,
-                       const std::vector<uint8_t>& constantData,
+                       std::shared_ptr<const std::vector<uint8_t>> constantData,
                        uint32_t sourceOperationId,
                        uint32_t sourceOperationOutputIndex)
         : m_Type(type)
         , m_Offset(offset)
         , m_Size(size)
         , m_Location(location)
-        , m_ConstantData(constantData)
+        , m_ConstantData(std::move(constantData))
         , m_SourceOperationId(sourceOperationId)
         , m_SourceOperationOutputIndex(sourceOperationOutputIndex)
+        , m_LifetimeStart(UINT32_MAX)
+        , m_LifetimeEnd(0)
     {}
 
     BufferType m_Type;
     uint32_t m_Offset;
     uint32_t m_Size;
     BufferLocation m_Location;
-    std::vector<uint8_t> m_ConstantData;      ///< May be empty if this buffer is not constant.
+    /// The data of a constant buffer, null otherwise. This is shared with wherever the data came from (e.g. the
+    /// weight encoder cache) rather than copied, and is released once Allocate() has copied it into place.
+    std::shared_ptr<const std::vector<uint8_t>> m_ConstantData;
     uint32_t m_SourceOperationId;             ///< Only relevant for input and output buffer infos.
     uint32_t m_SourceOperationOutputIndex;    ///< Only relevant for input and output buffer infos.
+    /// The range of commands in the command stream which use this buffer, from the first (inclusive) to the last
+    /// (exclusive). This is empty (start >= end) if no command uses the buffer.
+    /// Only relevant for intermediate DRAM buffers, which may share memory if their lifetimes don't overlap.
+    /// @{
+    uint32_t m_LifetimeStart;
+    uint32_t m_LifetimeEnd;
+    /// @}
 };
 
 /// Maintains and builds up the set of buffers required by the compiled network.
 class BufferManager
 {
 public:
+    /// How much of the constant data of one type was found to be identical to other constant data, and so was only
+    /// stored once.
+    struct ConstantDataStats
+    {
+        uint32_t m_NumBuffers;             ///< The number of constant buffers of this type, including duplicates.
+        uint32_t m_NumDuplicateBuffers;    ///< The number of these which share the data of an earlier buffer.
+        uint32_t m_DuplicateBytes;         ///< The size of the data which wasn't stored again.
+        uint32_t m_StoredBytes;            ///< The size of the concatenated data, including alignment padding.
+    };
+
     BufferManager();
 
     /// Adds a new buffer with the given properties. Returns the ID of the buffer.
     /// @{
     uint32_t AddDram(BufferType type, uint32_t size);
-    uint32_t AddDramConstant(BufferType type, const std::vector<uint8_t>& constantData);
+    uint32_t AddDramConstant(BufferType type, std::shared_ptr<const std::vector<uint8_t>> constantData);
     uint32_t AddDramInput(uint32_t size, uint32_t sourceOperationId);
     uint32_t AddSram(uint32_t size, uint32_t offset);
     /// @}
 
     /// Adds the command stream buffer, which always has an ID of zero.
+    /// The lifetime of each buffer is extended to cover all the commands which use it (see MarkBufferUsedAtTime).
     void AddCommandStream(const ethosn::command_stream::CommandStreamBuffer& cmdStream);
 
+    /// Records that the given buffer is in use from the given time (inclusive) until the given time (exclusive),
+    /// where time is measured in commands of the command stream. Unknown buffer IDs are ignored.
+    void MarkBufferUsedAtTime(uint32_t bufferId, uint32_t startTime, uint32_t endTime);
+
     /// Changes the given buffer into an output.
     void ChangeToOutput(uint32_t bufferId, uint32_t sourceOperationId, uint32_t sourceOperationOutputIndex);
 
@@ -89,14 +118,33 @@ public:
     uint32_t GetSramOffset(uint32_t bufferId);
 
     /// Sets of m_Offset field of all DRAM buffers such that all buffers of each type are laid out contiguously.
+    /// The exception is intermediate buffers, which may share memory with each other if they are never in use
+    /// at the same time, so that the intermediate data is as small as possible. Intermediate buffers which aren't
+    /// used by any command are assumed to be in use throughout.
     /// Also fills in m_ConstantDmaData and m_ConstantControlUnitData with the concatenated data from all
-    /// constant buffers of the corresponding type.
+    /// constant buffers of the corresponding type, after which the buffers no longer refer to their data.
+    /// Constant buffers with identical contents (e.g. repeated weights, PLE kernels or weight metadata) are given
+    /// the same offset, so that the data is only stored once. They are read-only, so this is safe.
     /// Call this once all buffers have been added.
     void Allocate();
 
+    /// Returns true if any two intermediate DRAM buffers which are in use at the same time overlap in memory, which
+    /// Allocate() never does. This is only correct if the commands of the command stream are executed one at a time,
+    /// in order, as lifetimes are measured in commands.
+    bool HasOverlappingIntermediates() const;
+
     const std::map<uint32_t, CompilerBufferInfo>& GetBuffers() const;
-    const std::vector<uint8_t>& GetConstantDmaData() const;
-    const std::vector<uint8_t>& GetConstantControlUnitData() const;
+    /// How much constant data Allocate() deduplicated.
+    /// @{
+    const ConstantDataStats& GetConstantDmaDataStats() const;
+    const ConstantDataStats& GetConstantControlUnitDataStats() const;
+    /// @}
+    /// Moves out the concatenated constant data filled in by Allocate(), leaving this empty, so that it can be
+    /// handed over to the CompiledNetwork without a copy.
+    /// @{
+    std::vector<uint8_t> TakeConstantDmaData();
+    std::vector<uint8_t> TakeConstantControlUnitData();
+    /// @}
 
 private:
     /// All the buffers we currently know about, looked up by ID.
@@ -109,6 +157,36 @@ private:
 
     std::vector<uint8_t> m_ConstantDmaData;
     std::vector<uint8_t> m_ConstantControlUnitData;
+    ConstantDataStats m_ConstantDmaDataStats;
+    ConstantDataStats m_ConstantControlUnitDataStats;
+};
+
+/// Appends constant data to the concatenated data of one type of constant buffer, unless identical data has already
+/// been appended, in which case that is reused. Used by BufferManager::Allocate().
+class ConstantDataAppender
+{
+public:
+    /// Finds the candidates for identical data. This can be replaced so that tests can cause collisions.
+    using HashFunction = Sha256::Digest (*)(const void* data, size_t numBytes);
+
+    ConstantDataAppender(std::vector<uint8_t>& dest,
+                         uint32_t alignment,
+                         BufferManager::ConstantDataStats& stats,
+                         HashFunction hash = &Sha256::Hash);
+
+    /// Returns the offset of the data in the concatenated data.
+    uint32_t Append(const std::vector<uint8_t>& data);
+
+private:
+    std::vector<uint8_t>& m_Dest;
+    uint32_t m_Alignment;
+    BufferManager::ConstantDataStats& m_Stats;
+    HashFunction m_Hash;
+    /// The hash and size of a piece of data.
+    using Key = std::pair<Sha256::Digest, size_t>;
+
+    /// The offset of each piece of data appended so far, looked up by its hash and size.
+    std::multimap<Key, uint32_t> m_OffsetsByHash;
 };
 
 }    // namespace support_library
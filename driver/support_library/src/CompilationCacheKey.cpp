@@ -0,0 +1,346 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "../include/ethosn_support_library/Support.hpp"
+
+#include "Compiler.hpp"
+#include "Network.hpp"
+#include "WeightEncoderCache.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+namespace ethosn
+{
+namespace support_library
+{
+
+namespace
+{
+
+/// Writes everything which describes a network, and the options it is compiled with, into a block of bytes which
+/// can then be hashed. Each value is written field by field (rather than as the bytes of a whole struct) so that
+/// padding and pointers don't affect the result, and containers are prefixed with their size so that
+/// different sequences of values can't produce the same bytes.
+class CacheKeyWriter : public INetworkVisitor
+{
+public:
+    const std::vector<uint8_t>& GetBytes() const
+    {
+        return m_Bytes;
+    }
+
+    template <typename T>
+    void Write(const T& value)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Type must be a scalar");
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        m_Bytes.insert(m_Bytes.end(), bytes, bytes + sizeof(value));
+    }
+
+    void Write(const std::string& value)
+    {
+        Write(static_cast<uint64_t>(value.size()));
+        m_Bytes.insert(m_Bytes.end(), value.begin(), value.end());
+    }
+
+    void Write(const std::vector<char>& value)
+    {
+        Write(static_cast<uint64_t>(value.size()));
+        m_Bytes.insert(m_Bytes.end(), value.begin(), value.end());
+    }
+
+    template <typename T>
+    void Write(const std::vector<T>& values)
+    {
+        Write(static_cast<uint64_t>(values.size()));
+        for (const T& value : values)
+        {
+            Write(value);
+        }
+    }
+
+    template <typename T, size_t N>
+    void Write(const std::array<T, N>& values)
+    {
+        for (const T& value : values)
+        {
+            Write(value);
+        }
+    }
+
+    void Write(const QuantizationInfo& info)
+    {
+        Write(info.GetZeroPoint());
+        const QuantizationScales& scales = info.GetScales();
+        Write(static_cast<uint64_t>(scales.Size()));
+        for (size_t i = 0; i < scales.Size(); ++i)
+        {
+            Write(scales[i]);
+        }
+        const QuantizationInfo::QuantizationDim dim = info.GetQuantizationDim();
+        Write(dim.has_value());
+        Write(dim.has_value() ? dim.value() : 0u);
+    }
+
+    void Write(const TensorInfo& info)
+    {
+        Write(info.m_Dimensions);
+        Write(info.m_DataType);
+        Write(info.m_DataFormat);
+        Write(info.m_QuantizationInfo);
+    }
+
+    void Write(const Padding& padding)
+    {
+        Write(padding.m_Top);
+        Write(padding.m_Bottom);
+        Write(padding.m_Left);
+        Write(padding.m_Right);
+    }
+
+    void Write(const ConvolutionInfo& info)
+    {
+        Write(info.m_Padding);
+        Write(info.m_Stride.m_X);
+        Write(info.m_Stride.m_Y);
+        Write(info.m_OutputQuantizationInfo);
+    }
+
+    void Write(const CompilationOptions& options)
+    {
+        Write(options.m_FwAndHwCapabilities);
+        Write(options.m_Strategy0);
+        Write(options.m_Strategy1);
+        Write(options.m_Strategy3);
+        Write(options.m_Strategy4);
+        Write(options.m_Strategy6);
+        Write(options.m_Strategy7);
+        Write(options.m_BlockConfig16x16);
+        Write(options.m_BlockConfig32x8);
+        Write(options.m_BlockConfig8x32);
+        Write(options.m_BlockConfig16x8);
+        Write(options.m_BlockConfig8x16);
+        Write(options.m_BlockConfig8x8);
+        Write(options.m_EnableIntermediateCompression);
+        Write(options.m_DisableWinograd);
+        Write(options.m_SelectStrategiesByCost);
+        // These add commands to the command stream. The rest of the debug info only affects the debug files.
+        Write(options.m_DebugInfo.m_DumpRam);
+        Write(options.m_DebugInfo.m_InitialSramDump);
+        Write(options.m_CompilerAlgorithm);
+        Write(options.m_CascadingBeamWidth);
+        Write(options.m_CascadingMaxCombinations);
+        Write(options.m_CascadingDynamicProgramming);
+        // m_NumThreads and m_WeightEncoderCache don't affect the compiled network.
+    }
+
+    void Visit(Input& input) override
+    {
+        WriteOperation(input, "Input");
+    }
+
+    void Visit(Output& output) override
+    {
+        WriteOperation(output, "Output");
+        Write(output.GetTensorInfo());
+    }
+
+    void Visit(Constant& constant) override
+    {
+        WriteOperation(constant, "Constant");
+        const std::vector<uint8_t>& data = constant.GetDataVector();
+        // The data can be large, so only its hash is kept.
+        const WeightEncoderCache::ContentHash hash = WeightEncoderCache::HashData(data.data(), data.size());
+        Write(static_cast<uint64_t>(data.size()));
+        for (uint8_t b : hash)
+        {
+            Write(b);
+        }
+    }
+
+    void Visit(Convolution& convolution) override
+    {
+        WriteOperation(convolution, "Convolution");
+        Write(convolution.GetBias().GetId());
+        Write(convolution.GetWeights().GetId());
+        Write(convolution.GetConvolutionInfo());
+    }
+
+    void Visit(DepthwiseConvolution& depthwiseConvolution) override
+    {
+        WriteOperation(depthwiseConvolution, "DepthwiseConvolution");
+        Write(depthwiseConvolution.GetBias().GetId());
+        Write(depthwiseConvolution.GetWeights().GetId());
+        Write(depthwiseConvolution.GetConvolutionInfo());
+    }
+
+    void Visit(TransposeConvolution& transposeConvolution) override
+    {
+        WriteOperation(transposeConvolution, "TransposeConvolution");
+        Write(transposeConvolution.GetBias().GetId());
+        Write(transposeConvolution.GetWeights().GetId());
+        Write(transposeConvolution.GetConvolutionInfo());
+    }
+
+    void Visit(Concatenation& concatenation) override
+    {
+        WriteOperation(concatenation, "Concatenation");
+        Write(concatenation.GetConcatenationInfo().m_Axis);
+        Write(concatenation.GetConcatenationInfo().m_OutputQuantizationInfo);
+    }
+
+    void Visit(Split& split) override
+    {
+        WriteOperation(split, "Split");
+        Write(split.GetSplitInfo().m_Axis);
+        Write(split.GetSplitInfo().m_Sizes);
+    }
+
+    void Visit(Addition& addition) override
+    {
+        WriteOperation(addition, "Addition");
+    }
+
+    void Visit(FullyConnected& fullyConnected) override
+    {
+        WriteOperation(fullyConnected, "FullyConnected");
+        Write(fullyConnected.GetBias().GetId());
+        Write(fullyConnected.GetWeights().GetId());
+        Write(fullyConnected.GetFullyConnectedInfo().m_OutputQuantizationInfo);
+    }
+
+    void Visit(Relu& relu) override
+    {
+        WriteOperation(relu, "Relu");
+        Write(relu.GetReluInfo().m_LowerBound);
+        Write(relu.GetReluInfo().m_UpperBound);
+    }
+
+    void Visit(LeakyRelu& leakyRelu) override
+    {
+        WriteOperation(leakyRelu, "LeakyRelu");
+        Write(leakyRelu.GetLeakyReluInfo().m_Alpha);
+        Write(leakyRelu.GetLeakyReluInfo().m_OutputQuantizationInfo);
+    }
+
+    void Visit(Requantize& requantize) override
+    {
+        WriteOperation(requantize, "Requantize");
+        Write(requantize.GetRequantizeInfo().m_OutputQuantizationInfo);
+    }
+
+    void Visit(Softmax& softmax) override
+    {
+        WriteOperation(softmax, "Softmax");
+    }
+
+    void Visit(Sigmoid& sigmoid) override
+    {
+        WriteOperation(sigmoid, "Sigmoid");
+    }
+
+    void Visit(Pooling& pooling) override
+    {
+        WriteOperation(pooling, "Pooling");
+        const PoolingInfo& info = pooling.GetPoolingInfo();
+        Write(info.m_PoolingSizeX);
+        Write(info.m_PoolingSizeY);
+        Write(info.m_PoolingStrideX);
+        Write(info.m_PoolingStrideY);
+        Write(info.m_Padding);
+        Write(info.m_PoolingType);
+    }
+
+    void Visit(Reshape& reshape) override
+    {
+        WriteOperation(reshape, "Reshape");
+        Write(reshape.GetReshapeInfo());
+    }
+
+    void Visit(DepthToSpace& depthToSpace) override
+    {
+        WriteOperation(depthToSpace, "DepthToSpace");
+        Write(depthToSpace.GetDepthToSpaceInfo().m_BlockSize);
+    }
+
+    void Visit(SpaceToDepth& spaceToDepth) override
+    {
+        WriteOperation(spaceToDepth, "SpaceToDepth");
+        Write(spaceToDepth.GetSpaceToDepthInfo().m_BlockSize);
+    }
+
+    void Visit(Transpose& transpose) override
+    {
+        WriteOperation(transpose, "Transpose");
+        Write(transpose.GetTransposeInfo().m_Permutation);
+    }
+
+    void Visit(Resize& resize) override
+    {
+        WriteOperation(resize, "Resize");
+        const ResizeInfo& info = resize.GetResizeInfo();
+        Write(info.m_Algo);
+        Write(info.m_NewHeight);
+        Write(info.m_NewWidth);
+        Write(info.m_OutputQuantizationInfo);
+    }
+
+    void Visit(EstimateOnly& estimateOnly) override
+    {
+        WriteOperation(estimateOnly, "EstimateOnly");
+    }
+
+private:
+    /// Writes what all operations have in common: the type, the ID, where the inputs come from and what the
+    /// outputs are.
+    void WriteOperation(const Operation& operation, const std::string& type)
+    {
+        Write(type);
+        Write(operation.GetId());
+        const std::vector<const Operand*> inputs = operation.GetInputs();
+        Write(static_cast<uint64_t>(inputs.size()));
+        for (const Operand* input : inputs)
+        {
+            Write(input->GetProducer().GetId());
+            Write(input->GetProducerOutputIndex());
+        }
+        const std::vector<Operand>& outputs = operation.GetOutputs();
+        Write(static_cast<uint64_t>(outputs.size()));
+        for (const Operand& output : outputs)
+        {
+            Write(output.GetTensorInfo());
+        }
+    }
+
+    std::vector<uint8_t> m_Bytes;
+};
+
+}    // namespace
+
+std::string GetCompilationCacheKey(const Network& network, const CompilationOptions& options)
+{
+    CacheKeyWriter writer;
+    // The library version alone isn't enough, as the format of a saved compiled network may change without it.
+    writer.Write(GetLibraryVersion().ToString());
+    writer.Write(CompiledNetworkImpl::GetSerializedFormatVersion());
+    writer.Write(network.IsEstimationMode());
+    writer.Write(options);
+    network.Accept(writer);
+
+    const std::vector<uint8_t>& bytes          = writer.GetBytes();
+    const WeightEncoderCache::ContentHash hash = WeightEncoderCache::HashData(bytes.data(), bytes.size());
+
+    std::stringstream key;
+    key << std::hex << std::setfill('0');
+    for (uint8_t b : hash)
+    {
+        key << std::setw(2) << static_cast<uint32_t>(b);
+    }
+    return key.str();
+}
+
+}    // namespace support_library
+}    // namespace ethosn
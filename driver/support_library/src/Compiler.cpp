@@ -16,8 +16,12 @@
 #include "cascading/Cascading.hpp"
 #include "nonCascading/NonCascading.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <fstream>
 #include <numeric>
+#include <set>
 #include <sstream>
 #include <vector>
 
@@ -124,6 +128,11 @@ Compiler::Compiler(const Network& network,
     , m_Capabilities(fwAndHwCapabilities)
     , m_CompilationOptions(compilationOptions)
     , m_DebuggingContext(compilationOptions.m_DebugInfo)
+    , m_ThreadPool(compilationOptions.m_NumThreads)
+    // A cache which only lasts for this compilation has the same default size limit as one the user creates, so that
+    // compiling a network with a lot of large weights doesn't keep every encoding of them in memory.
+    , m_WeightEncoderCache(compilationOptions.m_WeightEncoderCache ? compilationOptions.m_WeightEncoderCache
+                                                                   : CreateWeightEncoderCache())
     , m_EstimationOptions(estimationOptions)
     , m_PerfEstimate(false)
 {}
@@ -155,7 +164,7 @@ std::unique_ptr<CompiledNetwork> Compiler::Compile()
     std::set<uint32_t> compiledOperationIds = m_Network.GetOperationIds();
 
     std::unique_ptr<CompiledNetworkImpl> compiledNetwork = std::make_unique<CompiledNetworkImpl>(
-        m_BufferManager.GetConstantDmaData(), m_BufferManager.GetConstantControlUnitData(),
+        m_BufferManager.TakeConstantDmaData(), m_BufferManager.TakeConstantControlUnitData(),
         m_BufferManager.GetBuffers(), compiledOperationIds);
 
     return compiledNetwork;
@@ -251,7 +260,8 @@ NetworkPerformanceData Compiler::PrivateEstimatePerformance()
     }
     else
     {
-        Cascading cascadingEstimate(m_EstimationOptions, m_Capabilities, m_DebuggingContext);
+        Cascading cascadingEstimate(m_EstimationOptions, m_CompilationOptions, m_Capabilities, m_DebuggingContext,
+                                    m_ThreadPool, *m_WeightEncoderCache);
         m_PerformanceStream = cascadingEstimate.Estimate(m_Graph);
     }
 
@@ -267,36 +277,7 @@ void Compiler::Convert()
 
 void Compiler::Optimize()
 {
-    using OptimizationFunc                     = bool (*)(Graph&, Node*);
-    const OptimizationFunc optimizationFuncs[] = {
-        &MergeFormatConversionNodes,
-        &MergeRequantizeNodes,
-        &ReorderReinterpretAndRequantizeNodes,
-        &ReorderConcatAndRequantizeNodes,
-        &MergeConcatNodes,
-        &RemoveUnconnectedNode,
-        &MergeConstantAndReinterpretNodes,
-        &MergeConstantAndFormatConversionNodes,
-        &ReplaceConstantAdditionWithDepthwise,
-    };
-
-    bool madeChange;
-    do
-    {
-        madeChange = false;
-        for (Node* node : m_Graph.GetNodesSorted())
-        {
-            for (const OptimizationFunc f : optimizationFuncs)
-            {
-                madeChange = f(m_Graph, node);
-                if (madeChange)
-                {
-                    goto nextIteration;
-                }
-            }
-        }
-    nextIteration:;
-    } while (madeChange);
+    ApplyAllOptimizations(m_Graph);
 }
 
 void Compiler::Prepare()
@@ -309,11 +290,19 @@ void Compiler::Prepare()
     // repeatedly modify the graph thinking it will help, but it does not.
     // Note that this limit is set based on the size of the *initial* graph (the graph may grow in size).
     const uint32_t maxIterations = static_cast<uint32_t>(m_Graph.GetNodes().size()) * 10;
+    if (m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles || m_DebuggingContext.m_DebugInfo.m_DumpSramUsage)
+    {
+        m_SramUsageReport = std::make_unique<SramUsageReport>(m_Capabilities.GetNumberOfSrams());
+    }
     while (true)
     {
         DumpGraph(std::string("GraphPrepareIteration") + std::to_string(numIterations) + "_Pre");
 
         Optimize();
+        if (m_SramUsageReport)
+        {
+            m_SramUsageReport->StartIteration(numIterations);
+        }
         CreatePasses();
 
         DumpGraph(std::string("GraphPrepareIteration") + std::to_string(numIterations) + "_Post");
@@ -321,6 +310,7 @@ void Compiler::Prepare()
         if (IsPrepared())
         {
             CreateSections();
+            DumpSramUsage();
             break;
         }
 
@@ -380,6 +370,7 @@ void Compiler::Prepare()
                 errorMsg += " " + std::to_string(o);
             }
 
+            DumpSramUsage();
             throw NotSupportedException(errorMsg.c_str());
         }
 
@@ -407,9 +398,27 @@ bool Compiler::IsPrepared()
 
 void Compiler::CreatePasses()
 {
-    std::vector<IStrategy*> strategies = utils::GetRawPointers(m_AllowedStrategies);
-    std::vector<Node*> sortedNodes     = m_Graph.GetNodesSorted();
+    std::vector<IStrategy*> strategies    = utils::GetRawPointers(m_AllowedStrategies);
+    const std::vector<Node*>& sortedNodes = m_Graph.GetNodesSorted();
     SramAllocator sramAllocator(m_Capabilities.GetTotalSramSize() / m_Capabilities.GetNumberOfSrams());
+    sramAllocator.SetUsageReport(m_SramUsageReport.get());
+
+    // Nodes which have been asked to move to DRAM but haven't been yet, so that each is only reported once.
+    auto IsForcedToDram = [](const Node& node) {
+        return node.GetFixGraphLocationHint() == LocationHint::RequireDram &&
+               node.GetLocationHint() != LocationHint::RequireDram;
+    };
+    std::set<const Node*> nodesForcedToDram;
+    if (m_SramUsageReport)
+    {
+        for (const auto& node : m_Graph.GetNodes())
+        {
+            if (IsForcedToDram(*node))
+            {
+                nodesForcedToDram.insert(node.get());
+            }
+        }
+    }
 
     // forward estimate flag is passed on to the function CreateGreedily to allow FCAF for
     // strategies 6, 7 and arbitrary tensor shape. This happens if the forward-looking
@@ -421,12 +430,19 @@ void Compiler::CreatePasses()
         if (n->GetPass() == nullptr)
         {
             const size_t passId = m_Passes.size();
+            if (m_SramUsageReport)
+            {
+                sramAllocator.ResetPeakUsage();
+                m_SramUsageReport->StartPass(*n);
+            }
             std::unique_ptr<Pass> p;
             if (!p)
             {
                 p = McePlePass::CreateGreedily(m_Capabilities, passId, strategies, m_AllowedBlockConfigs,
                                                m_CompilationOptions.m_EnableIntermediateCompression,
-                                               !m_CompilationOptions.m_DisableWinograd, n, sramAllocator, forwardEst);
+                                               !m_CompilationOptions.m_DisableWinograd,
+                                               m_CompilationOptions.m_SelectStrategiesByCost, m_EstimationOptions, n,
+                                               sramAllocator, forwardEst, m_ThreadPool, *m_WeightEncoderCache);
             }
             if (!p)
             {
@@ -437,6 +453,26 @@ void Compiler::CreatePasses()
                 p = ConversionPass::CreateGreedily(m_Capabilities, passId, n, sramAllocator);
             }
 
+            if (m_SramUsageReport)
+            {
+                if (p)
+                {
+                    m_SramUsageReport->EndPass(*p, sramAllocator.GetPeakUsage());
+                }
+                else
+                {
+                    std::vector<const Node*> newNodesForcedToDram;
+                    for (const auto& node : m_Graph.GetNodes())
+                    {
+                        if (IsForcedToDram(*node) && nodesForcedToDram.insert(node.get()).second)
+                        {
+                            newNodesForcedToDram.push_back(node.get());
+                        }
+                    }
+                    m_SramUsageReport->EndFailedPass(newNodesForcedToDram);
+                }
+            }
+
             if (p)
             {
                 m_Passes.push_back(std::move(p));
@@ -469,7 +505,7 @@ void Compiler::CreateSections()
 
 void Compiler::Generate()
 {
-    std::vector<Node*> sorted = m_Graph.GetNodesSorted();
+    const std::vector<Node*>& sorted = m_Graph.GetNodesSorted();
 
     // If an initial dump is requested, add the sram dump command at the head of the stream.
     if (m_DebuggingContext.m_DebugInfo.m_InitialSramDump)
@@ -487,9 +523,14 @@ void Compiler::Generate()
 
     DumpGraph("GraphFinal");
 
+    // The lifetimes of the buffers are worked out from the command stream, assuming that its commands never overlap
+    // in time, i.e. that each one finishes using its buffers before the next one starts. Intermediate buffers are
+    // then only given the same memory if no command uses both of them.
     m_BufferManager.AddCommandStream(m_CommandStream);
 
     m_BufferManager.Allocate();
+    assert(!m_BufferManager.HasOverlappingIntermediates());
+    DumpConstantData();
 }
 
 void Compiler::DumpGraph(const std::string& filename)
@@ -508,16 +549,47 @@ void Compiler::DumpGraph(const std::string& filename)
     m_DebuggingContext.DumpGraph(m_Graph, finalFileName);
 }
 
-CompiledNetworkImpl::CompiledNetworkImpl(const std::vector<uint8_t>& constantDmaData,
-                                         const std::vector<uint8_t>& constantControlUnitData,
+void Compiler::DumpSramUsage()
+{
+    if (m_SramUsageReport)
+    {
+        std::ofstream stream(m_DebuggingContext.GetAbsolutePathOutputFileName("SramUsage.json"));
+        m_SramUsageReport->Save(stream);
+    }
+}
+
+void Compiler::DumpConstantData()
+{
+    if (!m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles)
+    {
+        return;
+    }
+    // How much constant data was found to be identical to other constant data, and so is only stored once.
+    std::ofstream stream(m_DebuggingContext.GetAbsolutePathOutputFileName("ConstantData.txt"));
+    auto SaveStats = [&stream](const std::string& name, const BufferManager::ConstantDataStats& stats) {
+        stream << name << ": " << stats.m_StoredBytes << " bytes, buffers " << stats.m_NumBuffers
+               << ", duplicate buffers " << stats.m_NumDuplicateBuffers << ", bytes saved " << stats.m_DuplicateBytes
+               << "\n";
+    };
+    SaveStats("Constant DMA data", m_BufferManager.GetConstantDmaDataStats());
+    SaveStats("Constant control unit data", m_BufferManager.GetConstantControlUnitDataStats());
+    stream << "Total bytes saved: "
+           << m_BufferManager.GetConstantDmaDataStats().m_DuplicateBytes +
+                  m_BufferManager.GetConstantControlUnitDataStats().m_DuplicateBytes
+           << std::endl;
+}
+
+CompiledNetworkImpl::CompiledNetworkImpl(std::vector<uint8_t> constantDmaData,
+                                         std::vector<uint8_t> constantControlUnitData,
                                          const std::map<uint32_t, CompilerBufferInfo>& buffers,
                                          const std::set<uint32_t>& operationIds)
-    : m_ConstantDmaData(constantDmaData)
-    , m_ConstantControlUnitData(constantControlUnitData)
+    : m_ConstantDmaData(std::move(constantDmaData))
+    , m_ConstantControlUnitData(std::move(constantControlUnitData))
     , m_OperationIds(operationIds)
+    , m_HasExternalConstantData(false)
 {
     // Convert the set of buffers from the BufferManager into the format that CompiledNetwork exposes.
-    for (auto internalBufferIt : buffers)
+    for (const auto& internalBufferIt : buffers)
     {
         uint32_t bufferId = internalBufferIt.first;
 
@@ -581,36 +653,229 @@ uint32_t CompiledNetworkImpl::GetIntermediateDataSize() const
     return GetLastBufferAddress(*maxBuffer);
 }
 
+const std::vector<uint8_t>& CompiledNetworkImpl::GetConstantDmaData() const
+{
+    std::call_once(m_CopyExternalConstantDataFlag, [this]() { CopyExternalConstantData(); });
+    return m_ConstantDmaData;
+}
+
+const std::vector<uint8_t>& CompiledNetworkImpl::GetConstantControlUnitData() const
+{
+    std::call_once(m_CopyExternalConstantDataFlag, [this]() { CopyExternalConstantData(); });
+    return m_ConstantControlUnitData;
+}
+
+DataView CompiledNetworkImpl::GetConstantDmaDataView() const
+{
+    return m_HasExternalConstantData ? m_ExternalConstantDmaData
+                                     : DataView{ m_ConstantDmaData.data(), m_ConstantDmaData.size() };
+}
+
+DataView CompiledNetworkImpl::GetConstantControlUnitDataView() const
+{
+    return m_HasExternalConstantData
+               ? m_ExternalConstantControlUnitData
+               : DataView{ m_ConstantControlUnitData.data(), m_ConstantControlUnitData.size() };
+}
+
+void CompiledNetworkImpl::CopyExternalConstantData() const
+{
+    if (m_HasExternalConstantData)
+    {
+        m_ConstantDmaData.assign(m_ExternalConstantDmaData.m_Data,
+                                 m_ExternalConstantDmaData.m_Data + m_ExternalConstantDmaData.m_Size);
+        m_ConstantControlUnitData.assign(m_ExternalConstantControlUnitData.m_Data,
+                                         m_ExternalConstantControlUnitData.m_Data +
+                                             m_ExternalConstantControlUnitData.m_Size);
+    }
+}
+
+namespace
+{
+
+/// The format written by CompiledNetworkImpl::Serialize is a SerializedHeader, followed by a SerializedSection for
+/// each section, followed by the data of each section. The data of each section starts at a multiple of
+/// g_SerializedSectionAlignment bytes from the start, so that it can be used in place when the whole thing is
+/// mapped into memory. All values are in the byte order of the machine which wrote them.
+constexpr char g_SerializedMagic[8]            = { 'E', 'T', 'H', 'O', 'S', 'N', 'C', 'N' };
+constexpr uint32_t g_SerializedFormatVersion   = 1;
+constexpr uint64_t g_SerializedSectionAlignment = 64;
+/// The format written before the section table was added starts with the size of the version string, which is
+/// always less than this. The magic number at the start of the current format is always greater.
+constexpr uint32_t g_LegacyMaxVersionSize = 100;
+/// The largest serialized Compiled Network which can be read from a stream whose size can't be found.
+constexpr uint64_t g_SerializedMaxSize = uint64_t{ 1 } << 32;
+
+struct SerializedHeader
+{
+    char m_Magic[8];
+    uint32_t m_FormatVersion;
+    uint32_t m_LibraryVersionMajor;
+    uint32_t m_LibraryVersionMinor;
+    uint32_t m_LibraryVersionPatch;
+    uint32_t m_NumSections;
+    uint32_t m_Reserved;
+};
+
+enum class SerializedSectionType : uint32_t
+{
+    ConstantDmaData,
+    ConstantControlUnitData,
+    InputBufferInfos,
+    OutputBufferInfos,
+    ConstantControlUnitDataBufferInfos,
+    ConstantDmaDataBufferInfos,
+    IntermediateDataBufferInfos,
+};
+
+struct SerializedSection
+{
+    SerializedSectionType m_Type;
+    /// The size of each element of the array stored in the section, so that a change to it is detected.
+    uint32_t m_ElementSize;
+    /// The offset of the data from the start of the header.
+    uint64_t m_Offset;
+    uint64_t m_Size;
+};
+
+/// A section to be written, and the data to write in it.
+struct SectionToSerialize
+{
+    SerializedSectionType m_Type;
+    uint32_t m_ElementSize;
+    const void* m_Data;
+    size_t m_Size;
+};
+
 template <typename T>
-void CompiledNetworkImpl::Serialize(std::ostream& out, const std::vector<T>& data) const
+SectionToSerialize MakeSectionToSerialize(SerializedSectionType type, const std::vector<T>& data)
 {
     static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+    return { type, sizeof(T), data.data(), data.size() * sizeof(T) };
+}
 
-    size_t size = data.size();
-    out.write(reinterpret_cast<char*>(&size), sizeof(uint32_t));
-    for (size_t i = 0; i < size; ++i)
+void CheckLibraryVersion(const Version& version)
+{
+    Version libraryVersion = GetLibraryVersion();
+    if (libraryVersion.Major != version.Major || libraryVersion.Minor < version.Minor)
+    {
+        std::stringstream str;
+        str << "Compiled Network was serialized with Support Library version " << version.ToString()
+            << ". Attempting to de-serialize with version " << libraryVersion.ToString() << std::endl;
+
+        throw VersionMismatchException(str.str().c_str());
+    }
+}
+
+void CheckHeader(const SerializedHeader& header)
+{
+    if (std::memcmp(header.m_Magic, g_SerializedMagic, sizeof(g_SerializedMagic)) != 0)
+    {
+        throw std::invalid_argument("Data is not a serialized Compiled Network");
+    }
+    CheckLibraryVersion(
+        Version(header.m_LibraryVersionMajor, header.m_LibraryVersionMinor, header.m_LibraryVersionPatch));
+    if (header.m_FormatVersion != g_SerializedFormatVersion)
     {
-        out.write(reinterpret_cast<const char*>(&data[i]), sizeof(T));
+        throw VersionMismatchException("Compiled Network was serialized in an unsupported format");
     }
 }
 
+/// Copies the data of a section which holds an array into the given vector.
+template <typename T>
+void DeserializeSection(const SerializedSection& section, const uint8_t* data, std::vector<T>& out)
+{
+    static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
+    if (section.m_ElementSize != sizeof(T) || section.m_Size % sizeof(T) != 0)
+    {
+        throw std::invalid_argument("Serialized Compiled Network has a section of the wrong size");
+    }
+    out.resize(section.m_Size / sizeof(T));
+    std::memcpy(out.data(), data, section.m_Size);
+}
+
+/// Returns the number of bytes left to read from the given stream, or g_SerializedMaxSize if the stream can't seek.
+uint64_t GetRemainingSize(std::istream& in)
+{
+    const std::istream::pos_type start = in.tellg();
+    if (start == std::istream::pos_type(-1))
+    {
+        return g_SerializedMaxSize;
+    }
+    in.seekg(0, std::ios::end);
+    const std::istream::pos_type end = in.tellg();
+    in.clear();
+    in.seekg(start);
+    if (!in || end == std::istream::pos_type(-1) || end < start)
+    {
+        in.clear();
+        return g_SerializedMaxSize;
+    }
+    return static_cast<uint64_t>(end - start);
+}
+
+/// A read-only stream buffer over a block of memory, so that it can be read by the functions which take a stream.
+class MemoryStreamBuffer : public std::streambuf
+{
+public:
+    MemoryStreamBuffer(const uint8_t* data, size_t size)
+    {
+        char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+        setg(begin, begin, begin + size);
+    }
+};
+
+}    // namespace
+
+uint32_t CompiledNetworkImpl::GetSerializedFormatVersion()
+{
+    return g_SerializedFormatVersion;
+}
+
 void CompiledNetworkImpl::Serialize(std::ostream& out) const
 {
-    // Serialize the library version
-    const std::string version = GetLibraryVersion().ToString();
-    size_t size               = version.size();
-    assert(size < 100);
-    out.write(reinterpret_cast<char*>(&size), sizeof(uint32_t));
-    out.write(version.c_str(), size);
+    const DataView constantDmaData         = GetConstantDmaDataView();
+    const DataView constantControlUnitData = GetConstantControlUnitDataView();
+    const std::vector<SectionToSerialize> sections = {
+        { SerializedSectionType::ConstantDmaData, 1, constantDmaData.m_Data, constantDmaData.m_Size },
+        { SerializedSectionType::ConstantControlUnitData, 1, constantControlUnitData.m_Data,
+          constantControlUnitData.m_Size },
+        MakeSectionToSerialize(SerializedSectionType::InputBufferInfos, m_InputBufferInfos),
+        MakeSectionToSerialize(SerializedSectionType::OutputBufferInfos, m_OutputBufferInfos),
+        MakeSectionToSerialize(SerializedSectionType::ConstantControlUnitDataBufferInfos,
+                               m_ConstantControlUnitDataBufferInfos),
+        MakeSectionToSerialize(SerializedSectionType::ConstantDmaDataBufferInfos, m_ConstantDmaDataBufferInfos),
+        MakeSectionToSerialize(SerializedSectionType::IntermediateDataBufferInfos, m_IntermediateDataBufferInfos),
+    };
+
+    const Version version   = GetLibraryVersion();
+    SerializedHeader header = {};
+    std::memcpy(header.m_Magic, g_SerializedMagic, sizeof(g_SerializedMagic));
+    header.m_FormatVersion       = g_SerializedFormatVersion;
+    header.m_LibraryVersionMajor = version.Major;
+    header.m_LibraryVersionMinor = version.Minor;
+    header.m_LibraryVersionPatch = version.Patch;
+    header.m_NumSections         = static_cast<uint32_t>(sections.size());
+
+    std::vector<SerializedSection> sectionTable;
+    uint64_t offset = sizeof(SerializedHeader) + sections.size() * sizeof(SerializedSection);
+    for (const SectionToSerialize& section : sections)
+    {
+        offset = RoundUpToNearestMultiple(offset, g_SerializedSectionAlignment);
+        sectionTable.push_back({ section.m_Type, section.m_ElementSize, offset, section.m_Size });
+        offset += section.m_Size;
+    }
 
-    // Serialize the vectors
-    Serialize(out, m_ConstantDmaData);
-    Serialize(out, m_ConstantControlUnitData);
-    Serialize(out, m_InputBufferInfos);
-    Serialize(out, m_OutputBufferInfos);
-    Serialize(out, m_ConstantControlUnitDataBufferInfos);
-    Serialize(out, m_ConstantDmaDataBufferInfos);
-    Serialize(out, m_IntermediateDataBufferInfos);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(sectionTable.data()), sectionTable.size() * sizeof(SerializedSection));
+    uint64_t written = sizeof(SerializedHeader) + sectionTable.size() * sizeof(SerializedSection);
+    const std::array<char, g_SerializedSectionAlignment> padding{};
+    for (size_t i = 0; i < sections.size(); ++i)
+    {
+        out.write(padding.data(), sectionTable[i].m_Offset - written);
+        out.write(reinterpret_cast<const char*>(sections[i].m_Data), sections[i].m_Size);
+        written = sectionTable[i].m_Offset + sections[i].m_Size;
+    }
 }
 
 template <typename T>
@@ -619,34 +884,195 @@ void CompiledNetworkImpl::Deserialize(std::istream& in, std::vector<T>& data)
     static_assert(std::is_trivially_copyable<T>::value, "Type must be trivially copyable");
 
     auto size = Read<uint32_t>(in);
+    // Checked before anything is allocated, so that corrupt data can't cause a huge allocation.
+    if (size > GetRemainingSize(in) / sizeof(T))
+    {
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
+    }
 
-    for (uint32_t i = 0; i < size; ++i)
+    data.resize(size);
+    in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(size * sizeof(T)));
+    if (!in)
     {
-        T item = T();
-        char data_buffer[sizeof(T)];
-        in.read(data_buffer, sizeof(T));
-        std::memcpy(&item, data_buffer, sizeof(T));
-        data.emplace_back(item);
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
     }
 }
 
 void CompiledNetworkImpl::Deserialize(std::istream& in)
 {
-    // Check that input stream was serialized with the same version of the support library
-    auto size = Read<uint32_t>(in);
-    assert(size < 100);
+    // The counts and sizes read from the stream are checked against its size before anything is allocated for them,
+    // so that corrupt data can't cause huge allocations.
+    const uint64_t size = GetRemainingSize(in);
 
-    char versionString[100];
-    in.read(versionString, size);
-    Version version(versionString);
-    Version libraryVersion = GetLibraryVersion();
+    // Data written before the section table was added starts with the size of the version string instead.
+    auto versionSize = Read<uint32_t>(in);
+    if (versionSize < g_LegacyMaxVersionSize)
+    {
+        DeserializeLegacy(in, versionSize);
+        return;
+    }
 
-    if (libraryVersion.Major != version.Major || libraryVersion.Minor < version.Minor)
+    SerializedHeader header;
+    std::memcpy(&header, &versionSize, sizeof(versionSize));
+    in.read(reinterpret_cast<char*>(&header) + sizeof(versionSize), sizeof(header) - sizeof(versionSize));
+    if (!in || size < sizeof(header))
     {
-        std::stringstream str;
-        str << "Compiled Network was serialized with Support Library version " << versionString
-            << ". Attempting to de-serialize with version " << GetLibraryVersion().ToString() << std::endl;
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
+    }
+    CheckHeader(header);
+    if ((size - sizeof(header)) / sizeof(SerializedSection) < header.m_NumSections)
+    {
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
+    }
+
+    std::vector<SerializedSection> sectionTable(header.m_NumSections);
+    in.read(reinterpret_cast<char*>(sectionTable.data()), sectionTable.size() * sizeof(SerializedSection));
+    if (!in)
+    {
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
+    }
+    uint64_t position = sizeof(SerializedHeader) + sectionTable.size() * sizeof(SerializedSection);
+
+    // Read the data of the sections in the order it was written, as the stream might not support seeking.
+    std::sort(sectionTable.begin(), sectionTable.end(),
+              [](const SerializedSection& a, const SerializedSection& b) { return a.m_Offset < b.m_Offset; });
+    std::vector<uint8_t> data;
+    for (const SerializedSection& section : sectionTable)
+    {
+        if (section.m_Offset < position)
+        {
+            throw std::invalid_argument("Serialized Compiled Network has overlapping sections");
+        }
+        if (section.m_Offset > size || section.m_Size > size - section.m_Offset)
+        {
+            throw std::invalid_argument("Serialized Compiled Network is truncated");
+        }
+        in.ignore(static_cast<std::streamsize>(section.m_Offset - position));
+        data.resize(section.m_Size);
+        in.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(section.m_Size));
+        if (!in)
+        {
+            throw std::invalid_argument("Serialized Compiled Network is truncated");
+        }
+        position = section.m_Offset + section.m_Size;
+
+        switch (section.m_Type)
+        {
+            case SerializedSectionType::ConstantDmaData:
+                m_ConstantDmaData.swap(data);
+                break;
+            case SerializedSectionType::ConstantControlUnitData:
+                m_ConstantControlUnitData.swap(data);
+                break;
+            case SerializedSectionType::InputBufferInfos:
+                DeserializeSection(section, data.data(), m_InputBufferInfos);
+                break;
+            case SerializedSectionType::OutputBufferInfos:
+                DeserializeSection(section, data.data(), m_OutputBufferInfos);
+                break;
+            case SerializedSectionType::ConstantControlUnitDataBufferInfos:
+                DeserializeSection(section, data.data(), m_ConstantControlUnitDataBufferInfos);
+                break;
+            case SerializedSectionType::ConstantDmaDataBufferInfos:
+                DeserializeSection(section, data.data(), m_ConstantDmaDataBufferInfos);
+                break;
+            case SerializedSectionType::IntermediateDataBufferInfos:
+                DeserializeSection(section, data.data(), m_IntermediateDataBufferInfos);
+                break;
+            default:
+                // Sections added by later minor versions are skipped.
+                break;
+        }
+    }
+}
 
+void CompiledNetworkImpl::Deserialize(const uint8_t* data, size_t size, std::shared_ptr<const void> owner)
+{
+    uint32_t versionSize = 0;
+    if (size >= sizeof(versionSize))
+    {
+        std::memcpy(&versionSize, data, sizeof(versionSize));
+    }
+    if (versionSize < g_LegacyMaxVersionSize)
+    {
+        // The data in the legacy format isn't aligned, so it is copied.
+        MemoryStreamBuffer buffer(data, size);
+        std::istream in(&buffer);
+        Deserialize(in);
+        return;
+    }
+
+    SerializedHeader header;
+    if (size < sizeof(header))
+    {
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
+    }
+    std::memcpy(&header, data, sizeof(header));
+    CheckHeader(header);
+    if ((size - sizeof(header)) / sizeof(SerializedSection) < header.m_NumSections)
+    {
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
+    }
+
+    for (uint32_t i = 0; i < header.m_NumSections; ++i)
+    {
+        SerializedSection section;
+        std::memcpy(&section, data + sizeof(header) + i * sizeof(SerializedSection), sizeof(section));
+        if (section.m_Offset > size || section.m_Size > size - section.m_Offset)
+        {
+            throw std::invalid_argument("Serialized Compiled Network is truncated");
+        }
+        const uint8_t* sectionData = data + section.m_Offset;
+        const size_t sectionSize   = static_cast<size_t>(section.m_Size);
+
+        switch (section.m_Type)
+        {
+            case SerializedSectionType::ConstantDmaData:
+                m_ExternalConstantDmaData = { sectionData, sectionSize };
+                break;
+            case SerializedSectionType::ConstantControlUnitData:
+                m_ExternalConstantControlUnitData = { sectionData, sectionSize };
+                break;
+            case SerializedSectionType::InputBufferInfos:
+                DeserializeSection(section, sectionData, m_InputBufferInfos);
+                break;
+            case SerializedSectionType::OutputBufferInfos:
+                DeserializeSection(section, sectionData, m_OutputBufferInfos);
+                break;
+            case SerializedSectionType::ConstantControlUnitDataBufferInfos:
+                DeserializeSection(section, sectionData, m_ConstantControlUnitDataBufferInfos);
+                break;
+            case SerializedSectionType::ConstantDmaDataBufferInfos:
+                DeserializeSection(section, sectionData, m_ConstantDmaDataBufferInfos);
+                break;
+            case SerializedSectionType::IntermediateDataBufferInfos:
+                DeserializeSection(section, sectionData, m_IntermediateDataBufferInfos);
+                break;
+            default:
+                // Sections added by later minor versions are skipped.
+                break;
+        }
+    }
+    m_HasExternalConstantData = true;
+    m_ExternalDataOwner       = std::move(owner);
+}
+
+void CompiledNetworkImpl::DeserializeLegacy(std::istream& in, uint32_t versionSize)
+{
+    // This format was only written by versions 0.x of the support library, so the major version never matches the
+    // current one and CheckLibraryVersion can't be used. The layout of the data is the same for all of them.
+    char versionString[g_LegacyMaxVersionSize] = {};
+    in.read(versionString, versionSize);
+    if (!in)
+    {
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
+    }
+    const Version version(versionString);
+    if (version.Major != 0)
+    {
+        std::stringstream str;
+        str << "Compiled Network was serialized in the legacy format by Support Library version "
+            << version.ToString() << ", which never used that format" << std::endl;
         throw VersionMismatchException(str.str().c_str());
     }
 
@@ -663,8 +1089,12 @@ void CompiledNetworkImpl::Deserialize(std::istream& in)
 template <typename T>
 T CompiledNetworkImpl::Read(std::istream& in)
 {
-    T data;
+    T data{};
     in.read(reinterpret_cast<char*>(&data), sizeof(data));
+    if (!in)
+    {
+        throw std::invalid_argument("Serialized Compiled Network is truncated");
+    }
     return data;
 }
 
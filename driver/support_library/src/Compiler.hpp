@@ -8,13 +8,17 @@
 #include "BufferManager.hpp"
 #include "DebuggingContext.hpp"
 #include "Graph.hpp"
+#include "SramUsageReport.hpp"
+#include "ThreadPool.hpp"
 #include "Utils.hpp"
+#include "WeightEncoderCache.hpp"
 
 #include <ethosn_command_stream/CommandStreamBuffer.hpp>
 
 #include <cstdint>
 #include <cstring>
 #include <memory>
+#include <mutex>
 
 namespace ethosn
 {
@@ -70,6 +74,8 @@ private:
     /// Debugging
     /// @{
     void DumpGraph(const std::string& filename);
+    void DumpSramUsage();
+    void DumpConstantData();
     /// @}
 
     /// The input Network constructed by the user, set at creation time.
@@ -85,6 +91,13 @@ private:
     const DebuggingContext m_DebuggingContext;
     /// @}
 
+    /// Worker threads shared by all stages of the compilation.
+    ThreadPool m_ThreadPool;
+
+    /// Encoded weights shared by all stages of the compilation. This is either the cache given in the
+    /// CompilationOptions or, if there isn't one, a cache local to this Compiler.
+    std::shared_ptr<WeightEncoderCache> m_WeightEncoderCache;
+
     /// Performance estimation
     /// @{
     const EstimationOptions& m_EstimationOptions;
@@ -101,6 +114,8 @@ private:
     /// The list of Sections we have built up so far.
     std::vector<std::unique_ptr<Section>> m_Sections;
     BufferManager m_BufferManager;
+    /// How the SRAM was used by the passes. This is only recorded if it is going to be dumped.
+    std::unique_ptr<SramUsageReport> m_SramUsageReport;
     /// @}
 
     /// Performance information
@@ -126,22 +141,22 @@ public:
         , m_ConstantDmaDataBufferInfos()
         , m_IntermediateDataBufferInfos()
         , m_OperationIds()
+        , m_HasExternalConstantData(false)
+        , m_ExternalConstantDmaData()
+        , m_ExternalConstantControlUnitData()
+        , m_ExternalDataOwner()
+        , m_CopyExternalConstantDataFlag()
     {}
 
-    CompiledNetworkImpl(const std::vector<uint8_t>& constantDmaData,
-                        const std::vector<uint8_t>& constantControlUnitData,
+    CompiledNetworkImpl(std::vector<uint8_t> constantDmaData,
+                        std::vector<uint8_t> constantControlUnitData,
                         const std::map<uint32_t, CompilerBufferInfo>& buffers,
                         const std::set<uint32_t>& operationIds);
 
-    virtual const std::vector<uint8_t>& GetConstantDmaData() const override
-    {
-        return m_ConstantDmaData;
-    }
-
-    virtual const std::vector<uint8_t>& GetConstantControlUnitData() const override
-    {
-        return m_ConstantControlUnitData;
-    }
+    virtual const std::vector<uint8_t>& GetConstantDmaData() const override;
+    virtual const std::vector<uint8_t>& GetConstantControlUnitData() const override;
+    virtual DataView GetConstantDmaDataView() const override;
+    virtual DataView GetConstantControlUnitDataView() const override;
 
     virtual const std::set<uint32_t>& GetOperationIds() const override
     {
@@ -175,22 +190,34 @@ public:
 
     virtual uint32_t GetIntermediateDataSize() const override;
 
-    template <typename T>
-    void Serialize(std::ostream& out, const std::vector<T>& data) const;
-
     virtual void Serialize(std::ostream& out) const override;
 
+    /// Returns the version of the format written by Serialize(), which changes whenever the format does.
+    static uint32_t GetSerializedFormatVersion();
+
     template <typename T>
     void Deserialize(std::istream& in, std::vector<T>& data);
 
     virtual void Deserialize(std::istream& in);
 
+    /// Deserializes from memory, referring to the constant data in place (see DeserializeCompiledNetwork).
+    void Deserialize(const uint8_t* data, size_t size, std::shared_ptr<const void> owner);
+
 private:
     template <typename T>
     T Read(std::istream& in);
 
-    std::vector<uint8_t> m_ConstantDmaData;
-    std::vector<uint8_t> m_ConstantControlUnitData;
+    /// Reads the format used before Serialize() wrote a section table, once the size of the version string
+    /// at the start of it has been read.
+    void DeserializeLegacy(std::istream& in, uint32_t versionSize);
+    /// Copies the constant data which is referred to in place into the vectors, for the getters which return them.
+    void CopyExternalConstantData() const;
+
+    /// These are empty while the constant data is referred to in place, until they are first asked for.
+    /// @{
+    mutable std::vector<uint8_t> m_ConstantDmaData;
+    mutable std::vector<uint8_t> m_ConstantControlUnitData;
+    /// @}
 
     std::vector<InputBufferInfo> m_InputBufferInfos;
     std::vector<OutputBufferInfo> m_OutputBufferInfos;
@@ -200,6 +227,14 @@ private:
 
     std::set<uint32_t> m_OperationIds;
     std::map<uint32_t, std::string> m_OperationIdsFailureReasons;
+
+    /// Set when deserialized from memory, in which case the constant data is referred to in place rather than
+    /// held in m_ConstantDmaData and m_ConstantControlUnitData, and m_ExternalDataOwner keeps it alive.
+    bool m_HasExternalConstantData;
+    DataView m_ExternalConstantDmaData;
+    DataView m_ExternalConstantControlUnitData;
+    std::shared_ptr<const void> m_ExternalDataOwner;
+    mutable std::once_flag m_CopyExternalConstantDataFlag;
 };
 
 std::vector<std::unique_ptr<IStrategy>> GenerateAllowedStrategies(const CompilationOptions& m_Options);
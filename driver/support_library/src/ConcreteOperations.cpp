@@ -153,7 +153,7 @@ Constant::Constant(const detail::PosInNetwork pos, uint32_t id, const TensorInfo
     : VisitableOperation<Constant>(pos, id, {}, { info })
 {
     const uint8_t* begin = static_cast<const uint8_t*>(data);
-    m_Data.assign(begin, begin + utils::TotalSizeBytes(info));
+    m_Data               = std::make_shared<const std::vector<uint8_t>>(begin, begin + utils::TotalSizeBytes(info));
 }
 
 const support_library::TensorInfo& Constant::GetTensorInfo() const
@@ -162,6 +162,11 @@ const support_library::TensorInfo& Constant::GetTensorInfo() const
 }
 
 const std::vector<uint8_t>& Constant::GetDataVector() const
+{
+    return *m_Data;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> Constant::GetSharedDataVector() const
 {
     return m_Data;
 }
@@ -169,10 +174,10 @@ const std::vector<uint8_t>& Constant::GetDataVector() const
 template <typename T>
 std::vector<T> Constant::GetDataVectorAs() const
 {
-    assert(m_Data.size() % sizeof(T) == 0);    // Otherwise won't fit exactly in result type.
-    size_t numElements = m_Data.size() / sizeof(T);
+    assert(m_Data->size() % sizeof(T) == 0);    // Otherwise won't fit exactly in result type.
+    size_t numElements = m_Data->size() / sizeof(T);
     std::vector<T> result(numElements);
-    std::memcpy(result.data(), m_Data.data(), m_Data.size());
+    std::memcpy(result.data(), m_Data->data(), m_Data->size());
     return result;
 }
 
@@ -58,12 +58,16 @@ public:
 
     const void* GetData() const
     {
-        return m_Data.data();
+        return m_Data->data();
     }
 
     /// Gets the internal data.
     const std::vector<uint8_t>& GetDataVector() const;
 
+    /// Gets the internal data as shared storage, so that the nodes created from this constant can refer to the same
+    /// bytes rather than each taking a copy. The data is never modified.
+    std::shared_ptr<const std::vector<uint8_t>> GetSharedDataVector() const;
+
     /// Gets the internal data, reinterpreted as an array of the given type.
     /// Note this incurs a full copy of the data.
     template <typename T>
@@ -72,7 +76,7 @@ public:
     void Print(std::ostream& os) final;
 
 private:
-    std::vector<uint8_t> m_Data;
+    std::shared_ptr<const std::vector<uint8_t>> m_Data;
 };
 
 // Convolution operation
@@ -590,8 +590,13 @@ const std::vector<std::unique_ptr<ethosn::support_library::Node>>& Graph::GetNod
     return m_Nodes;
 }
 
-std::vector<Node*> Graph::GetNodesSorted() const
+const std::vector<Node*>& Graph::GetNodesSorted() const
 {
+    if (m_IsSortedNodesValid)
+    {
+        return m_SortedNodes;
+    }
+
     std::vector<Node*> targets;
     for (const auto& node : m_Nodes)
     {
@@ -600,7 +605,6 @@ std::vector<Node*> Graph::GetNodesSorted() const
             targets.push_back(node.get());
         }
     }
-    std::vector<Node*> sorted;
     utils::GraphTopologicalSort<Node*, std::vector<Node*>>(
         targets,
         [](Node* n) {
@@ -609,8 +613,9 @@ std::vector<Node*> Graph::GetNodesSorted() const
                            [](auto x) -> Node* { return x->GetSource(); });
             return result;
         },
-        sorted);
-    return sorted;
+        m_SortedNodes);
+    m_IsSortedNodesValid = true;
+    return m_SortedNodes;
 }
 
 const std::vector<std::unique_ptr<Edge>>& Graph::GetEdges() const
@@ -621,6 +626,11 @@ const std::vector<std::unique_ptr<Edge>>& Graph::GetEdges() const
 void Graph::AddNode(std::unique_ptr<Node> node)
 {
     m_Nodes.push_back(std::move(node));
+    m_IsSortedNodesValid = false;
+    if (m_Observer)
+    {
+        m_Observer->NodeAdded(m_Nodes.back().get());
+    }
 }
 
 void Graph::Connect(Node* source, Node* destination, int32_t insertionIdx)
@@ -638,6 +648,11 @@ void Graph::Connect(Node* source, Node* destination, int32_t insertionIdx)
     {
         destination->m_Inputs.insert(destination->m_Inputs.begin() + insertionIdx, e2);
     }
+    m_IsSortedNodesValid = false;
+    if (m_Observer)
+    {
+        m_Observer->EdgeAdded(source, destination);
+    }
 }
 
 void Graph::RemoveNode(Node* node)
@@ -652,16 +667,23 @@ void Graph::RemoveNode(Node* node)
     {
         RemoveEdge(e);
     }
+    if (m_Observer)
+    {
+        m_Observer->NodeRemoved(node);
+    }
     {
         auto it = std::find_if(m_Nodes.begin(), m_Nodes.end(),
                                [&](const std::unique_ptr<Node>& n) { return n.get() == node; });
         assert(it != m_Nodes.end());
         m_Nodes.erase(it);
     }
+    m_IsSortedNodesValid = false;
 }
 
 int32_t Graph::RemoveEdge(Edge* edge)
 {
+    Node* source      = edge->GetSource();
+    Node* destination = edge->GetDestination();
     {
         auto it = std::find(edge->GetSource()->m_Outputs.begin(), edge->GetSource()->m_Outputs.end(), edge);
         assert(it != edge->GetSource()->m_Outputs.end());
@@ -680,6 +702,11 @@ int32_t Graph::RemoveEdge(Edge* edge)
         assert(it != m_Edges.end());
         m_Edges.erase(it);
     }
+    m_IsSortedNodesValid = false;
+    if (m_Observer)
+    {
+        m_Observer->EdgeRemoved(source, destination);
+    }
     return index;
 }
 
@@ -744,6 +771,11 @@ void Graph::InsertNodeAfter(Node* position, Node* newNode)
     Connect(position, newNode);
 }
 
+void Graph::SetObserver(GraphObserver* observer)
+{
+    m_Observer = observer;
+}
+
 NodeId Graph::GenerateNodeId()
 {
     return m_NextNodeId++;
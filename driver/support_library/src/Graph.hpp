@@ -276,6 +276,23 @@ private:
     Node* m_Destination;
 };
 
+/// Receives notifications of the changes made to the structure of a Graph, for example to find the nodes which
+/// might be affected by a change without searching the whole graph.
+class GraphObserver
+{
+public:
+    virtual ~GraphObserver() = default;
+
+    /// Called after a node has been added to the graph (before it has any connections).
+    virtual void NodeAdded(Node* node) = 0;
+    /// Called just before a node is destroyed. It will already have been disconnected from all other nodes.
+    virtual void NodeRemoved(Node* node) = 0;
+    /// Called after an edge has been connected between the given nodes.
+    virtual void EdgeAdded(Node* source, Node* destination) = 0;
+    /// Called after an edge between the given nodes has been disconnected.
+    virtual void EdgeRemoved(Node* source, Node* destination) = 0;
+};
+
 class Graph
 {
 public:
@@ -283,12 +300,19 @@ public:
         : m_Nodes()
         , m_Edges()
         , m_NextNodeId(0)
+        , m_Observer(nullptr)
+        , m_SortedNodes()
+        , m_IsSortedNodesValid(false)
     {}
 
     Graph(const Network& network, const HardwareCapabilities& capabilities, const EstimationOptions& estimationOptions);
 
     const std::vector<std::unique_ptr<Node>>& GetNodes() const;
-    std::vector<Node*> GetNodesSorted() const;
+    /// Returns all the nodes in this graph, ordered such that every node comes after all of its inputs.
+    /// The order is cached and only recalculated after the graph has been changed, so repeated calls are cheap.
+    /// The returned reference is invalidated by any change to the graph, so take a copy if the graph is going to be
+    /// changed whilst iterating over it.
+    const std::vector<Node*>& GetNodesSorted() const;
 
     const std::vector<std::unique_ptr<Edge>>& GetEdges() const;
 
@@ -318,6 +342,10 @@ public:
     /// changed to come from 'position' instead.
     void InsertNodeAfter(Node* position, Node* newNode);
 
+    /// Sets the object which will be notified of all subsequent changes to this graph, replacing any previous one.
+    /// Pass nullptr to stop notifications.
+    void SetObserver(GraphObserver* observer);
+
     void DumpToDotFormat(std::ostream& stream) const;
 
 private:
@@ -327,6 +355,11 @@ private:
     std::vector<std::unique_ptr<Node>> m_Nodes;
     std::vector<std::unique_ptr<Edge>> m_Edges;
     NodeId m_NextNodeId;
+    GraphObserver* m_Observer;
+
+    /// Cache for GetNodesSorted(), which is cleared whenever a node or edge is added or removed.
+    mutable std::vector<Node*> m_SortedNodes;
+    mutable bool m_IsSortedNodesValid;
 };
 
 template <typename TNode, typename... Args>
@@ -10,6 +10,7 @@
 #include "McePlePass.hpp"
 #include "Pass.hpp"
 #include "Utils.hpp"
+#include "WeightEncoderCache.hpp"
 
 #include <ethosn_command_stream/PleOperation.hpp>
 
@@ -54,7 +55,8 @@ MceOperationNode* CreateIdentityMceOpNode(Graph& graph, Node* previousNode)
 
     MceOperationNode* result = graph.CreateAndAddNode<MceOperationNode>(
         previousNode->GetShape(), previousNode->GetShape(), previousNode->GetDataType(),
-        previousNode->GetQuantizationInfo(), weightInfo, weightsData, biasInfo, biasData, Stride{ 1, 1 }, 0, 0,
+        previousNode->GetQuantizationInfo(), weightInfo,
+        std::make_shared<const std::vector<uint8_t>>(std::move(weightsData)), biasInfo, biasData, Stride{ 1, 1 }, 0, 0,
         ethosn::command_stream::MceOperation::DEPTHWISE_CONVOLUTION, CompilerDataFormat::NHWCB,
         previousNode->GetCorrespondingOperationIds());
 
@@ -124,6 +126,11 @@ DotAttributes ConstantNode::GetDotAttributes()
 }
 
 const std::vector<uint8_t>& ConstantNode::GetConstantData() const
+{
+    return *m_ConstantData;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> ConstantNode::GetSharedConstantData() const
 {
     return m_ConstantData;
 }
@@ -139,7 +146,7 @@ MceOperationNode::MceOperationNode(NodeId id,
                                    DataType dataType,
                                    const QuantizationInfo& outputQuantizationInfo,
                                    const TensorInfo& weightsInfo,
-                                   std::vector<uint8_t> weightsData,
+                                   std::shared_ptr<const std::vector<uint8_t>> weightsData,
                                    const TensorInfo& biasInfo,
                                    std::vector<int32_t> biasData,
                                    Stride stride,
@@ -154,6 +161,8 @@ MceOperationNode::MceOperationNode(NodeId id,
     , m_WeightsData(std::move(weightsData))
     , m_BiasInfo(biasInfo)
     , m_BiasData(std::move(biasData))
+    , m_WeightsAndBiasHash(WeightEncoderCache::HashWeightsAndBias(m_WeightsData->data(), m_WeightsData->size(),
+                                                                  m_BiasData.data(), m_BiasData.size()))
     , m_Stride(stride)
     , m_UpscaleFactor(1U)
     , m_UpsampleType(command_stream::UpsampleType::OFF)
@@ -177,6 +186,11 @@ const ethosn::support_library::TensorInfo& MceOperationNode::GetWeightsInfo() co
 }
 
 const std::vector<uint8_t>& MceOperationNode::GetWeightsData() const
+{
+    return *m_WeightsData;
+}
+
+std::shared_ptr<const std::vector<uint8_t>> MceOperationNode::GetSharedWeightsData() const
 {
     return m_WeightsData;
 }
@@ -191,6 +205,11 @@ const std::vector<int32_t>& MceOperationNode::GetBiasData() const
     return m_BiasData;
 }
 
+const Sha256::Digest& MceOperationNode::GetWeightsAndBiasHash() const
+{
+    return m_WeightsAndBiasHash;
+}
+
 uint32_t MceOperationNode::GetPadTop() const
 {
     return m_PadTop;
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "Graph.hpp"
+#include "Sha256.hpp"
 
 #include <ethosn_command_stream/PleOperation.hpp>
 
@@ -69,7 +70,7 @@ class ConstantNode : public Node
 public:
     ConstantNode(NodeId id,
                  const TensorInfo& constantInfo,
-                 std::vector<uint8_t> constantData,
+                 std::shared_ptr<const std::vector<uint8_t>> constantData,
                  std::set<uint32_t> correspondingOperationIds)
         : Node(id,
                constantInfo.m_Dimensions,
@@ -78,10 +79,12 @@ public:
                ConvertExternalToCompilerDataFormat(constantInfo.m_DataFormat),
                correspondingOperationIds)
         , m_ConstantDataType(constantInfo.m_DataType)
-        , m_ConstantData(constantData)
+        , m_ConstantData(std::move(constantData))
     {}
 
     const std::vector<uint8_t>& GetConstantData() const;
+    /// Gets the data as shared storage, so that nodes created from this one can refer to it without a copy.
+    std::shared_ptr<const std::vector<uint8_t>> GetSharedConstantData() const;
     const DataType& GetConstantDataType() const;
 
     bool IsPrepared() override;
@@ -89,7 +92,9 @@ public:
 
 private:
     DataType m_ConstantDataType;
-    std::vector<uint8_t> m_ConstantData;
+    /// Constant data is immutable, so it is shared with the Constant operation it was created from (and any other
+    /// nodes using the same data) rather than copied.
+    std::shared_ptr<const std::vector<uint8_t>> m_ConstantData;
 };
 
 class MceOperationNode : public Node
@@ -101,7 +106,7 @@ public:
                      DataType dataType,
                      const QuantizationInfo& outputQuantizationInfo,
                      const TensorInfo& weightsInfo,
-                     std::vector<uint8_t> weightsData,
+                     std::shared_ptr<const std::vector<uint8_t>> weightsData,
                      const TensorInfo& biasInfo,
                      std::vector<int32_t> biasData,
                      Stride stride,
@@ -115,10 +120,15 @@ public:
 
     const TensorInfo& GetWeightsInfo() const;
     const std::vector<uint8_t>& GetWeightsData() const;
+    std::shared_ptr<const std::vector<uint8_t>> GetSharedWeightsData() const;
 
     const TensorInfo& GetBiasInfo() const;
     const std::vector<int32_t>& GetBiasData() const;
 
+    /// Gets the digest of the weight and bias data which identifies them in the WeightEncoderCache
+    /// (see WeightEncoderCache::HashWeightsAndBias). The data never changes, so this is only calculated once.
+    const Sha256::Digest& GetWeightsAndBiasHash() const;
+
     uint32_t GetPadTop() const;
     uint32_t GetPadLeft() const;
 
@@ -155,9 +165,11 @@ public:
 private:
     TensorShape m_UninterleavedInputShape;
     TensorInfo m_WeightsInfo;
-    std::vector<uint8_t> m_WeightsData;
+    /// Shared with the Constant the weights came from when they are used unmodified, and with any copies of this node.
+    std::shared_ptr<const std::vector<uint8_t>> m_WeightsData;
     TensorInfo m_BiasInfo;
     std::vector<int32_t> m_BiasData;
+    Sha256::Digest m_WeightsAndBiasHash;
     Stride m_Stride;
     uint32_t m_UpscaleFactor;
     ethosn::command_stream::UpsampleType m_UpsampleType;
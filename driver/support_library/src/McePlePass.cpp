@@ -8,6 +8,7 @@
 #include "Compiler.hpp"
 #include "StrategyX.hpp"
 #include "Utils.hpp"
+#include "WeightEncoderCache.hpp"
 #include "cascading/EstimationUtils.hpp"
 #include "cascading/MceEstimationUtils.hpp"
 
@@ -159,6 +160,146 @@ CompilerDataCompressedFormat GetIntermediateOutputCompressedFormat(const Hardwar
     return CompilerDataCompressedFormat::NONE;
 }
 
+command_stream::PleOperation GetPleOperation(const FuseOnlyPleOperationNode* pleOperation)
+{
+    // Get PLE code buffer - passthrough unless we have been fused with a PLE operation
+#if OFM_SCALING_BYPASS_ENABLE
+    (void)pleOperation;
+    return command_stream::PleOperation::OFM_SCALING;
+#else
+    return pleOperation ? pleOperation->GetKernelOperation() : command_stream::PleOperation::PASSTHROUGH;
+#endif
+}
+
+/// Where the output of an McePlePass which ends with the given node is kept, when using the given TensorConfig.
+BufferLocation GetOutputLocation(const TensorConfig& tensorConfig, const Node& lastNode)
+{
+    // If we can keep the output in SRAM then do so.
+    return tensorConfig.strategy == Strategy::STRATEGY_3 && lastNode.GetFormat() == CompilerDataFormat::NHWCB &&
+                   lastNode.GetLocationHint() != LocationHint::RequireDram
+               ? BufferLocation::Sram
+               : BufferLocation::Dram;
+}
+
+std::pair<uint32_t, uint32_t> GetWeightStripeSizeAndDepth(const MceOperationNode& mceOperation,
+                                                          const TensorShape& weightsStripeShape)
+{
+    const TensorInfo& weightsInfo = mceOperation.GetWeightsInfo();
+    // weight stripe size is needed for weight encoder if weight streaming.
+    uint32_t weightStripeSize = weightsStripeShape[2];
+
+    // Encode weights
+    uint32_t weightStripeDepth;
+    if (weightsInfo.m_DataFormat == DataFormat::HWIO)
+    {
+        weightStripeDepth = weightsStripeShape[3];
+    }
+    else if (weightsInfo.m_DataFormat == DataFormat::HWIM)
+    {
+        weightStripeDepth = weightsStripeShape[2] * weightsStripeShape[3] /
+                            (mceOperation.GetStride().m_X * mceOperation.GetStride().m_Y);
+    }
+    else
+    {
+        // Weight tensor must be HWIO or HWIM
+        assert(false);
+    }
+    return { weightStripeSize, weightStripeDepth };
+}
+
+/// Calculates the stats of an McePlePass made of the given nodes, using the given TensorConfig.
+/// This doesn't need the Pass to exist, so that it can also be used to compare TensorConfigs while choosing one.
+PassStats CalculateStats(const HardwareCapabilities& capabilities,
+                         const std::vector<Node*>& nodes,
+                         const MceOperationNode& mceOperation,
+                         command_stream::PleOperation pleOperation,
+                         const QuantizationInfo& quantizationInfo,
+                         const TensorConfig& tensorConfig,
+                         BufferLocation outputLocation,
+                         CompilerMceAlgorithm algorithm,
+                         const EstimationOptions& estimationOptions,
+                         ThreadPool& threadPool,
+                         WeightEncoderCache& weightEncoderCache)
+{
+    PassStats perfData;
+
+    const TensorShape& inputShape = mceOperation.GetInputShape(0);
+    const TensorShape& roundedUpInputShape =
+        nodes.front()->GetInputBufferFormat(0) != command_stream::DataFormat::NHWC
+            ? RoundUpHeightAndWidthToBrickGroup(inputShape)
+            : inputShape;
+    const TensorShape& inputStripeShape = tensorConfig.inputAllocation.stripeShape;
+    const BufferLocation inputLocation  = nodes.front()->GetInput(0)->GetSource()->GetLocation();
+    const uint32_t inputTileSize        = tensorConfig.inputAllocation.tileSize;
+
+    const TensorInfo& weightsInfo         = mceOperation.GetWeightsInfo();
+    const TensorShape& weightsStripeShape = tensorConfig.weightsAllocation.stripeShape;
+    const uint32_t weightsTileSize        = tensorConfig.weightsAllocation.tileSize;
+
+    const TensorShape& mceOutputShape = mceOperation.GetShape();
+
+    const TensorShape& outputShape          = nodes.back()->GetShape();
+    const TensorShape& roundedUpOutputShape = nodes.back()->GetBufferFormat() != command_stream::DataFormat::NHWC
+                                                  ? RoundUpHeightAndWidthToBrickGroup(outputShape)
+                                                  : outputShape;
+    const TensorShape& outputStripeShape = tensorConfig.outputAllocation.stripeShape;
+
+    // Number of output stripes affects the number of input data reloads for some streaming strategies.
+    uint32_t numOutStripeC = utils::DivRoundUp(outputShape[3], outputStripeShape[3]);
+
+    // Input data streaming statistics.
+    InputStats uncompressedInput =
+        GetInputStats(capabilities, roundedUpInputShape, inputStripeShape,
+                      inputLocation == BufferLocation::Dram ? Location::Dram : Location::Sram, inputTileSize,
+                      weightsInfo, numOutStripeC);
+
+    if (nodes.front()->GetInputCompressed(0))
+    {
+        perfData.m_Input =
+            AccountForActivationCompression(uncompressedInput, estimationOptions.m_ActivationCompressionSaving);
+    }
+    else
+    {
+        perfData.m_Input = uncompressedInput;
+    }
+
+    // Output data streaming statistics.
+    OutputStats uncompressedOutput =
+        GetOutputStats(roundedUpOutputShape, outputStripeShape,
+                       outputLocation == BufferLocation::Dram ? Location::Dram : Location::Sram);
+
+    if (nodes.back()->GetCompressed())
+    {
+        perfData.m_Output =
+            AccountForActivationCompression(uncompressedOutput, estimationOptions.m_ActivationCompressionSaving);
+    }
+    else
+    {
+        perfData.m_Output = uncompressedOutput;
+    }
+
+    // Calculate the size of the encoded weights to know the actual amount of data including headers.
+    uint32_t weightStripeSize;
+    uint32_t weightStripeDepth;
+    std::tie(weightStripeSize, weightStripeDepth) = GetWeightStripeSizeAndDepth(mceOperation, weightsStripeShape);
+    WeightEncoderCache::Params params =
+        WeightEncoderCache::GetParams(mceOperation, weightStripeDepth, weightStripeSize, quantizationInfo);
+    // The algorithm may not have been set on the node yet.
+    params.algorithm = algorithm;
+    EncodedWeightsSize encodedWeights = weightEncoderCache.EstimateEncodedSize(
+        capabilities, threadPool, params, GetWeightCompressionSaving(estimationOptions));
+
+    perfData.m_Weights = GetWeightsStats(capabilities, encodedWeights, weightsInfo, weightsStripeShape,
+                                         weightsTileSize, inputShape, inputStripeShape);
+
+    perfData.m_Mce = GetMceStats(capabilities, mceOperation.GetStride(), mceOperation.GetOperation(), algorithm,
+                                 inputShape, mceOutputShape, weightsInfo.m_Dimensions);
+
+    perfData.m_Ple = GetPleStats(capabilities, { mceOutputShape }, pleOperation);
+
+    return perfData;
+}
+
 }    // namespace
 
 std::vector<command_stream::BlockConfig>
@@ -348,7 +489,11 @@ LinearNodesOutput McePlePass::FindLinearWorkingNodes(Node* firstNode,
                                                      const HardwareCapabilities& capabilities,
                                                      std::vector<IStrategy*> allowedStrategies,
                                                      std::vector<command_stream::BlockConfig> allowedBlockConfigs,
-                                                     bool enableWinograd)
+                                                     bool enableWinograd,
+                                                     bool selectStrategyByCost,
+                                                     const EstimationOptions& estimationOptions,
+                                                     ThreadPool& threadPool,
+                                                     WeightEncoderCache& weightEncoderCache)
 {
     Node* current                              = firstNode;
     ExtractSubtensorNode* extractSubtensorNode = nullptr;
@@ -508,10 +653,33 @@ LinearNodesOutput McePlePass::FindLinearWorkingNodes(Node* firstNode,
             // The shape we pass to strategy selection is the *MCE* input shape.
             // Note this may be different to firstNode->GetShape() if we are taking our input from a supertensor.
             TensorShape mceInputShape = mceOperation->GetInputShape(0);
-            strategySelected          = ChooseAndSetupStrategy(
-                capabilities, currentSramAllocator, validStrategies, validBlockConfigs, tensorConfig, mceInputShape,
-                lastNode->GetShape(), mceOperation->GetWeightsInfo().m_DataFormat, weightsShape, shapeMultiplier,
-                inputStaticAndOffset, res.m_Algorithm, depthMax);
+            StrategySelectionCost selectionCost;
+            if (selectStrategyByCost)
+            {
+                auto lastRequantize = std::find_if(currentSetOfNodes.rbegin(), currentSetOfNodes.rend(),
+                                                   [](Node* n) { return dynamic_cast<RequantizeNode*>(n) != nullptr; });
+                const QuantizationInfo& quantizationInfo = lastRequantize == currentSetOfNodes.rend()
+                                                               ? mceOperation->GetQuantizationInfo()
+                                                               : (*lastRequantize)->GetQuantizationInfo();
+                auto getCost = [&](const TensorConfig& candidate) {
+                    const PassStats stats = CalculateStats(
+                        capabilities, currentSetOfNodes, *mceOperation, support_library::GetPleOperation(fuseOnlyPle),
+                        quantizationInfo, candidate, GetOutputLocation(candidate, *lastNode), res.m_Algorithm,
+                        estimationOptions, threadPool, weightEncoderCache);
+                    return GetPerformanceDataMetric(stats);
+                };
+                strategySelected = ChooseAndSetupStrategyByCost(
+                    capabilities, currentSramAllocator, validStrategies, validBlockConfigs, tensorConfig,
+                    mceInputShape, lastNode->GetShape(), mceOperation->GetWeightsInfo().m_DataFormat, weightsShape,
+                    shapeMultiplier, inputStaticAndOffset, res.m_Algorithm, depthMax, getCost, selectionCost);
+            }
+            else
+            {
+                strategySelected = ChooseAndSetupStrategy(
+                    capabilities, currentSramAllocator, validStrategies, validBlockConfigs, tensorConfig,
+                    mceInputShape, lastNode->GetShape(), mceOperation->GetWeightsInfo().m_DataFormat, weightsShape,
+                    shapeMultiplier, inputStaticAndOffset, res.m_Algorithm, depthMax);
+            }
 
             if (IsStrategyX(mceOperation->GetOperation(), mceOperation->GetUpsampleType(), tensorConfig,
                             res.m_Algorithm, validStrategies))
@@ -524,6 +692,8 @@ LinearNodesOutput McePlePass::FindLinearWorkingNodes(Node* firstNode,
                     capabilities, mceOperation->GetShapeMultiplier(),
                     (fuseOnlyPle != nullptr ? fuseOnlyPle->GetShapeMultiplier() : g_IdentityShapeMultiplier),
                     inputStaticAndOffset, depthMax);
+                // Strategy X is always used when possible, so it wasn't chosen by cost.
+                selectionCost = StrategySelectionCost();
             }
 
             if (strategySelected)
@@ -542,23 +712,17 @@ LinearNodesOutput McePlePass::FindLinearWorkingNodes(Node* firstNode,
                     requiredOutputFormat = CompilerDataFormat::NHWC;
                 }
 
-                if (tensorConfig.strategy == Strategy::STRATEGY_3 &&
-                    lastNode->GetFormat() == CompilerDataFormat::NHWCB &&
-                    lastNode->GetLocationHint() != LocationHint::RequireDram)
+                res.m_OutputLocation = GetOutputLocation(tensorConfig, *lastNode);
+                if (res.m_OutputLocation == BufferLocation::Sram)
                 {
-                    // If we can keep the output in SRAM then do so.
                     requiredOutputFormat = CompilerDataFormat::NHWCB;
-                    res.m_OutputLocation = BufferLocation::Sram;
                 }
-                else
-                {
-                    res.m_OutputLocation = BufferLocation::Dram;
-                }
-                res.m_WorkingNodes         = currentSetOfNodes;
-                res.m_SramAllocator        = currentSramAllocator;
-                res.m_RequiredOutputFormat = requiredOutputFormat;
-                res.m_TensorConfig         = tensorConfig;
-                res.m_ValidBlockConfigs    = validBlockConfigs;
+                res.m_WorkingNodes          = currentSetOfNodes;
+                res.m_SramAllocator         = currentSramAllocator;
+                res.m_RequiredOutputFormat  = requiredOutputFormat;
+                res.m_TensorConfig          = tensorConfig;
+                res.m_ValidBlockConfigs     = validBlockConfigs;
+                res.m_StrategySelectionCost = selectionCost;
             }
             res.m_StrategySelected = strategySelected;
             res.m_MceOperation     = mceOperation;
@@ -576,13 +740,18 @@ std::unique_ptr<ethosn::support_library::McePlePass>
                                std::vector<command_stream::BlockConfig> allowedBlockConfigs,
                                bool enableIntermediateCompression,
                                bool enableWinograd,
+                               bool selectStrategyByCost,
+                               const EstimationOptions& estimationOptions,
                                Node* firstNode,
                                SramAllocator& sramAllocator,
-                               bool forwardEst)
+                               bool forwardEst,
+                               ThreadPool& threadPool,
+                               WeightEncoderCache& weightEncoderCache)
 {
     // Find the largest set of linear nodes which can be formed into a pass
     LinearNodesOutput linearNodes = FindLinearWorkingNodes(firstNode, sramAllocator, capabilities, allowedStrategies,
-                                                           allowedBlockConfigs, enableWinograd);
+                                                           allowedBlockConfigs, enableWinograd, selectStrategyByCost,
+                                                           estimationOptions, threadPool, weightEncoderCache);
 
     // If we haven't found an MceOperation we can't do anything
     if (!linearNodes.m_MceOperation)
@@ -691,7 +860,8 @@ std::unique_ptr<ethosn::support_library::McePlePass>
 
     std::unique_ptr<ethosn::support_library::McePlePass> result = std::make_unique<McePlePass>(
         capabilities, id, linearNodes.m_WorkingNodes, linearNodes.m_TensorConfig, linearNodes.m_OutputLocation,
-        intermediateOutputCompressedFormat, linearNodes.m_Algorithm, sramOffset);
+        intermediateOutputCompressedFormat, linearNodes.m_Algorithm, sramOffset, threadPool, weightEncoderCache);
+    result->m_StrategySelectionCost = linearNodes.m_StrategySelectionCost;
 
     return result;
 }
@@ -703,13 +873,17 @@ McePlePass::McePlePass(const HardwareCapabilities& capabilities,
                        BufferLocation outputLocation,
                        CompilerDataCompressedFormat intermediateCompressedFormat,
                        CompilerMceAlgorithm algorithm,
-                       uint32_t sramOffset)
+                       uint32_t sramOffset,
+                       ThreadPool& threadPool,
+                       WeightEncoderCache& weightEncoderCache)
     : Pass(capabilities, id)
     , m_ExtractSubtensorNode(nullptr)
     , m_MceOperation(nullptr)
     , m_PleOperation(nullptr)
-    , m_WeightEncoder(WeightEncoder::CreateWeightEncoder(capabilities))
+    , m_ThreadPool(threadPool)
+    , m_WeightEncoderCache(weightEncoderCache)
     , m_TensorConfig(tensorConfig)
+    , m_StrategySelectionCost()
 {
     m_Nodes = nodes;
     for (auto node : nodes)
@@ -760,12 +934,7 @@ McePlePass::McePlePass(const HardwareCapabilities& capabilities,
 
 command_stream::PleOperation McePlePass::GetPleOperation() const
 {
-    // Get PLE code buffer - passthrough unless we have been fused with a PLE operation
-#if OFM_SCALING_BYPASS_ENABLE
-    return command_stream::PleOperation::OFM_SCALING;
-#else
-    return m_PleOperation ? m_PleOperation->GetKernelOperation() : command_stream::PleOperation::PASSTHROUGH;
-#endif
+    return support_library::GetPleOperation(m_PleOperation);
 }
 
 bool McePlePass::ChooseAndSetupStrategy(const HardwareCapabilities& capabilities,
@@ -808,6 +977,66 @@ bool McePlePass::ChooseAndSetupStrategy(const HardwareCapabilities& capabilities
     return strategySelected;
 }
 
+bool McePlePass::ChooseAndSetupStrategyByCost(const HardwareCapabilities& capabilities,
+                                              SramAllocator& sramAllocator,
+                                              const std::vector<IStrategy*>& allowedStrategies,
+                                              const std::vector<command_stream::BlockConfig>& allowedBlockConfigs,
+                                              TensorConfig& tensorConfig,
+                                              const TensorShape& inputShape,
+                                              const TensorShape& outputShape,
+                                              DataFormat weightsFormat,
+                                              const TensorShape& weightsShape,
+                                              const utils::ShapeMultiplier& shapeMultiplier,
+                                              std::pair<bool, uint32_t> inputStaticAndOffset,
+                                              CompilerMceAlgorithm algorithm,
+                                              const uint32_t depthMax,
+                                              const std::function<uint64_t(const TensorConfig&)>& getCost,
+                                              StrategySelectionCost& selectionCost)
+{
+    selectionCost                                      = StrategySelectionCost();
+    IStrategy* bestStrategy                            = nullptr;
+    const command_stream::BlockConfig* bestBlockConfig = nullptr;
+
+    for (IStrategy* strategy : allowedStrategies)
+    {
+        for (auto& currBlockConfig : allowedBlockConfigs)
+        {
+            // Each pair is set up from the same starting point, as if it was the only one tried, and then undone.
+            const SramAllocator::Checkpoint checkpoint = sramAllocator.CreateCheckpoint();
+            TensorConfig candidateTensorConfig;
+            const bool isSetup =
+                strategy->TrySetup(candidateTensorConfig, sramAllocator, inputShape, outputShape, weightsFormat,
+                                   weightsShape, currBlockConfig, capabilities, shapeMultiplier, inputStaticAndOffset,
+                                   algorithm, depthMax);
+            sramAllocator.Rollback(checkpoint);
+            if (!isSetup)
+            {
+                continue;
+            }
+            const uint64_t cost = getCost(candidateTensorConfig);
+            if (selectionCost.m_NumCandidates == 0 || cost < selectionCost.m_Metric)
+            {
+                selectionCost.m_Metric = cost;
+                bestStrategy           = strategy;
+                bestBlockConfig        = &currBlockConfig;
+            }
+            ++selectionCost.m_NumCandidates;
+        }
+    }
+
+    if (selectionCost.m_NumCandidates == 0)
+    {
+        return false;
+    }
+    // Set up the cheapest pair again, from the same starting point, which gives the same result as before.
+    const bool isSetup =
+        bestStrategy->TrySetup(tensorConfig, sramAllocator, inputShape, outputShape, weightsFormat, weightsShape,
+                               *bestBlockConfig, capabilities, shapeMultiplier, inputStaticAndOffset, algorithm,
+                               depthMax);
+    assert(isSetup);
+    return isSetup;
+}
+
 ethosn::support_library::DotAttributes McePlePass::GetDotAttributes()
 {
     DotAttributes result = Pass::GetDotAttributes();
@@ -838,33 +1067,19 @@ ethosn::support_library::DotAttributes McePlePass::GetDotAttributes()
         default:
             break;
     }
+    if (m_StrategySelectionCost.m_NumCandidates > 0)
+    {
+        result.m_Label += "\nBlock " + std::to_string(m_TensorConfig.blockWidth) + "x" +
+                          std::to_string(m_TensorConfig.blockHeight) + ", chosen by cost " +
+                          std::to_string(m_StrategySelectionCost.m_Metric) + " of " +
+                          std::to_string(m_StrategySelectionCost.m_NumCandidates) + " candidates";
+    }
     return result;
 }
 
 std::pair<uint32_t, uint32_t> McePlePass::GetWeightStripeSizeAndDepth()
 {
-    const TensorInfo& weightsInfo = m_MceOperation->GetWeightsInfo();
-    // weight stripe size is needed for weight encoder if weight streaming.
-    uint32_t weightStripeSize = m_TensorConfig.weightsAllocation.stripeShape[2];
-
-    // Encode weights
-    uint32_t weightStripeDepth;
-    if (weightsInfo.m_DataFormat == DataFormat::HWIO)
-    {
-        weightStripeDepth = m_TensorConfig.weightsAllocation.stripeShape[3];
-    }
-    else if (weightsInfo.m_DataFormat == DataFormat::HWIM)
-    {
-        weightStripeDepth = m_TensorConfig.weightsAllocation.stripeShape[2] *
-                            m_TensorConfig.weightsAllocation.stripeShape[3] /
-                            (m_MceOperation->GetStride().m_X * m_MceOperation->GetStride().m_Y);
-    }
-    else
-    {
-        // Weight tensor must be HWIO or HWIM
-        assert(false);
-    }
-    return { weightStripeSize, weightStripeDepth };
+    return support_library::GetWeightStripeSizeAndDepth(*m_MceOperation, m_TensorConfig.weightsAllocation.stripeShape);
 }
 
 void McePlePass::Generate(command_stream::CommandStreamBuffer& cmdStream, BufferManager& bufferManager, bool dumpRam)
@@ -946,18 +1161,21 @@ void McePlePass::Generate(command_stream::CommandStreamBuffer& cmdStream, Buffer
     uint32_t weightStripeSize;
     uint32_t weightStripeDepth;
     std::tie(weightStripeSize, weightStripeDepth) = GetWeightStripeSizeAndDepth();
-    EncodedWeights encodedWeights =
-        m_WeightEncoder->Encode(*m_MceOperation, weightStripeDepth, weightStripeSize, quantizationInfo);
-    std::vector<uint8_t>& compressedWeights = encodedWeights.m_Data;
-    uint32_t weightBufferId                 = bufferManager.AddDramConstant(BufferType::ConstantDma, compressedWeights);
+    std::shared_ptr<const EncodedWeights> encodedWeights = m_WeightEncoderCache.Encode(
+        m_Capabilities, m_ThreadPool,
+        WeightEncoderCache::GetParams(*m_MceOperation, weightStripeDepth, weightStripeSize, quantizationInfo));
+    // The buffer refers to the encoded weights held by the cache (keeping them alive) rather than taking a copy.
+    std::shared_ptr<const std::vector<uint8_t>> compressedWeights(encodedWeights, &encodedWeights->m_Data);
+    uint32_t weightBufferId = bufferManager.AddDramConstant(BufferType::ConstantDma, std::move(compressedWeights));
 
     // Add weight metadata to buffer table and command stream
-    std::vector<uint8_t> metadataBytes;
-    metadataBytes.assign(
-        reinterpret_cast<const uint8_t*>(encodedWeights.m_Metadata.data()),
-        reinterpret_cast<const uint8_t*>(encodedWeights.m_Metadata.data() + encodedWeights.m_Metadata.size()));
+    auto metadataBytes = std::make_shared<std::vector<uint8_t>>();
+    metadataBytes->assign(
+        reinterpret_cast<const uint8_t*>(encodedWeights->m_Metadata.data()),
+        reinterpret_cast<const uint8_t*>(encodedWeights->m_Metadata.data() + encodedWeights->m_Metadata.size()));
 
-    uint32_t weightMetadataBufferId    = bufferManager.AddDramConstant(BufferType::ConstantControlUnit, metadataBytes);
+    uint32_t weightMetadataBufferId =
+        bufferManager.AddDramConstant(BufferType::ConstantControlUnit, std::move(metadataBytes));
     convCmd.m_WeightMetadataBufferId() = weightMetadataBufferId;
 
     convCmd.m_InputInfo().m_DataType()         = ConvertDataType(m_Nodes.front()->GetInputDataType(0));
@@ -1144,84 +1362,13 @@ void McePlePass::Generate(command_stream::CommandStreamBuffer& cmdStream, Buffer
 
 PassStats McePlePass::GetStats(const EstimationOptions& estimationOptions)
 {
-    PassStats perfData;
-
-    const TensorShape& inputShape = m_MceOperation->GetInputShape(0);
-    const TensorShape& roundedUpInputShape =
-        m_Nodes.front()->GetInputBufferFormat(0) != command_stream::DataFormat::NHWC
-            ? RoundUpHeightAndWidthToBrickGroup(inputShape)
-            : inputShape;
-    const TensorShape& inputStripeShape = m_TensorConfig.inputAllocation.stripeShape;
-    const BufferLocation inputLocation  = m_Nodes.front()->GetInput(0)->GetSource()->GetLocation();
-    const uint32_t inputTileSize        = m_TensorConfig.inputAllocation.tileSize;
-
-    const TensorInfo& weightsInfo         = m_MceOperation->GetWeightsInfo();
-    const TensorShape& weightsStripeShape = m_TensorConfig.weightsAllocation.stripeShape;
-    const uint32_t weightsTileSize        = m_TensorConfig.weightsAllocation.tileSize;
-
-    const TensorShape& mceOutputShape = m_MceOperation->GetShape();
-
-    const TensorShape& outputShape          = m_Nodes.back()->GetShape();
-    const TensorShape& roundedUpOutputShape = m_Nodes.back()->GetBufferFormat() != command_stream::DataFormat::NHWC
-                                                  ? RoundUpHeightAndWidthToBrickGroup(outputShape)
-                                                  : outputShape;
-    const TensorShape& outputStripeShape = m_TensorConfig.outputAllocation.stripeShape;
-    const BufferLocation outputLocation  = m_Nodes.back()->GetLocation();
-
-    // Number of output stripes affects the number of input data reloads for some streaming strategies.
-    uint32_t numOutStripeC = utils::DivRoundUp(outputShape[3], outputStripeShape[3]);
-
-    // Input data streaming statistics.
-    InputStats uncompressedInput =
-        GetInputStats(m_Capabilities, roundedUpInputShape, inputStripeShape,
-                      inputLocation == BufferLocation::Dram ? Location::Dram : Location::Sram, inputTileSize,
-                      weightsInfo, numOutStripeC);
-
-    if (m_Nodes.front()->GetInputCompressed(0))
-    {
-        perfData.m_Input =
-            AccountForActivationCompression(uncompressedInput, estimationOptions.m_ActivationCompressionSaving);
-    }
-    else
-    {
-        perfData.m_Input = uncompressedInput;
-    }
-
-    // Output data streaming statistics.
-    OutputStats uncompressedOutput =
-        GetOutputStats(roundedUpOutputShape, outputStripeShape,
-                       outputLocation == BufferLocation::Dram ? Location::Dram : Location::Sram);
-
-    if (m_Nodes.back()->GetCompressed())
-    {
-        perfData.m_Output =
-            AccountForActivationCompression(uncompressedOutput, estimationOptions.m_ActivationCompressionSaving);
-    }
-    else
-    {
-        perfData.m_Output = uncompressedOutput;
-    }
-
     const QuantizationInfo& quantizationInfo = m_RequantizeNodes.empty()
                                                    ? m_MceOperation->GetQuantizationInfo()
                                                    : m_RequantizeNodes.back()->GetQuantizationInfo();
 
-    // Encode weights to know the actual amount of data including headers.
-    uint32_t weightStripeSize;
-    uint32_t weightStripeDepth;
-    std::tie(weightStripeSize, weightStripeDepth) = GetWeightStripeSizeAndDepth();
-    EncodedWeights encodedWeights =
-        m_WeightEncoder->Encode(*m_MceOperation, weightStripeDepth, weightStripeSize, quantizationInfo);
-
-    perfData.m_Weights = GetWeightsStats(m_Capabilities, encodedWeights, weightsInfo, weightsStripeShape,
-                                         weightsTileSize, inputShape, inputStripeShape);
-
-    perfData.m_Mce = GetMceStats(m_Capabilities, m_MceOperation->GetStride(), m_MceOperation->GetOperation(),
-                                 m_MceOperation->GetAlgorithm(), inputShape, mceOutputShape, weightsInfo.m_Dimensions);
-
-    perfData.m_Ple = GetPleStats(m_Capabilities, { mceOutputShape }, GetPleOperation());
-
-    return perfData;
+    return CalculateStats(m_Capabilities, m_Nodes, *m_MceOperation, GetPleOperation(), quantizationInfo,
+                          m_TensorConfig, m_Nodes.back()->GetLocation(), m_MceOperation->GetAlgorithm(),
+                          estimationOptions, m_ThreadPool, m_WeightEncoderCache);
 }
 
 }    // namespace support_library
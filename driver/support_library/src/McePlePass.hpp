@@ -10,6 +10,8 @@
 
 #include <ethosn_command_stream/PleOperation.hpp>
 
+#include <functional>
+
 namespace ethosn
 {
 namespace support_library
@@ -19,6 +21,18 @@ class FuseOnlyPleOperationNode;
 class FormatConversionNode;
 class McePostProcessOperationNode;
 class RequantizeNode;
+class ThreadPool;
+class WeightEncoderCache;
+
+/// How the strategy and block config of an McePlePass were chosen, when they were chosen by cost rather than by
+/// taking the first which fits in SRAM.
+struct StrategySelectionCost
+{
+    /// The number of (strategy, block config) pairs which fit in SRAM. Zero if they weren't chosen by cost.
+    uint32_t m_NumCandidates = 0;
+    /// The performance metric (see utils::GetPerformanceDataMetric) of the pair chosen, which is the lowest.
+    uint64_t m_Metric = 0;
+};
 
 struct LinearNodesOutput
 {
@@ -34,6 +48,7 @@ struct LinearNodesOutput
     SramAllocator m_SramAllocator;
     CompilerMceAlgorithm m_Algorithm = CompilerMceAlgorithm::None;
     std::vector<command_stream::BlockConfig> m_ValidBlockConfigs;
+    StrategySelectionCost m_StrategySelectionCost;
 };
 
 /// A set of operations which are evaluated by Ethos-N in a single "pass" through the MCE and PLE.
@@ -49,9 +64,13 @@ public:
                                                       std::vector<command_stream::BlockConfig> allowedBlockConfigs,
                                                       bool enableIntermediateCompression,
                                                       bool enableWinograd,
+                                                      bool selectStrategyByCost,
+                                                      const EstimationOptions& estimationOptions,
                                                       Node* firstNode,
                                                       SramAllocator& sramAllocator,
-                                                      bool forwardEst);
+                                                      bool forwardEst,
+                                                      ThreadPool& threadPool,
+                                                      WeightEncoderCache& weightEncoderCache);
 
     McePlePass(const HardwareCapabilities& capabilities,
                size_t id,
@@ -60,7 +79,9 @@ public:
                BufferLocation outputLocation,
                CompilerDataCompressedFormat intermediateCompressedFormat,
                CompilerMceAlgorithm algorithm,
-               uint32_t sramOffset);
+               uint32_t sramOffset,
+               ThreadPool& threadPool,
+               WeightEncoderCache& weightEncoderCache);
 
     /// Generates this Pass by adding appropriate entries to the given command stream, memory map and buffer table.
     void Generate(command_stream::CommandStreamBuffer& cmdStream, BufferManager& bufferManager, bool dumpRam) override;
@@ -81,13 +102,37 @@ public:
                                        CompilerMceAlgorithm algorithm,
                                        const uint32_t depthMax = UINT32_MAX);
 
+    /// Like ChooseAndSetupStrategy, but rather than setting up the first strategy and block config which fit in SRAM,
+    /// tries them all and sets up the pair for which getCost returns the lowest value. Ties are resolved in the order
+    /// that ChooseAndSetupStrategy would try them. Each pair is tried from the state sramAllocator is in when called,
+    /// and sramAllocator is left unchanged if none fit.
+    static bool ChooseAndSetupStrategyByCost(const HardwareCapabilities& capabilities,
+                                             SramAllocator& sramAllocator,
+                                             const std::vector<IStrategy*>& allowedStrategies,
+                                             const std::vector<command_stream::BlockConfig>& allowedBlockConfigs,
+                                             TensorConfig& tensorConfig,
+                                             const TensorShape& inputShape,
+                                             const TensorShape& outputShape,
+                                             DataFormat weightsFormat,
+                                             const TensorShape& weightsShape,
+                                             const utils::ShapeMultiplier& shapeMultiplier,
+                                             std::pair<bool, uint32_t> inputStaticAndOffset,
+                                             CompilerMceAlgorithm algorithm,
+                                             const uint32_t depthMax,
+                                             const std::function<uint64_t(const TensorConfig&)>& getCost,
+                                             StrategySelectionCost& selectionCost);
+
 private:
     static LinearNodesOutput FindLinearWorkingNodes(Node* firstNode,
                                                     const SramAllocator& sramAllocator,
                                                     const HardwareCapabilities& capabilities,
                                                     std::vector<IStrategy*> allowedStrategies,
                                                     std::vector<command_stream::BlockConfig> allowedBlockConfigs,
-                                                    bool enableWinograd);
+                                                    bool enableWinograd,
+                                                    bool selectStrategyByCost,
+                                                    const EstimationOptions& estimationOptions,
+                                                    ThreadPool& threadPool,
+                                                    WeightEncoderCache& weightEncoderCache);
     // Update the set of block configs to those that are valid for the selected Mce operation or algorithm,
     // e.g.Winograd, FullyConnected
     static std::vector<command_stream::BlockConfig>
@@ -116,10 +161,12 @@ private:
     std::vector<FormatConversionNode*> m_PostConversionNodes;
     std::vector<RequantizeNode*> m_RequantizeNodes;
 
-    std::unique_ptr<WeightEncoder> m_WeightEncoder;
+    ThreadPool& m_ThreadPool;
+    WeightEncoderCache& m_WeightEncoderCache;
 
     /// Tensor sram allocation information
     TensorConfig m_TensorConfig;
+    StrategySelectionCost m_StrategySelectionCost;
 };
 
 }    // namespace support_library
@@ -7,7 +7,7 @@
 
 #include "GraphNodes.hpp"
 #include "Utils.hpp"
-#include "cascading/MceEstimationUtils.hpp"
+#include "WeightEncoder.hpp"
 
 using namespace ethosn::support_library::utils;
 
@@ -105,7 +105,7 @@ std::vector<Node*> CreateTransposeConv(Graph& graph,
 
         MceOperationNode* identityDepthwiseNode = graph.CreateAndAddNode<MceOperationNode>(
             inputShape, intermediateOutputShape, inputInfo.m_DataType, inputInfo.m_QuantizationInfo, weightInfo,
-            weightsData, biasInfo, biasData, Stride(), 0, 0,
+            std::make_shared<const std::vector<uint8_t>>(std::move(weightsData)), biasInfo, biasData, Stride(), 0, 0,
             ethosn::command_stream::MceOperation::DEPTHWISE_CONVOLUTION, CompilerDataFormat::NHWCB,
             std::set<uint32_t>{ sourceOperationId });
         nodes.push_back(identityDepthwiseNode);
@@ -136,7 +136,8 @@ std::vector<Node*> CreateTransposeConv(Graph& graph,
 
     MceOperationNode* convNode = graph.CreateAndAddNode<MceOperationNode>(
         inputShape, outputInfo.m_Dimensions, outputInfo.m_DataType, outputInfo.m_QuantizationInfo, weightsInfo,
-        flippedWeightsData, biasInfo, std::move(biasData), Stride(), topMcePadding, leftMcePadding,
+        std::make_shared<const std::vector<uint8_t>>(std::move(flippedWeightsData)), biasInfo, std::move(biasData),
+        Stride(), topMcePadding, leftMcePadding,
         command_stream::MceOperation::CONVOLUTION, CompilerDataFormat::NHWCB, std::set<uint32_t>{ sourceOperationId });
 
     convNode->SetUpsampleParams(upscaleFactor, upsampleType);
@@ -317,10 +318,16 @@ void NetworkToGraphConverter::Visit(Requantize& requantize)
 namespace
 {
 
-std::vector<uint8_t> Pad(const std::vector<uint8_t>& input, size_t newSize, uint8_t padValue)
+/// Returns the input itself (rather than a copy) if it is already the requested size.
+std::shared_ptr<const std::vector<uint8_t>>
+    Pad(const std::shared_ptr<const std::vector<uint8_t>>& input, size_t newSize, uint8_t padValue)
 {
-    std::vector<uint8_t> result = input;
-    result.resize(newSize, padValue);
+    if (input->size() == newSize)
+    {
+        return input;
+    }
+    auto result = std::make_shared<std::vector<uint8_t>>(*input);
+    result->resize(newSize, padValue);
     return result;
 }
 
@@ -386,14 +393,14 @@ void NetworkToGraphConverter::Visit(FullyConnected& fullyConnected)
     // it is less desirable.
     TensorInfo weightsInfo      = fullyConnected.GetWeights().GetTensorInfo();
     weightsInfo.m_Dimensions[2] = utils::RoundUpToNearestMultiple(weightsInfo.m_Dimensions[2], g_WeightsChannelVecProd);
-    std::vector<uint8_t> paddedWeightsData =
-        Pad(fullyConnected.GetWeights().GetDataVector(), utils::TotalSizeBytes(weightsInfo),
+    std::shared_ptr<const std::vector<uint8_t>> paddedWeightsData =
+        Pad(fullyConnected.GetWeights().GetSharedDataVector(), utils::TotalSizeBytes(weightsInfo),
             static_cast<uint8_t>(weightsInfo.m_QuantizationInfo.GetZeroPoint()));
 
     Node* fcNode = m_Graph.CreateAndAddNode<MceOperationNode>(
         inputTensorInfo.m_Dimensions, outputTensorInfo.m_Dimensions, inputTensorInfo.m_DataType,
-        outputTensorInfo.m_QuantizationInfo, weightsInfo, MaybeOverrideWeights(paddedWeightsData, weightsInfo),
-        fullyConnected.GetBias().GetTensorInfo(), fullyConnected.GetBias().GetDataVectorAs<int32_t>(), Stride(), 0, 0,
+        outputTensorInfo.m_QuantizationInfo, weightsInfo, paddedWeightsData, fullyConnected.GetBias().GetTensorInfo(),
+        fullyConnected.GetBias().GetDataVectorAs<int32_t>(), Stride(), 0, 0,
         command_stream::MceOperation::FULLY_CONNECTED, CompilerDataFormat::NHWCB,
         std::set<uint32_t>{ fullyConnected.GetId() });
     nodes.push_back(fcNode);
@@ -605,8 +612,8 @@ void NetworkToGraphConverter::Visit(Split& split)
 
 void NetworkToGraphConverter::Visit(Constant& constant)
 {
-    Node* constantNode = m_Graph.CreateAndAddNode<ConstantNode>(constant.GetTensorInfo(), constant.GetDataVector(),
-                                                                std::set<uint32_t>{ constant.GetId() });
+    Node* constantNode = m_Graph.CreateAndAddNode<ConstantNode>(
+        constant.GetTensorInfo(), constant.GetSharedDataVector(), std::set<uint32_t>{ constant.GetId() });
 
     ConnectNode(constant, constantNode);
 }
@@ -682,8 +689,8 @@ void NetworkToGraphConverter::Visit(DepthwiseConvolution& depthwiseConvolution)
         depthwiseConvolution.GetOutput(0).GetTensorInfo().m_Dimensions,
         depthwiseConvolution.GetOutput(0).GetTensorInfo().m_DataType,
         depthwiseConvolution.GetOutput(0).GetTensorInfo().m_QuantizationInfo, weightInfo,
-        MaybeOverrideWeights(depthwiseConvolution.GetWeights().GetDataVector(), weightInfo),
-        depthwiseConvolution.GetBias().GetTensorInfo(), depthwiseConvolution.GetBias().GetDataVectorAs<int32_t>(),
+        depthwiseConvolution.GetWeights().GetSharedDataVector(), depthwiseConvolution.GetBias().GetTensorInfo(),
+        depthwiseConvolution.GetBias().GetDataVectorAs<int32_t>(),
         depthwiseConvolution.GetConvolutionInfo().m_Stride, depthwiseConvolution.GetConvolutionInfo().m_Padding.m_Top,
         depthwiseConvolution.GetConvolutionInfo().m_Padding.m_Left, operation, CompilerDataFormat::NHWCB,
         std::set<uint32_t>{ depthwiseConvolution.GetId() });
@@ -742,8 +749,8 @@ void NetworkToGraphConverter::Visit(Convolution& convolution)
         convolution.GetInput(0).GetTensorInfo().m_Dimensions, convolution.GetOutput(0).GetTensorInfo().m_Dimensions,
         convolution.GetOutput(0).GetTensorInfo().m_DataType,
         convolution.GetOutput(0).GetTensorInfo().m_QuantizationInfo, convolution.GetWeights().GetTensorInfo(),
-        MaybeOverrideWeights(convolution.GetWeights().GetDataVector(), convolution.GetWeights().GetTensorInfo()),
-        convolution.GetBias().GetTensorInfo(), convolution.GetBias().GetDataVectorAs<int32_t>(),
+        convolution.GetWeights().GetSharedDataVector(), convolution.GetBias().GetTensorInfo(),
+        convolution.GetBias().GetDataVectorAs<int32_t>(),
         convolution.GetConvolutionInfo().m_Stride, convolution.GetConvolutionInfo().m_Padding.m_Top,
         convolution.GetConvolutionInfo().m_Padding.m_Left, command_stream::MceOperation::CONVOLUTION,
         CompilerDataFormat::NHWCB, std::set<uint32_t>{ convolution.GetId() });
@@ -956,8 +963,9 @@ void NetworkToGraphConverter::Visit(Resize& resize)
 
     MceOperationNode* resizeNode = m_Graph.CreateAndAddNode<MceOperationNode>(
         inputShape, outputInfo.m_Dimensions, outputInfo.m_DataType, outputInfo.m_QuantizationInfo, weightInfo,
-        weightsData, biasInfo, biasData, Stride(), 0, 0, ethosn::command_stream::MceOperation::DEPTHWISE_CONVOLUTION,
-        CompilerDataFormat::NHWCB, std::set<uint32_t>{ resize.GetId() });
+        std::make_shared<const std::vector<uint8_t>>(std::move(weightsData)), biasInfo, biasData, Stride(), 0, 0,
+        ethosn::command_stream::MceOperation::DEPTHWISE_CONVOLUTION, CompilerDataFormat::NHWCB,
+        std::set<uint32_t>{ resize.GetId() });
     nodes.push_back(resizeNode);
 
     // This is checked in IsSupported but let's make sure that here it using the only
@@ -1018,23 +1026,6 @@ void NetworkToGraphConverter::ConnectNodeChain(const Operation& operation, const
     }
 }
 
-std::vector<uint8_t> NetworkToGraphConverter::MaybeOverrideWeights(const std::vector<uint8_t>& userWeights,
-                                                                   const TensorInfo& weightsInfo) const
-
-{
-    if (m_EstimationOptions.has_value() && m_EstimationOptions.value().m_UseWeightCompressionOverride)
-    {
-        std::vector<uint8_t> dummyWeightData =
-            GenerateCompressibleData(userWeights.size(), m_EstimationOptions.value().m_WeightCompressionSaving,
-                                     weightsInfo.m_QuantizationInfo.GetZeroPoint());
-        return dummyWeightData;
-    }
-    else
-    {
-        return userWeights;
-    }
-}
-
 }    // namespace support_library
 
 }    // namespace ethosn
@@ -61,9 +61,6 @@ private:
     /// The first node in the list will have its inputs connected to the nodes representing the inputs of the Operation.
     void ConnectNodeChain(const Operation& operation, const std::vector<Node*>& linearNodes);
 
-    std::vector<uint8_t> MaybeOverrideWeights(const std::vector<uint8_t>& userWeights,
-                                              const TensorInfo& weightsInfo) const;
-
     /// For each Operand in the input Network that we have visited,
     /// this contains the corresponding Node in the resulting Graph that produces the equivalent of that Operand.
     std::unordered_map<const Operand*, Node*> m_OperandToNode;
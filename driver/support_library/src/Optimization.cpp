@@ -6,12 +6,238 @@
 #include "Optimization.hpp"
 
 #include "GraphNodes.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_set>
 
 namespace ethosn
 {
 namespace support_library
 {
 
+OptimizationWorklist::OptimizationWorklist(Graph& graph)
+    : m_Graph(graph)
+    , m_NextAfter(1)
+    , m_NextBefore(-1)
+{
+    const std::vector<Node*>& sorted = graph.GetNodesSorted();
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        const Position position{ i, 0 };
+        m_Positions[sorted[i]] = position;
+        m_Pending[position]    = sorted[i];
+    }
+    m_Graph.SetObserver(this);
+}
+
+OptimizationWorklist::~OptimizationWorklist()
+{
+    m_Graph.SetObserver(nullptr);
+}
+
+Node* OptimizationWorklist::Pop()
+{
+    if (m_Pending.empty())
+    {
+        return nullptr;
+    }
+    Node* node = m_Pending.begin()->second;
+    m_Pending.erase(m_Pending.begin());
+    return node;
+}
+
+void OptimizationWorklist::QueueAffectedNodes()
+{
+    // The affected nodes are those with edges which were added or removed, and the producers of their inputs,
+    // as these are what the rules look at when deciding whether to make a change.
+    for (Node* node : m_Touched)
+    {
+        if (m_Unplaced.erase(node) > 0)
+        {
+            // A new node which was never connected to anything can go anywhere, so put it first.
+            m_Positions[node] = Position{ 0, m_NextBefore-- };
+        }
+        m_Pending.emplace(m_Positions.at(node), node);
+        for (Edge* input : node->GetInputs())
+        {
+            Node* source = input->GetSource();
+            m_Pending.emplace(m_Positions.at(source), source);
+        }
+    }
+    m_Touched.clear();
+}
+
+bool OptimizationWorklist::IsBefore(Node* a, Node* b) const
+{
+    return m_Positions.at(a) < m_Positions.at(b);
+}
+
+void OptimizationWorklist::NodeAdded(Node* node)
+{
+    // The node is given a position once we know where it is connected.
+    m_Unplaced.insert(node);
+    m_Touched.push_back(node);
+}
+
+void OptimizationWorklist::NodeRemoved(Node* node)
+{
+    auto positionIt = m_Positions.find(node);
+    if (positionIt != m_Positions.end())
+    {
+        m_Pending.erase(positionIt->second);
+        m_Positions.erase(positionIt);
+    }
+    m_Unplaced.erase(node);
+    // Don't keep the pointer around, as a node created later could be given the same address.
+    m_Touched.erase(std::remove(m_Touched.begin(), m_Touched.end(), node), m_Touched.end());
+}
+
+void OptimizationWorklist::EdgeAdded(Node* source, Node* destination)
+{
+    m_Touched.push_back(source);
+    m_Touched.push_back(destination);
+
+    // A new node is placed right next to the first node it is connected to, so that the order stays valid without
+    // moving any other nodes.
+    if (m_Unplaced.count(source) > 0 && m_Unplaced.count(destination) > 0)
+    {
+        m_Unplaced.erase(source);
+        m_Positions[source] = Position{ 0, m_NextBefore-- };
+    }
+    if (m_Unplaced.erase(source) > 0)
+    {
+        m_Positions[source] = Position{ m_Positions.at(destination).first, m_NextBefore-- };
+    }
+    else if (m_Unplaced.erase(destination) > 0)
+    {
+        m_Positions[destination] = Position{ m_Positions.at(source).first, m_NextAfter++ };
+    }
+    else
+    {
+        Reorder(source, destination);
+    }
+}
+
+void OptimizationWorklist::EdgeRemoved(Node* source, Node* destination)
+{
+    // Removing an edge never invalidates the order.
+    m_Touched.push_back(source);
+    m_Touched.push_back(destination);
+}
+
+void OptimizationWorklist::Reorder(Node* source, Node* destination)
+{
+    const Position lowerBound = m_Positions.at(destination);
+    const Position upperBound = m_Positions.at(source);
+    if (upperBound < lowerBound)
+    {
+        return;
+    }
+
+    // Only the nodes which are positioned between the two ends of the new edge might need moving: those reachable
+    // from the destination which are before the source, and those which reach the source which are after the
+    // destination. The former are moved after the latter, keeping their relative order, using just the positions
+    // they already had between them.
+    std::vector<Node*> forward = FindNodesBetween(destination, lowerBound, upperBound, true);
+    std::vector<Node*> backward = FindNodesBetween(source, lowerBound, upperBound, false);
+
+    auto byPosition = [&](Node* a, Node* b) { return m_Positions.at(a) < m_Positions.at(b); };
+    std::sort(forward.begin(), forward.end(), byPosition);
+    std::sort(backward.begin(), backward.end(), byPosition);
+    std::vector<Node*> moved = backward;
+    moved.insert(moved.end(), forward.begin(), forward.end());
+
+    std::vector<Position> positions;
+    positions.reserve(moved.size());
+    for (Node* node : moved)
+    {
+        const Position position = m_Positions.at(node);
+        positions.push_back(position);
+    }
+    std::sort(positions.begin(), positions.end());
+
+    std::vector<Node*> pending;
+    for (Node* node : moved)
+    {
+        if (m_Pending.erase(m_Positions.at(node)) > 0)
+        {
+            pending.push_back(node);
+        }
+    }
+    for (size_t i = 0; i < moved.size(); ++i)
+    {
+        m_Positions[moved[i]] = positions[i];
+    }
+    for (Node* node : pending)
+    {
+        m_Pending.emplace(m_Positions.at(node), node);
+    }
+}
+
+std::vector<Node*> OptimizationWorklist::FindNodesBetween(Node* start,
+                                                          const Position& lowerBound,
+                                                          const Position& upperBound,
+                                                          bool followOutputs) const
+{
+    std::vector<Node*> result;
+    std::unordered_set<Node*> visited;
+    std::vector<Node*> stack = { start };
+    visited.insert(start);
+    while (!stack.empty())
+    {
+        Node* node = stack.back();
+        stack.pop_back();
+        result.push_back(node);
+        for (Edge* edge : followOutputs ? node->GetOutputs() : node->GetInputs())
+        {
+            Node* next              = followOutputs ? edge->GetDestination() : edge->GetSource();
+            const Position position = m_Positions.at(next);
+            // If the forward search reached the upper bound then the new edge would have made a cycle.
+            assert(!followOutputs || position != upperBound);
+            if ((followOutputs ? position < upperBound : lowerBound < position) && visited.insert(next).second)
+            {
+                stack.push_back(next);
+            }
+        }
+    }
+    return result;
+}
+
+void ApplyOptimizations(Graph& graph, const std::vector<OptimizationFunc>& rules)
+{
+    OptimizationWorklist worklist(graph);
+    while (Node* node = worklist.Pop())
+    {
+        for (const OptimizationFunc rule : rules)
+        {
+            if (rule(graph, node))
+            {
+                worklist.QueueAffectedNodes();
+                break;
+            }
+        }
+    }
+}
+
+void ApplyAllOptimizations(Graph& graph)
+{
+    const std::vector<OptimizationFunc> optimizationFuncs = {
+        &MergeFormatConversionNodes,
+        &MergeRequantizeNodes,
+        &ReorderReinterpretAndRequantizeNodes,
+        &ReorderConcatAndRequantizeNodes,
+        &MergeConcatNodes,
+        &RemoveUnconnectedNode,
+        &MergeConstantAndReinterpretNodes,
+        &MergeConstantAndFormatConversionNodes,
+        &ReplaceConstantAdditionWithDepthwise,
+    };
+
+    ApplyOptimizations(graph, optimizationFuncs);
+}
+
 bool MergeFormatConversionNodes(Graph& graph, Node* node)
 {
     // Two adjacent format conversions which perform opposite conversions can be eliminated:
@@ -190,8 +416,8 @@ bool MergeConstantAndReinterpretNodes(Graph& graph, Node* node)
         ReinterpretNode* reinterpetNode = dynamic_cast<ReinterpretNode*>(constantNode->GetOutput(0)->GetDestination());
         const TensorInfo constantInfo(reinterpetNode->GetShape(), constantNode->GetConstantDataType(), DataFormat::NHWC,
                                       constantNode->GetQuantizationInfo());
-        Node* newConstantNode = graph.CreateAndAddNode<ConstantNode>(constantInfo, constantNode->GetConstantData(),
-                                                                     node->GetCorrespondingOperationIds());
+        Node* newConstantNode = graph.CreateAndAddNode<ConstantNode>(
+            constantInfo, constantNode->GetSharedConstantData(), node->GetCorrespondingOperationIds());
         // preserve the operation ids from the nodes that are being removed
         newConstantNode->AddCorrespondingOperationIDs(reinterpetNode->GetCorrespondingOperationIds());
 
@@ -257,8 +483,8 @@ bool ReplaceConstantAdditionWithDepthwise(Graph& graph, Node* node)
                 const TensorInfo constantLayerInfo(constantNode->GetShape(), constantNode->GetConstantDataType(),
                                                    DataFormat::NHWC, constantNode->GetQuantizationInfo());
 
-                std::vector<uint8_t> constantLayerData = constantNode->GetConstantData();
-                const Padding& padding                 = { 0, 0, 0, 0 };
+                const std::vector<uint8_t>& constantLayerData = constantNode->GetConstantData();
+                const Padding& padding                        = { 0, 0, 0, 0 };
 
                 // Assume there is only one constant input (and only 2 inputs total).
                 // In this case the input to the depthwise will be the non constant one.
@@ -323,8 +549,9 @@ bool ReplaceConstantAdditionWithDepthwise(Graph& graph, Node* node)
                                 static_cast<int32_t>(std::round(fpValue / newConstantLayerScale)));
                         }
                         Node* mceNode = graph.CreateAndAddNode<MceOperationNode>(
-                            inputShape, outputShape, dataType, outputQuantInfo, weightInfo, weightsData,
-                            constantLayerInfo, newConstantLayerData, Stride{ 1, 1 }, padding.m_Top, padding.m_Left,
+                            inputShape, outputShape, dataType, outputQuantInfo, weightInfo,
+                            std::make_shared<const std::vector<uint8_t>>(std::move(weightsData)), constantLayerInfo,
+                            newConstantLayerData, Stride{ 1, 1 }, padding.m_Top, padding.m_Left,
                             ethosn::command_stream::MceOperation::DEPTHWISE_CONVOLUTION, CompilerDataFormat::NHWCB,
                             node->GetCorrespondingOperationIds());
 
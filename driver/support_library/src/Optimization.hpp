@@ -5,13 +5,85 @@
 
 #pragma once
 
+#include "Graph.hpp"
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
 namespace ethosn
 {
 namespace support_library
 {
 
-class Node;
-class Graph;
+/// A local rewrite rule. Attempts to change the graph around the given node, returning true if it made a change.
+/// Rules may only depend on the node, its neighbours and the inputs of the nodes it outputs to, as after a change only
+/// the nodes around it are visited again (see ApplyOptimizations).
+using OptimizationFunc = bool (*)(Graph& graph, Node* node);
+
+/// Applies the given rules to the graph until none of them make any further changes.
+/// For each node the rules are tried in the order given, and at most one is applied before moving on.
+/// The nodes are visited in topological order. After each change, the nodes with edges which were added or removed,
+/// and the producers of their inputs, are queued to be visited again, in their place in that order (see
+/// OptimizationWorklist). This way the rules are only tried again on the nodes around each change, rather than on the
+/// whole graph, although removing nodes and edges from the Graph still takes time linear in its size.
+void ApplyOptimizations(Graph& graph, const std::vector<OptimizationFunc>& rules);
+
+/// Applies all the rules below, as the compiler does before estimating the performance of the graph with cascading.
+void ApplyAllOptimizations(Graph& graph);
+
+/// The nodes still to be visited by ApplyOptimizations, in topological order.
+/// Observes the changes made to the graph to find the nodes which need visiting again, and to keep a topological order
+/// of the whole graph up to date without sorting it again. Each node has a position in this order, and when an edge
+/// is added against it only the nodes positioned between its two ends are moved (as in the algorithm of Pearce and
+/// Kelly). A new node is positioned next to the first node it is connected to.
+class OptimizationWorklist : public GraphObserver
+{
+public:
+    explicit OptimizationWorklist(Graph& graph);
+    ~OptimizationWorklist();
+
+    /// Returns the next node to visit, i.e. the first one in the order, or nullptr if there are none left.
+    Node* Pop();
+
+    /// Queues the nodes affected by the changes made since the last call, so that they are visited again.
+    void QueueAffectedNodes();
+
+    /// Returns true if a comes before b in the order, which every node comes after all of its inputs in.
+    bool IsBefore(Node* a, Node* b) const;
+
+    void NodeAdded(Node* node) override;
+    void NodeRemoved(Node* node) override;
+    void EdgeAdded(Node* source, Node* destination) override;
+    void EdgeRemoved(Node* source, Node* destination) override;
+
+private:
+    /// Nodes are ordered by the position in the sorted original graph, then by a second number which is used to put
+    /// new nodes just before or after an existing one.
+    using Position = std::pair<size_t, int64_t>;
+
+    /// Moves nodes so that the source of the new edge comes before its destination.
+    void Reorder(Node* source, Node* destination);
+    /// Finds the nodes reachable from start (in the given direction) which are positioned between the bounds.
+    std::vector<Node*> FindNodesBetween(Node* start,
+                                        const Position& lowerBound,
+                                        const Position& upperBound,
+                                        bool followOutputs) const;
+
+    Graph& m_Graph;
+    std::unordered_map<Node*, Position> m_Positions;
+    /// New nodes which haven't been connected to anything yet, so don't have a position.
+    std::unordered_set<Node*> m_Unplaced;
+    int64_t m_NextAfter;
+    int64_t m_NextBefore;
+    /// The nodes still to visit, by their position.
+    std::map<Position, Node*> m_Pending;
+    /// The nodes whose connections have changed since the last call to QueueAffectedNodes().
+    std::vector<Node*> m_Touched;
+};
 
 bool MergeFormatConversionNodes(Graph& graph, Node* node);
 bool MergeRequantizeNodes(Graph& graph, Node* node);
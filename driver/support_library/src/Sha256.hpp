@@ -0,0 +1,46 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace ethosn
+{
+namespace support_library
+{
+
+/// Calculates the SHA-256 digest (FIPS 180-4) of some data, which may be given in several pieces.
+/// This is used wherever data is identified by its hash alone (e.g. cached encoded weights), so that different
+/// data can't be mistaken for each other, whether by accident or by design.
+class Sha256
+{
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    Sha256();
+
+    /// Adds the given data to that being hashed.
+    void Update(const void* data, size_t numBytes);
+
+    /// Returns the digest of all the data added. No more data may be added afterwards.
+    Digest Finalize();
+
+    /// Returns the digest of the given data.
+    static Digest Hash(const void* data, size_t numBytes);
+
+private:
+    void ProcessBlock(const uint8_t* block);
+
+    std::array<uint32_t, 8> m_State;
+    std::array<uint8_t, 64> m_Block;
+    size_t m_BlockSize;
+    uint64_t m_TotalBytes;
+};
+
+}    // namespace support_library
+}    // namespace ethosn
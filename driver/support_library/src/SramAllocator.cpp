@@ -5,94 +5,386 @@
 
 #include "SramAllocator.hpp"
 
+#include "SramUsageReport.hpp"
+
 #include <algorithm>
 #include <cassert>
+#include <limits>
 
 namespace ethosn
 {
 namespace support_library
 {
 
-SramAllocator& SramAllocator::operator=(const SramAllocator& s)
+SramAllocator::FreeRegionTree::FreeRegionTree()
+    : m_Nodes()
+    , m_FreeNodes()
+    , m_Root(s_Nil)
+    , m_RandomState(1)
+{}
+
+void SramAllocator::FreeRegionTree::Clear()
+{
+    m_Nodes.clear();
+    m_FreeNodes.clear();
+    m_Root = s_Nil;
+}
+
+bool SramAllocator::FreeRegionTree::IsEmpty() const
+{
+    return m_Root == s_Nil;
+}
+
+void SramAllocator::FreeRegionTree::Insert(uint32_t begin, uint32_t end)
+{
+    // xorshift32
+    m_RandomState ^= m_RandomState << 13;
+    m_RandomState ^= m_RandomState >> 17;
+    m_RandomState ^= m_RandomState << 5;
+    const TreeNode treeNode = { { begin, end }, m_RandomState, end - begin, s_Nil, s_Nil };
+
+    NodeIdx node;
+    if (m_FreeNodes.empty())
+    {
+        node = static_cast<NodeIdx>(m_Nodes.size());
+        m_Nodes.push_back(treeNode);
+    }
+    else
+    {
+        node = m_FreeNodes.back();
+        m_FreeNodes.pop_back();
+        m_Nodes[node] = treeNode;
+    }
+
+    NodeIdx before;
+    NodeIdx after;
+    Split(m_Root, begin, before, after);
+    m_Root = Merge(Merge(before, node), after);
+}
+
+void SramAllocator::FreeRegionTree::Erase(uint32_t begin)
+{
+    NodeIdx before;
+    NodeIdx rest;
+    Split(m_Root, begin, before, rest);
+    NodeIdx erased;
+    NodeIdx after;
+    Split(rest, begin + 1, erased, after);
+    assert(erased != s_Nil && m_Nodes[erased].m_Left == s_Nil && m_Nodes[erased].m_Right == s_Nil);
+    m_FreeNodes.push_back(erased);
+    m_Root = Merge(before, after);
+}
+
+const SramAllocator::FreeRegionTree::Region* SramAllocator::FreeRegionTree::FindAtOrBefore(uint32_t offset) const
+{
+    const Region* result = nullptr;
+    NodeIdx node         = m_Root;
+    while (node != s_Nil)
+    {
+        if (m_Nodes[node].m_Region.m_Begin <= offset)
+        {
+            result = &m_Nodes[node].m_Region;
+            node   = m_Nodes[node].m_Right;
+        }
+        else
+        {
+            node = m_Nodes[node].m_Left;
+        }
+    }
+    return result;
+}
+
+const SramAllocator::FreeRegionTree::Region* SramAllocator::FreeRegionTree::FindAtOrAfter(uint32_t offset) const
+{
+    const Region* result = nullptr;
+    NodeIdx node         = m_Root;
+    while (node != s_Nil)
+    {
+        if (m_Nodes[node].m_Region.m_Begin >= offset)
+        {
+            result = &m_Nodes[node].m_Region;
+            node   = m_Nodes[node].m_Left;
+        }
+        else
+        {
+            node = m_Nodes[node].m_Right;
+        }
+    }
+    return result;
+}
+
+const SramAllocator::FreeRegionTree::Region* SramAllocator::FreeRegionTree::FindFirstFit(uint32_t size) const
+{
+    if (m_Root == s_Nil || GetMaxSize(m_Root) < size)
+    {
+        return nullptr;
+    }
+    // There is a region big enough under every node we go to, so we never need to backtrack.
+    // An empty child is never gone to, even for a zero size.
+    NodeIdx node = m_Root;
+    while (true)
+    {
+        const TreeNode& treeNode = m_Nodes[node];
+        if (treeNode.m_Left != s_Nil && GetMaxSize(treeNode.m_Left) >= size)
+        {
+            node = treeNode.m_Left;
+        }
+        else if (treeNode.m_Region.m_End - treeNode.m_Region.m_Begin >= size)
+        {
+            return &treeNode.m_Region;
+        }
+        else
+        {
+            node = treeNode.m_Right;
+        }
+    }
+}
+
+const SramAllocator::FreeRegionTree::Region* SramAllocator::FreeRegionTree::FindLastFit(uint32_t size) const
 {
-    this->m_Capacity   = s.m_Capacity;
-    this->m_FreeMemory = s.m_FreeMemory;
-    this->m_UsedMemory = s.m_UsedMemory;
-    return *this;
+    if (m_Root == s_Nil || GetMaxSize(m_Root) < size)
+    {
+        return nullptr;
+    }
+    NodeIdx node = m_Root;
+    while (true)
+    {
+        const TreeNode& treeNode = m_Nodes[node];
+        if (treeNode.m_Right != s_Nil && GetMaxSize(treeNode.m_Right) >= size)
+        {
+            node = treeNode.m_Right;
+        }
+        else if (treeNode.m_Region.m_End - treeNode.m_Region.m_Begin >= size)
+        {
+            return &treeNode.m_Region;
+        }
+        else
+        {
+            node = treeNode.m_Left;
+        }
+    }
 }
 
-std::pair<bool, uint32_t> SramAllocator::Allocate(uint32_t size, AllocationPreference pref, std::string debugName)
+std::vector<SramAllocator::FreeRegionTree::Region> SramAllocator::FreeRegionTree::GetRegions() const
 {
-    if (pref == AllocationPreference::Start)
+    std::vector<Region> result;
+    std::vector<NodeIdx> stack;
+    NodeIdx node = m_Root;
+    while (node != s_Nil || !stack.empty())
     {
-        for (auto range = m_FreeMemory.begin(); range != m_FreeMemory.end(); ++range)
+        while (node != s_Nil)
         {
-            if (size <= range->m_End - range->m_Begin)
+            stack.push_back(node);
+            node = m_Nodes[node].m_Left;
+        }
+        node = stack.back();
+        stack.pop_back();
+        result.push_back(m_Nodes[node].m_Region);
+        node = m_Nodes[node].m_Right;
+    }
+    return result;
+}
+
+uint32_t SramAllocator::FreeRegionTree::GetMaxSize(NodeIdx node) const
+{
+    return node == s_Nil ? 0 : m_Nodes[node].m_MaxSize;
+}
+
+void SramAllocator::FreeRegionTree::Update(NodeIdx node)
+{
+    TreeNode& treeNode = m_Nodes[node];
+    treeNode.m_MaxSize = std::max({ treeNode.m_Region.m_End - treeNode.m_Region.m_Begin, GetMaxSize(treeNode.m_Left),
+                                    GetMaxSize(treeNode.m_Right) });
+}
+
+void SramAllocator::FreeRegionTree::Split(NodeIdx node, uint32_t offset, NodeIdx& before, NodeIdx& rest)
+{
+    if (node == s_Nil)
+    {
+        before = s_Nil;
+        rest   = s_Nil;
+    }
+    else if (m_Nodes[node].m_Region.m_Begin < offset)
+    {
+        Split(m_Nodes[node].m_Right, offset, m_Nodes[node].m_Right, rest);
+        before = node;
+        Update(node);
+    }
+    else
+    {
+        Split(m_Nodes[node].m_Left, offset, before, m_Nodes[node].m_Left);
+        rest = node;
+        Update(node);
+    }
+}
+
+SramAllocator::FreeRegionTree::NodeIdx SramAllocator::FreeRegionTree::Merge(NodeIdx before, NodeIdx after)
+{
+    if (before == s_Nil)
+    {
+        return after;
+    }
+    if (after == s_Nil)
+    {
+        return before;
+    }
+    if (m_Nodes[before].m_Priority > m_Nodes[after].m_Priority)
+    {
+        m_Nodes[before].m_Right = Merge(m_Nodes[before].m_Right, after);
+        Update(before);
+        return before;
+    }
+    else
+    {
+        m_Nodes[after].m_Left = Merge(before, m_Nodes[after].m_Left);
+        Update(after);
+        return after;
+    }
+}
+
+SramAllocator::DebugNameId SramAllocator::InternDebugName(const std::string& debugName)
+{
+    if (debugName.empty())
+    {
+        return 0;
+    }
+    auto it = m_DebugNameIds.find(debugName);
+    if (it != m_DebugNameIds.end())
+    {
+        return it->second;
+    }
+    const DebugNameId id = static_cast<DebugNameId>(m_DebugNames.size());
+    m_DebugNames.push_back(debugName);
+    m_DebugNameIds.emplace(debugName, id);
+    return id;
+}
+
+std::pair<bool, uint32_t>
+    SramAllocator::Allocate(uint32_t size, AllocationPreference pref, const std::string& debugName)
+{
+    const FreeRegionTree::Region* region = nullptr;
+    FreeRegionTree::Region bestFitRegion;
+    if (m_Policy == AllocationPolicy::BestFit)
+    {
+        // Of the smallest regions which are big enough, use the one nearest the preferred end of the memory.
+        auto bySize = m_FreeBySize.lower_bound({ size, 0 });
+        if (bySize != m_FreeBySize.end())
+        {
+            if (pref == AllocationPreference::End)
             {
-                MemoryChunk chunk = { range->m_Begin, range->m_Begin + size, debugName };
-                m_UsedMemory.emplace_back(chunk);
-                range->m_Begin += size;
-                if (range->m_Begin == range->m_End)
-                {
-                    m_FreeMemory.erase(range);
-                }
-                return { true, chunk.m_Begin };
+                bySize = std::prev(m_FreeBySize.upper_bound({ bySize->first, std::numeric_limits<uint32_t>::max() }));
             }
+            bestFitRegion = { bySize->second, bySize->second + bySize->first };
+            region        = &bestFitRegion;
         }
     }
+    else if (pref == AllocationPreference::Start)
+    {
+        region = m_FreeByOffset.FindFirstFit(size);
+    }
     else if (pref == AllocationPreference::End)
     {
-        // If we prefer starting at the end, we iterate through the free regions backwards
+        // If we prefer starting at the end, we use the last region which is big enough
         // and allocate at the end of the region
-        for (auto range = m_FreeMemory.rbegin(); range != m_FreeMemory.rend(); ++range)
+        region = m_FreeByOffset.FindLastFit(size);
+    }
+
+    if (region == nullptr)
+    {
+        if (m_UsageReport != nullptr)
         {
-            if (size <= range->m_End - range->m_Begin)
-            {
-                MemoryChunk chunk = { range->m_End - size, range->m_End, debugName };
-                m_UsedMemory.emplace_back(chunk);
-                range->m_End -= size;
-                if (range->m_Begin == range->m_End)
-                {
-                    m_FreeMemory.erase(std::next(range).base());
-                }
-                return { true, chunk.m_Begin };
-            }
+            m_UsageReport->AddFailedAllocation(debugName, size, GetUsage());
         }
+        return { false, 0 };
     }
 
-    return { false, 0 };
+    const uint32_t begin          = pref == AllocationPreference::Start ? region->m_Begin : region->m_End - size;
+    const DebugNameId debugNameId = InternDebugName(debugName);
+    TakeFreeMemory(begin, begin + size, debugNameId);
+    if (m_NumOpenCheckpoints > 0)
+    {
+        m_History.push_back({ true, begin, begin + size, debugNameId });
+    }
+    if (m_UsedBytes > m_PeakUsage.m_UsedBytes)
+    {
+        m_PeakUsage = GetUsage();
+    }
+    return { true, begin };
 }
 
 bool SramAllocator::Free(uint32_t offset)
 {
-    auto MatchChunk = [offset](const auto& chunk) { return (offset == chunk.m_Begin); };
-    // Remove the chunk from used memory and add it to the free memory.
-    auto memoryChunkIt = std::find_if(m_UsedMemory.begin(), m_UsedMemory.end(), MatchChunk);
-    if (memoryChunkIt == std::end(m_UsedMemory))
+    // If there are several chunks at this offset (i.e. zero-sized ones) then free the one which was allocated first.
+    auto usedChunk = m_UsedMemory.lower_bound(offset);
+    if (usedChunk == m_UsedMemory.end() || usedChunk->first != offset)
     {
         return false;
     }
-    MemoryChunk memoryChunk = *memoryChunkIt;
-    m_UsedMemory.erase(memoryChunkIt);
-    m_FreeMemory.push_back(memoryChunk);
-
-    auto SortMemoryChunks = [](const auto& lhs, const auto& rhs) { return lhs.m_Begin < rhs.m_Begin; };
-    std::sort(m_FreeMemory.begin(), m_FreeMemory.end(), SortMemoryChunks);
-    CollapseRegions();
+    const HistoryEntry entry = { false, usedChunk->first, usedChunk->second.m_End, usedChunk->second.m_Debug };
+    m_UsedMemory.erase(usedChunk);
+    m_UsedBytes -= entry.m_End - entry.m_Begin;
+    AddFreeRegion(entry.m_Begin, entry.m_End);
+    if (m_NumOpenCheckpoints > 0)
+    {
+        m_History.push_back(entry);
+    }
     return true;
 }
 
+SramAllocator::Checkpoint SramAllocator::CreateCheckpoint()
+{
+    ++m_NumOpenCheckpoints;
+    return { m_History.size(), m_PeakUsage };
+}
+
+void SramAllocator::Rollback(Checkpoint checkpoint)
+{
+    assert(m_NumOpenCheckpoints > 0 && checkpoint.m_HistorySize <= m_History.size());
+    while (m_History.size() > checkpoint.m_HistorySize)
+    {
+        const HistoryEntry entry = m_History.back();
+        m_History.pop_back();
+        if (entry.m_WasAllocation)
+        {
+            // Changes are undone in reverse order, so this is the most recent chunk allocated at this offset.
+            auto usedChunk = std::prev(m_UsedMemory.upper_bound(entry.m_Begin));
+            assert(usedChunk->first == entry.m_Begin && usedChunk->second.m_End == entry.m_End);
+            m_UsedMemory.erase(usedChunk);
+            m_UsedBytes -= entry.m_End - entry.m_Begin;
+            AddFreeRegion(entry.m_Begin, entry.m_End);
+        }
+        else
+        {
+            TakeFreeMemory(entry.m_Begin, entry.m_End, entry.m_Debug);
+        }
+    }
+    m_PeakUsage = checkpoint.m_PeakUsage;
+    Commit(checkpoint);
+}
+
+void SramAllocator::Commit(Checkpoint checkpoint)
+{
+    assert(m_NumOpenCheckpoints > 0 && checkpoint.m_HistorySize <= m_History.size());
+    (void)checkpoint;
+    --m_NumOpenCheckpoints;
+    if (m_NumOpenCheckpoints == 0)
+    {
+        // Nothing can be rolled back any more, so there is no need to keep the history.
+        m_History.clear();
+    }
+}
+
 std::string SramAllocator::DumpUsage() const
 {
     std::string ret;
     ret += std::string("Sram Used Memory: \n");
     for (const auto& x : m_UsedMemory)
     {
-        ret += std::string("range=") + std::to_string(x.m_Begin) + std::string("---") + std::to_string(x.m_End) + " " +
-               x.m_Debug + std::string("\n");
+        ret += std::string("range=") + std::to_string(x.first) + std::string("---") + std::to_string(x.second.m_End) +
+               " " + m_DebugNames[x.second.m_Debug] + std::string("\n");
     }
     ret += std::string("Sram Free Memory: \n");
-    for (const auto& x : m_FreeMemory)
+    for (const FreeRegionTree::Region& x : m_FreeByOffset.GetRegions())
     {
         ret += std::string("range=") + std::to_string(x.m_Begin) + std::string("---") + std::to_string(x.m_End) +
                std::string("\n");
@@ -100,29 +392,109 @@ std::string SramAllocator::DumpUsage() const
     return ret;
 }
 
-void SramAllocator::CollapseRegions()
+void SramAllocator::TakeFreeMemory(uint32_t begin, uint32_t end, DebugNameId debugName)
+{
+    if (begin < end)
+    {
+        // The range must be entirely within the free region which starts at or before it.
+        const FreeRegionTree::Region* region = m_FreeByOffset.FindAtOrBefore(begin);
+        assert(region != nullptr);
+        const uint32_t freeRegionBegin = region->m_Begin;
+        const uint32_t freeRegionEnd   = region->m_End;
+        assert(end <= freeRegionEnd);
+
+        RemoveFreeRegion(freeRegionBegin, freeRegionEnd);
+        // What is left either side of the chunk can't be next to any other free region, so there is nothing to merge
+        if (freeRegionBegin < begin)
+        {
+            m_FreeByOffset.Insert(freeRegionBegin, begin);
+            m_FreeBySize.emplace(begin - freeRegionBegin, freeRegionBegin);
+        }
+        if (end < freeRegionEnd)
+        {
+            m_FreeByOffset.Insert(end, freeRegionEnd);
+            m_FreeBySize.emplace(freeRegionEnd - end, end);
+        }
+    }
+    m_UsedMemory.emplace(begin, UsedChunk{ end, debugName });
+    m_UsedBytes += end - begin;
+}
+
+void SramAllocator::AddFreeRegion(uint32_t begin, uint32_t end)
 {
-    for (size_t i = m_FreeMemory.size() - 1; i >= 1; --i)
+    if (begin == end)
+    {
+        return;
+    }
+
+    // Collapse adjacent regions of free memory into one region
+    const FreeRegionTree::Region* next = m_FreeByOffset.FindAtOrAfter(begin);
+    // Regions should never overlap otherwise something has gone horribly wrong
+    assert(next == nullptr || end <= next->m_Begin);
+    if (next != nullptr && next->m_Begin == end)
     {
-        // Regions should never overlap otherwise something has gone horribly wrong
-        assert(m_FreeMemory[i - 1].m_End <= m_FreeMemory[i].m_Begin);
-        if (m_FreeMemory[i - 1].m_End == m_FreeMemory[i].m_Begin)
+        end = next->m_End;
+        RemoveFreeRegion(next->m_Begin, next->m_End);
+    }
+    const FreeRegionTree::Region* prev = m_FreeByOffset.FindAtOrBefore(begin);
+    if (prev != nullptr)
+    {
+        assert(prev->m_End <= begin);
+        if (prev->m_End == begin)
         {
-            m_FreeMemory[i - 1].m_End = m_FreeMemory[i].m_End;
-            m_FreeMemory.erase(m_FreeMemory.begin() + i);
+            begin = prev->m_Begin;
+            RemoveFreeRegion(prev->m_Begin, prev->m_End);
         }
     }
+
+    m_FreeByOffset.Insert(begin, end);
+    m_FreeBySize.emplace(end - begin, begin);
+}
+
+void SramAllocator::RemoveFreeRegion(uint32_t begin, uint32_t end)
+{
+    m_FreeBySize.erase({ end - begin, begin });
+    m_FreeByOffset.Erase(begin);
 }
 
 void SramAllocator::Reset()
 {
-    m_FreeMemory = { { 0, m_Capacity, "" } };
-    m_UsedMemory = {};
+    assert(m_NumOpenCheckpoints == 0);
+    m_FreeByOffset.Clear();
+    m_FreeBySize.clear();
+    m_UsedMemory.clear();
+    m_DebugNames = { std::string() };
+    m_DebugNameIds.clear();
+    m_History.clear();
+    m_UsedBytes = 0;
+    AddFreeRegion(0, m_Capacity);
+    ResetPeakUsage();
+}
+
+SramAllocator::UsageStats SramAllocator::GetUsage() const
+{
+    const uint32_t largestFreeRegion = m_FreeBySize.empty() ? 0 : m_FreeBySize.rbegin()->first;
+    return { m_UsedBytes, m_Capacity - m_UsedBytes, largestFreeRegion };
+}
+
+SramAllocator::UsageStats SramAllocator::GetPeakUsage() const
+{
+    return m_PeakUsage;
+}
+
+void SramAllocator::ResetPeakUsage()
+{
+    m_PeakUsage = GetUsage();
+}
+
+void SramAllocator::SetUsageReport(SramUsageReport* report)
+{
+    m_UsageReport = report;
 }
 
 bool SramAllocator::IsFull()
 {
-    return m_FreeMemory.empty();
+    return m_FreeByOffset.IsEmpty();
 }
 
 bool SramAllocator::IsEmpty()
@@ -131,4 +503,4 @@ bool SramAllocator::IsEmpty()
 }
 
 }    // namespace support_library
-}    // namespace ethosn
\ No newline at end of file
+}    // namespace ethosn
@@ -5,7 +5,12 @@
 
 #pragma once
 
+#include <cstdint>
+#include <map>
+#include <set>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace ethosn
@@ -13,66 +18,219 @@ namespace ethosn
 namespace support_library
 {
 
+class SramUsageReport;
+
 enum class AllocationPreference
 {
     Start,
     End,
 };
 
-struct MemoryChunk
+/// How the allocator chooses which free region to allocate from.
+enum class AllocationPolicy
 {
-    uint32_t m_Begin;
-    uint32_t m_End;
-    std::string m_Debug;
+    /// The first region which is big enough, searching from the start (or end) of the memory.
+    FirstFit,
+    /// The smallest region which is big enough, which tends to leave larger regions free for later allocations.
+    BestFit,
 };
 
 // A simple allocator to be used to allocate data in SRAM.
-// Assumes a small number of chunks allocated at once,
-// thus iterating over the internal vectors is fast, and minimal fragmentation
+// The free regions are kept in a balanced tree ordered by offset, which also records the size of the biggest region
+// under each node, and in a set ordered by size. The allocated regions are kept ordered by offset. This way both
+// policies find a region, and allocating and freeing update the regions, in time logarithmic in the number of regions.
+// Changes can be undone cheaply using a checkpoint, rather than taking a copy of the whole allocator.
 class SramAllocator
 {
 public:
-    SramAllocator()
-        : m_Capacity(0)
-        , m_FreeMemory()
-        , m_UsedMemory()
+    /// A summary of how much of the memory is in use.
+    struct UsageStats
     {
-        Reset();
-    }
+        uint32_t m_UsedBytes;
+        uint32_t m_FreeBytes;
+        /// The size of the biggest free region, which is the biggest allocation that could currently succeed.
+        uint32_t m_LargestFreeRegion;
+    };
+
+    /// Identifies a point in the history of an allocator which it can be rolled back to.
+    struct Checkpoint
+    {
+        size_t m_HistorySize;
+        UsageStats m_PeakUsage;
+    };
+
+    SramAllocator()
+        : SramAllocator(0)
+    {}
 
-    SramAllocator(uint32_t capacity)
+    SramAllocator(uint32_t capacity, AllocationPolicy policy = AllocationPolicy::FirstFit)
         : m_Capacity(capacity)
-        , m_FreeMemory()
+        , m_Policy(policy)
+        , m_FreeByOffset()
+        , m_FreeBySize()
         , m_UsedMemory()
+        , m_DebugNames()
+        , m_DebugNameIds()
+        , m_History()
+        , m_NumOpenCheckpoints(0)
+        , m_UsedBytes(0)
+        , m_PeakUsage()
+        , m_UsageReport(nullptr)
     {
         Reset();
     }
 
-    SramAllocator& operator=(const SramAllocator& s);
-
     // Return whether allocating was successful and the offset of the requested size
-    std::pair<bool, uint32_t>
-        Allocate(uint32_t size, AllocationPreference pref = AllocationPreference::Start, std::string debugName = "");
+    std::pair<bool, uint32_t> Allocate(uint32_t size,
+                                       AllocationPreference pref    = AllocationPreference::Start,
+                                       const std::string& debugName = std::string());
 
     bool Free(uint32_t offset);
 
     void Reset();
 
+    /// Returns a checkpoint which Rollback() can later be used to return to, undoing all the allocations and frees
+    /// made in between. Every checkpoint must be finished with exactly one call to either Rollback() or Commit(),
+    /// and checkpoints must be finished in the reverse order to which they were created.
+    Checkpoint CreateCheckpoint();
+    /// Undoes all the changes made since the given checkpoint was created.
+    void Rollback(Checkpoint checkpoint);
+    /// Keeps all the changes made since the given checkpoint was created.
+    void Commit(Checkpoint checkpoint);
+
     std::string DumpUsage() const;
 
+    UsageStats GetUsage() const;
+    /// Returns the usage at the point at which the most memory was in use since the allocator was reset or
+    /// ResetPeakUsage() was called. Changes which have been rolled back are not included.
+    UsageStats GetPeakUsage() const;
+    void ResetPeakUsage();
+
+    /// Records every allocation which fails in the given report (if not null), along with the usage at the time.
+    /// Copies of this allocator record into the same report.
+    void SetUsageReport(SramUsageReport* report);
+
     bool IsFull();
 
     bool IsEmpty();
 
 private:
-    // Collapse regions of contiguous free memory into one chunk
-    void CollapseRegions();
+    /// The free regions of memory, as a treap (a binary search tree which is balanced by giving each node a random
+    /// priority, which its children can't have more than) ordered by the start offset of the regions.
+    /// Each node also records the size of the biggest region in its subtree, to find the first or last region which
+    /// is big enough without looking at all of them.
+    /// The nodes are stored in a vector and refer to each other by index, so that it can be copied along with the
+    /// allocator.
+    class FreeRegionTree
+    {
+    public:
+        struct Region
+        {
+            uint32_t m_Begin;
+            uint32_t m_End;
+        };
+
+        FreeRegionTree();
+
+        void Clear();
+        bool IsEmpty() const;
+        /// The given region must not overlap any region already in the tree.
+        void Insert(uint32_t begin, uint32_t end);
+        /// Removes the region which starts at the given offset, which must exist.
+        void Erase(uint32_t begin);
+
+        /// The following return nullptr if there is no such region. The returned pointer is only valid until the tree
+        /// is next changed.
+        /// @{
+        /// Returns the last region starting at or before the given offset.
+        const Region* FindAtOrBefore(uint32_t offset) const;
+        /// Returns the first region starting at or after the given offset.
+        const Region* FindAtOrAfter(uint32_t offset) const;
+        /// Returns the region with the lowest offset which is at least the given size.
+        const Region* FindFirstFit(uint32_t size) const;
+        /// Returns the region with the highest offset which is at least the given size.
+        const Region* FindLastFit(uint32_t size) const;
+        /// @}
+
+        /// Returns all the regions, ordered by offset.
+        std::vector<Region> GetRegions() const;
+
+    private:
+        using NodeIdx                  = int32_t;
+        static constexpr NodeIdx s_Nil = -1;
+
+        struct TreeNode
+        {
+            Region m_Region;
+            uint32_t m_Priority;
+            /// The size of the biggest region in the subtree rooted at this node.
+            uint32_t m_MaxSize;
+            NodeIdx m_Left;
+            NodeIdx m_Right;
+        };
+
+        uint32_t GetMaxSize(NodeIdx node) const;
+        void Update(NodeIdx node);
+        /// Splits the given subtree into the regions which start before the given offset and the rest.
+        void Split(NodeIdx node, uint32_t offset, NodeIdx& before, NodeIdx& rest);
+        /// Joins two subtrees, where all the regions in the first start before all those in the second.
+        NodeIdx Merge(NodeIdx before, NodeIdx after);
+
+        std::vector<TreeNode> m_Nodes;
+        /// Indices into m_Nodes which are no longer used and can be reused.
+        std::vector<NodeIdx> m_FreeNodes;
+        NodeIdx m_Root;
+        /// The state of the generator of the node priorities, which is deterministic so that the allocator is.
+        uint32_t m_RandomState;
+    };
+
+    /// Debug names are interned so that each chunk only needs to store a small id rather than a copy of the string.
+    /// Each allocator has its own table, so allocating doesn't need to take a lock. Id 0 is always the empty string.
+    using DebugNameId = uint32_t;
+    DebugNameId InternDebugName(const std::string& debugName);
+
+    struct UsedChunk
+    {
+        uint32_t m_End;
+        DebugNameId m_Debug;
+    };
 
-    uint32_t m_Capacity;
+    /// A change which has been made to the allocator, recorded while there are checkpoints open.
+    struct HistoryEntry
+    {
+        bool m_WasAllocation;
+        uint32_t m_Begin;
+        uint32_t m_End;
+        DebugNameId m_Debug;
+    };
+
+    /// Removes the given range from the free memory and records it as used.
+    void TakeFreeMemory(uint32_t begin, uint32_t end, DebugNameId debugName);
+    /// Adds the given range to the free regions, merging it with any adjacent free regions.
+    void AddFreeRegion(uint32_t begin, uint32_t end);
+    void RemoveFreeRegion(uint32_t begin, uint32_t end);
 
-    // Pairs of numbers to represent the range of free contiguous memory left to allocate and the memory in use
-    std::vector<MemoryChunk> m_FreeMemory;
-    std::vector<MemoryChunk> m_UsedMemory;
+    uint32_t m_Capacity;
+    AllocationPolicy m_Policy;
+
+    /// The free regions of memory, ordered by offset.
+    FreeRegionTree m_FreeByOffset;
+    /// The same free regions as (size, start offset) pairs, to find the best fitting region quickly.
+    std::set<std::pair<uint32_t, uint32_t>> m_FreeBySize;
+    /// The allocated regions of memory, keyed by their start offset.
+    /// Zero-sized allocations may share an offset with another allocation, hence the multimap.
+    std::multimap<uint32_t, UsedChunk> m_UsedMemory;
+
+    /// The interned debug names, indexed by their id, and the reverse mapping.
+    std::vector<std::string> m_DebugNames;
+    std::unordered_map<std::string, DebugNameId> m_DebugNameIds;
+
+    std::vector<HistoryEntry> m_History;
+    uint32_t m_NumOpenCheckpoints;
+
+    uint32_t m_UsedBytes;
+    UsageStats m_PeakUsage;
+    SramUsageReport* m_UsageReport;
 };
 
 }    // namespace support_library
@@ -0,0 +1,185 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "SramUsageReport.hpp"
+
+#include "Graph.hpp"
+#include "Pass.hpp"
+
+namespace ethosn
+{
+namespace support_library
+{
+
+namespace
+{
+
+std::string Indent(uint32_t depth)
+{
+    return std::string(depth, '\t');
+}
+
+std::string JsonField(const std::string& name)
+{
+    return '"' + name + "\": ";
+}
+
+std::ostream& PrintIds(std::ostream& os, const std::set<uint32_t>& ids)
+{
+    os << "[";
+    for (auto it = ids.begin(); it != ids.end(); ++it)
+    {
+        os << (it == ids.begin() ? " " : ", ") << *it;
+    }
+    return os << " ]";
+}
+
+}    // namespace
+
+SramUsageReport::SramUsageReport(uint32_t numSrams)
+    : m_NumSrams(numSrams)
+    , m_Iteration(0)
+    , m_Passes()
+    , m_FailedPasses()
+    , m_Current()
+{}
+
+void SramUsageReport::StartIteration(uint32_t iteration)
+{
+    m_Iteration = iteration;
+    m_Passes.clear();
+}
+
+void SramUsageReport::StartPass(const Node& firstNode)
+{
+    m_Current                = FailedPass();
+    m_Current.m_Iteration    = m_Iteration;
+    m_Current.m_FirstNodeId  = firstNode.GetId();
+    m_Current.m_OperationIds = firstNode.GetCorrespondingOperationIds();
+}
+
+void SramUsageReport::AddFailedAllocation(const std::string& debugName,
+                                          uint32_t size,
+                                          const SramAllocator::UsageStats& usage)
+{
+    auto it = m_Current.m_FailedAllocations.find(debugName);
+    if (it == m_Current.m_FailedAllocations.end())
+    {
+        m_Current.m_FailedAllocations.emplace(debugName, FailedAllocations{ 1, size, usage });
+    }
+    else
+    {
+        ++it->second.m_Count;
+        if (size < it->second.m_SmallestSize)
+        {
+            it->second.m_SmallestSize = size;
+            it->second.m_Usage        = usage;
+        }
+    }
+}
+
+void SramUsageReport::EndPass(const Pass& pass, const SramAllocator::UsageStats& peakUsage)
+{
+    // Allocations which failed along the way (e.g. while trying strategies which didn't fit) are not of interest
+    // as a Pass was created in the end.
+    m_Passes.push_back({ &pass, peakUsage });
+}
+
+void SramUsageReport::EndFailedPass(const std::vector<const Node*>& nodesForcedToDram)
+{
+    // Only failures which are due to the SRAM being full are of interest.
+    if (m_Current.m_FailedAllocations.empty() && nodesForcedToDram.empty())
+    {
+        return;
+    }
+    for (const Node* node : nodesForcedToDram)
+    {
+        m_Current.m_NodesForcedToDram.emplace_back(node->GetId(), node->GetCorrespondingOperationIds());
+    }
+    m_FailedPasses.push_back(std::move(m_Current));
+}
+
+void SramUsageReport::SaveUsage(std::ostream& os, uint32_t indent, const SramAllocator::UsageStats& usage) const
+{
+    // The fragmentation is the proportion of the free memory which can't be used by the biggest allocation possible.
+    const double fragmentation =
+        usage.m_FreeBytes == 0 ? 0.0 : 1.0 - static_cast<double>(usage.m_LargestFreeRegion) / usage.m_FreeBytes;
+
+    os << Indent(indent) << JsonField("UsedBytes") << usage.m_UsedBytes * m_NumSrams << ",\n";
+    os << Indent(indent) << JsonField("FreeBytes") << usage.m_FreeBytes * m_NumSrams << ",\n";
+    os << Indent(indent) << JsonField("LargestFreeBlockBytes") << usage.m_LargestFreeRegion * m_NumSrams << ",\n";
+    os << Indent(indent) << JsonField("Fragmentation") << fragmentation;
+}
+
+void SramUsageReport::Save(std::ostream& os) const
+{
+    os << "{\n";
+    os << Indent(1) << JsonField("NumIterations") << m_Iteration + 1 << ",\n";
+
+    os << Indent(1) << JsonField("Passes") << "[";
+    for (auto it = m_Passes.begin(); it != m_Passes.end(); ++it)
+    {
+        const Pass& pass = *it->m_Pass;
+        os << (it == m_Passes.begin() ? "\n" : ",\n");
+        os << Indent(2) << "{\n";
+        os << Indent(3) << JsonField("PassId") << pass.GetId() << ",\n";
+        if (pass.GetSection() != nullptr)
+        {
+            os << Indent(3) << JsonField("SectionId") << '"' << pass.GetSection()->GetId() << "\",\n";
+        }
+        std::set<uint32_t> operationIds;
+        for (const Node* node : pass.GetNodes())
+        {
+            const std::set<uint32_t> nodeOperationIds = node->GetCorrespondingOperationIds();
+            operationIds.insert(nodeOperationIds.begin(), nodeOperationIds.end());
+        }
+        os << Indent(3) << JsonField("OperationIds");
+        PrintIds(os, operationIds) << ",\n";
+        os << Indent(3) << JsonField("Peak") << "{\n";
+        SaveUsage(os, 4, it->m_PeakUsage);
+        os << "\n" << Indent(3) << "}\n";
+        os << Indent(2) << "}";
+    }
+    os << (m_Passes.empty() ? "],\n" : "\n" + Indent(1) + "],\n");
+
+    os << Indent(1) << JsonField("FailedPasses") << "[";
+    for (auto it = m_FailedPasses.begin(); it != m_FailedPasses.end(); ++it)
+    {
+        os << (it == m_FailedPasses.begin() ? "\n" : ",\n");
+        os << Indent(2) << "{\n";
+        os << Indent(3) << JsonField("Iteration") << it->m_Iteration << ",\n";
+        os << Indent(3) << JsonField("NodeId") << it->m_FirstNodeId << ",\n";
+        os << Indent(3) << JsonField("OperationIds");
+        PrintIds(os, it->m_OperationIds) << ",\n";
+
+        os << Indent(3) << JsonField("FailedAllocations") << "[";
+        for (auto a = it->m_FailedAllocations.begin(); a != it->m_FailedAllocations.end(); ++a)
+        {
+            os << (a == it->m_FailedAllocations.begin() ? "\n" : ",\n");
+            os << Indent(4) << "{\n";
+            os << Indent(5) << JsonField("Name") << '"' << a->first << "\",\n";
+            os << Indent(5) << JsonField("NumFailures") << a->second.m_Count << ",\n";
+            os << Indent(5) << JsonField("SmallestSizeBytes") << a->second.m_SmallestSize * m_NumSrams << ",\n";
+            SaveUsage(os, 5, a->second.m_Usage);
+            os << "\n" << Indent(4) << "}";
+        }
+        os << (it->m_FailedAllocations.empty() ? "],\n" : "\n" + Indent(3) + "],\n");
+
+        os << Indent(3) << JsonField("NodesForcedToDram") << "[";
+        for (auto n = it->m_NodesForcedToDram.begin(); n != it->m_NodesForcedToDram.end(); ++n)
+        {
+            os << (n == it->m_NodesForcedToDram.begin() ? "\n" : ",\n");
+            os << Indent(4) << "{ " << JsonField("NodeId") << n->first << ", " << JsonField("OperationIds");
+            PrintIds(os, n->second) << " }";
+        }
+        os << (it->m_NodesForcedToDram.empty() ? "]\n" : "\n" + Indent(3) + "]\n");
+        os << Indent(2) << "}";
+    }
+    os << (m_FailedPasses.empty() ? "]\n" : "\n" + Indent(1) + "]\n");
+    os << "}\n";
+}
+
+}    // namespace support_library
+}    // namespace ethosn
@@ -0,0 +1,85 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include "SramAllocator.hpp"
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ethosn
+{
+namespace support_library
+{
+
+class Node;
+class Pass;
+
+/// Records how the SRAM is used by each Pass as the passes are created, and which allocations failed when a Pass
+/// could not be created, so that it can be seen why parts of a network had to be moved to DRAM.
+/// Sizes given to the report are per SRAM (as used by SramAllocator) but are saved as the total over all the SRAMs.
+class SramUsageReport
+{
+public:
+    explicit SramUsageReport(uint32_t numSrams);
+
+    /// Starts recording a new attempt at creating the passes for the graph. The passes recorded by any previous
+    /// attempt are forgotten, but their failures are kept so that every change made to the graph is explained.
+    void StartIteration(uint32_t iteration);
+
+    /// Starts recording an attempt at creating a Pass beginning at the given node.
+    void StartPass(const Node& firstNode);
+    void AddFailedAllocation(const std::string& debugName, uint32_t size, const SramAllocator::UsageStats& usage);
+    /// Finishes the current attempt, which created the given Pass.
+    void EndPass(const Pass& pass, const SramAllocator::UsageStats& peakUsage);
+    /// Finishes the current attempt, which did not create a Pass. The given nodes are those which were asked to be
+    /// moved to DRAM as a result.
+    void EndFailedPass(const std::vector<const Node*>& nodesForcedToDram);
+
+    /// Writes the report as JSON. This must be called while the passes given to EndPass() still exist.
+    void Save(std::ostream& os) const;
+
+private:
+    /// All the failed allocations with the same debug name (e.g. "weights") during an attempt.
+    struct FailedAllocations
+    {
+        uint32_t m_Count;
+        uint32_t m_SmallestSize;
+        /// The usage when the smallest allocation failed.
+        SramAllocator::UsageStats m_Usage;
+    };
+
+    struct PassUsage
+    {
+        const Pass* m_Pass;
+        SramAllocator::UsageStats m_PeakUsage;
+    };
+
+    struct FailedPass
+    {
+        uint32_t m_Iteration;
+        size_t m_FirstNodeId;
+        std::set<uint32_t> m_OperationIds;
+        std::map<std::string, FailedAllocations> m_FailedAllocations;
+        std::vector<std::pair<size_t, std::set<uint32_t>>> m_NodesForcedToDram;
+    };
+
+    void SaveUsage(std::ostream& os, uint32_t indent, const SramAllocator::UsageStats& usage) const;
+
+    uint32_t m_NumSrams;
+    uint32_t m_Iteration;
+    std::vector<PassUsage> m_Passes;
+    std::vector<FailedPass> m_FailedPasses;
+    /// The attempt currently being recorded.
+    FailedPass m_Current;
+};
+
+}    // namespace support_library
+}    // namespace ethosn
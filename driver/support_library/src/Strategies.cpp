@@ -190,9 +190,8 @@ bool TryStripeShapes(SramAllocator& sramAllocator,
         return false;
     }
 
-    SramAllocator currentSramAllocator = sramAllocator;
     AllocationResult allocationResults =
-        FitsInSram(currentSramAllocator, capabilities, inputTile, weightTile, outputTile, inputStaticAndOffset);
+        FitsInSram(sramAllocator, capabilities, inputTile, weightTile, outputTile, inputStaticAndOffset);
     if (!allocationResults.m_Success)
     {
         return false;
@@ -203,8 +202,6 @@ bool TryStripeShapes(SramAllocator& sramAllocator,
     outTensorConfig.outputAllocation.tileSize     = outputTile;
     outTensorConfig.weightsAllocation.stripeShape = weightStripe;
     outTensorConfig.weightsAllocation.tileSize    = weightTile;
-    // If we succeeded in finding a strategy, update the sram allocation state
-    sramAllocator = currentSramAllocator;
     FillTensorConfigOffsets(allocationResults, outTensorConfig);
     return true;
 }
@@ -350,7 +347,7 @@ bool Strategy3::TrySetup(TensorConfig& tensorConfig,
 }
 
 bool Strategy4::TrySetup(TensorConfig& tensorConfig,
-                         SramAllocator& originalSramAllocator,
+                         SramAllocator& sramAllocator,
                          const TensorShape& inputShape,
                          const TensorShape& outputShape,
                          DataFormat weightsFormat,
@@ -457,8 +454,7 @@ bool Strategy4::TrySetup(TensorConfig& tensorConfig,
     for (uint32_t numStripesInWeightTile = 2; numStripesInWeightTile >= 1; --numStripesInWeightTile)
     {
         // clang-format on
-        SramAllocator sramAllocator = originalSramAllocator;
-        bool isHwim                 = weightsFormat == DataFormat::HWIM;
+        bool isHwim = weightsFormat == DataFormat::HWIM;
         const uint32_t weightTile =
             EstimateWeightSizeBytes(weightStripe, capabilities, isHwim) * numStripesInWeightTile;
         AllocationResult allocationResults =
@@ -474,7 +470,6 @@ bool Strategy4::TrySetup(TensorConfig& tensorConfig,
             tensorConfig.blockWidth                    = blockConfig.m_BlockWidth();
             tensorConfig.blockHeight                   = blockConfig.m_BlockHeight();
             tensorConfig.strategy                      = Strategy::STRATEGY_4;
-            originalSramAllocator                      = sramAllocator;
             FillTensorConfigOffsets(allocationResults, tensorConfig);
             return true;
         }
@@ -484,7 +479,7 @@ bool Strategy4::TrySetup(TensorConfig& tensorConfig,
 }
 
 bool Strategy6::TrySetup(TensorConfig& tensorConfig,
-                         SramAllocator& originalSramAllocator,
+                         SramAllocator& sramAllocator,
                          const TensorShape& inputShape,
                          const TensorShape& outputShape,
                          DataFormat weightsFormat,
@@ -532,7 +527,7 @@ bool Strategy6::TrySetup(TensorConfig& tensorConfig,
 
     for (auto params : paramsList)
     {
-        if (TryStripeShapes(originalSramAllocator,
+        if (TryStripeShapes(sramAllocator,
                             { 1, params.outputStripeHeight, params.outputStripeWidth, params.outputStripeChannel },
                             inputShape, outputShape, weightsFormat, weightsShape, capabilities, shapeMultiplier,
                             inputStaticAndOffset, tensorConfig, depthMax))
@@ -552,7 +547,7 @@ bool Strategy6::TrySetup(TensorConfig& tensorConfig,
 // (1) IFM split in Z direction only, no split in XY
 // (2) Winograd is not supported
 bool Strategy7::TrySetup(TensorConfig& tensorConfig,
-                         SramAllocator& originalSramAllocator,
+                         SramAllocator& sramAllocator,
                          const TensorShape& inputShape,
                          const TensorShape& outputShape,
                          DataFormat weightsFormat,
@@ -644,7 +639,6 @@ bool Strategy7::TrySetup(TensorConfig& tensorConfig,
 
     uint32_t inputStripeDepth = inputStripe[3];
 
-    SramAllocator sramAllocator;
     AllocationResult allocationResults;
 
     uint32_t inputTile;
@@ -679,7 +673,6 @@ bool Strategy7::TrySetup(TensorConfig& tensorConfig,
             inputTile  = (inputStripe[0] * inputStripe[1] * inputStripe[2] * inputStripe[3] * numInputStripesTile);
             weightTile = EstimateWeightSizeBytes(weightStripe, capabilities, false) * numWeightStripesTile;
 
-            sramAllocator = originalSramAllocator;
             allocationResults =
                 FitsInSram(sramAllocator, capabilities, inputTile, weightTile, outputTile, inputStaticAndOffset);
         } while (allocationResults.m_Success == false);
@@ -688,9 +681,8 @@ bool Strategy7::TrySetup(TensorConfig& tensorConfig,
     {
         // For depthwise, we start with the smallest input stripe depth anyway
         // (as it must be equal to the output stripe depth) so there is only one configuration to try.
-        inputTile     = inputStripe[0] * inputStripe[1] * inputStripe[2] * inputStripe[3] * numInputStripesTile;
-        weightTile    = EstimateWeightSizeBytes(weightStripe, capabilities, false) * 2;
-        sramAllocator = originalSramAllocator;
+        inputTile  = inputStripe[0] * inputStripe[1] * inputStripe[2] * inputStripe[3] * numInputStripesTile;
+        weightTile = EstimateWeightSizeBytes(weightStripe, capabilities, false) * 2;
         allocationResults =
             FitsInSram(sramAllocator, capabilities, inputTile, weightTile, outputTile, inputStaticAndOffset);
         if (!allocationResults.m_Success)
@@ -714,14 +706,13 @@ bool Strategy7::TrySetup(TensorConfig& tensorConfig,
     tensorConfig.blockHeight                   = blockConfig.m_BlockHeight();
     tensorConfig.strategy                      = Strategy::STRATEGY_7;
 
-    originalSramAllocator = sramAllocator;
     FillTensorConfigOffsets(allocationResults, tensorConfig);
 
     return true;
 }
 
 bool StrategyFc::TrySetup(TensorConfig& tensorConfig,
-                          SramAllocator& originalSramAllocator,
+                          SramAllocator& sramAllocator,
                           const TensorShape& inputShape,
                           const TensorShape& outputShape,
                           const DataFormat weightsFormat,
@@ -797,7 +788,6 @@ bool StrategyFc::TrySetup(TensorConfig& tensorConfig,
         return false;
     }
 
-    SramAllocator sramAllocator = originalSramAllocator;
     // weight stripe tensor is adjusted so that input+weight+output tiles fit into SRAM.
     AllocationResult allocationResults =
         FitsInSram(sramAllocator, capabilities, inputTile, weightTile, outputTile, inputStaticAndOffset);
@@ -811,8 +801,7 @@ bool StrategyFc::TrySetup(TensorConfig& tensorConfig,
         weightStripe[2] = inputLength;
 
         // recalculate the weight size
-        weightTile                  = EstimateWeightSizeBytes(weightStripe, capabilities, isHwim) * 2;
-        SramAllocator sramAllocator = originalSramAllocator;
+        weightTile = EstimateWeightSizeBytes(weightStripe, capabilities, isHwim) * 2;
         allocationResults =
             FitsInSram(sramAllocator, capabilities, inputTile, weightTile, outputTile, inputStaticAndOffset);
     }
@@ -826,7 +815,6 @@ bool StrategyFc::TrySetup(TensorConfig& tensorConfig,
     tensorConfig.blockWidth                    = blockConfig.m_BlockWidth();
     tensorConfig.blockHeight                   = blockConfig.m_BlockHeight();
     tensorConfig.strategy                      = Strategy::STRATEGY_FC;
-    originalSramAllocator                      = sramAllocator;
     FillTensorConfigOffsets(allocationResults, tensorConfig);
     return true;
 }
@@ -27,6 +27,7 @@ struct AllocationResult
     uint32_t m_PleOffset;
 };
 
+/// Allocates the tiles for a strategy. If they don't all fit then the allocator is left unchanged.
 AllocationResult FitsInSram(SramAllocator& sramAllocator,
                             const HardwareCapabilities& capabilities,
                             const uint32_t input,
@@ -34,6 +35,8 @@ AllocationResult FitsInSram(SramAllocator& sramAllocator,
                             const uint32_t output,
                             std::pair<const bool, const uint32_t> inputStaticAndOffset)
 {
+    const SramAllocator::Checkpoint checkpoint = sramAllocator.CreateCheckpoint();
+
     AllocationResult res;
     res.m_Success          = true;
     auto pleAllocateResult = sramAllocator.Allocate(capabilities.GetMaxPleSize(), AllocationPreference::Start, "ple");
@@ -81,6 +84,14 @@ AllocationResult FitsInSram(SramAllocator& sramAllocator,
     res.m_Success &= outputAllocateResult.first;
     res.m_OutputOffset = outputAllocateResult.second;
 
+    if (res.m_Success)
+    {
+        sramAllocator.Commit(checkpoint);
+    }
+    else
+    {
+        sramAllocator.Rollback(checkpoint);
+    }
     return res;
 }
 
@@ -244,9 +244,8 @@ bool TryStripeShapes(const command_stream::MceOperation& mceOperation,
                      RoundUpToNearestMultiple(GetChannels(outputShape), capabilities.GetNumberOfOfm()) });
     const uint32_t outputTile = std::min(TotalSizeBytes(outputStripe) * numOutputStripesInTile, outputTileMax);
 
-    SramAllocator currentSramAllocator = sramAllocator;
     AllocationResult allocationResults =
-        FitsInSram(currentSramAllocator, capabilities, inputTile, weightTile, outputTile, inputStaticAndOffset);
+        FitsInSram(sramAllocator, capabilities, inputTile, weightTile, outputTile, inputStaticAndOffset);
     if (!allocationResults.m_Success)
     {
         return false;
@@ -257,8 +256,6 @@ bool TryStripeShapes(const command_stream::MceOperation& mceOperation,
     outTensorConfig.outputAllocation.tileSize     = outputTile;
     outTensorConfig.weightsAllocation.stripeShape = weightStripe;
     outTensorConfig.weightsAllocation.tileSize    = weightTile;
-    // If we succeeded in finding a strategy, update the sram allocation state
-    sramAllocator = currentSramAllocator;
     FillTensorConfigOffsets(allocationResults, outTensorConfig);
     return true;
 }
@@ -10,6 +10,7 @@
 #include "Graph.hpp"
 #include "Network.hpp"
 #include "Pass.hpp"
+#include "WeightEncoderCache.hpp"
 
 #include <iomanip>
 #include <iostream>
@@ -410,6 +411,11 @@ std::shared_ptr<Network> CreateEstimationNetwork()
     return std::make_shared<Network>(true);
 }
 
+std::shared_ptr<WeightEncoderCache> CreateWeightEncoderCache(size_t maxSizeBytes)
+{
+    return std::make_shared<WeightEncoderCache>(maxSizeBytes);
+}
+
 TensorAndId<Operand> AddInput(const std::shared_ptr<Network>& network, const TensorInfo& info)
 {
     Input& input = network->AddInput(info);
@@ -667,6 +673,14 @@ std::unique_ptr<CompiledNetwork> DeserializeCompiledNetwork(std::istream& in)
     return compiledNetwork;
 }
 
+std::unique_ptr<CompiledNetwork>
+    DeserializeCompiledNetwork(const void* data, size_t size, std::shared_ptr<const void> owner)
+{
+    std::unique_ptr<CompiledNetworkImpl> compiledNetwork = std::make_unique<CompiledNetworkImpl>();
+    compiledNetwork->Deserialize(static_cast<const uint8_t*>(data), size, std::move(owner));
+    return compiledNetwork;
+}
+
 const char* EthosNVariantAsString(EthosNVariant npuType)
 {
     switch (npuType)
@@ -0,0 +1,169 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace ethosn
+{
+namespace support_library
+{
+
+namespace
+{
+
+// State shared between the thread that called ParallelFor and any workers helping it.
+// This is reference counted because a worker may pick up a helper task after the ParallelFor call it belongs to
+// has already returned (all the work having been done by other threads), in which case it must find nothing to do.
+struct ParallelForState
+{
+    ParallelForState(size_t count, const std::function<void(size_t)>& func)
+        : m_Count(count)
+        , m_Func(func)
+        , m_NextIdx(0)
+        , m_NumCompleted(0)
+        , m_FirstErrorIdx(count)
+    {}
+
+    // Runs items until there are none left to be claimed.
+    void Run()
+    {
+        while (true)
+        {
+            const size_t idx = m_NextIdx.fetch_add(1);
+            if (idx >= m_Count)
+            {
+                return;
+            }
+
+            try
+            {
+                m_Func(idx);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                if (idx < m_FirstErrorIdx)
+                {
+                    m_FirstErrorIdx = idx;
+                    m_FirstError    = std::current_exception();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            ++m_NumCompleted;
+            if (m_NumCompleted == m_Count)
+            {
+                m_AllCompleted.notify_all();
+            }
+        }
+    }
+
+    const size_t m_Count;
+    // Only dereferenced while there are unclaimed items, which guarantees the caller's function is still alive.
+    const std::function<void(size_t)>& m_Func;
+    std::atomic<size_t> m_NextIdx;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_AllCompleted;
+    size_t m_NumCompleted;
+    size_t m_FirstErrorIdx;
+    std::exception_ptr m_FirstError;
+};
+
+}    // namespace
+
+ThreadPool::ThreadPool(uint32_t numThreads)
+    : m_Stopping(false)
+{
+    if (numThreads == 0)
+    {
+        numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    // The calling thread always takes part in the work, so we need one fewer dedicated worker.
+    for (uint32_t i = 1; i < numThreads; ++i)
+    {
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+    }
+    m_TaskAvailable.notify_all();
+    for (std::thread& t : m_Workers)
+    {
+        t.join();
+    }
+}
+
+uint32_t ThreadPool::GetNumThreads() const
+{
+    return static_cast<uint32_t>(m_Workers.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    auto state = std::make_shared<ParallelForState>(count, func);
+
+    // Ask for help from as many workers as could usefully take part. Some or all of them may be busy with other
+    // work, in which case the calling thread will do more of the work itself.
+    const size_t numHelpers = std::min(m_Workers.size(), count - 1);
+    if (numHelpers > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for (size_t i = 0; i < numHelpers; ++i)
+            {
+                m_Tasks.emplace_back([state]() { state->Run(); });
+            }
+        }
+        m_TaskAvailable.notify_all();
+    }
+
+    state->Run();
+
+    std::unique_lock<std::mutex> lock(state->m_Mutex);
+    state->m_AllCompleted.wait(lock, [&state]() { return state->m_NumCompleted == state->m_Count; });
+
+    if (state->m_FirstError)
+    {
+        std::rethrow_exception(state->m_FirstError);
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_TaskAvailable.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+            if (m_Tasks.empty())
+            {
+                return;
+            }
+            task = std::move(m_Tasks.front());
+            m_Tasks.pop_front();
+        }
+        task();
+    }
+}
+
+}    // namespace support_library
+}    // namespace ethosn
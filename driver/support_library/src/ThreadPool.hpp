@@ -0,0 +1,58 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ethosn
+{
+namespace support_library
+{
+
+/// A fixed-size pool of worker threads used to parallelise independent pieces of compiler work
+/// (e.g. encoding the weights for each OFM).
+/// A pool with a single thread does not create any workers and runs all work on the calling thread, which is the
+/// default and gives exactly the same behaviour as the serial code.
+class ThreadPool
+{
+public:
+    /// Creates a pool that will use up to numThreads threads in total (including the calling thread).
+    /// Zero means use as many threads as the hardware supports.
+    explicit ThreadPool(uint32_t numThreads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /// Total number of threads that work is distributed over, including the calling thread.
+    uint32_t GetNumThreads() const;
+
+    /// Calls func(i) for every i in [0, count), distributing the calls over the threads of the pool, and waits for
+    /// all of them to complete. The calling thread takes part in the work, so it is safe to call ParallelFor from
+    /// inside a function which is itself being run by ParallelFor.
+    /// There is no ordering guarantee between different values of i, so callers which need a deterministic result
+    /// must write each result into its own slot and combine them afterwards.
+    /// If any call throws, the exception from the lowest index is rethrown once all calls have finished.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+private:
+    void WorkerLoop();
+
+    std::vector<std::thread> m_Workers;
+    std::deque<std::function<void()>> m_Tasks;
+    std::mutex m_Mutex;
+    std::condition_variable m_TaskAvailable;
+    bool m_Stopping;
+};
+
+}    // namespace support_library
+}    // namespace ethosn
@@ -273,7 +273,7 @@ uint64_t GetPerformanceDataMetric(const PassStats& passStat)
 {
     return passStat.m_Input.m_MemoryStats.m_DramParallel + passStat.m_Input.m_MemoryStats.m_DramNonParallel +
            passStat.m_Output.m_MemoryStats.m_DramParallel + passStat.m_Output.m_MemoryStats.m_DramNonParallel +
-           passStat.m_Weights.m_MemoryStats.m_DramParallel + passStat.m_Output.m_MemoryStats.m_DramNonParallel;
+           passStat.m_Weights.m_MemoryStats.m_DramParallel + passStat.m_Weights.m_MemoryStats.m_DramNonParallel;
 }
 
 uint64_t GetMetric(const NetworkPerformanceData& netPerfData)
@@ -82,6 +82,12 @@ private:
 namespace utils
 {
 
+/// Combines a value into the hash of a key made up of several values, e.g. for the hasher of an unordered_map.
+constexpr size_t CombineHash(size_t seed, size_t value)
+{
+    return seed * 37 + value;
+}
+
 template <typename T>
 T Clamp(const T& value, const T& low, const T& high)
 {
@@ -599,6 +605,7 @@ struct ShapeMultiplier
 
 constexpr ShapeMultiplier g_IdentityShapeMultiplier = { Fraction{ 1, 1 }, Fraction{ 1, 1 }, Fraction{ 1, 1 } };
 
+/// Returns the number of bytes transferred to and from DRAM by a pass, for its inputs, outputs and weights.
 uint64_t GetPerformanceDataMetric(const PassStats& passStat);
 uint64_t GetMetric(const NetworkPerformanceData& netPerfData);
 bool IsLeftMoreDataPerformantThanRight(const NetworkPerformanceData& left, const NetworkPerformanceData& right);
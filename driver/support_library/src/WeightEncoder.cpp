@@ -8,10 +8,12 @@
 #include "Compiler.hpp"
 #include "GraphNodes.hpp"
 #include "SubmapFilter.hpp"
+#include "ThreadPool.hpp"
 #include "Utils.hpp"
 #include "WeightEncoderV2.hpp"
 
 #include <algorithm>
+#include <cmath>
 #include <deque>
 #include <exception>
 #include <iterator>
@@ -41,28 +43,35 @@ std::deque<Weight>
 }    // namespace
 
 // BitstreamWriter is a helper class that supports writing packed bitfields into a vector.
+// Bits are accumulated in a 64-bit register and only copied into the vector a whole word at a time.
+// A writer created with countOnly set only counts the bits written to it, so that the size of a stream can be
+// found without building it. Its bitstream is always empty.
 
 class BitstreamWriter
 {
 public:
-    BitstreamWriter();
+    explicit BitstreamWriter(bool countOnly = false);
 
     // Returns the current write position in the bitstream (in bits)
-    size_t GetOffset();
+    size_t GetOffset() const;
 
     // Write an element to the stream. Offset specifies where to start writing in the stream.
-    void Write(uint8_t elem, int numBits, size_t offset);
+    // The bits being written to must have been previously reserved (see Reserve).
+    void Write(uint64_t elem, int numBits, size_t offset);
 
     // Write an element to end of the stream.
-    void Write(uint8_t elem, int numBits);
+    void Write(uint64_t elem, int numBits);
 
-    // Write an element to the stream. Offset specifies where to start writing in the stream.
+    // Write an element to end of the stream. The bits are taken from consecutive bytes starting at elem.
     template <class T>
     void Write(const T* elem, int numBits);
 
     // Reserve space in the stream by writing 0 bits
     void Reserve(size_t numBits);
 
+    // Pre-allocate enough memory for a stream of the given size (in bits), to avoid reallocating as it grows.
+    void ReserveCapacity(size_t numBits);
+
     // Returns the stream as a uint8_t vector
     const std::vector<uint8_t>& GetBitstream();
 
@@ -70,90 +79,213 @@ public:
     void Clear();
 
 private:
+    // Appends all 64 bits of the accumulator to the vector.
+    void FlushAccumulator();
+
+    // Moves the partial byte left at the end of the vector by GetBitstream back into the accumulator,
+    // so that more bits can be written after it.
+    void ReopenTail();
+
+    const bool m_CountOnly;
+    // Number of bits written to a writer which only counts them.
+    size_t m_NumCountedBits;
+
+    // Bytes which have been flushed from the accumulator.
     std::vector<uint8_t> m_Bitstream;
-    size_t m_EndPos;
+    // Bits not yet flushed. The first bit in the accumulator follows the last bit in m_Bitstream.
+    uint64_t m_Accumulator;
+    uint32_t m_NumAccumulatorBits;
+    // Number of unused bits at the end of the last byte in m_Bitstream. This is only non-zero after GetBitstream
+    // has flushed a partial byte.
+    uint32_t m_NumTailPaddingBits;
 };
 
-BitstreamWriter::BitstreamWriter()
-    : m_EndPos(0)
+namespace
+{
+
+uint64_t LowBitsMask(uint32_t numBits)
+{
+    return numBits >= 64 ? ~uint64_t{ 0 } : ((uint64_t{ 1 } << numBits) - 1);
+}
+
+}    // namespace
+
+BitstreamWriter::BitstreamWriter(bool countOnly)
+    : m_CountOnly(countOnly)
+    , m_NumCountedBits(0)
+    , m_Accumulator(0)
+    , m_NumAccumulatorBits(0)
+    , m_NumTailPaddingBits(0)
 {}
 
-size_t BitstreamWriter::GetOffset()
+size_t BitstreamWriter::GetOffset() const
 {
-    return m_EndPos;
+    if (m_CountOnly)
+    {
+        return m_NumCountedBits;
+    }
+    return m_Bitstream.size() * 8 - m_NumTailPaddingBits + m_NumAccumulatorBits;
 }
 
-void BitstreamWriter::Write(uint8_t elem, int numBits, size_t offset)
+void BitstreamWriter::Write(uint64_t elem, int numBits, size_t offset)
 {
-    for (int i = 0; i < numBits; ++i)
+    assert(numBits >= 0 && numBits <= 64);
+    assert(offset + static_cast<size_t>(numBits) <= GetOffset());
+    if (m_CountOnly)
     {
-        size_t idx = offset / 8;
-        int bit    = offset % 8;
+        // The bits were counted when they were reserved
+        return;
+    }
+    ReopenTail();
 
-        if (idx >= m_Bitstream.size())
-        {
-            m_Bitstream.push_back((elem >> i) & 1);
-        }
-        else
-        {
-            m_Bitstream[idx] = static_cast<uint8_t>(m_Bitstream[idx] | (((elem >> i) & 1) << bit));
-        }
+    uint32_t bitsLeft = static_cast<uint32_t>(numBits);
+    elem &= LowBitsMask(bitsLeft);
 
-        ++offset;
+    // Part of the field may already have been flushed to the vector
+    const size_t flushedBits = m_Bitstream.size() * 8;
+    while (bitsLeft > 0 && offset < flushedBits)
+    {
+        const uint32_t bit           = static_cast<uint32_t>(offset % 8);
+        const uint32_t numBitsInByte = std::min(8 - bit, bitsLeft);
+        m_Bitstream[offset / 8] =
+            static_cast<uint8_t>(m_Bitstream[offset / 8] | ((elem & LowBitsMask(numBitsInByte)) << bit));
+        elem >>= numBitsInByte;
+        bitsLeft -= numBitsInByte;
+        offset += numBitsInByte;
     }
 
-    if (static_cast<size_t>(offset) > m_EndPos)
+    // The rest is still in the accumulator
+    if (bitsLeft > 0)
     {
-        m_EndPos = offset;
+        m_Accumulator |= elem << (offset - flushedBits);
     }
 }
 
-void BitstreamWriter::Write(uint8_t elem, int numBits)
+void BitstreamWriter::Write(uint64_t elem, int numBits)
 {
-    Write(elem, numBits, m_EndPos);
+    assert(numBits >= 0 && numBits <= 64);
+    if (m_CountOnly)
+    {
+        m_NumCountedBits += static_cast<size_t>(numBits);
+        return;
+    }
+    ReopenTail();
+
+    const uint32_t numBitsU = static_cast<uint32_t>(numBits);
+    if (numBitsU == 0)
+    {
+        return;
+    }
+    elem &= LowBitsMask(numBitsU);
+
+    const uint32_t numFreeBits = 64 - m_NumAccumulatorBits;
+    m_Accumulator |= elem << m_NumAccumulatorBits;
+    if (numBitsU < numFreeBits)
+    {
+        m_NumAccumulatorBits += numBitsU;
+    }
+    else
+    {
+        // The accumulator is full. Flush it and keep the bits that didn't fit.
+        FlushAccumulator();
+        m_Accumulator        = numFreeBits < 64 ? elem >> numFreeBits : 0;
+        m_NumAccumulatorBits = numBitsU - numFreeBits;
+    }
 }
 
 template <class T>
 void BitstreamWriter::Write(const T* elem, int numBits)
 {
+    if (m_CountOnly)
+    {
+        m_NumCountedBits += static_cast<size_t>(std::max(numBits, 0));
+        return;
+    }
+
     const uint8_t* p = reinterpret_cast<const uint8_t*>(elem);
 
     while (numBits > 0)
     {
-        Write(*p, std::min(numBits, 8));
+        // Gather up to 8 bytes at a time, least significant byte first
+        const int numBitsThisWord = std::min(numBits, 64);
+        uint64_t word             = 0;
+        for (int i = 0; i * 8 < numBitsThisWord; ++i)
+        {
+            word |= static_cast<uint64_t>(p[i]) << (i * 8);
+        }
+        Write(word, numBitsThisWord);
 
-        numBits -= 8;
-        ++p;
+        numBits -= numBitsThisWord;
+        p += 8;
     }
 }
 
 void BitstreamWriter::Reserve(size_t numBits)
 {
-    size_t i = 0;
-
-    while (i < numBits)
+    while (numBits > 0)
     {
-        size_t idx = (m_EndPos + i) / 8;
-        if (idx >= static_cast<size_t>(m_Bitstream.size()))
-        {
-            m_Bitstream.push_back(0);
-        }
-
-        i += 8 - ((m_EndPos + i) % 8);
+        const size_t numBitsThisWord = std::min<size_t>(numBits, 64);
+        Write(uint64_t{ 0 }, static_cast<int>(numBitsThisWord));
+        numBits -= numBitsThisWord;
     }
+}
 
-    m_EndPos += numBits;
+void BitstreamWriter::ReserveCapacity(size_t numBits)
+{
+    if (m_CountOnly)
+    {
+        return;
+    }
+    // Whole words are flushed, so round up to allow for the final one
+    m_Bitstream.reserve(((numBits + 63) / 64) * 8);
 }
 
 const std::vector<uint8_t>& BitstreamWriter::GetBitstream()
 {
+    // Flush the remaining whole and partial bytes in the accumulator
+    const uint32_t numBytes = utils::DivRoundUp(m_NumAccumulatorBits, 8u);
+    for (uint32_t i = 0; i < numBytes; ++i)
+    {
+        m_Bitstream.push_back(static_cast<uint8_t>(m_Accumulator >> (i * 8)));
+    }
+    m_NumTailPaddingBits = numBytes * 8 - m_NumAccumulatorBits;
+    m_Accumulator        = 0;
+    m_NumAccumulatorBits = 0;
+
     return m_Bitstream;
 }
 
 void BitstreamWriter::Clear()
 {
+    m_NumCountedBits = 0;
     m_Bitstream.clear();
-    m_EndPos = 0;
+    m_Accumulator        = 0;
+    m_NumAccumulatorBits = 0;
+    m_NumTailPaddingBits = 0;
+}
+
+void BitstreamWriter::FlushAccumulator()
+{
+    const size_t size = m_Bitstream.size();
+    m_Bitstream.resize(size + 8);
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        m_Bitstream[size + i] = static_cast<uint8_t>(m_Accumulator >> (i * 8));
+    }
+    m_Accumulator        = 0;
+    m_NumAccumulatorBits = 0;
+}
+
+void BitstreamWriter::ReopenTail()
+{
+    if (m_NumTailPaddingBits != 0)
+    {
+        assert(m_NumAccumulatorBits == 0);
+        m_Accumulator        = m_Bitstream.back();
+        m_NumAccumulatorBits = 8 - m_NumTailPaddingBits;
+        m_NumTailPaddingBits = 0;
+        m_Bitstream.pop_back();
+    }
 }
 
 /**
@@ -216,7 +348,11 @@ void DefaultCompressor::CompressWeight(uint8_t weight)
 class IndexCompressor : public WeightCompressor
 {
 public:
-    IndexCompressor(std::vector<uint8_t>& result, uint32_t indexSize, const std::vector<uint8_t>& lut, bool lutReload);
+    IndexCompressor(std::vector<uint8_t>& result,
+                    uint32_t indexSize,
+                    const std::vector<uint8_t>& lut,
+                    bool lutReload,
+                    size_t numWeights);
     virtual ~IndexCompressor()
     {}
 
@@ -240,7 +376,8 @@ uint8_t IndexCompressor::GetLutIndex(uint8_t weight)
 IndexCompressor::IndexCompressor(std::vector<uint8_t>& result,
                                  uint32_t indexSize,
                                  const std::vector<uint8_t>& lut,
-                                 bool lutReload)
+                                 bool lutReload,
+                                 size_t numWeights)
     : WeightCompressor(result)
 {
     std::vector<uint8_t> lutUsed(256, 0);
@@ -267,6 +404,9 @@ IndexCompressor::IndexCompressor(std::vector<uint8_t>& result,
        indexSize == 2 => Lut enabled, each index is 4 bits
        indexSize == 3 => Lut enabled, each index is 5 bits */
     m_BitsPerElement = (indexSize != 0) ? indexSize + 2 : 8;
+
+    // Every weight takes at most one index plus one bit of zero mask
+    m_Bitstream.ReserveCapacity(m_Bitstream.GetOffset() + numWeights * (m_BitsPerElement + 1));
 }
 
 void IndexCompressor::CompressWeight(uint8_t weight)
@@ -292,7 +432,8 @@ public:
                    const std::vector<uint8_t>& lut,
                    bool lutReload,
                    const uint32_t zeroPoint,
-                   int blockSize);
+                   int blockSize,
+                   size_t numWeights);
 
     virtual void CompressWeight(uint8_t weight);
     void Flush();
@@ -311,8 +452,9 @@ ZeroCompressor::ZeroCompressor(std::vector<uint8_t>& result,
                                const std::vector<uint8_t>& lut,
                                bool lutReload,
                                const uint32_t zeroPoint,
-                               int blockSize)
-    : IndexCompressor(result, indexSize, lut, lutReload)
+                               int blockSize,
+                               size_t numWeights)
+    : IndexCompressor(result, indexSize, lut, lutReload, numWeights)
     , m_BlockSize(blockSize)
     , m_Mask(0)
     , m_NumWeights(0)
@@ -376,15 +518,16 @@ static std::shared_ptr<WeightCompressor> CreateWeightCompressor(std::vector<uint
                                                                 bool lutReload,
                                                                 bool maskEnable,
                                                                 const uint32_t zeroPoint,
-                                                                int blockSize)
+                                                                int blockSize,
+                                                                size_t numWeights)
 {
     if (!maskEnable && indexSize > 0)
     {
-        return std::make_shared<IndexCompressor>(result, indexSize, lut, lutReload);
+        return std::make_shared<IndexCompressor>(result, indexSize, lut, lutReload, numWeights);
     }
     else if (maskEnable)
     {
-        return std::make_shared<ZeroCompressor>(result, indexSize, lut, lutReload, zeroPoint, blockSize);
+        return std::make_shared<ZeroCompressor>(result, indexSize, lut, lutReload, zeroPoint, blockSize, numWeights);
     }
 
     return std::make_shared<DefaultCompressor>(result);
@@ -396,7 +539,7 @@ static std::shared_ptr<WeightCompressor> CreateWeightCompressor(std::vector<uint
 class WeightEncoderV1 : public WeightEncoder
 {
 public:
-    WeightEncoderV1(const HardwareCapabilities& capabilities);
+    WeightEncoderV1(const HardwareCapabilities& capabilities, ThreadPool* threadPool);
 
 protected:
     struct WeightCompressionParamsV1 : public WeightCompressionParams
@@ -410,6 +553,9 @@ protected:
     virtual std::vector<std::unique_ptr<WeightCompressionParams>>
         GenerateCompressionParams(uint32_t numOfmInParallel) override;
 
+    virtual uint32_t
+        GetCompressionParamsIdx(uint32_t ofmIdx, uint32_t numOfmInParallel, uint32_t stripeDepth) const override;
+
     virtual EncodedOfm EncodeOfm(const uint8_t* weightData,
                                  uint32_t ofmIdx,
                                  uint32_t numOfmInParallel,
@@ -427,6 +573,26 @@ protected:
                                  const EncodingParams& params,
                                  std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams) override;
 
+    virtual EncodedOfmSize
+        EstimateOfmSize(const uint8_t* weightData,
+                        uint32_t ofmIdx,
+                        uint32_t numOfmInParallel,
+                        uint32_t numIterationsOfm,
+                        uint32_t stripeDepth,
+                        uint32_t iteration,
+                        const TensorInfo& weightsTensorInfo,
+                        uint32_t strideY,
+                        uint32_t strideX,
+                        uint32_t paddingTop,
+                        uint32_t paddingLeft,
+                        uint32_t iterationSize,
+                        ethosn::command_stream::MceOperation operation,
+                        CompilerMceAlgorithm algorithm,
+                        const EncodingParams& params,
+                        std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams) override;
+
+    virtual uint32_t GetOfmHeaderNumBits(const TensorInfo& weightsTensorInfo) const override;
+
     virtual uint32_t GetOfmShiftOffset() const override;
 
     virtual std::pair<uint32_t, uint32_t> GetHwimWeightPadding(
@@ -442,10 +608,30 @@ protected:
         ChooseCompressionParameters(const std::vector<uint8_t>& rawWeightsForZeroMaskCompression,
                                     const std::vector<uint8_t>& rawWeightsForNoZeroMaskCompression,
                                     const TensorInfo& weightsTensorInfo) const;
+
+    // Chooses the compression parameters for one OFM, as used by both EncodeOfm and EstimateOfmSize, and records
+    // them as the previous parameters for the CE. The raw weights to be compressed with them are returned in
+    // rawWeights.
+    WeightCompressionParamsV1
+        ChooseOfmCompressionParameters(const uint8_t* weightData,
+                                       uint32_t ofmIdx,
+                                       uint32_t numOfmInParallel,
+                                       uint32_t stripeDepth,
+                                       uint32_t iteration,
+                                       const TensorInfo& weightsTensorInfo,
+                                       uint32_t strideY,
+                                       uint32_t strideX,
+                                       uint32_t paddingTop,
+                                       uint32_t paddingLeft,
+                                       uint32_t iterationSize,
+                                       ethosn::command_stream::MceOperation operation,
+                                       CompilerMceAlgorithm algorithm,
+                                       std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParameters,
+                                       std::vector<uint8_t>& rawWeights) const;
 };
 
-WeightEncoderV1::WeightEncoderV1(const HardwareCapabilities& capabilities)
-    : WeightEncoder(capabilities)
+WeightEncoderV1::WeightEncoderV1(const HardwareCapabilities& capabilities, ThreadPool* threadPool)
+    : WeightEncoder(capabilities, threadPool)
 {}
 
 template <class T>
@@ -461,8 +647,8 @@ void insert_back(std::vector<uint8_t>& dst, const T& src)
     insert_back(dst, &src, sizeof(src));
 }
 
-WeightEncoderV2::WeightEncoderV2(const HardwareCapabilities& capabilities)
-    : WeightEncoder(capabilities)
+WeightEncoderV2::WeightEncoderV2(const HardwareCapabilities& capabilities, ThreadPool* threadPool)
+    : WeightEncoder(capabilities, threadPool)
     , m_Mode(WeightCompMode::AUTO)
 {}
 
@@ -482,6 +668,11 @@ std::vector<std::unique_ptr<WeightEncoder::WeightCompressionParams>>
     return params;
 }
 
+uint32_t WeightEncoderV2::GetCompressionParamsIdx(uint32_t ofmIdx, uint32_t numOfmInParallel, uint32_t stripeDepth) const
+{
+    return (ofmIdx % stripeDepth) % numOfmInParallel;
+}
+
 WeightEncoder::EncodedOfm
     WeightEncoderV2::EncodeOfm(const uint8_t* weightData,
                                uint32_t ofmIdx,
@@ -500,7 +691,58 @@ WeightEncoder::EncodedOfm
                                const EncodingParams& params,
                                std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams)
 {
-    uint32_t wdIdx = (ofmIdx % stripeDepth) % numOfmInParallel;
+    BitstreamWriter writer;
+    WriteOfm(weightData, ofmIdx, numOfmInParallel, numIterationsOfm, stripeDepth, iteration, weightsTensorInfo, strideY,
+             strideX, paddingTop, paddingLeft, iterationSize, operation, algorithm, params, compressionParams, writer);
+    return { std::move(writer.GetBitstream()), static_cast<uint32_t>(writer.GetOffset()) };
+}
+
+WeightEncoder::EncodedOfmSize
+    WeightEncoderV2::EstimateOfmSize(const uint8_t* weightData,
+                               uint32_t ofmIdx,
+                               uint32_t numOfmInParallel,
+                               uint32_t numIterationsOfm,
+                               uint32_t stripeDepth,
+                               uint32_t iteration,
+                               const TensorInfo& weightsTensorInfo,
+                               uint32_t strideY,
+                               uint32_t strideX,
+                               uint32_t paddingTop,
+                               uint32_t paddingLeft,
+                               uint32_t iterationSize,
+                               ethosn::command_stream::MceOperation operation,
+                               CompilerMceAlgorithm algorithm,
+                               const EncodingParams& params,
+                               std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams)
+{
+    // The packing of the chunks depends on the weights, so the stream is written to a writer which only counts the
+    // bits, rather than calculating its size from the compression parameters.
+    BitstreamWriter writer(true);
+    WriteOfm(weightData, ofmIdx, numOfmInParallel, numIterationsOfm, stripeDepth, iteration, weightsTensorInfo, strideY,
+             strideX, paddingTop, paddingLeft, iterationSize, operation, algorithm, params, compressionParams, writer);
+    const uint32_t numBits = static_cast<uint32_t>(writer.GetOffset());
+    return { utils::DivRoundUp(numBits, 8u), numBits };
+}
+
+void WeightEncoderV2::WriteOfm(const uint8_t* weightData,
+                              uint32_t ofmIdx,
+                              uint32_t numOfmInParallel,
+                              uint32_t numIterationsOfm,
+                              uint32_t stripeDepth,
+                              uint32_t iteration,
+                              const TensorInfo& weightsTensorInfo,
+                              uint32_t strideY,
+                              uint32_t strideX,
+                              uint32_t paddingTop,
+                              uint32_t paddingLeft,
+                              uint32_t iterationSize,
+                              ethosn::command_stream::MceOperation operation,
+                              CompilerMceAlgorithm algorithm,
+                              const EncodingParams& params,
+                              std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams,
+                              BitstreamWriter& writer)
+{
+    uint32_t wdIdx = GetCompressionParamsIdx(ofmIdx, numOfmInParallel, stripeDepth);
 
     // Grab a reference to previous compression parameters
     WeightCompressionParamsV2& prevCompParams = static_cast<WeightCompressionParamsV2&>(*compressionParams[wdIdx]);
@@ -533,12 +775,15 @@ WeightEncoder::EncodedOfm
 
     const bool ofmReload = GetOfmReload(compParams, prevCompParams, ofmIdx < numOfmInParallel);
 
-    BitstreamWriter writer;
-
     std::deque<WeightSymbol> weightSymbols, zeroSymbols;
 
     PaletteZrunEncode(uncompressedWeights, compParams, weightSymbols, zeroSymbols);
 
+    // Estimate the stream size from the headers plus the size of the weights if they were stored uncompressed
+    // (9 bits each). Compressed streams will usually be smaller than this.
+    constexpr size_t maxHeadersNumBits = 128 + 64 + 32 * 11;
+    writer.ReserveCapacity(maxHeadersNumBits + (weightSymbols.size() + zeroSymbols.size()) * 9);
+
     // Note the weight stream length will be filled later
     WriteWeightHeader(writer, 0xffff, params.m_OfmBias, ofmBiasSize, ofmReload, params.m_OfmScaleFactor,
                       params.m_OfmShift, params.m_OfmZeroPoint);
@@ -553,8 +798,13 @@ WeightEncoder::EncodedOfm
 
     // Remember current compression parameters
     prevCompParams = compParams;
+}
 
-    return { std::move(writer.GetBitstream()), static_cast<uint32_t>(writer.GetOffset()) };
+uint32_t WeightEncoderV2::GetOfmHeaderNumBits(const TensorInfo& weightsTensorInfo) const
+{
+    // The weight header with the OFM parameters reloaded (see WriteWeightHeader), followed by the payload header
+    // with the compression parameters reloaded but not the palette (see WritePayloadHeader).
+    return 16 + GetOfmBiasSize(weightsTensorInfo) * 8 + 1 + 16 + 6 + 8 + 17 + 1 + 3 + 3 + 1 + 5 + 1;
 }
 
 uint32_t WeightEncoderV2::GetOfmShiftOffset() const
@@ -1475,17 +1725,18 @@ void WeightEncoderV2::WritePayloadHeader(BitstreamWriter& writer,
 /*
  * Weight encoder base class
  */
-std::unique_ptr<WeightEncoder> WeightEncoder::CreateWeightEncoder(const HardwareCapabilities& capabilities)
+std::unique_ptr<WeightEncoder> WeightEncoder::CreateWeightEncoder(const HardwareCapabilities& capabilities,
+                                                                  ThreadPool* threadPool)
 {
     const uint32_t version = capabilities.GetWeightCompressionVersion();
 
     if (version == 0)
     {
-        return std::make_unique<WeightEncoderV1>(capabilities);
+        return std::make_unique<WeightEncoderV1>(capabilities, threadPool);
     }
     else if (version == 1)
     {
-        return std::make_unique<WeightEncoderV2>(capabilities);
+        return std::make_unique<WeightEncoderV2>(capabilities, threadPool);
     }
     else
     {
@@ -1493,8 +1744,9 @@ std::unique_ptr<WeightEncoder> WeightEncoder::CreateWeightEncoder(const Hardware
     }
 }
 
-WeightEncoder::WeightEncoder(const HardwareCapabilities& capabilities)
+WeightEncoder::WeightEncoder(const HardwareCapabilities& capabilities, ThreadPool* threadPool)
     : m_Capabilities(capabilities)
+    , m_ThreadPool(threadPool)
 {}
 
 EncodedWeights WeightEncoder::Encode(const MceOperationNode& mceOperation,
@@ -1544,20 +1796,47 @@ EncodedWeights WeightEncoder::Encode(const MceOperationNode& mceOperation,
     // clang-format on
 }
 
-EncodedWeights WeightEncoder::Encode(const TensorInfo& weightsTensorInfo,
-                                     const uint8_t* weightsData,
-                                     const TensorInfo& biasTensorInfo,
-                                     const int32_t* biasData,
-                                     const QuantizationInfo& inputQuantizationInfo,
-                                     const QuantizationInfo& outputQuantizationInfo,
-                                     uint32_t stripeDepth,
-                                     uint32_t strideY,
-                                     uint32_t strideX,
-                                     uint32_t paddingTop,
-                                     uint32_t paddingLeft,
-                                     uint32_t iterationSize,
-                                     ethosn::command_stream::MceOperation operation,
-                                     CompilerMceAlgorithm algorithm)
+EncodedWeightsSize WeightEncoder::EstimateEncodedSize(const MceOperationNode& mceOperation,
+                                                     uint32_t stripeDepth,
+                                                     uint32_t stripeSize,
+                                                     const QuantizationInfo& outputQuantizationInfo,
+                                                     const utils::Optional<float>& compressionSaving)
+{
+    // clang-format off
+    return EstimateEncodedSize(mceOperation.GetWeightsInfo(),
+                               static_cast<const uint8_t*>(mceOperation.GetWeightsData().data()),
+                               mceOperation.GetBiasInfo(),
+                               mceOperation.GetBiasData().data(),
+                               mceOperation.GetInputQuantizationInfo(0),
+                               outputQuantizationInfo,
+                               stripeDepth,
+                               mceOperation.GetStride().m_Y,
+                               mceOperation.GetStride().m_X,
+                               mceOperation.GetMceData().m_PadTop(),
+                               mceOperation.GetMceData().m_PadLeft(),
+                               stripeSize,
+                               mceOperation.GetMceData().m_Operation(),
+                               mceOperation.GetAlgorithm(),
+                               compressionSaving);
+    // clang-format on
+}
+
+WeightEncoder::EncodedOfmStreams WeightEncoder::EncodeOfmStreams(const TensorInfo& weightsTensorInfo,
+                                                                 const uint8_t* weightsData,
+                                                                 const TensorInfo& biasTensorInfo,
+                                                                 const int32_t* biasData,
+                                                                 const QuantizationInfo& inputQuantizationInfo,
+                                                                 const QuantizationInfo& outputQuantizationInfo,
+                                                                 uint32_t stripeDepth,
+                                                                 uint32_t strideY,
+                                                                 uint32_t strideX,
+                                                                 uint32_t paddingTop,
+                                                                 uint32_t paddingLeft,
+                                                                 uint32_t iterationSize,
+                                                                 ethosn::command_stream::MceOperation operation,
+                                                                 CompilerMceAlgorithm algorithm,
+                                                                 bool keepStreams,
+                                                                 const utils::Optional<float>& compressionSaving)
 {
     assert(stripeDepth > 0);
     assert(iterationSize > 0);
@@ -1593,8 +1872,7 @@ EncodedWeights WeightEncoder::Encode(const TensorInfo& weightsTensorInfo,
     // Number of Ofm processed in parallel which is the minimum number of
     // weights streams that need to be loaded at the same time for all the
     // mce interfaces to start producing an Ofm each.
-    uint32_t numSrams       = m_Capabilities.GetNumberOfSrams();
-    uint32_t numOfmsPerSram = m_Capabilities.GetNumberOfOfm() / numSrams;
+    uint32_t numSrams = m_Capabilities.GetNumberOfSrams();
 
     // The number of OFMs that can be processed in parallel is limited to the stripe depth
     uint32_t numOfmInParallel =
@@ -1604,14 +1882,21 @@ EncodedWeights WeightEncoder::Encode(const TensorInfo& weightsTensorInfo,
         GenerateCompressionParams(numOfmInParallel);
 
     // Encode each OFM stream independently
-    std::vector<std::vector<uint8_t>> encodedStreams;
-    encodedStreams.reserve(numOfms * numIterationsOfm);
-    std::vector<uint32_t> encodedNumBits;
-    encodedNumBits.reserve(numOfms * numIterationsOfm);
+    const uint32_t numOfmStreams = numOfms * numIterationsOfm;
+    EncodedOfmStreams result;
+    if (keepStreams)
+    {
+        result.m_Streams.resize(numOfmStreams);
+    }
+    result.m_NumBytes.resize(numOfmStreams);
+    result.m_NumBits.resize(numOfmStreams);
+    result.m_NumOfms          = numOfms;
+    result.m_NumIterationsOfm = numIterationsOfm;
+    result.m_NumOfmInParallel = numOfmInParallel;
+
     const auto numWeightScales = weightsTensorInfo.m_QuantizationInfo.GetScales().Size();
 
-    for (uint32_t ofm = 0; ofm < (numOfms * numIterationsOfm); ++ofm)
-    {
+    auto encodeOfmStream = [&](uint32_t ofm) {
         // numIterationsOfm >= 1, fully connected
         //                   = 1, otherwise
         uint32_t iteration = ofm % numIterationsOfm;
@@ -1630,14 +1915,100 @@ EncodedWeights WeightEncoder::Encode(const TensorInfo& weightsTensorInfo,
         params.m_OfmZeroPoint    = outputQuantizationInfo.GetZeroPoint();
         params.m_FilterZeroPoint = weightsTensorInfo.m_QuantizationInfo.GetZeroPoint();
 
-        EncodedOfm encodedOfm = EncodeOfm(weightsData, ofmIdx, numOfmInParallel, numIterationsOfm, stripeDepth,
-                                          iteration, weightsTensorInfo, strideY, strideX, paddingTop, paddingLeft,
-                                          iterationSize, operation, algorithm, params, compressionParams);
+        if (keepStreams)
+        {
+            EncodedOfm encodedOfm = EncodeOfm(weightsData, ofmIdx, numOfmInParallel, numIterationsOfm, stripeDepth,
+                                              iteration, weightsTensorInfo, strideY, strideX, paddingTop, paddingLeft,
+                                              iterationSize, operation, algorithm, params, compressionParams);
+
+            result.m_NumBytes[ofm] = static_cast<uint32_t>(encodedOfm.m_EncodedWeights.size());
+            result.m_NumBits[ofm]  = encodedOfm.m_NumOfBits;
+            result.m_Streams[ofm]  = std::move(encodedOfm.m_EncodedWeights);
+        }
+        else if (compressionSaving.has_value())
+        {
+            // The weights are assumed to compress as well as requested, so only their uncompressed size is needed
+            const uint32_t numWeights = static_cast<uint32_t>(
+                GetRawOfmStream(weightsData, ofmIdx, iteration, weightsTensorInfo, strideY, strideX, paddingTop,
+                                paddingLeft, iterationSize, operation, algorithm, false)
+                    .size());
+            const uint32_t numBits =
+                GetOfmHeaderNumBits(weightsTensorInfo) +
+                static_cast<uint32_t>(std::ceil(numWeights * 8.0 * (1.0 - compressionSaving.value())));
+            result.m_NumBytes[ofm] = utils::DivRoundUp(numBits, 8);
+            result.m_NumBits[ofm]  = numBits;
+        }
+        else
+        {
+            EncodedOfmSize encodedOfmSize =
+                EstimateOfmSize(weightsData, ofmIdx, numOfmInParallel, numIterationsOfm, stripeDepth, iteration,
+                                weightsTensorInfo, strideY, strideX, paddingTop, paddingLeft, iterationSize,
+                                operation, algorithm, params, compressionParams);
+
+            result.m_NumBytes[ofm] = encodedOfmSize.m_NumBytes;
+            result.m_NumBits[ofm]  = encodedOfmSize.m_NumOfBits;
+        }
+    };
+
+    if (m_ThreadPool == nullptr || m_ThreadPool->GetNumThreads() == 1)
+    {
+        for (uint32_t ofm = 0; ofm < numOfmStreams; ++ofm)
+        {
+            encodeOfmStream(ofm);
+        }
+    }
+    else
+    {
+        // The encoding of an OFM depends on the compression parameters chosen for the previous OFM which shares the
+        // same entry in compressionParams, so each of these chains must be encoded in order on a single thread.
+        // Different chains are independent and are encoded concurrently. Because every OFM writes its result to its
+        // own slot, the result is identical to that of the serial loop.
+        std::vector<std::vector<uint32_t>> ofmChains(compressionParams.size());
+        for (uint32_t ofm = 0; ofm < numOfmStreams; ++ofm)
+        {
+            const uint32_t ofmIdx = ofm / numIterationsOfm;
+            ofmChains[GetCompressionParamsIdx(ofmIdx, numOfmInParallel, stripeDepth)].push_back(ofm);
+        }
 
-        encodedStreams.push_back(std::move(encodedOfm.m_EncodedWeights));
-        encodedNumBits.push_back(encodedOfm.m_NumOfBits);
+        m_ThreadPool->ParallelFor(ofmChains.size(), [&](size_t chainIdx) {
+            for (uint32_t ofm : ofmChains[chainIdx])
+            {
+                encodeOfmStream(ofm);
+            }
+        });
     }
 
+    return result;
+}
+
+EncodedWeights WeightEncoder::Encode(const TensorInfo& weightsTensorInfo,
+                                     const uint8_t* weightsData,
+                                     const TensorInfo& biasTensorInfo,
+                                     const int32_t* biasData,
+                                     const QuantizationInfo& inputQuantizationInfo,
+                                     const QuantizationInfo& outputQuantizationInfo,
+                                     uint32_t stripeDepth,
+                                     uint32_t strideY,
+                                     uint32_t strideX,
+                                     uint32_t paddingTop,
+                                     uint32_t paddingLeft,
+                                     uint32_t iterationSize,
+                                     ethosn::command_stream::MceOperation operation,
+                                     CompilerMceAlgorithm algorithm)
+{
+    EncodedOfmStreams ofmStreams =
+        EncodeOfmStreams(weightsTensorInfo, weightsData, biasTensorInfo, biasData, inputQuantizationInfo,
+                         outputQuantizationInfo, stripeDepth, strideY, strideX, paddingTop, paddingLeft, iterationSize,
+                         operation, algorithm, true, utils::EmptyOptional());
+    const uint32_t numOfms          = ofmStreams.m_NumOfms;
+    const uint32_t numIterationsOfm = ofmStreams.m_NumIterationsOfm;
+    const uint32_t numOfmInParallel = ofmStreams.m_NumOfmInParallel;
+    const uint32_t numSrams         = m_Capabilities.GetNumberOfSrams();
+    const uint32_t numOfmsPerSram   = m_Capabilities.GetNumberOfOfm() / numSrams;
+
+    std::vector<std::vector<uint8_t>>& encodedStreams = ofmStreams.m_Streams;
+    const std::vector<uint32_t>& encodedNumBits       = ofmStreams.m_NumBits;
+
     constexpr uint32_t dmaEngineAlignment = 16;
 
     // Merge the OFM streams together so that all the OFMs that will be processed in the same stripe
@@ -1732,6 +2103,107 @@ EncodedWeights WeightEncoder::Encode(const TensorInfo& weightsTensorInfo,
     return encodedWeights;
 }
 
+EncodedWeightsSize WeightEncoder::EstimateEncodedSize(const TensorInfo& weightsTensorInfo,
+                                                     const uint8_t* weightsData,
+                                                     const TensorInfo& biasTensorInfo,
+                                                     const int32_t* biasData,
+                                                     const QuantizationInfo& inputQuantizationInfo,
+                                                     const QuantizationInfo& outputQuantizationInfo,
+                                                     uint32_t stripeDepth,
+                                                     uint32_t strideY,
+                                                     uint32_t strideX,
+                                                     uint32_t paddingTop,
+                                                     uint32_t paddingLeft,
+                                                     uint32_t iterationSize,
+                                                     ethosn::command_stream::MceOperation operation,
+                                                     CompilerMceAlgorithm algorithm,
+                                                     const utils::Optional<float>& compressionSaving)
+{
+    const EncodedOfmStreams ofmStreams =
+        EncodeOfmStreams(weightsTensorInfo, weightsData, biasTensorInfo, biasData, inputQuantizationInfo,
+                         outputQuantizationInfo, stripeDepth, strideY, strideX, paddingTop, paddingLeft, iterationSize,
+                         operation, algorithm, false, compressionSaving);
+    const uint32_t numOfms          = ofmStreams.m_NumOfms;
+    const uint32_t numIterationsOfm = ofmStreams.m_NumIterationsOfm;
+    const uint32_t numOfmInParallel = ofmStreams.m_NumOfmInParallel;
+    const uint32_t numSrams         = m_Capabilities.GetNumberOfSrams();
+
+    constexpr uint32_t dmaEngineAlignment = 16;
+
+    // This follows the same steps as Encode, but only tracks the length of each stream rather than its contents.
+    // See Encode for a description of how the OFM streams are merged into a stream per stripe and OG.
+    const uint32_t numOgs = numOfmInParallel * numIterationsOfm;
+    std::vector<uint32_t> streamPerStripeOgSizes;
+    const uint32_t numStripes = utils::DivRoundUp(numOfms, stripeDepth);
+    for (uint32_t stripeIdx = 0; stripeIdx < numStripes; ++stripeIdx)
+    {
+        const uint32_t firstOfmInStripe = stripeDepth * stripeIdx * numIterationsOfm;
+        const uint32_t lastOfmInStripe  = std::min<uint32_t>(numOfms, stripeDepth * (stripeIdx + 1)) * numIterationsOfm;
+
+        std::vector<uint32_t> ogSizes(numOgs, 0);
+        std::vector<uint32_t> ogNumBits(numOgs, 0);
+        for (uint32_t ofm = firstOfmInStripe; ofm < lastOfmInStripe; ++ofm)
+        {
+            const uint32_t ogIdx = (ofm - firstOfmInStripe) % numOgs;
+            if (m_Capabilities.GetWeightCompressionVersion() == 0)
+            {
+                // MergeStreams concatenates whole streams
+                ogSizes[ogIdx] += ofmStreams.m_NumBytes[ofm];
+            }
+            else
+            {
+                // MergeStreamsOg packs each stream directly after the last bit of the previous one, unless that
+                // ended on a byte boundary, in which case the whole of the new stream is appended
+                const uint32_t bitPos = ogNumBits[ogIdx] % 8;
+                if (bitPos == 0)
+                {
+                    ogSizes[ogIdx] += ofmStreams.m_NumBytes[ofm];
+                }
+                else
+                {
+                    ogSizes[ogIdx] += utils::DivRoundUp(bitPos + ofmStreams.m_NumBits[ofm], 8) - 1;
+                }
+                ogNumBits[ogIdx] += ofmStreams.m_NumBits[ofm];
+            }
+        }
+        streamPerStripeOgSizes.insert(streamPerStripeOgSizes.end(), ogSizes.begin(), ogSizes.end());
+    }
+
+    // All streams are padded to the same size, which is a multiple of the DMA alignment
+    uint32_t maxLength = 0;
+    for (uint32_t size : streamPerStripeOgSizes)
+    {
+        maxLength = std::max(maxLength, size);
+    }
+    const uint32_t paddedLength = utils::RoundUpToNearestMultiple(maxLength, dmaEngineAlignment);
+
+    EncodedWeightsSize result;
+
+    // See CalculateWeightsMetadata
+    result.m_MaxSize          = 0;
+    uint32_t runningSize      = 0;
+    const uint32_t numStreams = static_cast<uint32_t>(streamPerStripeOgSizes.size());
+    for (uint32_t i = 0; i < numStreams; i += numOfmInParallel)
+    {
+        const uint32_t stripeSize = paddedLength * numOfmInParallel;
+        result.m_Metadata.push_back(WeightsMetadata{ runningSize, stripeSize });
+        runningSize += stripeSize;
+        result.m_MaxSize = std::max(result.m_MaxSize, stripeSize);
+    }
+
+    // The streams are merged into one per SRAM (see MergeStreams) and these are then interleaved, padding the
+    // shorter ones with zeroes, so the total size is determined by the SRAM with the most streams.
+    std::vector<uint32_t> numStreamsPerSram(numSrams, 0);
+    for (uint32_t streamIdx = 0; streamIdx < numStreams; ++streamIdx)
+    {
+        ++numStreamsPerSram[(streamIdx / numIterationsOfm) % numSrams];
+    }
+    const uint32_t maxNumStreamsPerSram = *std::max_element(numStreamsPerSram.begin(), numStreamsPerSram.end());
+    result.m_TotalSize                  = maxNumStreamsPerSram * paddedLength * numSrams;
+
+    return result;
+}
+
 /* Calculate the size if the weights are compressed with zero compression */
 static size_t CalcZeroCompressionSize(size_t nbrElements, size_t nbrZeros, size_t numSrams)
 {
@@ -2283,28 +2755,33 @@ std::vector<std::unique_ptr<WeightEncoder::WeightCompressionParams>>
     return params;
 }
 
-WeightEncoder::EncodedOfm
-    WeightEncoderV1::EncodeOfm(const uint8_t* weightData,
-                               uint32_t ofmIdx,
-                               uint32_t numOfmInParallel,
-                               uint32_t,
-                               uint32_t,
-                               uint32_t iteration,
-                               const TensorInfo& weightsTensorInfo,
-                               uint32_t strideY,
-                               uint32_t strideX,
-                               uint32_t paddingTop,
-                               uint32_t paddingLeft,
-                               uint32_t iterationSize,
-                               ethosn::command_stream::MceOperation operation,
-                               CompilerMceAlgorithm algorithm,
-                               const EncodingParams& params,
-                               std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParameters)
+uint32_t WeightEncoderV1::GetCompressionParamsIdx(uint32_t ofmIdx, uint32_t numOfmInParallel, uint32_t) const
+{
+    return ofmIdx % numOfmInParallel;
+}
+
+WeightEncoderV1::WeightCompressionParamsV1 WeightEncoderV1::ChooseOfmCompressionParameters(
+    const uint8_t* weightData,
+    uint32_t ofmIdx,
+    uint32_t numOfmInParallel,
+    uint32_t stripeDepth,
+    uint32_t iteration,
+    const TensorInfo& weightsTensorInfo,
+    uint32_t strideY,
+    uint32_t strideX,
+    uint32_t paddingTop,
+    uint32_t paddingLeft,
+    uint32_t iterationSize,
+    ethosn::command_stream::MceOperation operation,
+    CompilerMceAlgorithm algorithm,
+    std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParameters,
+    std::vector<uint8_t>& rawWeights) const
 {
     // Lookup the compression parameters for the previous OFM associated with the same CE. This is used
     // to modify the compression of this current OFM.
     WeightCompressionParamsV1& previousOfmSameCeCompressionParams =
-        static_cast<WeightCompressionParamsV1&>(*compressionParameters[ofmIdx % numOfmInParallel]);
+        static_cast<WeightCompressionParamsV1&>(
+            *compressionParameters[GetCompressionParamsIdx(ofmIdx, numOfmInParallel, stripeDepth)]);
 
     // Get the raw (unencoded) weight stream. Note we must do this twice - once to get a stream suited
     // for zero mask compression and again to get one suited to no zero mask compression. Yuck!
@@ -2318,8 +2795,8 @@ WeightEncoder::EncodedOfm
     // Choose the best compression scheme
     WeightCompressionParamsV1 compressionParams = ChooseCompressionParameters(
         rawWeightsForZeroMaskCompression, rawWeightsForNoZeroMaskCompression, weightsTensorInfo);
-    std::vector<uint8_t>& rawWeights =
-        compressionParams.m_MaskEnable ? rawWeightsForZeroMaskCompression : rawWeightsForNoZeroMaskCompression;
+    rawWeights = std::move(compressionParams.m_MaskEnable ? rawWeightsForZeroMaskCompression
+                                                          : rawWeightsForNoZeroMaskCompression);
 
     // If the Lut is the same as for previous OFM for the current CE then don't reload it
     const uint32_t numOfmsPerSram = m_Capabilities.GetNumberOfOfm() / m_Capabilities.GetNumberOfSrams();
@@ -2332,9 +2809,37 @@ WeightEncoder::EncodedOfm
         compressionParams.m_LutReload = false;
     }
 
+    previousOfmSameCeCompressionParams = compressionParams;
+    return compressionParams;
+}
+
+WeightEncoder::EncodedOfm
+    WeightEncoderV1::EncodeOfm(const uint8_t* weightData,
+                               uint32_t ofmIdx,
+                               uint32_t numOfmInParallel,
+                               uint32_t,
+                               uint32_t stripeDepth,
+                               uint32_t iteration,
+                               const TensorInfo& weightsTensorInfo,
+                               uint32_t strideY,
+                               uint32_t strideX,
+                               uint32_t paddingTop,
+                               uint32_t paddingLeft,
+                               uint32_t iterationSize,
+                               ethosn::command_stream::MceOperation operation,
+                               CompilerMceAlgorithm algorithm,
+                               const EncodingParams& params,
+                               std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParameters)
+{
+    std::vector<uint8_t> rawWeights;
+    const WeightCompressionParamsV1 compressionParams = ChooseOfmCompressionParameters(
+        weightData, ofmIdx, numOfmInParallel, stripeDepth, iteration, weightsTensorInfo, strideY, strideX, paddingTop,
+        paddingLeft, iterationSize, operation, algorithm, compressionParameters, rawWeights);
+
     EncodedOfm result{};
-    previousOfmSameCeCompressionParams   = compressionParams;
     std::vector<uint8_t>& encodedWeights = result.m_EncodedWeights;
+    // Worst case is the header and LUT followed by uncompressed weights, each with a bit of zero mask
+    encodedWeights.reserve(sizeof(WeightHeader) + compressionParams.m_Lut.size() + (rawWeights.size() * 9 + 7) / 8);
 
     // Add the per-OFM header.
     encodedWeights.insert(encodedWeights.end(), sizeof(WeightHeader), 0);
@@ -2358,7 +2863,7 @@ WeightEncoder::EncodedOfm
     // Compress each weight using the above chosen compression parameters
     std::shared_ptr<WeightCompressor> compressor = CreateWeightCompressor(
         encodedWeights, compressionParams.m_IndexSize, compressionParams.m_Lut, compressionParams.m_LutReload,
-        compressionParams.m_MaskEnable, params.m_FilterZeroPoint, m_Capabilities.GetNumberOfSrams());
+        compressionParams.m_MaskEnable, params.m_FilterZeroPoint, m_Capabilities.GetNumberOfSrams(), rawWeights.size());
 
     for (size_t i = 0; i < rawWeights.size(); ++i)
     {
@@ -2370,6 +2875,68 @@ WeightEncoder::EncodedOfm
     return result;
 }
 
+WeightEncoder::EncodedOfmSize
+    WeightEncoderV1::EstimateOfmSize(const uint8_t* weightData,
+                                     uint32_t ofmIdx,
+                                     uint32_t numOfmInParallel,
+                                     uint32_t,
+                                     uint32_t stripeDepth,
+                                     uint32_t iteration,
+                                     const TensorInfo& weightsTensorInfo,
+                                     uint32_t strideY,
+                                     uint32_t strideX,
+                                     uint32_t paddingTop,
+                                     uint32_t paddingLeft,
+                                     uint32_t iterationSize,
+                                     ethosn::command_stream::MceOperation operation,
+                                     CompilerMceAlgorithm algorithm,
+                                     const EncodingParams& params,
+                                     std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParameters)
+{
+    std::vector<uint8_t> rawWeights;
+    const WeightCompressionParamsV1 compressionParams = ChooseOfmCompressionParameters(
+        weightData, ofmIdx, numOfmInParallel, stripeDepth, iteration, weightsTensorInfo, strideY, strideX, paddingTop,
+        paddingLeft, iterationSize, operation, algorithm, compressionParameters, rawWeights);
+
+    // The size of the stream that the compressor chosen by CreateWeightCompressor would produce.
+    // The compressors which use a bitstream round it up to a whole number of bytes.
+    const uint32_t numWeights     = static_cast<uint32_t>(rawWeights.size());
+    const uint32_t bitsPerElement = (compressionParams.m_IndexSize != 0) ? compressionParams.m_IndexSize + 2 : 8;
+    const uint32_t lutNumBits =
+        compressionParams.m_LutReload ? static_cast<uint32_t>(compressionParams.m_Lut.size()) * 8 : 0;
+    uint32_t numPayloadBytes;
+    if (compressionParams.m_MaskEnable)
+    {
+        // Each block has a mask with a bit per weight, followed by an index for each weight which is not the
+        // zero point. The last block is padded with the zero point, which is written if it doesn't fit in a weight.
+        const uint32_t blockSize = m_Capabilities.GetNumberOfSrams();
+        const uint32_t numBlocks = utils::DivRoundUp(numWeights, blockSize);
+        const uint32_t zeroPoint = params.m_FilterZeroPoint;
+        uint32_t numIndices      = static_cast<uint32_t>(
+            std::count_if(rawWeights.begin(), rawWeights.end(), [zeroPoint](uint8_t w) { return w != zeroPoint; }));
+        if (static_cast<uint8_t>(zeroPoint) != zeroPoint)
+        {
+            numIndices += numBlocks * blockSize - numWeights;
+        }
+        numPayloadBytes = utils::DivRoundUp(lutNumBits + numBlocks * blockSize + numIndices * bitsPerElement, 8);
+    }
+    else if (compressionParams.m_IndexSize != 0)
+    {
+        numPayloadBytes = utils::DivRoundUp(lutNumBits + numWeights * bitsPerElement, 8);
+    }
+    else
+    {
+        numPayloadBytes = numWeights;
+    }
+
+    return { static_cast<uint32_t>(sizeof(WeightHeader)) + numPayloadBytes, 0 };
+}
+
+uint32_t WeightEncoderV1::GetOfmHeaderNumBits(const TensorInfo&) const
+{
+    return static_cast<uint32_t>(sizeof(WeightHeader)) * 8;
+}
+
 uint32_t WeightEncoderV1::GetOfmShiftOffset() const
 {
     return 0;
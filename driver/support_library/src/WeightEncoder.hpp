@@ -23,6 +23,7 @@ constexpr uint32_t g_WeightsChannelVecProd = 1024U;
 class Constant;
 class HardwareCapabilities;
 class MceOperationNode;
+class ThreadPool;
 
 struct WeightsMetadata
 {
@@ -37,15 +38,29 @@ struct EncodedWeights
     std::vector<uint8_t> m_Data;
 };
 
+/// The layout of some encoded weights without the encoded data itself, as returned by
+/// WeightEncoder::EstimateEncodedSize. The fields match those of the EncodedWeights that WeightEncoder::Encode
+/// would return for the same arguments.
+struct EncodedWeightsSize
+{
+    std::vector<WeightsMetadata> m_Metadata;
+    uint32_t m_MaxSize;
+    /// Equal to the size of EncodedWeights::m_Data.
+    uint32_t m_TotalSize;
+};
+
 class WeightEncoder
 {
 public:
     /**
      * Factory function that selects which weight encoder to use based on the hardware capabilities.
+     * If a thread pool is given then the OFM streams are encoded concurrently on it. The encoded weights are
+     * identical regardless of the number of threads used.
      */
-    static std::unique_ptr<WeightEncoder> CreateWeightEncoder(const HardwareCapabilities& capabilities);
+    static std::unique_ptr<WeightEncoder> CreateWeightEncoder(const HardwareCapabilities& capabilities,
+                                                              ThreadPool* threadPool = nullptr);
 
-    WeightEncoder(const HardwareCapabilities& capabilities);
+    WeightEncoder(const HardwareCapabilities& capabilities, ThreadPool* threadPool = nullptr);
 
     virtual ~WeightEncoder() = default;
 
@@ -77,6 +92,33 @@ public:
                           ethosn::command_stream::MceOperation operation,
                           CompilerMceAlgorithm algorithm);
 
+    /// Calculates the size of each weight stripe and the total size of the weights that Encode would produce,
+    /// without building the final encoded data. The compression parameters of each OFM are chosen as Encode does,
+    /// but only the size of the resulting stream is calculated. This is intended for performance estimation.
+    /// If compressionSaving is given then the weights are not analysed at all: each OFM is instead assumed to be
+    /// compressed to that proportion less than its uncompressed size.
+    EncodedWeightsSize EstimateEncodedSize(const MceOperationNode& mceOperation,
+                                           uint32_t stripeDepth,
+                                           uint32_t stripeSize,
+                                           const QuantizationInfo& outputQuantizationInfo,
+                                           const utils::Optional<float>& compressionSaving = utils::EmptyOptional());
+
+    EncodedWeightsSize EstimateEncodedSize(const TensorInfo& weightsTensorInfo,
+                                           const uint8_t* weightsData,
+                                           const TensorInfo& biasTensorInfo,
+                                           const int32_t* biasData,
+                                           const QuantizationInfo& inputQuantizationInfo,
+                                           const QuantizationInfo& outputQuantizationInfo,
+                                           uint32_t stripeDepth,
+                                           uint32_t strideY,
+                                           uint32_t strideX,
+                                           uint32_t paddingTop,
+                                           uint32_t paddingLeft,
+                                           uint32_t iterationSize,
+                                           ethosn::command_stream::MceOperation operation,
+                                           CompilerMceAlgorithm algorithm,
+                                           const utils::Optional<float>& compressionSaving = utils::EmptyOptional());
+
 protected:
     struct EncodingParams
     {
@@ -93,11 +135,48 @@ protected:
         uint32_t m_NumOfBits;
     };
 
+    struct EncodedOfmSize
+    {
+        uint32_t m_NumBytes;
+        uint32_t m_NumOfBits;
+    };
+
     struct WeightCompressionParams
     {
         virtual ~WeightCompressionParams() = default;
     };
 
+    /// The encoded streams for every OFM (and iteration of each OFM, for fully connected), before they are merged.
+    struct EncodedOfmStreams
+    {
+        /// Empty if only the sizes were requested.
+        std::vector<std::vector<uint8_t>> m_Streams;
+        std::vector<uint32_t> m_NumBytes;
+        std::vector<uint32_t> m_NumBits;
+        uint32_t m_NumOfms;
+        uint32_t m_NumIterationsOfm;
+        uint32_t m_NumOfmInParallel;
+    };
+
+    /// Encodes each OFM stream independently. If keepStreams is false then only the size of each stream is
+    /// calculated, using EstimateOfmSize, or from compressionSaving if that is given.
+    EncodedOfmStreams EncodeOfmStreams(const TensorInfo& weightsTensorInfo,
+                                       const uint8_t* weightsData,
+                                       const TensorInfo& biasTensorInfo,
+                                       const int32_t* biasData,
+                                       const QuantizationInfo& inputQuantizationInfo,
+                                       const QuantizationInfo& outputQuantizationInfo,
+                                       uint32_t stripeDepth,
+                                       uint32_t strideY,
+                                       uint32_t strideX,
+                                       uint32_t paddingTop,
+                                       uint32_t paddingLeft,
+                                       uint32_t iterationSize,
+                                       ethosn::command_stream::MceOperation operation,
+                                       CompilerMceAlgorithm algorithm,
+                                       bool keepStreams,
+                                       const utils::Optional<float>& compressionSaving);
+
     // Calculates the exact offset and size in DRAM of each weight stripe
     std::vector<WeightsMetadata> CalculateWeightsMetadata(const std::vector<std::vector<uint8_t>>& streamPerStripeOg,
                                                           uint32_t numOgPerStripe) const;
@@ -120,6 +199,11 @@ protected:
     virtual std::vector<std::unique_ptr<WeightCompressionParams>>
         GenerateCompressionParams(uint32_t numOfmInParallel) = 0;
 
+    /// Gets the index of the entry in the vector returned by GenerateCompressionParams that EncodeOfm reads and
+    /// updates when encoding the given OFM. OFMs sharing an entry depend on each other and must be encoded in order,
+    /// whereas OFMs using different entries are independent and can be encoded concurrently.
+    virtual uint32_t GetCompressionParamsIdx(uint32_t ofmIdx, uint32_t numOfmInParallel, uint32_t stripeDepth) const = 0;
+
     /// Encodes all the weights required to calculate a single OFM.
     virtual EncodedOfm EncodeOfm(const uint8_t* weightData,
                                  uint32_t ofmIdx,
@@ -138,6 +222,30 @@ protected:
                                  const EncodingParams& params,
                                  std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams) = 0;
 
+    /// Calculates the size of the stream that EncodeOfm would return for the same arguments, updating
+    /// compressionParams in the same way, without building the stream itself.
+    virtual EncodedOfmSize
+        EstimateOfmSize(const uint8_t* weightData,
+                        uint32_t ofmIdx,
+                        uint32_t numOfmInParallel,
+                        uint32_t numIterationsOfm,
+                        uint32_t numOfmSetsPerStripe,
+                        uint32_t iteration,
+                        const TensorInfo& weightsTensorInfo,
+                        uint32_t strideY,
+                        uint32_t strideX,
+                        uint32_t paddingTop,
+                        uint32_t paddingLeft,
+                        uint32_t iterationSize,
+                        ethosn::command_stream::MceOperation operation,
+                        CompilerMceAlgorithm algorithm,
+                        const EncodingParams& params,
+                        std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams) = 0;
+
+    /// Gets the number of bits in the headers which EncodeOfm writes before the weights of an OFM whose parameters
+    /// are all reloaded (not counting any LUT or palette, which depend on the weights).
+    virtual uint32_t GetOfmHeaderNumBits(const TensorInfo& weightsTensorInfo) const = 0;
+
     /// Merges the given streams of data into 'numGroups' groups, using a round-robin allocation of streams to groups.
     /// All the streams in a group are then concatenated together.
     ///
@@ -192,6 +300,9 @@ protected:
 
     /// Hardware capabilities.
     const HardwareCapabilities& m_Capabilities;
+
+    /// Pool used to encode OFM streams concurrently, or nullptr to encode them serially.
+    ThreadPool* m_ThreadPool;
 };
 
 }    // namespace support_library
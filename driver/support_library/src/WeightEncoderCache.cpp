@@ -0,0 +1,220 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "WeightEncoderCache.hpp"
+
+#include "GraphNodes.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+
+#include <cstring>
+
+namespace ethosn
+{
+namespace support_library
+{
+
+WeightEncoderCache::WeightEncoderCache(size_t maxSizeBytes)
+    : m_MaxSizeBytes(maxSizeBytes)
+    , m_SizeBytes(0)
+{}
+
+WeightEncoderCache::Params WeightEncoderCache::GetParams(const MceOperationNode& mceOperation,
+                                                         uint32_t stripeDepth,
+                                                         uint32_t stripeSize,
+                                                         const QuantizationInfo& outputQuantizationInfo)
+{
+    Params params;
+    params.weightsAndBiasHash     = mceOperation.GetWeightsAndBiasHash();
+    params.weightsTensorInfo      = mceOperation.GetWeightsInfo();
+    params.weightsData            = mceOperation.GetWeightsData().data();
+    params.biasTensorInfo         = mceOperation.GetBiasInfo();
+    params.biasData               = mceOperation.GetBiasData().data();
+    params.inputQuantizationInfo  = mceOperation.GetInputQuantizationInfo(0);
+    params.outputQuantizationInfo = outputQuantizationInfo;
+    params.stripeDepth            = stripeDepth;
+    params.strideY                = mceOperation.GetStride().m_Y;
+    params.strideX                = mceOperation.GetStride().m_X;
+    params.paddingTop             = mceOperation.GetPadTop();
+    params.paddingLeft            = mceOperation.GetPadLeft();
+    params.iterationSize          = stripeSize;
+    params.operation              = mceOperation.GetOperation();
+    params.algorithm              = mceOperation.GetAlgorithm();
+    return params;
+}
+
+std::shared_ptr<const EncodedWeights>
+    WeightEncoderCache::Encode(const HardwareCapabilities& caps, ThreadPool& threadPool, const Params& params)
+{
+    const Key key = CreateKey(caps, params);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Entries.find(key);
+        if (it != m_Entries.end() && it->second.m_EncodedWeights)
+        {
+            return Touch(key).m_EncodedWeights;
+        }
+    }
+
+    // Encode without holding the lock, so that other threads can use the cache in the meantime.
+    // If two threads encode the same weights at once they will produce the same result, so it does not matter
+    // which one ends up in the cache.
+    std::unique_ptr<WeightEncoder> encoder = WeightEncoder::CreateWeightEncoder(caps, &threadPool);
+    std::shared_ptr<const EncodedWeights> encodedWeights = std::make_shared<const EncodedWeights>(
+        encoder->Encode(params.weightsTensorInfo, params.weightsData, params.biasTensorInfo, params.biasData,
+                        params.inputQuantizationInfo, params.outputQuantizationInfo, params.stripeDepth,
+                        params.strideY, params.strideX, params.paddingTop, params.paddingLeft, params.iterationSize,
+                        params.operation, params.algorithm));
+
+    EncodedWeightsSize encodedWeightsSize = { encodedWeights->m_Metadata, encodedWeights->m_MaxSize,
+                                              static_cast<uint32_t>(encodedWeights->m_Data.size()) };
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Entry& entry               = Touch(key);
+    entry.m_EncodedWeights     = encodedWeights;
+    entry.m_EncodedWeightsSize = std::make_unique<EncodedWeightsSize>(encodedWeightsSize);
+    Resize(entry, sizeof(Key) + sizeof(Entry) + sizeof(EncodedWeights) + encodedWeights->m_Data.size() +
+                      encodedWeights->m_Metadata.size() * sizeof(encodedWeights->m_Metadata[0]));
+    return encodedWeights;
+}
+
+EncodedWeightsSize WeightEncoderCache::EstimateEncodedSize(const HardwareCapabilities& caps,
+                                                           ThreadPool& threadPool,
+                                                           const Params& params,
+                                                           const utils::Optional<float>& compressionSaving)
+{
+    const Key key = CreateKey(caps, params, compressionSaving);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Entries.find(key);
+        if (it != m_Entries.end() && it->second.m_EncodedWeightsSize)
+        {
+            return *Touch(key).m_EncodedWeightsSize;
+        }
+    }
+
+    std::unique_ptr<WeightEncoder> encoder = WeightEncoder::CreateWeightEncoder(caps, &threadPool);
+    EncodedWeightsSize encodedWeightsSize = encoder->EstimateEncodedSize(
+        params.weightsTensorInfo, params.weightsData, params.biasTensorInfo, params.biasData,
+        params.inputQuantizationInfo, params.outputQuantizationInfo, params.stripeDepth, params.strideY,
+        params.strideX, params.paddingTop, params.paddingLeft, params.iterationSize, params.operation,
+        params.algorithm, compressionSaving);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Entry& entry = Touch(key);
+    if (!entry.m_EncodedWeightsSize)
+    {
+        entry.m_EncodedWeightsSize = std::make_unique<EncodedWeightsSize>(encodedWeightsSize);
+        Resize(entry, sizeof(Key) + sizeof(Entry) + sizeof(EncodedWeightsSize) +
+                          encodedWeightsSize.m_Metadata.size() * sizeof(encodedWeightsSize.m_Metadata[0]));
+    }
+    return encodedWeightsSize;
+}
+
+WeightEncoderCache::Entry& WeightEncoderCache::Touch(const Key& key)
+{
+    auto inserted = m_Entries.emplace(key, Entry());
+    Entry& entry  = inserted.first->second;
+    if (inserted.second)
+    {
+        m_Lru.push_front(&inserted.first->first);
+        entry.m_LruIt = m_Lru.begin();
+    }
+    else
+    {
+        m_Lru.splice(m_Lru.begin(), m_Lru, entry.m_LruIt);
+    }
+    return entry;
+}
+
+void WeightEncoderCache::Resize(Entry& entry, size_t sizeBytes)
+{
+    m_SizeBytes       = m_SizeBytes - entry.m_SizeBytes + sizeBytes;
+    entry.m_SizeBytes = sizeBytes;
+
+    while (m_SizeBytes > m_MaxSizeBytes && m_Lru.back() != *entry.m_LruIt)
+    {
+        auto it = m_Entries.find(*m_Lru.back());
+        m_SizeBytes -= it->second.m_SizeBytes;
+        m_Lru.pop_back();
+        m_Entries.erase(it);
+    }
+}
+
+bool WeightEncoderCache::Key::operator==(const Key& r) const
+{
+    return weightsAndBiasHash == r.weightsAndBiasHash && weightsTensorInfo == r.weightsTensorInfo &&
+           biasTensorInfo == r.biasTensorInfo && inputQuantizationInfo == r.inputQuantizationInfo &&
+           outputQuantizationInfo == r.outputQuantizationInfo && stripeDepth == r.stripeDepth &&
+           strideY == r.strideY && strideX == r.strideX && paddingTop == r.paddingTop &&
+           paddingLeft == r.paddingLeft && iterationSize == r.iterationSize && operation == r.operation &&
+           algorithm == r.algorithm && compressionSaving == r.compressionSaving &&
+           weightCompressionVersion == r.weightCompressionVersion &&
+           numSrams == r.numSrams && numOfms == r.numOfms && numEngines == r.numEngines &&
+           ifmPerEngine == r.ifmPerEngine && wideKernelSize == r.wideKernelSize;
+}
+
+size_t WeightEncoderCache::KeyHasher::operator()(const Key& k) const
+{
+    // The content hashes already distinguish different weights, so only the parameters which commonly differ
+    // between encodings of the same weights are added. Any part of a digest is as good a hash as any other.
+    size_t h;
+    std::memcpy(&h, k.weightsAndBiasHash.data(), sizeof(h));
+    h = utils::CombineHash(h, std::hash<uint32_t>()(k.stripeDepth));
+    h = utils::CombineHash(h, std::hash<uint32_t>()(k.iterationSize));
+    // Note we cast the enum to an integral type, as some compilers (e.g. aarch64-linux-gnu-g++ 5.3.1)
+    // don't support using the enum type directly, even though the spec indicates that they should.
+    h = utils::CombineHash(h, std::hash<uint32_t>()(static_cast<uint32_t>(k.algorithm)));
+    h = utils::CombineHash(h, std::hash<uint32_t>()(k.weightCompressionVersion));
+    return h;
+}
+
+WeightEncoderCache::ContentHash WeightEncoderCache::HashData(const void* data, size_t numBytes)
+{
+    return Sha256::Hash(data, numBytes);
+}
+
+WeightEncoderCache::ContentHash WeightEncoderCache::HashWeightsAndBias(const uint8_t* weightsData,
+                                                                      size_t numWeights,
+                                                                      const int32_t* biasData,
+                                                                      size_t numBiases)
+{
+    Sha256 sha;
+    sha.Update(weightsData, numWeights);
+    sha.Update(biasData, numBiases * sizeof(int32_t));
+    return sha.Finalize();
+}
+
+WeightEncoderCache::Key WeightEncoderCache::CreateKey(const HardwareCapabilities& caps,
+                                                     const Params& params,
+                                                     const utils::Optional<float>& compressionSaving)
+{
+    Key key;
+    // When a compression saving is given the size doesn't depend on the data
+    key.weightsAndBiasHash       = compressionSaving.has_value() ? ContentHash{} : params.weightsAndBiasHash;
+    key.weightsTensorInfo        = params.weightsTensorInfo;
+    key.biasTensorInfo           = params.biasTensorInfo;
+    key.inputQuantizationInfo    = params.inputQuantizationInfo;
+    key.outputQuantizationInfo   = params.outputQuantizationInfo;
+    key.stripeDepth              = params.stripeDepth;
+    key.strideY                  = params.strideY;
+    key.strideX                  = params.strideX;
+    key.paddingTop               = params.paddingTop;
+    key.paddingLeft              = params.paddingLeft;
+    key.iterationSize            = params.iterationSize;
+    key.operation                = params.operation;
+    key.algorithm                = params.algorithm;
+    key.compressionSaving        = compressionSaving;
+    key.weightCompressionVersion = caps.GetWeightCompressionVersion();
+    key.numSrams                 = caps.GetNumberOfSrams();
+    key.numOfms                  = caps.GetNumberOfOfm();
+    key.numEngines               = caps.GetNumberOfEngines();
+    key.ifmPerEngine             = caps.GetIfmPerEngine();
+    key.wideKernelSize           = caps.GetWideKernelSize();
+    return key;
+}
+
+}    // namespace support_library
+}    // namespace ethosn
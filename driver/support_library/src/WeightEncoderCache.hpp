@@ -0,0 +1,158 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include "Sha256.hpp"
+#include "WeightEncoder.hpp"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace ethosn
+{
+namespace support_library
+{
+
+class HardwareCapabilities;
+class ThreadPool;
+
+/// Caches the results of encoding weights, so that the same weights are not encoded more than once
+/// (e.g. for different Plans of the same Part, or when recompiling a network with different options).
+/// Entries are keyed by the SHA-256 digest of the weight and bias data, together with all the other parameters
+/// which affect the encoding, so the data itself does not need to be kept alive or copied. The digest is given by
+/// the caller, so that it is calculated once for each set of weights rather than on every lookup.
+/// Once the encoded weights held take up more than a given number of bytes, the least recently used entries are
+/// evicted, so a cache which is shared between many compilations does not grow without limit.
+/// A cache is safe to use from multiple threads at once, and with different hardware capabilities.
+class WeightEncoderCache
+{
+public:
+    /// Creates a cache which holds roughly at most the given number of bytes of encoded weights.
+    explicit WeightEncoderCache(size_t maxSizeBytes);
+
+    /// The SHA-256 digest of some data, used in place of the data itself.
+    using ContentHash = Sha256::Digest;
+
+    /// The arguments to WeightEncoder::Encode. The data is only read during the call to the cache.
+    struct Params
+    {
+        /// The digest of weightsData and biasData, as returned by HashWeightsAndBias.
+        ContentHash weightsAndBiasHash;
+        TensorInfo weightsTensorInfo;
+        const uint8_t* weightsData;
+        TensorInfo biasTensorInfo;
+        const int32_t* biasData;
+        QuantizationInfo inputQuantizationInfo;
+        QuantizationInfo outputQuantizationInfo;
+        uint32_t stripeDepth;
+        uint32_t strideY;
+        uint32_t strideX;
+        uint32_t paddingTop;
+        uint32_t paddingLeft;
+        uint32_t iterationSize;
+        ethosn::command_stream::MceOperation operation;
+        CompilerMceAlgorithm algorithm;
+    };
+
+    /// Gets the params to encode the weights of the given MCE operation, as used by WeightEncoder::Encode.
+    static Params GetParams(const MceOperationNode& mceOperation,
+                            uint32_t stripeDepth,
+                            uint32_t stripeSize,
+                            const QuantizationInfo& outputQuantizationInfo);
+
+    /// Hashes the given data. This is also used to identify other data which is too big to compare directly.
+    static ContentHash HashData(const void* data, size_t numBytes);
+
+    /// Hashes the weight and bias data of an MCE operation together, for Params::weightsAndBiasHash.
+    static ContentHash
+        HashWeightsAndBias(const uint8_t* weightsData, size_t numWeights, const int32_t* biasData, size_t numBiases);
+
+    /// Returns the result of WeightEncoder::Encode, encoding the weights only if they are not already in the cache.
+    /// The result is shared with the cache rather than copied, and must not be modified.
+    std::shared_ptr<const EncodedWeights>
+        Encode(const HardwareCapabilities& caps, ThreadPool& threadPool, const Params& params);
+
+    /// Returns the result of WeightEncoder::EstimateEncodedSize, calculating it only if the weights (or their size)
+    /// are not already in the cache. When a compressionSaving is given the size does not depend on the values of the
+    /// weights, so they are not hashed.
+    EncodedWeightsSize EstimateEncodedSize(const HardwareCapabilities& caps,
+                                           ThreadPool& threadPool,
+                                           const Params& params,
+                                           const utils::Optional<float>& compressionSaving = utils::EmptyOptional());
+
+private:
+    struct Key
+    {
+        ContentHash weightsAndBiasHash;
+        TensorInfo weightsTensorInfo;
+        TensorInfo biasTensorInfo;
+        QuantizationInfo inputQuantizationInfo;
+        QuantizationInfo outputQuantizationInfo;
+        uint32_t stripeDepth;
+        uint32_t strideY;
+        uint32_t strideX;
+        uint32_t paddingTop;
+        uint32_t paddingLeft;
+        uint32_t iterationSize;
+        ethosn::command_stream::MceOperation operation;
+        CompilerMceAlgorithm algorithm;
+        /// Only set for estimates which assume a given compression saving, for which the content hashes are unused.
+        utils::Optional<float> compressionSaving;
+        /// The hardware capabilities which affect the encoding.
+        uint32_t weightCompressionVersion;
+        uint32_t numSrams;
+        uint32_t numOfms;
+        uint32_t numEngines;
+        uint32_t ifmPerEngine;
+        uint32_t wideKernelSize;
+
+        bool operator==(const Key& r) const;
+    };
+
+    struct KeyHasher
+    {
+        size_t operator()(const Key& k) const;
+    };
+
+    /// The keys of the entries, from the most to the least recently used.
+    /// These point to the keys in m_Entries, which don't move while they are in the map.
+    using LruList = std::list<const Key*>;
+
+    struct Entry
+    {
+        /// Both of these are set if the weights have been fully encoded. Only the size is set if they have only
+        /// been estimated.
+        std::shared_ptr<const EncodedWeights> m_EncodedWeights;
+        std::unique_ptr<EncodedWeightsSize> m_EncodedWeightsSize;
+        /// The number of bytes this entry counts towards the size of the cache.
+        size_t m_SizeBytes = 0;
+        LruList::iterator m_LruIt;
+    };
+
+    static Key CreateKey(const HardwareCapabilities& caps,
+                         const Params& params,
+                         const utils::Optional<float>& compressionSaving = utils::EmptyOptional());
+
+    /// Returns the entry for the given key, creating it if needed, and marks it as the most recently used.
+    /// m_Mutex must be held.
+    Entry& Touch(const Key& key);
+    /// Changes the size of the given entry and evicts the least recently used entries (never the given one)
+    /// until the cache fits within its size limit. m_Mutex must be held.
+    void Resize(Entry& entry, size_t sizeBytes);
+
+    const size_t m_MaxSizeBytes;
+
+    std::mutex m_Mutex;
+    std::unordered_map<Key, Entry, KeyHasher> m_Entries;
+    LruList m_Lru;
+    size_t m_SizeBytes;
+};
+
+}    // namespace support_library
+}    // namespace ethosn
@@ -102,7 +102,7 @@ public:
         bool m_InitialParameters;
     };
 
-    WeightEncoderV2(const HardwareCapabilities& capabilities);
+    WeightEncoderV2(const HardwareCapabilities& capabilities, ThreadPool* threadPool = nullptr);
 
     WeightEncoderV2(const HardwareCapabilities& capabilities,
                     WeightCompMode mode,
@@ -133,9 +133,51 @@ protected:
                                  const EncodingParams& params,
                                  std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams) override;
 
+    virtual EncodedOfmSize
+        EstimateOfmSize(const uint8_t* weightData,
+                        uint32_t ofmIdx,
+                        uint32_t numOfmInParallel,
+                        uint32_t numIterationsOfm,
+                        uint32_t stripeDepth,
+                        uint32_t iteration,
+                        const TensorInfo& weightsTensorInfo,
+                        uint32_t strideY,
+                        uint32_t strideX,
+                        uint32_t paddingTop,
+                        uint32_t paddingLeft,
+                        uint32_t iterationSize,
+                        ethosn::command_stream::MceOperation operation,
+                        CompilerMceAlgorithm algorithm,
+                        const EncodingParams& params,
+                        std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams) override;
+
+    virtual uint32_t GetOfmHeaderNumBits(const TensorInfo& weightsTensorInfo) const override;
+
+    /// Writes the stream for a single OFM, as returned by EncodeOfm, to the given writer.
+    void WriteOfm(const uint8_t* weightData,
+                  uint32_t ofmIdx,
+                  uint32_t numOfmInParallel,
+                  uint32_t numIterationsOfm,
+                  uint32_t stripeDepth,
+                  uint32_t iteration,
+                  const TensorInfo& weightsTensorInfo,
+                  uint32_t strideY,
+                  uint32_t strideX,
+                  uint32_t paddingTop,
+                  uint32_t paddingLeft,
+                  uint32_t iterationSize,
+                  ethosn::command_stream::MceOperation operation,
+                  CompilerMceAlgorithm algorithm,
+                  const EncodingParams& params,
+                  std::vector<std::unique_ptr<WeightCompressionParams>>& compressionParams,
+                  BitstreamWriter& writer);
+
     virtual std::vector<std::unique_ptr<WeightCompressionParams>>
         GenerateCompressionParams(uint32_t numOfmInParallel) override;
 
+    virtual uint32_t
+        GetCompressionParamsIdx(uint32_t ofmIdx, uint32_t numOfmInParallel, uint32_t stripeDepth) const override;
+
     uint8_t WeightOffsetClamp(WeightSymbol offset) const
     {
         constexpr uint8_t maxWeightOffset = 31;
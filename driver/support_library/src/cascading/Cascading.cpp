@@ -8,6 +8,7 @@
 #include "../Graph.hpp"
 #include "../GraphNodes.hpp"
 #include "../McePlePass.hpp"
+#include "../ThreadPool.hpp"
 #include "../Utils.hpp"
 #include "DebuggingContext.hpp"
 #include "Estimation.hpp"
@@ -15,8 +16,11 @@
 
 #include "../include/ethosn_support_library/Optional.hpp"
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <mutex>
 
 using namespace std;
 
@@ -109,20 +113,57 @@ GraphOfParts CreateGraphOfParts(const Graph& graph)
     return graphOfParts;
 }
 
-void CreatePlans(Parts& parts, const HardwareCapabilities& caps)
+void CreatePlans(Parts& parts,
+                 const HardwareCapabilities& caps,
+                 const EstimationOptions& estimationOptions,
+                 ThreadPool& threadPool,
+                 WeightEncoderCache& weightEncoderCache,
+                 bool deterministicDebugTags)
 {
-    for (auto& part : parts)
+    // Each Part only reads the Graph and its own subgraph, and the plans it creates are stored in the Part, so the
+    // Parts can be processed concurrently and the plans (and their ids) are the same regardless of the order.
+    // The exception is the default debug tags of the plans, which are numbered in the order they are created, so
+    // the Parts are processed in order when the tags may be seen (i.e. in debug files).
+    auto createPlansForPart = [&](size_t partIdx) {
+        parts[partIdx]->CreatePlans(caps, estimationOptions, threadPool, weightEncoderCache);
+    };
+    if (deterministicDebugTags)
+    {
+        for (size_t partIdx = 0; partIdx < parts.size(); ++partIdx)
+        {
+            createPlansForPart(partIdx);
+        }
+    }
+    else
     {
-        part->CreatePlans(caps);
+        threadPool.ParallelFor(parts.size(), createPlansForPart);
     }
+}
+
+namespace
+{
 
-    return;
+/// Doubles a limit of the search, where zero means no limit. A limit which would overflow becomes no limit.
+uint32_t DoubleLimit(uint32_t limit)
+{
+    return limit > std::numeric_limits<uint32_t>::max() / 2 ? 0 : limit * 2;
 }
 
+}    // namespace
+
 Cascading::Cascading(const EstimationOptions& estOpt,
+                     const CompilationOptions& compOpt,
                      const HardwareCapabilities& hwCap,
-                     const DebuggingContext& debuggingContext)
+                     const DebuggingContext& debuggingContext,
+                     ThreadPool& threadPool,
+                     WeightEncoderCache& weightEncoderCache)
     : IEstimationStrategy(estOpt, hwCap, debuggingContext)
+    , m_SearchLimits{ compOpt.m_CascadingBeamWidth, compOpt.m_CascadingMaxCombinations }
+    , m_ActiveSearchLimits(m_SearchLimits)
+    , m_UseDynamicProgrammingOption(compOpt.m_CascadingDynamicProgramming)
+    , m_UseDynamicProgramming(m_UseDynamicProgrammingOption)
+    , m_ThreadPool(threadPool)
+    , m_WeightEncoderCache(weightEncoderCache)
 {
     // Constructor
 }
@@ -132,29 +173,78 @@ Cascading::~Cascading()
 
 NetworkPerformanceData Cascading::Estimate(Graph& graph)
 {
+    m_SearchReport = CombinerSearchReport();
+    // The cached passes refer to the Ops and Buffers of the previous GraphOfParts, which is about to be destroyed.
+    m_PassStatsCache.Clear();
+
     m_GraphOfParts = CreateGraphOfParts(graph);
 
     m_DebuggingContext.SaveGraphToDot(graph, &m_GraphOfParts, "Cascaded_GraphOfParts.dot", DetailLevel::Low);
     m_DebuggingContext.SaveGraphToDot(graph, &m_GraphOfParts, "Cascaded_GraphOfPartsDetailed.dot", DetailLevel::High);
 
-    CreatePlans(m_GraphOfParts.m_Parts, m_Capabilities);
+    CreatePlans(m_GraphOfParts.m_Parts, m_Capabilities, GetEstimationOptions(), m_ThreadPool, m_WeightEncoderCache,
+                m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles);
 
     if (m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles)
     {
         std::ofstream debugPlanCountsDumpFile(
             m_DebuggingContext.GetAbsolutePathOutputFileName("Cascaded_PlanCounts.txt"));
 
+        // Plans which were dominated by other plans of the same Part were removed before combining.
+        size_t totalKept    = 0;
+        size_t totalRemoved = 0;
         for (auto&& part : m_GraphOfParts.m_Parts)
         {
-            debugPlanCountsDumpFile << part->m_DebugTag << ": " << part->GetNumPlans() << std::endl;
+            debugPlanCountsDumpFile << part->m_DebugTag << ": " << part->GetNumPlans() << " (removed "
+                                    << part->GetNumDominatedPlans() << " dominated)" << std::endl;
+            totalKept += part->GetNumPlans();
+            totalRemoved += part->GetNumDominatedPlans();
 
             m_DebuggingContext.SavePlansToDot(*part, "Cascaded_" + part->m_DebugTag + " Plans.dot", DetailLevel::Low);
             m_DebuggingContext.SavePlansToDot(*part, "Cascaded_" + part->m_DebugTag + " PlansDetailed.dot",
                                               DetailLevel::High);
         }
+        debugPlanCountsDumpFile << "Total: " << totalKept << " (removed " << totalRemoved << " dominated)" << std::endl;
     }
 
-    m_ValidCombinations = Combine(m_GraphOfParts);
+    // A limited search can drop every combination which can be estimated, or every one which can be completed. If so,
+    // the search is repeated with limits twice as large, until it finds one or nothing was dropped (i.e. it was a
+    // full search). Each search is deterministic, so the result doesn't depend on the speed of the machine.
+    // Likewise if none of the combinations found with the ChainCombiner can be estimated, the search is repeated
+    // without it.
+    m_ActiveSearchLimits        = m_SearchLimits;
+    m_UseDynamicProgramming     = m_UseDynamicProgrammingOption;
+    bool chainCombinerAbandoned = false;
+    for (uint32_t numRetries = 0;; ++numRetries)
+    {
+        m_SearchReport                          = CombinerSearchReport();
+        m_SearchReport.m_NumRetries             = numRetries;
+        m_SearchReport.m_ChainCombinerAbandoned = chainCombinerAbandoned;
+        m_BestCombinationIdx.reset();
+        m_ValidCombinations = Combine(m_GraphOfParts);
+        if (!m_ValidCombinations.empty())
+        {
+            EstimatePerformance();
+        }
+        if (m_BestCombinationIdx.has_value())
+        {
+            break;
+        }
+        if (m_SearchReport.m_NumChainRegionsCombined > 0)
+        {
+            m_UseDynamicProgramming = false;
+            chainCombinerAbandoned  = true;
+            continue;
+        }
+        const bool wasLimited =
+            m_SearchReport.m_NumCombinationsDropped > 0 || m_SearchReport.m_CombinationBudgetExceeded;
+        if (!wasLimited)
+        {
+            break;
+        }
+        m_ActiveSearchLimits.m_BeamWidth       = DoubleLimit(m_ActiveSearchLimits.m_BeamWidth);
+        m_ActiveSearchLimits.m_MaxCombinations = DoubleLimit(m_ActiveSearchLimits.m_MaxCombinations);
+    }
 
     if (m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles)
     {
@@ -180,10 +270,11 @@ NetworkPerformanceData Cascading::Estimate(Graph& graph)
 
     if (m_ValidCombinations.empty())
     {
+        SaveSearchReport();
         throw NotSupportedException("No valid combinations were found.");
     }
 
-    EstimatePerformance();
+    SaveSearchReport();
     return m_PerformanceStream;
 }
 
@@ -192,50 +283,124 @@ const GraphOfParts& Cascading::getGraphOfParts() const
     return m_GraphOfParts;
 }
 
-void Cascading::EstimatePerformance()
+const CombinerSearchReport& Cascading::GetSearchReport() const
 {
-    std::ofstream debugPerformanceDumpFile;
-    if (m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles)
+    return m_SearchReport;
+}
+
+const Combinations& Cascading::GetValidCombinations() const
+{
+    return m_ValidCombinations;
+}
+
+const utils::Optional<uint32_t>& Cascading::GetBestCombinationIdx() const
+{
+    return m_BestCombinationIdx;
+}
+
+bool Cascading::IsCombinationBudgetExceeded() const
+{
+    return m_ActiveSearchLimits.m_MaxCombinations != 0 &&
+           m_SearchReport.m_NumCombinationsCreated > m_ActiveSearchLimits.m_MaxCombinations;
+}
+
+void Cascading::SaveSearchReport() const
+{
+    if (!m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles)
     {
-        debugPerformanceDumpFile.open(m_DebuggingContext.GetAbsolutePathOutputFileName("Cascaded_Performance.txt"));
+        return;
     }
-    uint32_t combinationIdx = 0;
-    utils::Optional<uint32_t> bestCombinationIdx;
-    for (const Combination& combination : m_ValidCombinations)
+    std::ofstream file(m_DebuggingContext.GetAbsolutePathOutputFileName("Cascaded_SearchReport.txt"));
+    file << "Beam width: " << m_ActiveSearchLimits.m_BeamWidth << "\n";
+    file << "Combination budget: " << m_ActiveSearchLimits.m_MaxCombinations << "\n";
+    file << "Searches repeated with larger limits: " << m_SearchReport.m_NumRetries << "\n";
+    file << "Chain regions combined by dynamic programming: " << m_SearchReport.m_NumChainRegionsCombined << "\n";
+    file << "Chain regions searched step by step instead: " << m_SearchReport.m_NumChainRegionFallbacks << "\n";
+    file << "Search repeated without dynamic programming: " << (m_SearchReport.m_ChainCombinerAbandoned ? "yes" : "no")
+         << "\n";
+    file << "Steps: " << m_SearchReport.m_NumSteps << "\n";
+    file << "Most combinations kept after a step: " << m_SearchReport.m_MaxNumCombinations << "\n";
+    file << "Partial combinations dropped: " << m_SearchReport.m_NumCombinationsDropped << "\n";
+    file << "Backtracks after reaching a dead end: " << m_SearchReport.m_NumBacktracks << "\n";
+    file << "Combinations created: " << m_SearchReport.m_NumCombinationsCreated << "\n";
+    if (m_SearchReport.m_CombinationBudgetExceeded)
     {
-        try
-        {
-            NetworkPerformanceData curNetPerfData = EstimateCombination(combination);
+        file << "Combination budget exceeded at step " << m_SearchReport.m_StepWhenBudgetExceeded << " (Part "
+             << m_SearchReport.m_PartWhenBudgetExceeded << " of " << m_GraphOfParts.GetNumParts() << ")\n";
+    }
+    file << "Complete combinations: " << m_ValidCombinations.size() << std::endl;
+}
 
-            if (m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles)
-            {
-                debugPerformanceDumpFile << combinationIdx << ": " << utils::GetMetric(curNetPerfData) << std::endl;
-            }
+void Cascading::EstimatePerformance()
+{
+    const bool dumpDebugFiles = m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles;
 
-            if (!bestCombinationIdx.has_value() ||
-                utils::IsLeftMoreDataPerformantThanRight(curNetPerfData, m_PerformanceStream))
-            {
-                m_PerformanceStream = curNetPerfData;
-                bestCombinationIdx  = combinationIdx;
-            }
+    // The combinations are estimated concurrently. The metric of the best combination found so far is shared between
+    // the threads, so that estimating a combination can stop as soon as it is known to be worse.
+    // When two combinations are equally good the one with the lower index is chosen, so that the result is the same
+    // as estimating them in order, regardless of the number of threads.
+    std::mutex bestMutex;
+    std::atomic<uint64_t> bestMetric(std::numeric_limits<uint64_t>::max());
+    m_BestCombinationIdx.reset();
+
+    // The metric of each combination, or why it couldn't be estimated. Only used for the debug file.
+    std::vector<std::string> debugResults(dumpDebugFiles ? m_ValidCombinations.size() : 0);
+
+    auto estimate = [&](size_t i) {
+        const uint32_t combinationIdx = static_cast<uint32_t>(i);
+        // When dumping debug files every combination is estimated in full, so that all their metrics are reported.
+        const uint64_t metricLimit = dumpDebugFiles ? std::numeric_limits<uint64_t>::max() : bestMetric.load();
+
+        utils::Optional<NetworkPerformanceData> curNetPerfData;
+        try
+        {
+            curNetPerfData = EstimateCombination(m_ValidCombinations[combinationIdx], metricLimit);
         }
         catch (const NotSupportedException& e)
         {
             // Ignore this combination - others may still be valid
-            if (m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles)
+            if (dumpDebugFiles)
             {
-                debugPerformanceDumpFile << combinationIdx << ": Error: " << e.what() << std::endl;
+                debugResults[combinationIdx] = std::string("Error: ") + e.what();
             }
+            return;
+        }
+        if (!curNetPerfData.has_value())
+        {
+            return;
         }
 
-        ++combinationIdx;
-    }
+        const uint64_t metric = utils::GetMetric(curNetPerfData.value());
+        if (dumpDebugFiles)
+        {
+            debugResults[combinationIdx] = std::to_string(metric);
+        }
 
-    if (m_DebuggingContext.m_DebugInfo.m_DumpDebugFiles)
+        std::lock_guard<std::mutex> lock(bestMutex);
+        if (!m_BestCombinationIdx.has_value() || metric < bestMetric ||
+            (metric == bestMetric && combinationIdx < m_BestCombinationIdx.value()))
+        {
+            m_PerformanceStream  = curNetPerfData.value();
+            m_BestCombinationIdx = combinationIdx;
+            bestMetric           = metric;
+        }
+    };
+
+    // Every complete combination kept by the search is estimated, even over budget, and the best of them is chosen.
+    // The beam width bounds how many of them there are.
+    m_ThreadPool.ParallelFor(m_ValidCombinations.size(), [&](size_t i) { estimate(i); });
+
+    if (dumpDebugFiles)
     {
+        std::ofstream debugPerformanceDumpFile(
+            m_DebuggingContext.GetAbsolutePathOutputFileName("Cascaded_Performance.txt"));
+        for (uint32_t combinationIdx = 0; combinationIdx < debugResults.size(); ++combinationIdx)
+        {
+            debugPerformanceDumpFile << combinationIdx << ": " << debugResults[combinationIdx] << std::endl;
+        }
         debugPerformanceDumpFile << "\nBest: "
-                                 << (bestCombinationIdx.has_value() ? std::to_string(bestCombinationIdx.value())
-                                                                    : "NONE")
+                                 << (m_BestCombinationIdx.has_value() ? std::to_string(m_BestCombinationIdx.value())
+                                                                      : "NONE")
                                  << std::endl;
     }
 }
@@ -243,7 +408,16 @@ void Cascading::EstimatePerformance()
 NetworkPerformanceData Cascading::EstimateCombination(const Combination& combination)
 {
     OpGraph combiOpGraph = GetOpGraphForCombination(combination, m_GraphOfParts);
-    return ethosn::support_library::EstimateOpGraph(combiOpGraph, m_Capabilities, GetEstimationOptions());
+    return ethosn::support_library::EstimateOpGraph(combiOpGraph, m_Capabilities, GetEstimationOptions(),
+                                                    &m_PassStatsCache);
+}
+
+utils::Optional<NetworkPerformanceData> Cascading::EstimateCombination(const Combination& combination,
+                                                                       uint64_t metricLimit)
+{
+    OpGraph combiOpGraph = GetOpGraphForCombination(combination, m_GraphOfParts);
+    return ethosn::support_library::EstimateOpGraph(combiOpGraph, m_Capabilities, GetEstimationOptions(),
+                                                    metricLimit, &m_PassStatsCache);
 }
 
 }    // namespace support_library
@@ -7,27 +7,37 @@
 
 #include "../Utils.hpp"
 #include "Combiner.hpp"
+#include "Estimation.hpp"
 #include "IEstimationStrategy.hpp"
 #include "Part.hpp"
 
+#include "../include/ethosn_support_library/Optional.hpp"
+
 namespace ethosn
 {
 namespace support_library
 {
 
 class Graph;
+class ThreadPool;
+class WeightEncoderCache;
 
 class Cascading : public IEstimationStrategy
 {
 public:
     Cascading(const EstimationOptions& estOpt,
+              const CompilationOptions& compOpt,
               const HardwareCapabilities& caps,
-              const DebuggingContext& debuggingContext);
+              const DebuggingContext& debuggingContext,
+              ThreadPool& threadPool,
+              WeightEncoderCache& weightEncoderCache);
     virtual ~Cascading();
 
     NetworkPerformanceData Estimate(Graph& graph) override;
     void EstimatePerformance();
     NetworkPerformanceData EstimateCombination(const Combination&);
+    /// Returns nothing if the Combination is known to perform worse than one with the given metric.
+    utils::Optional<NetworkPerformanceData> EstimateCombination(const Combination&, uint64_t metricLimit);
 
     Combinations Combine(const GraphOfParts&);
 
@@ -42,14 +52,55 @@ public:
 
     const GraphOfParts& getGraphOfParts() const;
 
+    /// Describes how far the search for combinations got in the last call to Estimate().
+    const CombinerSearchReport& GetSearchReport() const;
+
+    /// The complete combinations found by the last call to Estimate(), and the index of the one which was chosen.
+    /// @{
+    const Combinations& GetValidCombinations() const;
+    const utils::Optional<uint32_t>& GetBestCombinationIdx() const;
+    /// @}
+
 private:
+    bool IsCombinationBudgetExceeded() const;
+    /// Ranks the given combinations and drops the least promising so that the search stays within its limits.
+    /// Returns the most promising of those dropped, to carry on from if the others reach a dead end.
+    Combinations ApplySearchLimits(Combinations& combinations, size_t numParts);
+    void SaveSearchReport() const;
+
     NetworkPerformanceData m_PerformanceStream;
     Metadata m_Metadata;
     Combinations m_ValidCombinations;
+    /// The index into m_ValidCombinations of the Combination with the best estimated performance, if any.
+    utils::Optional<uint32_t> m_BestCombinationIdx;
     GraphOfParts m_GraphOfParts;
+    /// The limits given in the CompilationOptions.
+    CombinerSearchLimits m_SearchLimits;
+    /// The limits of the current search, which are raised if the search doesn't find a combination which can be
+    /// estimated.
+    CombinerSearchLimits m_ActiveSearchLimits;
+    /// Whether to grow the combinations through chain regions with a ChainCombiner, as given in the CompilationOptions.
+    bool m_UseDynamicProgrammingOption;
+    /// Whether the current search uses a ChainCombiner. This is turned off if the combinations it finds can't be
+    /// estimated.
+    bool m_UseDynamicProgramming;
+    CombinerSearchReport m_SearchReport;
+    /// The stats of the passes of the combinations estimated so far, which many combinations have in common.
+    PassStatsCache m_PassStatsCache;
+    ThreadPool& m_ThreadPool;
+    WeightEncoderCache& m_WeightEncoderCache;
 };
 
 GraphOfParts CreateGraphOfParts(const Graph& graph);
 
+/// Creates the plans of each of the given Parts, using the threads of the given pool. If deterministicDebugTags is
+/// set, the Parts are processed in order so that the default debug tags of their plans are too.
+void CreatePlans(Parts& parts,
+                 const HardwareCapabilities& caps,
+                 const EstimationOptions& estimationOptions,
+                 ThreadPool& threadPool,
+                 WeightEncoderCache& weightEncoderCache,
+                 bool deterministicDebugTags);
+
 }    // namespace support_library
 }    // namespace ethosn
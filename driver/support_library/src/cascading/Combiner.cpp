@@ -7,14 +7,243 @@
 
 #include "../SramAllocator.hpp"
 #include "Cascading.hpp"
+#include "Estimation.hpp"
 #include "Part.hpp"
 #include "Plan.hpp"
 
+#include <algorithm>
+#include <limits>
+#include <tuple>
+
 namespace ethosn
 {
 namespace support_library
 {
 
+constexpr uint32_t Combination::ms_NumBitsPerLevel;
+constexpr size_t Combination::ms_NumChildren;
+constexpr uint32_t Combination::ms_MaxNumUnindexedChanges;
+
+namespace
+{
+
+/// Returns true if an index with the given number of levels, each indexed by the given number of bits, can hold the
+/// given PartId.
+bool IsInIndex(PartId partId, uint32_t numLevels, uint32_t numBitsPerLevel)
+{
+    const uint32_t numBits = numLevels * numBitsPerLevel;
+    return numBits >= std::numeric_limits<PartId>::digits || (partId >> numBits) == 0;
+}
+
+}    // namespace
+
+Combination::Change::~Change()
+{
+    // Nothing else can start using a change which is only used by this one
+    std::shared_ptr<const Change> previous = std::move(m_Previous);
+    while (previous != nullptr && previous.use_count() == 1)
+    {
+        previous = std::move(previous->m_Previous);
+    }
+}
+
+void Combination::AddChange(Change::Type type, PartId partId, PlanId planId, const Edge* edge, const Elem::Link& link)
+{
+    const Change* previousForPart = FindLastChange(partId);
+    m_LastChange =
+        std::make_shared<const Change>(Change{ m_LastChange, previousForPart, type, partId, planId, edge, link });
+    ++m_NumUnindexedChanges;
+    if (m_NumUnindexedChanges == ms_MaxNumUnindexedChanges)
+    {
+        UpdateIndex();
+    }
+}
+
+void Combination::AddElem(PartId partId, PlanId planId)
+{
+    assert(!HasElem(partId));
+    AddChange(Change::Type::AddElem, partId, planId, nullptr, Elem::Link{ planId, nullptr });
+    ++m_NumElems;
+}
+
+void Combination::AddLink(PartId partId, PlanId planId, const Edge* edge, const Elem::Link& link)
+{
+    if (!HasElem(partId))
+    {
+        AddChange(Change::Type::AddElem, partId, planId, edge, link);
+        ++m_NumElems;
+    }
+    else if (GetLink(partId, edge) == nullptr)
+    {
+        AddChange(Change::Type::AddLink, partId, planId, edge, link);
+    }
+}
+
+void Combination::AddVisitedEdge(PartId partId, const Edge* edge)
+{
+    AddChange(Change::Type::AddVisitedEdge, partId, 0, edge, Elem::Link{ 0, nullptr });
+}
+
+bool Combination::HasElem(PartId partId) const
+{
+    for (const Change* c = FindLastChange(partId); c != nullptr; c = c->m_PreviousForPart)
+    {
+        if (c->m_Type == Change::Type::AddElem)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+const Elem::Link* Combination::GetLink(PartId partId, const Edge* edge) const
+{
+    if (edge == nullptr)
+    {
+        return nullptr;
+    }
+    for (const Change* c = FindLastChange(partId); c != nullptr; c = c->m_PreviousForPart)
+    {
+        if (c->m_Type != Change::Type::AddVisitedEdge && c->m_Edge == edge)
+        {
+            return &c->m_Link;
+        }
+    }
+    return nullptr;
+}
+
+bool Combination::IsEdgeVisited(PartId partId, const Edge* edge) const
+{
+    for (const Change* c = FindLastChange(partId); c != nullptr; c = c->m_PreviousForPart)
+    {
+        if (c->m_Type == Change::Type::AddVisitedEdge && c->m_Edge == edge)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t Combination::GetNumVisitedEdges(PartId partId) const
+{
+    size_t result = 0;
+    for (const Change* c = FindLastChange(partId); c != nullptr; c = c->m_PreviousForPart)
+    {
+        if (c->m_Type == Change::Type::AddVisitedEdge)
+        {
+            ++result;
+        }
+    }
+    return result;
+}
+
+std::vector<Elem> Combination::GetElems() const
+{
+    std::vector<const Change*> changes;
+    for (const Change* c = m_LastChange.get(); c != nullptr; c = c->m_Previous.get())
+    {
+        changes.push_back(c);
+    }
+
+    // Replay the changes in the order they were made
+    std::vector<Elem> result;
+    result.reserve(m_NumElems);
+    std::unordered_map<PartId, size_t> indexes;
+    for (auto it = changes.rbegin(); it != changes.rend(); ++it)
+    {
+        const Change& c = **it;
+        if (c.m_Type == Change::Type::AddElem)
+        {
+            indexes[c.m_PartId] = result.size();
+            result.push_back(Elem{ c.m_PartId, c.m_PlanId, {} });
+        }
+        if (c.m_Type != Change::Type::AddVisitedEdge && c.m_Edge != nullptr)
+        {
+            result.at(indexes.at(c.m_PartId)).m_Glues.insert(std::make_pair(c.m_Edge, c.m_Link));
+        }
+    }
+    return result;
+}
+
+const Combination::Change* Combination::FindLastChange(PartId partId) const
+{
+    const Change* c = m_LastChange.get();
+    for (uint32_t i = 0; i < m_NumUnindexedChanges; ++i, c = c->m_Previous.get())
+    {
+        if (c->m_PartId == partId)
+        {
+            return c;
+        }
+    }
+
+    if (m_Index == nullptr || !IsInIndex(partId, m_Index->m_NumLevels, ms_NumBitsPerLevel))
+    {
+        return nullptr;
+    }
+    const IndexNode* node = m_Index.get();
+    for (uint32_t level = m_Index->m_NumLevels - 1; level > 0 && node != nullptr; --level)
+    {
+        node = node->m_Children[(partId >> (level * ms_NumBitsPerLevel)) % ms_NumChildren].get();
+    }
+    return (node != nullptr) ? node->m_Changes[partId % ms_NumChildren] : nullptr;
+}
+
+void Combination::UpdateIndex()
+{
+    // The latest change to each Part which has been changed since the index was last updated, sorted by PartId
+    std::vector<const Change*> lastChanges;
+    const Change* c = m_LastChange.get();
+    for (uint32_t i = 0; i < m_NumUnindexedChanges; ++i, c = c->m_Previous.get())
+    {
+        if (FindLastChange(c->m_PartId) == c)
+        {
+            lastChanges.push_back(c);
+        }
+    }
+    std::sort(lastChanges.begin(), lastChanges.end(),
+              [](const Change* a, const Change* b) { return a->m_PartId < b->m_PartId; });
+
+    // Add levels above the root until the index is deep enough for the largest PartId
+    uint32_t numLevels                   = (m_Index != nullptr) ? m_Index->m_NumLevels : 0;
+    std::shared_ptr<const IndexNode> root = m_Index;
+    while (numLevels == 0 || !IsInIndex(lastChanges.back()->m_PartId, numLevels, ms_NumBitsPerLevel))
+    {
+        auto newRoot            = std::make_shared<IndexNode>();
+        newRoot->m_Children[0] = std::move(root);
+        root                    = std::move(newRoot);
+        ++numLevels;
+    }
+
+    std::shared_ptr<IndexNode> newRoot = UpdateIndex(root.get(), numLevels - 1, lastChanges.begin(), lastChanges.end());
+    newRoot->m_NumLevels  = numLevels;
+    m_Index               = std::move(newRoot);
+    m_NumUnindexedChanges = 0;
+}
+
+std::shared_ptr<Combination::IndexNode> Combination::UpdateIndex(const IndexNode* node,
+                                                                  uint32_t level,
+                                                                  std::vector<const Change*>::const_iterator begin,
+                                                                  std::vector<const Change*>::const_iterator end)
+{
+    auto result      = (node != nullptr) ? std::make_shared<IndexNode>(*node) : std::make_shared<IndexNode>();
+    auto getChildIdx = [level](const Change* c) { return (c->m_PartId >> (level * ms_NumBitsPerLevel)) % ms_NumChildren; };
+    while (begin != end)
+    {
+        const size_t childIdx = getChildIdx(*begin);
+        const auto childEnd = std::find_if(begin, end, [&](const Change* c) { return getChildIdx(c) != childIdx; });
+        if (level == 0)
+        {
+            result->m_Changes[childIdx] = *begin;
+        }
+        else
+        {
+            result->m_Children[childIdx] = UpdateIndex(result->m_Children[childIdx].get(), level - 1, begin, childEnd);
+        }
+        begin = childEnd;
+    }
+    return result;
+}
+
 namespace
 {
 
@@ -76,6 +305,141 @@ SizeInBytes GetInputsSizeInBytes(const Plan& plan)
     return result;
 }
 
+/// Each DmaOp in a glue copies the whole tensor between SRAM and DRAM.
+uint64_t GetGlueDramTraffic(const Glue& glue, const Buffer& outputBuffer)
+{
+    const OpGraph::OpList& ops = glue.m_Graph.GetOps();
+    const auto numDmaOps       = std::count_if(ops.begin(), ops.end(), [](Op* op) { return IsObjectOfType<DmaOp>(op); });
+    return static_cast<uint64_t>(numDmaOps) * utils::TotalSizeBytes(outputBuffer.m_TensorShape);
+}
+
+/// Whether ArePlansCompatible treats the two buffers the same, when they are on the same side of the same Edge, and
+/// the combiner treats them the same when merging the plans (see AddSeed).
+bool HaveSameBoundaryProperties(const Buffer& a, const Buffer& b) noexcept
+{
+    return a.m_Lifetime == b.m_Lifetime && a.m_Location == b.m_Location && a.m_Format == b.m_Format &&
+           a.m_TensorShape == b.m_TensorShape && a.m_StripeShape == b.m_StripeShape && a.m_Order == b.m_Order &&
+           a.m_SizeInBytes == b.m_SizeInBytes && a.m_QuantizationInfo == b.m_QuantizationInfo;
+}
+
+/// Hashes the properties compared by HaveSameBoundaryProperties, except the quantization info, which is only
+/// compared.
+struct BoundaryPropertiesHasher
+{
+    size_t operator()(const Buffer* b) const noexcept
+    {
+        size_t h = static_cast<size_t>(b->m_Lifetime);
+        h        = utils::CombineHash(h, static_cast<size_t>(b->m_Location));
+        h        = utils::CombineHash(h, static_cast<size_t>(b->m_Format));
+        h        = utils::CombineHash(h, static_cast<size_t>(b->m_Order));
+        h        = utils::CombineHash(h, b->m_SizeInBytes);
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            h = utils::CombineHash(h, b->m_TensorShape[i]);
+            h = utils::CombineHash(h, b->m_StripeShape[i]);
+        }
+        return h;
+    }
+};
+
+struct BoundaryPropertiesEqual
+{
+    bool operator()(const Buffer* a, const Buffer* b) const noexcept
+    {
+        return HaveSameBoundaryProperties(*a, *b);
+    }
+};
+
+/// Caches the results of ArePlansCompatible for the plans either side of an Edge. Plans are grouped into classes
+/// by the properties of their buffer on the Edge, and each pair of classes shares a single result and Glue.
+/// Glues are not shared between Edges, as the Ops of a Glue can only be added once to the OpGraph of a combination.
+class BoundaryCompatibilityCache
+{
+public:
+    struct Entry
+    {
+        bool m_IsCompatible;
+        bool m_RequiresGlue;
+        std::shared_ptr<const Glue> m_Glue;
+        /// The DRAM traffic caused by the glue, see Scratch::m_MinDramTraffic.
+        uint64_t m_GlueDramTraffic;
+    };
+
+    explicit BoundaryCompatibilityCache(const Edge& edge)
+        : m_Edge(edge)
+    {}
+
+    /// Gets the class of a plan of the source or destination Part of the Edge.
+    size_t GetOutputClass(const Plan& plan)
+    {
+        return GetClass(m_Outputs, plan, plan.GetOutputBuffer(m_Edge.GetSource()));
+    }
+    size_t GetInputClass(const Plan& plan)
+    {
+        return GetClass(m_Inputs, plan, plan.GetInputBuffer(&m_Edge));
+    }
+
+    const Entry& Get(size_t outputClass, size_t inputClass)
+    {
+        static const Entry incompatible{ false, false, nullptr, 0 };
+        if (outputClass == noClass || inputClass == noClass)
+        {
+            // Not compatible as the plans aren't connected along this Edge.
+            return incompatible;
+        }
+        const std::pair<size_t, size_t> key(outputClass, inputClass);
+        auto it = m_Entries.find(key);
+        if (it != m_Entries.end())
+        {
+            return it->second;
+        }
+        PlanCompatibilityResult plCompRes =
+            ArePlansCompatible(*m_Outputs[outputClass].second, *m_Inputs[inputClass].second, m_Edge);
+        Entry entry{ plCompRes.m_IsCompatible, plCompRes.m_RequiresGlue, nullptr, 0 };
+        if (plCompRes.m_IsCompatible)
+        {
+            entry.m_GlueDramTraffic = GetGlueDramTraffic(plCompRes.m_Glue, *m_Outputs[outputClass].first);
+            entry.m_Glue            = std::make_shared<const Glue>(std::move(plCompRes.m_Glue));
+        }
+        return m_Entries.emplace(key, std::move(entry)).first->second;
+    }
+
+private:
+    static constexpr size_t noClass = static_cast<size_t>(-1);
+
+    /// The buffer on the Edge of the first plan found in each class, and that plan, along with the class of each
+    /// buffer found so far, looked up by its properties.
+    struct Representatives
+    {
+        std::vector<std::pair<const Buffer*, const Plan*>> m_Classes;
+        std::unordered_map<const Buffer*, size_t, BoundaryPropertiesHasher, BoundaryPropertiesEqual> m_ClassIdxs;
+
+        const std::pair<const Buffer*, const Plan*>& operator[](size_t c) const
+        {
+            return m_Classes[c];
+        }
+    };
+
+    static size_t GetClass(Representatives& representatives, const Plan& plan, const Buffer* buffer)
+    {
+        if (buffer == nullptr)
+        {
+            return noClass;
+        }
+        auto it = representatives.m_ClassIdxs.emplace(buffer, representatives.m_Classes.size());
+        if (it.second)
+        {
+            representatives.m_Classes.emplace_back(buffer, &plan);
+        }
+        return it.first->second;
+    }
+
+    const Edge& m_Edge;
+    Representatives m_Outputs;
+    Representatives m_Inputs;
+    std::map<std::pair<size_t, size_t>, Entry> m_Entries;
+};
+
 using Allocated = std::pair<bool, uint32_t>;
 
 struct AddedSeed
@@ -94,18 +458,16 @@ AddedSeed AddSeed(const PlanId fPlId,
                   const Combination& comb,
                   const uint32_t baseSizeInBytes,
                   const uint32_t minSizeInBytes,
+                  const uint64_t addedDramTraffic,
                   SramAllocator& alloc,
                   const HardwareCapabilities& caps,
                   const bool canMerge)
 {
     Allocated allocated;
-    Combination result            = comb;
-    Scratch::Indexes::iterator it = result.m_Scratch.m_Idx.find(fPaId);
+    Combination result = comb;
 
     alloc.Reset();
 
-    const bool update = (it != result.m_Scratch.m_Idx.end());
-
     const Plan& sPl            = part.GetPlan(sPlId);
     const SizeInBytes sTotSize = GetTotSizeInBytes(sPl);
     const SizeInBytes sInSize  = GetInputsSizeInBytes(sPl);
@@ -128,28 +490,10 @@ AddedSeed AddSeed(const PlanId fPlId,
         return AddedSeed{ false, std::numeric_limits<uint32_t>::max(), Combination{} };
     }
 
-    if (update)
-    {
-        Elem& el = result.m_Elems.at(it->second);
-        el.m_Glues.insert(std::make_pair(sEdge, Elem::Link{ sPlId, glue }));
-    }
-    else
-    {
-        Elem el;
-        el.m_PartId = fPaId;
-        el.m_PlanId = fPlId;
-        el.m_Glues.insert(std::make_pair(sEdge, Elem::Link{ sPlId, glue }));
-        result.m_Elems.push_back(el);
-    }
+    result.AddLink(fPaId, fPlId, sEdge, Elem::Link{ sPlId, glue });
 
     result.m_Scratch.m_AllocatedSram = allocatedSram;
-
-    if (!update)
-    {
-        // Update the current combination indexes
-        result.m_Scratch.m_Idx.insert(
-            std::make_pair(fPaId, (result.GetNumElems() > 0) ? (result.GetNumElems() - 1U) : 0));
-    }
+    result.m_Scratch.m_MinDramTraffic += addedDramTraffic;
 
     if (canMerge)
     {
@@ -183,7 +527,6 @@ NxtPa GetNxtPart(const PartId id, const size_t max, const Combination& comb, con
     {
         result.m_Dst   = nullptr;
         result.m_Found = false;
-        result.m_Comb.m_Scratch.m_Edges.insert(std::make_pair(id, Scratch::Dst{}));
         result.m_Comb.m_Scratch.m_CurrPartId = id + 1U;
         return result;
     }
@@ -193,11 +536,8 @@ NxtPa GetNxtPart(const PartId id, const size_t max, const Combination& comb, con
     std::pair<const Edge*, PartId> lowestDstPart(nullptr, std::numeric_limits<PartId>::max());
     for (const auto& it : mOfPa.m_Destination)
     {
-        const Edge* edge             = it.first;
-        Scratch::Edges::iterator eIt = result.m_Comb.m_Scratch.m_Edges.find(id);
-        const bool saved             = (eIt != result.m_Comb.m_Scratch.m_Edges.end());
-        Scratch::Dst dst             = saved ? (eIt->second) : Scratch::Dst{};
-        const bool done              = (std::find(std::begin(dst), std::end(dst), edge) != std::end(dst));
+        const Edge* edge = it.first;
+        const bool done  = result.m_Comb.IsEdgeVisited(id, edge);
         if (!done && it.second < lowestDstPart.second)
         {
             lowestDstPart.first  = it.first;
@@ -209,18 +549,9 @@ NxtPa GetNxtPart(const PartId id, const size_t max, const Combination& comb, con
         return result;
     }
 
-    const Edge* edge             = lowestDstPart.first;
-    Scratch::Edges::iterator eIt = result.m_Comb.m_Scratch.m_Edges.find(id);
-    const bool saved             = (eIt != result.m_Comb.m_Scratch.m_Edges.end());
-    if (saved)
-    {
-        (eIt->second).push_back(edge);
-    }
-    else
-    {
-        result.m_Comb.m_Scratch.m_Edges.insert(std::make_pair(id, Scratch::Dst{ { edge } }));
-    }
-    const bool last = (mOfPa.m_Destination.size() == (result.m_Comb.m_Scratch.m_Edges.find(id)->second).size());
+    const Edge* edge = lowestDstPart.first;
+    result.m_Comb.AddVisitedEdge(id, edge);
+    const bool last = (mOfPa.m_Destination.size() == result.m_Comb.GetNumVisitedEdges(id));
     result.m_Dst    = edge;
     result.m_Found  = true;
     result.m_Comb.m_Scratch.m_CurrPartId = last ? (id + 1U) : id;
@@ -247,19 +578,12 @@ PlanFromSource GetPlanFromSource(PartId id, const Combination& comb, const Metad
     SrcPart::const_iterator it = mOfPa.m_Source.begin();
     while (it != mOfPa.m_Source.end())
     {
-        const PartId src                       = it->second;
-        Scratch::Indexes::const_iterator idxIt = comb.m_Scratch.m_Idx.find(src);
-        if (idxIt != comb.m_Scratch.m_Idx.end())
+        const Elem::Link* link = comb.GetLink(it->second, it->first);
+        if (link != nullptr)
         {
-            size_t combIdx                   = idxIt->first;
-            const Elem& el                   = comb.m_Elems.at(combIdx);
-            Elem::Glues::const_iterator glIt = el.m_Glues.find(it->first);
-            if (glIt != el.m_Glues.end())
-            {
-                result.m_Id    = (glIt->second).m_Id;
-                result.m_Found = true;
-                return result;
-            }
+            result.m_Id    = link->m_Id;
+            result.m_Found = true;
+            return result;
         }
         ++it;
     }
@@ -302,6 +626,9 @@ Combinations CombineSeeds(const PlanId fPlId,
 
     uint32_t minSizeInBytes = std::numeric_limits<uint32_t>::max();
 
+    // The first part's plan is only added to the combination once, along with its first outgoing edge.
+    const uint64_t planDramTraffic = comb.HasElem(fPartId) ? 0 : fMOfPa.m_PlanDramTraffic.at(fPlId);
+
     // Process all the list of compatible plans
     for (uint32_t i = 0; i < fComPls.size(); ++i)
     {
@@ -312,12 +639,13 @@ Combinations CombineSeeds(const PlanId fPlId,
             continue;
         }
 
-        const bool hasGlue = (fComPl.m_Glue.m_Graph.GetOps().size() > 0);
+        const bool hasGlue = (fComPl.m_Glue->m_Graph.GetOps().size() > 0);
 
         const bool canMerge = !hasGlue && !outInDram && !outAtomic;
 
-        AddedSeed addedSeed = AddSeed(fPlId, fComPl.m_Id, fPartId, sEdge, sPart, &fComPl.m_Glue, comb, baseSizeInBytes,
-                                      minSizeInBytes, alloc, caps, canMerge);
+        AddedSeed addedSeed =
+            AddSeed(fPlId, fComPl.m_Id, fPartId, sEdge, sPart, fComPl.m_Glue.get(), comb, baseSizeInBytes, minSizeInBytes,
+                    planDramTraffic + fComPl.m_GlueDramTraffic, alloc, caps, canMerge);
 
         if (addedSeed.m_Added)
         {
@@ -331,6 +659,57 @@ Combinations CombineSeeds(const PlanId fPlId,
     return result;
 }
 
+/// One way of reaching a plan of a Part in CombineChainRegion. Only the ways which aren't dominated by another way of
+/// reaching the same plan (i.e. one which leaves no less SRAM free, causes no more DRAM traffic and merges no fewer
+/// plans) are kept.
+struct ChainLabel
+{
+    uint32_t m_AllocatedSram;
+    uint64_t m_DramTraffic;
+    size_t m_NumMerges;
+    /// The plan of the previous Part, and the label of that plan, which this was reached from.
+    PlanId m_PrevPlanId;
+    size_t m_PrevLabelIdx;
+    const Glue* m_Glue;
+};
+
+using ChainLabels = std::vector<ChainLabel>;
+
+/// Whether the only output of the given Part is the only input of the next Part in topological order.
+bool IsChainLink(const Metadata& metadata, PartId partId)
+{
+    if (partId + 1U >= metadata.size())
+    {
+        return false;
+    }
+    const MetadataOfPart& mOfPa = metadata.at(partId);
+    return mOfPa.m_Destination.size() == 1U && mOfPa.m_Destination.begin()->second == partId + 1U &&
+           metadata.at(partId + 1U).m_Source.size() == 1U;
+}
+
+/// Whether the first label is at least as good as the second in every way. The number of merges counts, as it is the
+/// score by which the search drops combinations (see GrowSeeds).
+bool DominatesChainLabel(const ChainLabel& a, const ChainLabel& b)
+{
+    return a.m_AllocatedSram <= b.m_AllocatedSram && a.m_DramTraffic <= b.m_DramTraffic &&
+           a.m_NumMerges >= b.m_NumMerges;
+}
+
+void AddChainLabel(ChainLabels& labels, const ChainLabel& label)
+{
+    for (const ChainLabel& l : labels)
+    {
+        if (DominatesChainLabel(l, label))
+        {
+            return;
+        }
+    }
+    labels.erase(std::remove_if(labels.begin(), labels.end(),
+                                [&label](const ChainLabel& l) { return DominatesChainLabel(label, l); }),
+                 labels.end());
+    labels.push_back(label);
+}
+
 }    // namespace
 
 PlanCompatibilityResult ArePlansCompatible(const Plan& plan1, const Plan& plan2, const Edge& edge)
@@ -437,7 +816,7 @@ PlanCompatibilityResult ArePlansCompatible(const Plan& plan1, const Plan& plan2,
     return PlanCompatibilityResult{};
 }
 
-Metadata CreateMetadata(const GraphOfParts& parts)
+Metadata CreateMetadata(const GraphOfParts& parts, const HardwareCapabilities& caps)
 {
     const size_t numParts = parts.GetNumParts();
     assert(numParts > 1U);
@@ -453,10 +832,15 @@ Metadata CreateMetadata(const GraphOfParts& parts)
         mOfPa.m_Comp.clear();
         mOfPa.m_Source.clear();
         mOfPa.m_Destination.clear();
+        mOfPa.m_PlanDramTraffic.clear();
         comPlsOfPa.clear();
 
         const Part& fPart                      = parts.GetPart(p);
         mOfPa.m_PartId                         = p;
+        for (uint32_t f = 0; f < fPart.GetNumPlans(); ++f)
+        {
+            mOfPa.m_PlanDramTraffic.push_back(EstimateWeightsDramTraffic(fPart.GetPlan(f).m_OpGraph, caps));
+        }
         const std::vector<const Edge*> dsEdges = fPart.GetOutputs();
         for (uint32_t n = 0; n < dsEdges.size(); ++n)
         {
@@ -471,23 +855,31 @@ Metadata CreateMetadata(const GraphOfParts& parts)
             // part has multiple inputs
             const bool reqDram = ((p + 1U) != inPa.second) || (dsEdges.size() > 1U) || (sPart.GetInputs().size() > 1U);
 
+            BoundaryCompatibilityCache compatibility(*dsEdge);
+            std::vector<size_t> inputClasses;
+            for (uint32_t s = 0; s < sPart.GetNumPlans(); ++s)
+            {
+                inputClasses.push_back(compatibility.GetInputClass(sPart.GetPlan(s)));
+            }
+
             for (uint32_t f = 0; f < fPart.GetNumPlans(); ++f)
             {
                 cPls.clear();
 
-                const Plan& fPl = fPart.GetPlan(f);
+                const Plan& fPl          = fPart.GetPlan(f);
+                const size_t outputClass = compatibility.GetOutputClass(fPl);
 
                 for (uint32_t s = 0; s < sPart.GetNumPlans(); ++s)
                 {
-                    const Plan& sPl                   = sPart.GetPlan(s);
-                    PlanCompatibilityResult plCompRes = ArePlansCompatible(fPl, sPl, *dsEdge);
+                    const BoundaryCompatibilityCache::Entry& plCompRes =
+                        compatibility.Get(outputClass, inputClasses[s]);
                     if (plCompRes.m_IsCompatible)
                     {
                         if (reqDram && !IsOutputBufferInDram(fPl, *dsEdge) && !plCompRes.m_RequiresGlue)
                         {
                             continue;
                         }
-                        cPls.push_back(CompatiblePlan{ std::move(plCompRes.m_Glue), s });
+                        cPls.push_back(CompatiblePlan{ plCompRes.m_Glue, s, plCompRes.m_GlueDramTraffic });
                     }
                 }
                 if (cPls.size() > 0)
@@ -531,7 +923,10 @@ Metadata CreateMetadata(const GraphOfParts& parts)
     return result;
 }
 
-Combinations CreateSeeds(const GraphOfParts& parts, const Metadata& metadata, const HardwareCapabilities& caps)
+Combinations CreateSeeds(const GraphOfParts& parts,
+                         const Metadata& metadata,
+                         const HardwareCapabilities& caps,
+                         ChainCombiner* chainCombiner)
 {
     const size_t numParts = parts.GetNumParts();
     assert(numParts > 1U);
@@ -542,7 +937,18 @@ Combinations CreateSeeds(const GraphOfParts& parts, const Metadata& metadata, co
     Combination comb;
 
     // First part in topological order
-    const PartId fPartId = 0;
+    const PartId fPartId           = 0;
+    comb.m_Scratch.m_CurrPartId    = fPartId;
+    comb.m_Scratch.m_AllocatedSram = 0;
+
+    if (chainCombiner != nullptr)
+    {
+        GrownSeeds grown = chainCombiner->Grow(Combinations{ comb }, 0);
+        if (!grown.m_Combinations.empty())
+        {
+            return grown.m_Combinations;
+        }
+    }
 
     // Second part in topological order
     NxtPa next = GetNxtPart(fPartId, numParts, comb, metadata);
@@ -572,11 +978,21 @@ GrownSeeds GrowSeeds(const Combinations& combs,
                      const GraphOfParts& parts,
                      const size_t minScore,
                      const Metadata& metadata,
-                     const HardwareCapabilities& caps)
+                     const HardwareCapabilities& caps,
+                     ChainCombiner* chainCombiner)
 {
     const size_t numParts = parts.GetNumParts();
     assert(numParts > 1U);
 
+    if (chainCombiner != nullptr)
+    {
+        GrownSeeds grown = chainCombiner->Grow(combs, minScore);
+        if (!grown.m_Combinations.empty())
+        {
+            return grown;
+        }
+    }
+
     GrownSeeds result;
     result.m_Terminated = true;
 
@@ -646,7 +1062,11 @@ GrownSeeds GrowSeeds(const Combinations& combs,
                 // Output part
                 Combination grownComb    = next.m_Comb;
                 const PlanFromSource fPl = GetPlanFromSource(fPartId, next.m_Comb, metadata);
-                grownComb.m_Elems.push_back(Elem{ fPartId, fPl.m_Id, {} });
+                grownComb.AddElem(fPartId, fPl.m_Id);
+                if (fPl.m_Found)
+                {
+                    grownComb.m_Scratch.m_MinDramTraffic += fMOfPa.m_PlanDramTraffic.at(fPl.m_Id);
+                }
                 result.m_Combinations.push_back(grownComb);
             }
         }
@@ -663,24 +1083,348 @@ GrownSeeds GrowSeeds(const Combinations& combs,
     return result;
 }
 
+std::vector<ChainRegion> FindChainRegions(const Metadata& metadata)
+{
+    std::vector<ChainRegion> result;
+    PartId first = 0;
+    while (first < metadata.size())
+    {
+        PartId last = first;
+        while (IsChainLink(metadata, last))
+        {
+            ++last;
+        }
+        if (last > first)
+        {
+            result.push_back(ChainRegion{ first, last });
+        }
+        first = last + 1U;
+    }
+    return result;
+}
+
+std::vector<ChainPath> CombineChainRegion(const GraphOfParts& parts,
+                                          const Metadata& metadata,
+                                          const HardwareCapabilities& caps,
+                                          const ChainRegion& region,
+                                          PlanId firstPlanId)
+{
+    assert(region.m_First < region.m_Last && region.m_Last < metadata.size());
+    const size_t numParts          = region.m_Last - region.m_First + 1U;
+    const uint32_t sramSizeInBytes = caps.GetTotalSramSize() / caps.GetNumberOfSrams();
+
+    // The labels of each plan of each Part of the region (indexed from the first), reached by the same rules as
+    // CombineSeeds uses (except that merges aren't limited to the smallest one found so far).
+    std::vector<std::vector<ChainLabels>> labels(numParts);
+    for (size_t i = 0; i < numParts; ++i)
+    {
+        labels[i].resize(parts.GetPart(region.m_First + static_cast<PartId>(i)).GetNumPlans());
+    }
+    const SizeInBytes firstTotSize = GetTotSizeInBytes(parts.GetPart(region.m_First).GetPlan(firstPlanId));
+    labels[0][firstPlanId].push_back(ChainLabel{ firstTotSize.m_Tot - firstTotSize.m_TotAtomic,
+                                                 metadata.at(region.m_First).m_PlanDramTraffic.at(firstPlanId), 0, 0,
+                                                 0, nullptr });
+
+    for (size_t i = 0; i + 1U < numParts; ++i)
+    {
+        const PartId fPartId         = region.m_First + static_cast<PartId>(i);
+        const MetadataOfPart& fMOfPa = metadata.at(fPartId);
+        const MetadataOfPart& sMOfPa = metadata.at(fPartId + 1U);
+        const Edge* sEdge            = fMOfPa.m_Destination.begin()->first;
+        const Part& fPart            = parts.GetPart(fPartId);
+        const Part& sPart            = parts.GetPart(fPartId + 1U);
+
+        const CompatiblePlansOfParts::const_iterator comPlsOfPa = fMOfPa.m_Comp.find(sEdge);
+        if (comPlsOfPa == fMOfPa.m_Comp.end())
+        {
+            return {};
+        }
+        for (const auto& fComPls : comPlsOfPa->second)
+        {
+            const PlanId fPlId = fComPls.first;
+            if (labels[i][fPlId].empty())
+            {
+                continue;
+            }
+            const Plan& fPl      = fPart.GetPlan(fPlId);
+            const bool outInDram = IsOutputBufferInDram(fPl, *sEdge);
+            const bool outAtomic = IsOutputBufferAtomic(fPl, *sEdge);
+
+            for (const CompatiblePlan& fComPl : fComPls.second)
+            {
+                const bool hasGlue  = (fComPl.m_Glue->m_Graph.GetOps().size() > 0);
+                const bool canMerge = !hasGlue && !outInDram && !outAtomic;
+
+                const SizeInBytes sTotSize = GetTotSizeInBytes(sPart.GetPlan(fComPl.m_Id));
+                const SizeInBytes sInSize  = GetInputsSizeInBytes(sPart.GetPlan(fComPl.m_Id));
+                const uint64_t addedDramTraffic =
+                    fComPl.m_GlueDramTraffic + sMOfPa.m_PlanDramTraffic.at(fComPl.m_Id);
+
+                for (size_t l = 0; l < labels[i][fPlId].size(); ++l)
+                {
+                    const ChainLabel& fLabel      = labels[i][fPlId][l];
+                    const uint32_t addSizeInBytes = canMerge
+                                                        ? (fLabel.m_AllocatedSram + sTotSize.m_Tot - sInSize.m_Tot)
+                                                        : sTotSize.m_Tot;
+                    if (addSizeInBytes / caps.GetNumberOfSrams() > sramSizeInBytes)
+                    {
+                        // There is no space
+                        continue;
+                    }
+                    AddChainLabel(labels[i + 1U][fComPl.m_Id],
+                                  ChainLabel{ addSizeInBytes - sTotSize.m_TotAtomic,
+                                              fLabel.m_DramTraffic + addedDramTraffic,
+                                              fLabel.m_NumMerges + (canMerge ? 1U : 0U), fPlId, l,
+                                              fComPl.m_Glue.get() });
+                }
+            }
+        }
+    }
+
+    // For each plan of the last Part, follow its labels back to the first Part to find the plan chosen for each Part.
+    // Only the labels which aren't beaten on both DRAM traffic and the number of merges are followed, as the SRAM left
+    // free after the region doesn't matter: the output of the last Part goes to DRAM. Of labels which are equally good
+    // on both, the one which leaves the most SRAM free is chosen, so that the result doesn't depend on their order.
+    std::vector<ChainPath> result;
+    const std::vector<ChainLabels>& lastLabels = labels[numParts - 1U];
+    for (PlanId s = 0; s < lastLabels.size(); ++s)
+    {
+        std::vector<const ChainLabel*> sorted;
+        for (const ChainLabel& label : lastLabels[s])
+        {
+            sorted.push_back(&label);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const ChainLabel* a, const ChainLabel* b) {
+            return std::make_tuple(a->m_DramTraffic, b->m_NumMerges, a->m_AllocatedSram) <
+                   std::make_tuple(b->m_DramTraffic, a->m_NumMerges, b->m_AllocatedSram);
+        });
+
+        for (size_t l = 0; l < sorted.size(); ++l)
+        {
+            const ChainLabel* last = sorted[l];
+            if (l > 0 && last->m_NumMerges <= result.back().m_NumMerges)
+            {
+                continue;
+            }
+
+            ChainPath path;
+            path.m_PlanIds.resize(numParts);
+            path.m_Glues.resize(numParts - 1U);
+            path.m_AllocatedSram = last->m_AllocatedSram;
+            path.m_DramTraffic   = last->m_DramTraffic - metadata.at(region.m_Last).m_PlanDramTraffic.at(s);
+            path.m_NumMerges     = last->m_NumMerges;
+
+            path.m_PlanIds[numParts - 1U] = s;
+            const ChainLabel* label       = last;
+            for (size_t i = numParts - 1U; i > 0; --i)
+            {
+                path.m_Glues[i - 1U]   = label->m_Glue;
+                path.m_PlanIds[i - 1U] = label->m_PrevPlanId;
+                label                  = &labels[i - 1U][label->m_PrevPlanId].at(label->m_PrevLabelIdx);
+            }
+            result.push_back(std::move(path));
+        }
+    }
+    return result;
+}
+
+ChainCombiner::ChainCombiner(const GraphOfParts& parts, const Metadata& metadata, const HardwareCapabilities& caps)
+    : m_Parts(parts)
+    , m_Metadata(metadata)
+    , m_Capabilities(caps)
+{
+    for (const ChainRegion& region : FindChainRegions(metadata))
+    {
+        m_Regions.emplace(region.m_First, region);
+    }
+}
+
+GrownSeeds ChainCombiner::Grow(const Combinations& combs, size_t minScore)
+{
+    // The combinations are grown in step, so they normally all get to the start of a region together.
+    const ChainRegion* region = nullptr;
+    for (const Combination& comb : combs)
+    {
+        if (comb.m_Scratch.m_Score < minScore)
+        {
+            continue;
+        }
+        const std::map<PartId, ChainRegion>::const_iterator it = m_Regions.find(comb.m_Scratch.m_CurrPartId);
+        if (it == m_Regions.end() || (region != nullptr && region != &it->second))
+        {
+            return GrownSeeds{};
+        }
+        region = &it->second;
+    }
+    if (region == nullptr)
+    {
+        return GrownSeeds{};
+    }
+
+    GrownSeeds result;
+    result.m_Terminated = false;
+    for (const Combination& comb : combs)
+    {
+        if (comb.m_Scratch.m_Score >= minScore)
+        {
+            GrowThroughRegion(comb, *region, result.m_Combinations);
+        }
+    }
+    if (result.m_Combinations.empty())
+    {
+        ++m_NumFallbacks;
+        return GrownSeeds{};
+    }
+    for (const Combination& comb : result.m_Combinations)
+    {
+        result.m_BestScore = std::max(result.m_BestScore, comb.m_Scratch.m_Score);
+    }
+    ++m_NumRegionsCombined;
+    return result;
+}
+
+void ChainCombiner::GrowThroughRegion(const Combination& comb, const ChainRegion& region, Combinations& result)
+{
+    const MetadataOfPart& fMOfPa = m_Metadata.at(region.m_First);
+    const Edge* fEdge            = fMOfPa.m_Destination.begin()->first;
+
+    const CompatiblePlansOfParts::const_iterator comPlsOfPa = fMOfPa.m_Comp.find(fEdge);
+    if (comPlsOfPa == fMOfPa.m_Comp.end())
+    {
+        return;
+    }
+
+    // The first Part of a region only has one output, so its plan's DRAM traffic hasn't been counted yet.
+    assert(!comb.HasElem(region.m_First));
+    const PlanFromSource fPl = GetPlanFromSource(region.m_First, comb, m_Metadata);
+    for (const auto& fComPls : comPlsOfPa->second)
+    {
+        if (fPl.m_Found && fComPls.first != fPl.m_Id)
+        {
+            continue;
+        }
+        for (const ChainPath& path : GetPaths(region, fComPls.first))
+        {
+            Combination grownComb = comb;
+            for (PartId p = region.m_First; p < region.m_Last; ++p)
+            {
+                const size_t i    = p - region.m_First;
+                const Edge* sEdge = m_Metadata.at(p).m_Destination.begin()->first;
+                grownComb.AddVisitedEdge(p, sEdge);
+                grownComb.AddLink(p, path.m_PlanIds[i], sEdge, Elem::Link{ path.m_PlanIds[i + 1U], path.m_Glues[i] });
+            }
+            grownComb.m_Scratch.m_CurrPartId    = region.m_Last;
+            grownComb.m_Scratch.m_AllocatedSram = path.m_AllocatedSram;
+            grownComb.m_Scratch.m_MinDramTraffic += path.m_DramTraffic;
+            grownComb.m_Scratch.m_Score += path.m_NumMerges;
+            result.push_back(std::move(grownComb));
+        }
+    }
+}
+
+const std::vector<ChainPath>& ChainCombiner::GetPaths(const ChainRegion& region, PlanId firstPlanId)
+{
+    const std::pair<PartId, PlanId> key(region.m_First, firstPlanId);
+    std::map<std::pair<PartId, PlanId>, std::vector<ChainPath>>::const_iterator it = m_Paths.find(key);
+    if (it == m_Paths.end())
+    {
+        it = m_Paths
+                 .emplace(key, CombineChainRegion(m_Parts, m_Metadata, m_Capabilities, region, firstPlanId))
+                 .first;
+    }
+    return it->second;
+}
+
 Combinations Cascading::Combine(const GraphOfParts& parts)
 {
-    m_Metadata = CreateMetadata(parts);
+    m_Metadata = CreateMetadata(parts, m_Capabilities);
 
-    Combinations currSeeds = CreateSeeds(parts, m_Metadata, m_Capabilities);
+    std::unique_ptr<ChainCombiner> chainCombiner;
+    if (m_UseDynamicProgramming)
+    {
+        chainCombiner = std::make_unique<ChainCombiner>(parts, m_Metadata, m_Capabilities);
+    }
+
+    // When the search is limited, some of the combinations dropped at each step are kept in reserve in case all the
+    // combinations kept reach a dead end (e.g. because their plans aren't compatible with any plans of the next Part).
+    std::vector<Combinations> reserves;
+
+    Combinations currSeeds = CreateSeeds(parts, m_Metadata, m_Capabilities, chainCombiner.get());
+    reserves.push_back(ApplySearchLimits(currSeeds, parts.GetNumParts()));
 
     GrownSeeds grownSeeds;
 
     do
     {
         const size_t limit = (grownSeeds.m_BestScore > 1U) ? (grownSeeds.m_BestScore - 1U) : grownSeeds.m_BestScore;
-        grownSeeds         = GrowSeeds(currSeeds, parts, limit, m_Metadata, m_Capabilities);
-        currSeeds          = grownSeeds.m_Combinations;
+        grownSeeds         = GrowSeeds(currSeeds, parts, limit, m_Metadata, m_Capabilities, chainCombiner.get());
+        currSeeds          = std::move(grownSeeds.m_Combinations);
+        ++m_SearchReport.m_NumSteps;
+        while (currSeeds.empty() && !reserves.empty())
+        {
+            // Carry on from the combinations dropped most recently
+            currSeeds = std::move(reserves.back());
+            reserves.pop_back();
+            grownSeeds.m_BestScore = 0;
+            m_SearchReport.m_NumBacktracks += currSeeds.empty() ? 0 : 1;
+        }
+        reserves.push_back(ApplySearchLimits(currSeeds, parts.GetNumParts()));
     } while (!grownSeeds.m_Terminated);
 
+    if (chainCombiner)
+    {
+        m_SearchReport.m_NumChainRegionsCombined = chainCombiner->GetNumRegionsCombined();
+        m_SearchReport.m_NumChainRegionFallbacks = chainCombiner->GetNumFallbacks();
+    }
     return currSeeds;
 }
 
+Combinations Cascading::ApplySearchLimits(Combinations& combinations, size_t numParts)
+{
+    m_SearchReport.m_MaxNumCombinations = std::max(m_SearchReport.m_MaxNumCombinations, combinations.size());
+    m_SearchReport.m_NumCombinationsCreated += combinations.size();
+    if (m_ActiveSearchLimits.m_BeamWidth == 0 && m_ActiveSearchLimits.m_MaxCombinations == 0)
+    {
+        return {};
+    }
+
+    // All the combinations are grown in step so are either all complete or all partial.
+    const bool isComplete = !combinations.empty() && combinations.front().m_Scratch.m_CurrPartId >= numParts;
+    const bool overBudget = IsCombinationBudgetExceeded();
+    if (overBudget && !m_SearchReport.m_CombinationBudgetExceeded)
+    {
+        m_SearchReport.m_CombinationBudgetExceeded = true;
+        m_SearchReport.m_StepWhenBudgetExceeded    = m_SearchReport.m_NumSteps;
+        m_SearchReport.m_PartWhenBudgetExceeded =
+            combinations.empty() ? 0 : combinations.front().m_Scratch.m_CurrPartId;
+    }
+
+    // Once over budget only the most promising partial combination is grown, so that the search finishes quickly.
+    // Complete combinations are kept up to the beam width, as they are then all estimated to find the best.
+    const size_t width = (overBudget && !isComplete) ? 1 : m_ActiveSearchLimits.m_BeamWidth;
+    const bool drop    = width != 0 && combinations.size() > width;
+
+    // Complete combinations are ranked too, so that the most promising are estimated first and the others can stop
+    // as soon as they are known to be worse.
+    // The sort is stable so that the result doesn't depend on the implementation of the standard library.
+    if (drop || isComplete)
+    {
+        std::stable_sort(combinations.begin(), combinations.end(), [](const Combination& a, const Combination& b) {
+            return a.m_Scratch.m_MinDramTraffic < b.m_Scratch.m_MinDramTraffic;
+        });
+    }
+    Combinations reserve;
+    if (drop)
+    {
+        m_SearchReport.m_NumCombinationsDropped += combinations.size() - width;
+        // Complete combinations can't reach a dead end, so none are kept in reserve for them.
+        const size_t reserveSize = isComplete ? 0 : std::min(width, combinations.size() - width);
+        reserve.assign(combinations.begin() + width, combinations.begin() + width + reserveSize);
+        combinations.erase(combinations.begin() + width, combinations.end());
+    }
+    return reserve;
+}
+
 OpGraph GetOpGraphForCombination(const Combination& combination, const GraphOfParts& parts)
 {
     OpGraph result;
@@ -705,7 +1449,7 @@ OpGraph GetOpGraphForCombination(const Combination& combination, const GraphOfPa
 
     // Add each Elem, one at a time. It is assumed that these are toplogically sorted, so we can assume that all
     // parts used as input to each part have already been processed.
-    for (const Elem& elem : combination.m_Elems)
+    for (const Elem& elem : combination.GetElems())
     {
         const Part& part = parts.GetPart(elem.m_PartId);
         const Plan& plan = part.GetPlan(elem.m_PlanId);
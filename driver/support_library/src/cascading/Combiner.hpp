@@ -5,9 +5,11 @@
 
 #pragma once
 
+#include "../include/ethosn_support_library/Optional.hpp"
 #include "Part.hpp"
 #include "Plan.hpp"
 
+#include <array>
 #include <memory>
 #include <unordered_map>
 
@@ -59,29 +61,50 @@ struct Elem
 
 struct Scratch
 {
-    using Indexes = std::unordered_map<PartId, size_t>;
-    using Dst     = std::vector<const Edge*>;
-    using Edges   = std::unordered_map<PartId, Dst>;
-
     uint32_t m_AllocatedSram;
 
-    Indexes m_Idx;
-    Edges m_Edges;
     PartId m_CurrPartId;
 
     size_t m_Score = 0;
+
+    /// The DRAM traffic which the plans and glues chosen so far are known to cause, whatever else is chosen.
+    /// This is used to rank partial combinations when they can't all be kept.
+    uint64_t m_MinDramTraffic = 0;
 };
 
-struct Combination
+/// A (possibly partial) combination of plans, one for each Part.
+/// The combiner grows many combinations from each one, so rather than storing a full copy of its elements, each
+/// combination is a list of the changes made to it which is shared with all the combinations it was grown from (and
+/// grown into). Copying or adding to a combination is therefore O(1) in time and memory.
+/// So that lookups don't have to search back through all the changes, each change also points to the previous one
+/// made to the same Part, and every few changes the latest change to each Part is added to an index which is shared
+/// in the same way. Lookups therefore take O(log n) time in the number of Parts, plus the number of changes made to
+/// the Part itself. Combinations can be read from multiple threads at once.
+class Combination
 {
-    using Elems          = std::vector<Elem>;
-    Combination& operator=(const Combination& c) = default;
+public:
+    /// Adds an element for the given Part, which must not already have one.
+    void AddElem(PartId partId, PlanId planId);
+    /// Connects the element of the given Part to a plan of the Part on the other end of the given edge, adding
+    /// the element first if the Part doesn't have one yet. Links which have already been added are left unchanged.
+    void AddLink(PartId partId, PlanId planId, const Edge* edge, const Elem::Link& link);
+    /// Records that the given outgoing edge of the given Part has been visited by the combiner.
+    void AddVisitedEdge(PartId partId, const Edge* edge);
+
+    bool HasElem(PartId partId) const;
+    /// Returns the link from the element of the given Part along the given edge, or nullptr if there isn't one.
+    const Elem::Link* GetLink(PartId partId, const Edge* edge) const;
+    bool IsEdgeVisited(PartId partId, const Edge* edge) const;
+    size_t GetNumVisitedEdges(PartId partId) const;
+
+    /// Returns the elements, in the order in which they were added.
+    std::vector<Elem> GetElems() const;
 
     /// Helpers
     /// @{
     size_t GetNumElems() const
     {
-        return m_Elems.size();
+        return m_NumElems;
     }
     /// @}
 
@@ -90,13 +113,76 @@ struct Combination
     Scratch m_Scratch;
     /// @}
 
-    Elems m_Elems;
+private:
+    struct Change
+    {
+        enum class Type
+        {
+            /// A new element for m_PartId, using m_PlanId and with m_Link along m_Edge if m_Edge is not null.
+            AddElem,
+            /// A link from the existing element for m_PartId along m_Edge.
+            AddLink,
+            /// m_Edge is an outgoing edge of m_PartId which has been visited.
+            AddVisitedEdge,
+        };
+
+        /// Releases the earlier changes which are only used by this one in a loop rather than recursively, so that
+        /// destroying a combination with any number of changes can't overflow the stack.
+        ~Change();
+
+        /// This is only changed while the change is being destroyed.
+        mutable std::shared_ptr<const Change> m_Previous;
+        /// The previous change made to m_PartId, if any, which is kept alive by m_Previous.
+        const Change* m_PreviousForPart;
+        Type m_Type;
+        PartId m_PartId;
+        PlanId m_PlanId;
+        const Edge* m_Edge;
+        Elem::Link m_Link;
+    };
+
+    static constexpr uint32_t ms_NumBitsPerLevel = 2;
+    static constexpr size_t ms_NumChildren       = size_t{ 1 } << ms_NumBitsPerLevel;
+    /// The number of changes which are made before they are added to the index.
+    static constexpr uint32_t ms_MaxNumUnindexedChanges = 16;
+
+    /// A node of the index, which is never changed once it is part of a combination. Each level of the index is
+    /// indexed by the next ms_NumBitsPerLevel bits of the PartId, from the most significant.
+    struct IndexNode
+    {
+        /// For the other levels, the nodes of the level below.
+        std::array<std::shared_ptr<const IndexNode>, ms_NumChildren> m_Children;
+        /// For the lowest level, the latest change made to each Part.
+        std::array<const Change*, ms_NumChildren> m_Changes;
+        /// For the root, the number of levels, which is just enough for the largest PartId in the index.
+        uint32_t m_NumLevels;
+    };
+
+    void AddChange(Change::Type type, PartId partId, PlanId planId, const Edge* edge, const Elem::Link& link);
+    /// Returns the latest change made to the given Part, or nullptr if there isn't one.
+    const Change* FindLastChange(PartId partId) const;
+    /// Adds the changes made since the index was last updated to the index.
+    void UpdateIndex();
+    /// Returns a copy of the given node (or a new node if it is null) with the given changes, which are the latest
+    /// changes to Parts below the node, sorted by PartId.
+    static std::shared_ptr<IndexNode> UpdateIndex(const IndexNode* node,
+                                                  uint32_t level,
+                                                  std::vector<const Change*>::const_iterator begin,
+                                                  std::vector<const Change*>::const_iterator end);
+
+    /// The most recent change, which leads back to all the earlier ones.
+    std::shared_ptr<const Change> m_LastChange;
+    /// The latest change to each Part as of m_NumUnindexedChanges changes ago.
+    std::shared_ptr<const IndexNode> m_Index;
+    uint32_t m_NumUnindexedChanges = 0;
+    uint32_t m_NumElems            = 0;
 };
 
 using Combinations = std::vector<Combination>;
 
 // Compatible plan of a destination part given the source part and
 // its plan. The glue member tells how the plans are connected.
+// Plans whose buffers on the same Edge are the same share a single Glue.
 struct CompatiblePlan
 {
     CompatiblePlan()                          = default;
@@ -104,8 +190,10 @@ struct CompatiblePlan
     CompatiblePlan(const CompatiblePlan& rhs) = delete;
     CompatiblePlan& operator=(CompatiblePlan&& rhs) = delete;
 
-    Glue m_Glue;
+    std::shared_ptr<const Glue> m_Glue;
     PlanId m_Id;
+    /// The DRAM traffic caused by the glue, see Scratch::m_MinDramTraffic.
+    uint64_t m_GlueDramTraffic = 0;
 };
 
 // Vector of all compatible plans of a destination part given the
@@ -149,6 +237,8 @@ struct MetadataOfPart
     DstPart m_Destination;
     PartId m_PartId;
     CompatiblePlansOfParts m_Comp;
+    /// For each plan of the Part, the DRAM traffic it causes by itself, see Scratch::m_MinDramTraffic.
+    std::vector<uint64_t> m_PlanDramTraffic;
 };
 
 // |-----------------------------------------------------------|----
@@ -176,6 +266,44 @@ struct GrownSeeds
     Combinations m_Combinations;
 };
 
+/// Limits on the search for combinations, see CompilationOptions::m_CascadingBeamWidth and
+/// CompilationOptions::m_CascadingMaxCombinations. Zero means no limit.
+struct CombinerSearchLimits
+{
+    uint32_t m_BeamWidth       = 0;
+    uint32_t m_MaxCombinations = 0;
+};
+
+/// How far the search for combinations got, and what was left out to keep it within its limits.
+struct CombinerSearchReport
+{
+    /// The number of times all the combinations were grown.
+    uint32_t m_NumSteps = 0;
+    /// The greatest number of combinations there were after any step, before any were dropped.
+    size_t m_MaxNumCombinations = 0;
+    /// The total number of combinations created by all the steps, before any were dropped.
+    size_t m_NumCombinationsCreated = 0;
+    /// The number of partial combinations dropped to keep within the beam width (or the combination budget).
+    size_t m_NumCombinationsDropped = 0;
+    /// The number of times all the combinations being grown reached a dead end, so the search carried on from some
+    /// which had been dropped.
+    uint32_t m_NumBacktracks = 0;
+    bool m_CombinationBudgetExceeded = false;
+    /// If the combination budget was exceeded, the step and the Part the search had got to.
+    uint32_t m_StepWhenBudgetExceeded = 0;
+    PartId m_PartWhenBudgetExceeded   = 0;
+    /// The number of times the search was repeated with larger limits, because the combinations it was limited to
+    /// couldn't be estimated.
+    uint32_t m_NumRetries = 0;
+    /// The number of times the combinations were grown through a whole chain region at once by ChainCombiner.
+    uint32_t m_NumChainRegionsCombined = 0;
+    /// The number of times ChainCombiner found no way through a chain region, so it was searched step by step.
+    uint32_t m_NumChainRegionFallbacks = 0;
+    /// Whether the search was repeated without ChainCombiner, because none of the combinations it found could be
+    /// estimated.
+    bool m_ChainCombinerAbandoned = false;
+};
+
 /// Checks whether two given plans are compatible, i.e. whether plan1 could be joined to plan2 along the given Edge.
 PlanCompatibilityResult ArePlansCompatible(const Plan& plan1, const Plan& plan2, const Edge& edge);
 
@@ -186,7 +314,74 @@ PlanCompatibilityResult ArePlansCompatible(const Plan& plan1, const Plan& plan2,
 //
 // For each plan in PartX list all the compatible plans of PartY.
 // No SRAM allocation verification is performed at this stage.
-Metadata CreateMetadata(const GraphOfParts&);
+Metadata CreateMetadata(const GraphOfParts&, const HardwareCapabilities&);
+
+/// A run of Parts, consecutive in topological order, where each Part but the last has a single output which is the
+/// only input of the next Part. Plans can only be merged within a chain region, as the buffers between the Parts of
+/// different regions are always in DRAM.
+struct ChainRegion
+{
+    PartId m_First;
+    PartId m_Last;
+};
+
+/// A way through a chain region, found by CombineChainRegion.
+struct ChainPath
+{
+    /// The plan of each Part of the region, in order.
+    std::vector<PlanId> m_PlanIds;
+    /// The glue between each Part of the region and the next.
+    std::vector<const Glue*> m_Glues;
+    /// See Scratch::m_AllocatedSram, after the last Part of the region.
+    uint32_t m_AllocatedSram;
+    /// The DRAM traffic caused by the plans of the region (except the last, which is counted when the combination is
+    /// grown from it) and their glues.
+    uint64_t m_DramTraffic;
+    /// The number of plans merged with the previous plan, see Scratch::m_Score.
+    size_t m_NumMerges;
+};
+
+/// Speeds up the search for combinations by growing them through each chain region at once, choosing the plans of
+/// the Parts inside the region by dynamic programming (see CombineChainRegion) rather than trying every one.
+/// For each plan of its last Part, only the ways through the region which aren't beaten on both DRAM traffic and the
+/// number of merges are kept. The search prefers combinations with more merges (see GrowSeeds), so a way with more
+/// DRAM traffic but more merges may still be the one which the search would have found.
+/// The complete combinations are still ranked by estimating their performance.
+class ChainCombiner
+{
+public:
+    ChainCombiner(const GraphOfParts&, const Metadata&, const HardwareCapabilities&);
+
+    /// If the given combinations (those with at least the given score) have all got to the first Part of the same
+    /// chain region, grows each of them through the whole region. Returns no combinations otherwise, or if there is
+    /// no way through the region from any of them, in which case the region is searched step by step as usual.
+    GrownSeeds Grow(const Combinations& combs, size_t minScore);
+
+    uint32_t GetNumRegionsCombined() const
+    {
+        return m_NumRegionsCombined;
+    }
+    uint32_t GetNumFallbacks() const
+    {
+        return m_NumFallbacks;
+    }
+
+private:
+    /// Adds to the given combinations those grown from the given one through the given region.
+    void GrowThroughRegion(const Combination& comb, const ChainRegion& region, Combinations& result);
+    const std::vector<ChainPath>& GetPaths(const ChainRegion& region, PlanId firstPlanId);
+
+    const GraphOfParts& m_Parts;
+    const Metadata& m_Metadata;
+    const HardwareCapabilities& m_Capabilities;
+    /// The chain regions, by their first Part.
+    std::map<PartId, ChainRegion> m_Regions;
+    /// The result of CombineChainRegion for each region (by its first Part) and plan of its first Part, as many
+    /// combinations reach a region with the same plan.
+    std::map<std::pair<PartId, PlanId>, std::vector<ChainPath>> m_Paths;
+    uint32_t m_NumRegionsCombined = 0;
+    uint32_t m_NumFallbacks       = 0;
+};
 
 // Create the seeds from which all the combinations are going to be derived.
 // The seeds are created from the first part in topological order.
@@ -197,12 +392,34 @@ Metadata CreateMetadata(const GraphOfParts&);
 // PartX and PartY. At this stage two plans can be merged if they
 // meet the SRAM allocation requirements (e.g. all required buffers fit
 // in the SRAM).
-Combinations CreateSeeds(const GraphOfParts&, const Metadata&, const HardwareCapabilities&);
+// If a ChainCombiner is given and the first part starts a chain region, the seeds are grown through the whole region.
+Combinations CreateSeeds(const GraphOfParts&,
+                         const Metadata&,
+                         const HardwareCapabilities&,
+                         ChainCombiner* chainCombiner = nullptr);
 
 // The input combinations seeds are grown by one plan at each iteration
 // until all the combinations have length equal to the number of parts.
-GrownSeeds
-    GrowSeeds(const Combinations&, const GraphOfParts&, const size_t, const Metadata&, const HardwareCapabilities&);
+// If a ChainCombiner is given, combinations which reach the first Part of a chain region are grown through the
+// whole region at once instead.
+GrownSeeds GrowSeeds(const Combinations&,
+                     const GraphOfParts&,
+                     const size_t,
+                     const Metadata&,
+                     const HardwareCapabilities&,
+                     ChainCombiner* chainCombiner = nullptr);
+
+/// Finds the chain regions of the Parts, in topological order.
+std::vector<ChainRegion> FindChainRegions(const Metadata&);
+
+/// Finds the ways through the given chain region, starting from the given plan of its first Part, with the least DRAM
+/// traffic (see Scratch::m_MinDramTraffic) by dynamic programming. This takes time linear in the number of Parts in
+/// the region. It considers every combination of compatible plans for which the plans which are merged together fit
+/// in SRAM, which includes all those that GrowSeeds would create.
+/// Returns, for each plan of the last Part which can be reached (in order of PlanId), the paths which aren't beaten on
+/// both DRAM traffic and the number of merges by another path, in order of DRAM traffic.
+std::vector<ChainPath> CombineChainRegion(
+    const GraphOfParts&, const Metadata&, const HardwareCapabilities&, const ChainRegion&, PlanId firstPlanId);
 
 /// Creates a single OpGraph which contains the full graph of Ops and Buffers for the given Combination.
 /// This handles merging of adjacent Plans and Glues to give a homogenous structure, suitable for
@@ -15,6 +15,7 @@
 #include "Part.hpp"
 
 #include <iostream>
+#include <limits>
 
 using namespace std;
 using namespace ethosn::support_library::utils;
@@ -32,17 +33,150 @@ DataFormat GetWeightsFormat(const MceOp& mceOp)
     return mceOp.m_Op == MceOperation::DEPTHWISE_CONVOLUTION ? DataFormat::HWIM : DataFormat::HWIO;
 }
 
+/// Calculates the stats of a pass from the Ops and Buffers found by EstimatePassGrownFrom.
+PassStats CalculatePassStats(const PassStatsCache::Key& pass,
+                             const HardwareCapabilities& capabilities,
+                             const EstimationOptions& estimationOpts)
+{
+    PassStats result;
+
+    MceOp* mceOp = pass.m_MceOp;
+    PleOp* pleOp = pass.m_PleOp;
+
+    // Calculate MCE and weight stats if we have an MceOp
+    // Remember weights info as we need it for the input stats. Set a default in case we have no weights (i.e. Ple-only)
+    TensorInfo weightsTensorInfo = {
+        { { 1, 1, 1, 1 } },
+        DataType::UINT8_QUANTIZED,
+        DataFormat::HWIM,
+        { 0, 0.1f },
+    };
+    if (mceOp != nullptr)
+    {
+        result.m_Mce = GetMceStats(capabilities, mceOp->m_Stride, mceOp->m_Op, mceOp->m_Algo, mceOp->m_InputStripeShape,
+                                   mceOp->m_OutputStripeShape, mceOp->m_WeightsStripeShape);
+
+        const Buffer* inputBuffer = pass.m_Inputs[0].first;
+        const Buffer* weightsSram = pass.m_WeightsSram;
+        const Buffer* weightsDram = pass.m_WeightsDram;
+
+        weightsTensorInfo = TensorInfo(weightsDram->m_TensorShape, DataType::UINT8_QUANTIZED, GetWeightsFormat(*mceOp),
+                                       weightsDram->m_QuantizationInfo);
+        result.m_Weights =
+            GetWeightsStats(capabilities, *weightsDram->m_EncodedWeightsSize, weightsTensorInfo, weightsSram->m_StripeShape,
+                            weightsSram->m_SizeInBytes, inputBuffer->m_TensorShape, inputBuffer->m_StripeShape);
+    }
+
+    // Calculate PLE stats if we have a PleOp
+    if (pleOp != nullptr)
+    {
+        std::vector<TensorShape> inputShapes;
+        for (Buffer* inputBuffer : pass.m_PleInputs)
+        {
+            inputShapes.push_back(inputBuffer->m_TensorShape);
+        }
+
+        result.m_Ple = GetPleStats(capabilities, inputShapes, pleOp->m_Op);
+    }
+
+    const Buffer* sramOutputBuffer = pass.m_Output;
+
+    for (const std::pair<Buffer*, Location>& input : pass.m_Inputs)
+    {
+        const Buffer* sramInputBuffer = input.first;
+        bool isCompressed             = false;
+
+        // Number of output stripes affects the number of input data reloads for some streaming strategies.
+        uint32_t numOutStripeC =
+            utils::DivRoundUp(sramOutputBuffer->m_TensorShape[3], sramOutputBuffer->m_StripeShape[3]);
+
+        const InputStats uncompressedStats =
+            GetInputStats(capabilities, sramInputBuffer->m_TensorShape, sramInputBuffer->m_StripeShape, input.second,
+                          sramInputBuffer->m_SizeInBytes, weightsTensorInfo, numOutStripeC);
+        const InputStats inputStats =
+            isCompressed
+                ? AccountForActivationCompression(uncompressedStats, estimationOpts.m_ActivationCompressionSaving)
+                : uncompressedStats;
+        result.m_Input += inputStats;
+    }
+
+    {
+        bool isCompressed = false;
+
+        const TensorShape& roundedUpOutputShape =
+            pass.m_OutputFormat != CompilerDataFormat::NHWC
+                ? RoundUpHeightAndWidthToBrickGroup(sramOutputBuffer->m_TensorShape)
+                : sramOutputBuffer->m_TensorShape;
+
+        const OutputStats uncompressedStats =
+            GetOutputStats(roundedUpOutputShape, sramOutputBuffer->m_StripeShape, pass.m_OutputLocation);
+        result.m_Output = isCompressed ? AccountForActivationCompression(uncompressedStats,
+                                                                         estimationOpts.m_ActivationCompressionSaving)
+                                       : uncompressedStats;
+    }
+
+    return result;
+}
+
 }    // namespace
 
+bool PassStatsCache::Key::operator==(const Key& rhs) const
+{
+    return m_MceOp == rhs.m_MceOp && m_PleOp == rhs.m_PleOp && m_WeightsSram == rhs.m_WeightsSram &&
+           m_WeightsDram == rhs.m_WeightsDram && m_PleInputs == rhs.m_PleInputs && m_Inputs == rhs.m_Inputs &&
+           m_Output == rhs.m_Output && m_OutputLocation == rhs.m_OutputLocation &&
+           m_OutputFormat == rhs.m_OutputFormat;
+}
+
+size_t PassStatsCache::KeyHasher::operator()(const Key& k) const
+{
+    // The Ops and output Buffer of a pass are enough to tell most passes apart, as only the DMAs at the boundaries
+    // of a pass differ between combinations.
+    size_t h = std::hash<Op*>()(k.m_MceOp);
+    h        = utils::CombineHash(h, std::hash<Op*>()(k.m_PleOp));
+    h        = utils::CombineHash(h, std::hash<Buffer*>()(k.m_Output));
+    for (const std::pair<Buffer*, Location>& input : k.m_Inputs)
+    {
+        h = utils::CombineHash(h, std::hash<Buffer*>()(input.first));
+    }
+    return h;
+}
+
+utils::Optional<PassStats> PassStatsCache::Find(const Key& key)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end())
+    {
+        return {};
+    }
+    return it->second;
+}
+
+void PassStatsCache::Insert(const Key& key, const PassStats& stats)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Entries.emplace(key, stats);
+}
+
+void PassStatsCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Entries.clear();
+}
+
 /// Estimates a pass that contains the given Op and possibly some of its neighbours.
 /// Removes Ops from the given unestimatedOps set that it has included in its estimation.
 PassStats EstimatePassGrownFrom(const OpGraph& opGraph,
                                 Op* op,
                                 const HardwareCapabilities& capabilities,
                                 const EstimationOptions& estimationOpts,
-                                std::unordered_set<Op*>& unestimatedOps)
+                                std::unordered_set<Op*>& unestimatedOps,
+                                PassStatsCache* passStatsCache)
 {
-    PassStats result;
+    // First find the Ops and Buffers of the pass, checking that it is one that can be estimated, and then calculate
+    // its stats from those (unless the same pass has already been estimated).
+    PassStatsCache::Key pass;
 
     assert(unestimatedOps.count(op) > 0);
     MceOp* mceOp = GetObjectAs<MceOp>(op);
@@ -82,26 +216,17 @@ PassStats EstimatePassGrownFrom(const OpGraph& opGraph,
             }
         }
     }
+    pass.m_MceOp = mceOp;
+    pass.m_PleOp = pleOp;
 
-    // Calculate MCE and weight stats if we have an MceOp
-    // Remember weights info as we need it for the input stats. Set a default in case we have no weights (i.e. Ple-only)
-    TensorInfo weightsTensorInfo = {
-        { { 1, 1, 1, 1 } },
-        DataType::UINT8_QUANTIZED,
-        DataFormat::HWIM,
-        { 0, 0.1f },
-    };
+    // Find the weights if we have an MceOp
     if (mceOp != nullptr)
     {
-        result.m_Mce = GetMceStats(capabilities, mceOp->m_Stride, mceOp->m_Op, mceOp->m_Algo, mceOp->m_InputStripeShape,
-                                   mceOp->m_OutputStripeShape, mceOp->m_WeightsStripeShape);
-
         // Check for weights as second input to the MceOp
         if (opGraph.GetInputs(mceOp).size() != 2)
         {
             throw NotSupportedException("MceOp must have exactly 2 inputs");
         }
-        Buffer* inputBuffer = opGraph.GetInputs(mceOp)[0];
         Buffer* weightsSram = opGraph.GetInputs(mceOp)[1];
         if (weightsSram->m_Location != Location::Sram)
         {
@@ -125,27 +250,16 @@ PassStats EstimatePassGrownFrom(const OpGraph& opGraph,
         {
             throw NotSupportedException("Weights Dram buffer must not have a producer");
         }
-
-        weightsTensorInfo = TensorInfo(weightsDram->m_TensorShape, DataType::UINT8_QUANTIZED, GetWeightsFormat(*mceOp),
-                                       weightsDram->m_QuantizationInfo);
-        result.m_Weights =
-            GetWeightsStats(capabilities, *weightsDram->m_EncodedWeights, weightsTensorInfo, weightsSram->m_StripeShape,
-                            weightsSram->m_SizeInBytes, inputBuffer->m_TensorShape, inputBuffer->m_StripeShape);
+        pass.m_WeightsSram = weightsSram;
+        pass.m_WeightsDram = weightsDram;
 
         unestimatedOps.erase(dmaOp);
         unestimatedOps.erase(mceOp);
     }
 
-    // Calculate PLE stats if we have a PleOp
     if (pleOp != nullptr)
     {
-        std::vector<TensorShape> inputShapes;
-        for (Buffer* inputBuffer : opGraph.GetInputs(pleOp))
-        {
-            inputShapes.push_back(inputBuffer->m_TensorShape);
-        }
-
-        result.m_Ple = GetPleStats(capabilities, inputShapes, pleOp->m_Op);
+        pass.m_PleInputs = opGraph.GetInputs(pleOp);
         unestimatedOps.erase(pleOp);
     }
 
@@ -176,7 +290,6 @@ PassStats EstimatePassGrownFrom(const OpGraph& opGraph,
             throw NotSupportedException("Input buffer to PleOp/MceOp must be in Sram");
         }
         Location inputLocation = Location::Sram;
-        bool isCompressed      = false;
         DmaOp* dmaOp           = GetObjectAs<DmaOp>(opGraph.GetProducer(sramInputBuffer));
         if (dmaOp != nullptr && unestimatedOps.count(dmaOp) > 0)
         {
@@ -188,19 +301,7 @@ PassStats EstimatePassGrownFrom(const OpGraph& opGraph,
             inputLocation      = dramBuffer->m_Location;
             unestimatedOps.erase(dmaOp);
         }
-
-        // Number of output stripes affects the number of input data reloads for some streaming strategies.
-        uint32_t numOutStripeC =
-            utils::DivRoundUp(sramOutputBuffer->m_TensorShape[3], sramOutputBuffer->m_StripeShape[3]);
-
-        const InputStats uncompressedStats =
-            GetInputStats(capabilities, sramInputBuffer->m_TensorShape, sramInputBuffer->m_StripeShape, inputLocation,
-                          sramInputBuffer->m_SizeInBytes, weightsTensorInfo, numOutStripeC);
-        const InputStats inputStats =
-            isCompressed
-                ? AccountForActivationCompression(uncompressedStats, estimationOpts.m_ActivationCompressionSaving)
-                : uncompressedStats;
-        result.m_Input += inputStats;
+        pass.m_Inputs.emplace_back(sramInputBuffer, inputLocation);
     }
 
     // Check for a DmaOp afterwards, and use that to calculate output stats
@@ -211,7 +312,6 @@ PassStats EstimatePassGrownFrom(const OpGraph& opGraph,
         }
         Location outputLocation   = Location::Sram;
         CompilerDataFormat format = sramOutputBuffer->m_Format;
-        bool isCompressed         = false;
         if (opGraph.GetConsumers(sramOutputBuffer).size() == 1)
         {
             DmaOp* dmaOp = GetObjectAs<DmaOp>(opGraph.GetConsumers(sramOutputBuffer)[0].first);
@@ -227,26 +327,44 @@ PassStats EstimatePassGrownFrom(const OpGraph& opGraph,
                 unestimatedOps.erase(dmaOp);
             }
         }
-
-        const TensorShape& roundedUpOutputShape =
-            format != CompilerDataFormat::NHWC ? RoundUpHeightAndWidthToBrickGroup(sramOutputBuffer->m_TensorShape)
-                                               : sramOutputBuffer->m_TensorShape;
-
-        const OutputStats uncompressedStats =
-            GetOutputStats(roundedUpOutputShape, sramOutputBuffer->m_StripeShape, outputLocation);
-        result.m_Output = isCompressed ? AccountForActivationCompression(uncompressedStats,
-                                                                         estimationOpts.m_ActivationCompressionSaving)
-                                       : uncompressedStats;
+        pass.m_Output         = sramOutputBuffer;
+        pass.m_OutputLocation = outputLocation;
+        pass.m_OutputFormat   = format;
     }
 
+    if (passStatsCache == nullptr)
+    {
+        return CalculatePassStats(pass, capabilities, estimationOpts);
+    }
+    utils::Optional<PassStats> cached = passStatsCache->Find(pass);
+    if (cached.has_value())
+    {
+        return cached.value();
+    }
+    const PassStats result = CalculatePassStats(pass, capabilities, estimationOpts);
+    passStatsCache->Insert(pass, result);
     return result;
 }
 
 NetworkPerformanceData EstimateOpGraph(const OpGraph& opGraph,
                                        const HardwareCapabilities& capabilities,
-                                       const EstimationOptions& estimationOpts)
+                                       const EstimationOptions& estimationOpts,
+                                       PassStatsCache* passStatsCache)
+{
+    // No OpGraph can have a metric greater than this, so the estimation never stops early.
+    return EstimateOpGraph(opGraph, capabilities, estimationOpts, std::numeric_limits<uint64_t>::max(),
+                           passStatsCache)
+        .value();
+}
+
+utils::Optional<NetworkPerformanceData> EstimateOpGraph(const OpGraph& opGraph,
+                                                        const HardwareCapabilities& capabilities,
+                                                        const EstimationOptions& estimationOpts,
+                                                        uint64_t metricLimit,
+                                                        PassStatsCache* passStatsCache)
 {
     NetworkPerformanceData result;
+    uint64_t metric = 0;
 
     // In order to estimate performance using our existing estimation framework, we need to split up the graph into
     // a set of passes, and report stats for each pass independently.
@@ -266,8 +384,15 @@ NetworkPerformanceData EstimateOpGraph(const OpGraph& opGraph,
         if (IsObjectOfType<MceOp>(op) || IsObjectOfType<PleOp>(op))
         {
             PassPerformanceData passData;
-            passData.m_Stats = EstimatePassGrownFrom(opGraph, op, capabilities, estimationOpts, unestimatedOps);
+            passData.m_Stats =
+                EstimatePassGrownFrom(opGraph, op, capabilities, estimationOpts, unestimatedOps, passStatsCache);
             result.m_Stream.push_back(passData);
+
+            metric += GetPerformanceDataMetric(passData.m_Stats);
+            if (metric > metricLimit)
+            {
+                return {};
+            }
         }
     }
 
@@ -280,5 +405,39 @@ NetworkPerformanceData EstimateOpGraph(const OpGraph& opGraph,
     return result;
 }
 
+uint64_t EstimateWeightsDramTraffic(const OpGraph& opGraph, const HardwareCapabilities& capabilities)
+{
+    uint64_t result = 0;
+    for (Op* op : opGraph.GetOps())
+    {
+        MceOp* mceOp = GetObjectAs<MceOp>(op);
+        if (mceOp == nullptr || opGraph.GetInputs(mceOp).size() != 2)
+        {
+            continue;
+        }
+        Buffer* inputBuffer = opGraph.GetInputs(mceOp)[0];
+        Buffer* weightsSram = opGraph.GetInputs(mceOp)[1];
+        Op* dmaOp           = opGraph.GetProducer(weightsSram);
+        if (dmaOp == nullptr || opGraph.GetInputs(dmaOp).size() != 1)
+        {
+            continue;
+        }
+        Buffer* weightsDram = opGraph.GetInputs(dmaOp)[0];
+        if (weightsDram->m_EncodedWeightsSize == nullptr)
+        {
+            continue;
+        }
+
+        const TensorInfo weightsTensorInfo(weightsDram->m_TensorShape, DataType::UINT8_QUANTIZED,
+                                           GetWeightsFormat(*mceOp), weightsDram->m_QuantizationInfo);
+        const WeightsStats stats =
+            GetWeightsStats(capabilities, *weightsDram->m_EncodedWeightsSize, weightsTensorInfo,
+                            weightsSram->m_StripeShape, weightsSram->m_SizeInBytes, inputBuffer->m_TensorShape,
+                            inputBuffer->m_StripeShape);
+        result += stats.m_MemoryStats.m_DramParallel + stats.m_MemoryStats.m_DramNonParallel;
+    }
+    return result;
+}
+
 }    // namespace support_library
 }    // namespace ethosn
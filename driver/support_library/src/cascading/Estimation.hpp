@@ -5,9 +5,12 @@
 
 #pragma once
 
+#include "../include/ethosn_support_library/Optional.hpp"
 #include "../include/ethosn_support_library/Support.hpp"
 #include "Combiner.hpp"
 
+#include <mutex>
+#include <unordered_map>
 #include <unordered_set>
 
 namespace ethosn
@@ -15,15 +18,72 @@ namespace ethosn
 namespace support_library
 {
 
+/// Caches the stats of the passes estimated by EstimateOpGraph, so that a pass which is the same in several OpGraphs
+/// (e.g. those of combinations which only differ in other Parts) is only estimated once.
+/// Passes are identified by the Ops and Buffers they are estimated from, so a cache must only be used with the same
+/// hardware capabilities and estimation options, and must be cleared before any of those Ops and Buffers are
+/// destroyed or changed. A cache is safe to use from multiple threads at once.
+class PassStatsCache
+{
+public:
+    /// Everything which the stats of a pass are calculated from.
+    struct Key
+    {
+        MceOp* m_MceOp        = nullptr;
+        PleOp* m_PleOp        = nullptr;
+        Buffer* m_WeightsSram = nullptr;
+        Buffer* m_WeightsDram = nullptr;
+        std::vector<Buffer*> m_PleInputs;
+        /// The inputs of the pass (other than the weights), and where each is DMA'd from (or Sram if it isn't).
+        std::vector<std::pair<Buffer*, Location>> m_Inputs;
+        Buffer* m_Output = nullptr;
+        /// Where the output is DMA'd to (or Sram if it isn't), and in which format.
+        Location m_OutputLocation         = Location::Sram;
+        CompilerDataFormat m_OutputFormat = CompilerDataFormat::NONE;
+
+        bool operator==(const Key& rhs) const;
+    };
+
+    utils::Optional<PassStats> Find(const Key& key);
+    void Insert(const Key& key, const PassStats& stats);
+    void Clear();
+
+private:
+    struct KeyHasher
+    {
+        size_t operator()(const Key& k) const;
+    };
+
+    std::mutex m_Mutex;
+    std::unordered_map<Key, PassStats, KeyHasher> m_Entries;
+};
+
+/// If a PassStatsCache is given, the stats of the pass are taken from it if it has been estimated before, and are
+/// added to it otherwise.
 PassStats EstimatePassGrownFrom(const OpGraph& opGraph,
                                 Op* op,
                                 const HardwareCapabilities& capabilities,
                                 const EstimationOptions& estimationOpts,
-                                std::unordered_set<Op*>& unestimatedOps);
+                                std::unordered_set<Op*>& unestimatedOps,
+                                PassStatsCache* passStatsCache = nullptr);
 
 NetworkPerformanceData EstimateOpGraph(const OpGraph& opGraph,
                                        const HardwareCapabilities& capabilities,
-                                       const EstimationOptions& estimationOpts);
+                                       const EstimationOptions& estimationOpts,
+                                       PassStatsCache* passStatsCache = nullptr);
+
+/// As EstimateOpGraph, but stops as soon as the metric (see utils::GetMetric) of the passes estimated so far is greater
+/// than metricLimit, in which case nothing is returned. As the metric of each pass can't be negative, this means that
+/// the OpGraph is known to perform worse than one whose metric is metricLimit.
+utils::Optional<NetworkPerformanceData> EstimateOpGraph(const OpGraph& opGraph,
+                                                        const HardwareCapabilities& capabilities,
+                                                        const EstimationOptions& estimationOpts,
+                                                        uint64_t metricLimit,
+                                                        PassStatsCache* passStatsCache = nullptr);
+
+/// Returns the number of bytes of weights which are loaded from DRAM by all the MceOps in the given OpGraph,
+/// calculated in the same way as by EstimateOpGraph. MceOps whose weights are not DMA'd from DRAM are ignored.
+uint64_t EstimateWeightsDramTraffic(const OpGraph& opGraph, const HardwareCapabilities& capabilities);
 
 }    // namespace support_library
 }    // namespace ethosn
@@ -5,8 +5,6 @@
 
 #include "MceEstimationUtils.hpp"
 
-#include <random>
-
 namespace ethosn
 {
 namespace support_library
@@ -147,23 +145,13 @@ MceStats GetMceStats(const HardwareCapabilities& caps,
     return data;
 }
 
-std::vector<uint8_t> GenerateCompressibleData(size_t numElements, float spaceSavingProportion, int32_t zeroPoint)
+utils::Optional<float> GetWeightCompressionSaving(const EstimationOptions& estimationOptions)
 {
-    std::vector<uint8_t> dummyWeightData(numElements);
-    std::mt19937 gen;
-    std::uniform_int_distribution<> uniformDistribution(0, 255);
-    generate(dummyWeightData.begin(), dummyWeightData.end(),
-             [&]() -> uint8_t { return static_cast<uint8_t>(uniformDistribution(gen)); });
-
-    // Generate zero data with the weight ratio provided
-    std::bernoulli_distribution bernoulliDistribution(1.0f - spaceSavingProportion);
-    std::vector<uint8_t> zeroData(numElements);
-    generate(zeroData.begin(), zeroData.end(), [&]() -> uint8_t { return bernoulliDistribution(gen); });
-
-    // Take into account the zero point in the quantization info.
-    auto QuantizeIfZero = [zeroPoint](uint8_t a, uint8_t b) { return a == 0 ? static_cast<uint8_t>(zeroPoint) : b; };
-    std::transform(zeroData.begin(), zeroData.end(), dummyWeightData.begin(), dummyWeightData.begin(), QuantizeIfZero);
-    return dummyWeightData;
+    if (estimationOptions.m_UseWeightCompressionOverride)
+    {
+        return estimationOptions.m_WeightCompressionSaving;
+    }
+    return utils::EmptyOptional();
 }
 
 uint32_t GetWeightsNumReloads(const HardwareCapabilities& caps,
@@ -187,7 +175,7 @@ uint32_t GetWeightsNumReloads(const HardwareCapabilities& caps,
 }
 
 WeightsStats GetWeightsStats(const HardwareCapabilities& caps,
-                             EncodedWeights& encodedWeights,
+                             const EncodedWeightsSize& encodedWeights,
                              const TensorInfo& info,
                              const TensorShape& stripeShape,
                              const uint32_t tileSize,
@@ -212,19 +200,18 @@ WeightsStats GetWeightsStats(const HardwareCapabilities& caps,
         // to get the amount of data.
         data.m_MemoryStats.m_DramNonParallel = encodedWeights.m_Metadata[0].m_Size;
         data.m_MemoryStats.m_DramParallel =
-            (data.m_StripesStats.m_NumReloads + 1U) * static_cast<uint32_t>(encodedWeights.m_Data.size()) -
-            data.m_MemoryStats.m_DramNonParallel;
+            (data.m_StripesStats.m_NumReloads + 1U) * encodedWeights.m_TotalSize - data.m_MemoryStats.m_DramNonParallel;
     }
     else
     {
         data.m_MemoryStats.m_DramNonParallel =
-            (data.m_StripesStats.m_NumReloads + 1U) * static_cast<uint32_t>(encodedWeights.m_Data.size());
+            (data.m_StripesStats.m_NumReloads + 1U) * encodedWeights.m_TotalSize;
     }
     // Clamp the savings to 0
     // if the weights are uncompressable then the encoded weight size is larger than the weights provided
     // because of the header
     data.m_WeightCompressionSavings =
-        std::max(0.0f, 1.0f - (static_cast<float>(encodedWeights.m_Data.size()) /
+        std::max(0.0f, 1.0f - (static_cast<float>(encodedWeights.m_TotalSize) /
                                static_cast<float>(utils::GetNumElements(info.m_Dimensions))));
 
     return data;
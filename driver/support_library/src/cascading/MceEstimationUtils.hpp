@@ -23,14 +23,16 @@ MceStats GetMceStats(const HardwareCapabilities& caps,
                      const TensorShape& weightsShape);
 
 WeightsStats GetWeightsStats(const HardwareCapabilities& caps,
-                             EncodedWeights& encodedWeights,
+                             const EncodedWeightsSize& encodedWeights,
                              const TensorInfo& info,
                              const TensorShape& stripeShape,
                              const uint32_t tileSize,
                              const TensorShape& inShape,
                              const TensorShape& inStripeShape);
 
-std::vector<uint8_t> GenerateCompressibleData(size_t numElements, float spaceSavingProportion, int32_t zeroPoint);
+/// Gets the proportion of space that the weights should be assumed to save when they are compressed, if the estimation
+/// options override the compression of the weights. Otherwise the weights themselves are used to find their size.
+utils::Optional<float> GetWeightCompressionSaving(const EstimationOptions& estimationOptions);
 
 }    //namespace support_library
 }    //namespace ethosn
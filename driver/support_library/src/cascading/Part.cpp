@@ -6,12 +6,15 @@
 #include "Part.hpp"
 
 #include "../Graph.hpp"
+#include "Estimation.hpp"
 #include "GraphNodes.hpp"
+#include "MceEstimationUtils.hpp"
 #include "Plan.hpp"
 #include "Utils.hpp"
 #include "WeightEncoder.hpp"
+#include "WeightEncoderCache.hpp"
 
-#include <unordered_map>
+#include <algorithm>
 
 using namespace std;
 
@@ -20,84 +23,31 @@ namespace ethosn
 namespace support_library
 {
 
-class WeightEncoderCache
+/// Calculates the size of the encoded weights for the Plans of a Part, using the shared WeightEncoderCache so that
+/// weights which have already been encoded (e.g. for another Plan, Part or compilation) are not encoded again.
+class WeightsSizeCalculator
 {
 public:
-    WeightEncoderCache(const HardwareCapabilities& caps)
-        : m_Encoder(WeightEncoder::CreateWeightEncoder(caps))
+    WeightsSizeCalculator(const HardwareCapabilities& caps,
+                          const EstimationOptions& estimationOptions,
+                          ThreadPool& threadPool,
+                          WeightEncoderCache& cache)
+        : m_Capabilities(caps)
+        , m_CompressionSaving(GetWeightCompressionSaving(estimationOptions))
+        , m_ThreadPool(threadPool)
+        , m_Cache(cache)
     {}
 
-    struct Params
+    EncodedWeightsSize EstimateEncodedSize(const WeightEncoderCache::Params& params)
     {
-        TensorInfo weightsTensorInfo;
-        std::vector<uint8_t> weightsData;
-        TensorInfo biasTensorInfo;
-        std::vector<int32_t> biasData;
-        QuantizationInfo inputQuantizationInfo;
-        QuantizationInfo outputQuantizationInfo;
-        uint32_t stripeDepth;
-        uint32_t strideY;
-        uint32_t strideX;
-        uint32_t paddingTop;
-        uint32_t paddingLeft;
-        uint32_t iterationSize;
-        ethosn::command_stream::MceOperation operation;
-        CompilerMceAlgorithm algorithm;
-
-        bool operator==(const Params& r) const
-        {
-            return weightsTensorInfo == r.weightsTensorInfo && weightsData == r.weightsData &&
-                   biasTensorInfo == r.biasTensorInfo && biasData == r.biasData &&
-                   inputQuantizationInfo == r.inputQuantizationInfo &&
-                   outputQuantizationInfo == r.outputQuantizationInfo && stripeDepth == r.stripeDepth &&
-                   strideY == r.strideY && strideX == r.strideX && paddingTop == r.paddingTop &&
-                   paddingLeft == r.paddingLeft && iterationSize == r.iterationSize && operation == r.operation &&
-                   algorithm == r.algorithm;
-        }
-    };
-
-    EncodedWeights Encode(const Params& params)
-    {
-        auto it = m_Entries.find(params);
-        if (it == m_Entries.end())
-        {
-            EncodedWeights w =
-                m_Encoder->Encode(params.weightsTensorInfo, params.weightsData.data(), params.biasTensorInfo,
-                                  params.biasData.data(), params.inputQuantizationInfo, params.outputQuantizationInfo,
-                                  params.stripeDepth, params.strideY, params.strideX, params.paddingTop,
-                                  params.paddingLeft, params.iterationSize, params.operation, params.algorithm);
-            m_Entries[params] = w;
-            return w;
-        }
-        else
-        {
-            return it->second;
-        }
+        return m_Cache.EstimateEncodedSize(m_Capabilities, m_ThreadPool, params, m_CompressionSaving);
     }
 
 private:
-    struct Hasher
-    {
-        size_t operator()(const Params& p) const
-        {
-            // This hash function is deliberately very simple and therefore you might think would lead to lots of
-            // collisions. However, because we are only using it in the context of a single Part, the differences
-            // between each set of encoding params will be mostly (wholly?) in these fields that we are hashing,
-            // and not the exact weight values
-            size_t h = 17;
-            h        = h * 37 + std::hash<size_t>()(p.weightsData.size());
-            h        = h * 37 + std::hash<size_t>()(p.biasData.size());
-            h        = h * 37 + std::hash<uint32_t>()(p.stripeDepth);
-            h        = h * 37 + std::hash<uint32_t>()(p.iterationSize);
-            // Note we cast the enum to an integral type, as some compilers (e.g. aarch64-linux-gnu-g++ 5.3.1)
-            // don't support using the enum type directly, even though the spec indicates that they should.
-            h = h * 37 + std::hash<uint32_t>()(static_cast<uint32_t>(p.algorithm));
-            return h;
-        }
-    };
-
-    std::unique_ptr<WeightEncoder> m_Encoder;
-    std::unordered_map<Params, EncodedWeights, Hasher> m_Entries;
+    const HardwareCapabilities& m_Capabilities;
+    const utils::Optional<float> m_CompressionSaving;
+    ThreadPool& m_ThreadPool;
+    WeightEncoderCache& m_Cache;
 };
 
 bool Part::NumStripes::operator<(const NumStripes& rhs) const
@@ -291,6 +241,11 @@ size_t Part::GetNumPlans() const
     return m_Plans.size();
 }
 
+size_t Part::GetNumDominatedPlans() const
+{
+    return m_NumDominatedPlans;
+}
+
 std::vector<const Edge*> Part::GetInputs() const
 {
     assert(m_SubGraph.size());
@@ -433,7 +388,10 @@ const Parts& GraphOfParts::GetParts() const
     return m_Parts;
 }
 
-void Part::CreatePlans(const HardwareCapabilities& caps)
+void Part::CreatePlans(const HardwareCapabilities& caps,
+                       const EstimationOptions& estimationOptions,
+                       ThreadPool& threadPool,
+                       WeightEncoderCache& weightEncoderCache)
 {
     using DataFormats                      = std::list<CompilerDataFormat>;
     const DataFormats supportedDataFormats = { CompilerDataFormat::NHWC, CompilerDataFormat::NHWCB };
@@ -449,14 +407,130 @@ void Part::CreatePlans(const HardwareCapabilities& caps)
     }
     else
     {
-        WeightEncoderCache weightEncoderCache(caps);
-        GenerateWithTraversalOrders(node, caps, weightEncoderCache);
+        WeightsSizeCalculator weightsSizeCalculator(caps, estimationOptions, threadPool, weightEncoderCache);
+        GenerateWithTraversalOrders(node, caps, weightsSizeCalculator);
     }
 
     if (m_Plans.empty())
     {
         throw NotSupportedException("No plans generated for this part");
     }
+
+    RemoveDominatedPlans(caps);
+}
+
+namespace
+{
+
+/// The boundary buffers of a plan, ordered by what they are connected to rather than by the buffers themselves
+/// so that they can be compared with those of other plans of the same Part.
+template <typename Mapping>
+std::vector<std::pair<typename Mapping::mapped_type, const Buffer*>> GetBoundaryBuffers(const Mapping& mapping)
+{
+    std::vector<std::pair<typename Mapping::mapped_type, const Buffer*>> result;
+    for (auto&& m : mapping)
+    {
+        result.emplace_back(m.second, m.first);
+    }
+    std::stable_sort(result.begin(), result.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    return result;
+}
+
+template <typename T>
+bool AreBoundaryBuffersEqual(const std::vector<std::pair<T, const Buffer*>>& a,
+                             const std::vector<std::pair<T, const Buffer*>>& b)
+{
+    auto areEqual = [](const std::pair<T, const Buffer*>& x, const std::pair<T, const Buffer*>& y) {
+        const Buffer& bx = *x.second;
+        const Buffer& by = *y.second;
+        return x.first == y.first && bx.m_Lifetime == by.m_Lifetime && bx.m_Location == by.m_Location &&
+               bx.m_Format == by.m_Format && bx.m_QuantizationInfo == by.m_QuantizationInfo &&
+               bx.m_TensorShape == by.m_TensorShape && bx.m_StripeShape == by.m_StripeShape &&
+               bx.m_Order == by.m_Order && bx.m_SizeInBytes == by.m_SizeInBytes && bx.m_NumStripes == by.m_NumStripes;
+    };
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), areEqual);
+}
+
+/// The properties of a plan which the combiner and the performance estimate depend on.
+struct PlanCost
+{
+    std::vector<std::pair<Edge*, const Buffer*>> m_InputBuffers;
+    std::vector<std::pair<Node*, const Buffer*>> m_OutputBuffers;
+    /// As used by the combiner: the total size is allocated in SRAM for the plan, and all but the atomic buffers stay
+    /// allocated for the plans which are merged after it.
+    uint64_t m_TotSizeInBytes;
+    uint64_t m_TotNonAtomicSizeInBytes;
+    /// The DRAM traffic of loading the weights, which is the only part of the estimated DRAM traffic which depends
+    /// on more than the boundary buffers of the plan.
+    uint64_t m_WeightsDramBytes;
+};
+
+PlanCost GetPlanCost(const Plan& plan, const HardwareCapabilities& caps)
+{
+    PlanCost result;
+    result.m_InputBuffers         = GetBoundaryBuffers(plan.m_InputMappings);
+    result.m_OutputBuffers        = GetBoundaryBuffers(plan.m_OutputMappings);
+    result.m_TotSizeInBytes          = 0;
+    result.m_TotNonAtomicSizeInBytes = 0;
+    for (const Buffer* buffer : plan.m_OpGraph.GetBuffers())
+    {
+        result.m_TotSizeInBytes += buffer->m_SizeInBytes;
+        if (buffer->m_Lifetime != Lifetime::Atomic)
+        {
+            result.m_TotNonAtomicSizeInBytes += buffer->m_SizeInBytes;
+        }
+    }
+    result.m_WeightsDramBytes = EstimateWeightsDramTraffic(plan.m_OpGraph, caps);
+    return result;
+}
+
+/// Returns true if a plan with cost a is always at least as good as one with cost b, and better in some way.
+/// Plans which are equally good (e.g. differing only in block config) do not dominate each other, as the
+/// performance estimate can't yet tell them apart.
+bool Dominates(const PlanCost& a, const PlanCost& b)
+{
+    const bool noWorse = a.m_TotSizeInBytes <= b.m_TotSizeInBytes &&
+                         a.m_TotNonAtomicSizeInBytes <= b.m_TotNonAtomicSizeInBytes &&
+                         a.m_WeightsDramBytes <= b.m_WeightsDramBytes;
+    const bool better = a.m_TotSizeInBytes < b.m_TotSizeInBytes ||
+                        a.m_TotNonAtomicSizeInBytes < b.m_TotNonAtomicSizeInBytes ||
+                        a.m_WeightsDramBytes < b.m_WeightsDramBytes;
+    return noWorse && better && AreBoundaryBuffersEqual(a.m_InputBuffers, b.m_InputBuffers) &&
+           AreBoundaryBuffersEqual(a.m_OutputBuffers, b.m_OutputBuffers);
+}
+
+}    // namespace
+
+void Part::RemoveDominatedPlans(const HardwareCapabilities& caps)
+{
+    std::vector<PlanCost> costs;
+    costs.reserve(m_Plans.size());
+    for (auto&& plan : m_Plans)
+    {
+        costs.push_back(GetPlanCost(*plan, caps));
+    }
+
+    // Dominance is transitive, so a plan which is dominated by a removed plan is also dominated by a remaining one
+    // and only the remaining plans need to be checked against.
+    std::vector<bool> isDominated(m_Plans.size(), false);
+    for (size_t i = 0; i < m_Plans.size(); ++i)
+    {
+        for (size_t j = 0; j < m_Plans.size() && !isDominated[i]; ++j)
+        {
+            isDominated[i] = !isDominated[j] && Dominates(costs[j], costs[i]);
+        }
+    }
+
+    Plans remaining;
+    for (size_t i = 0; i < m_Plans.size(); ++i)
+    {
+        if (!isDominated[i])
+        {
+            remaining.push_back(std::move(m_Plans[i]));
+        }
+    }
+    m_NumDominatedPlans = m_Plans.size() - remaining.size();
+    m_Plans             = std::move(remaining);
 }
 
 void Part::AddNewPlan(Plan::InputMapping&& inputMappings, Plan::OutputMapping&& outputMappings, OwnedOpGraph&& opGraph)
@@ -567,9 +641,10 @@ void AddWeightBuffersAndDmaOpToMceOp(OwnedOpGraph& opGraph,
                                      const std::vector<uint8_t>& weightData,
                                      const TensorInfo& biasInfo,
                                      const std::vector<int32_t>& biasData,
+                                     const WeightEncoderCache::ContentHash& weightsAndBiasHash,
                                      Lifetime lifetime,
                                      TraversalOrder order,
-                                     WeightEncoderCache& weightEncoderCache)
+                                     WeightsSizeCalculator& weightsSizeCalculator)
 {
     const OpGraph::BufferList& buffers = opGraph.GetBuffers();
     const OpGraph::OpList& ops         = opGraph.GetOps();
@@ -603,7 +678,7 @@ void AddWeightBuffersAndDmaOpToMceOp(OwnedOpGraph& opGraph,
     opGraph.SetProducer(weightsBufferInSram, dmaOp);
     opGraph.AddConsumer(weightsBufferInSram, op, 1);
 
-    // Encode weights
+    // Calculate the size of the encoded weights
     const uint32_t weightStripeSize  = mceOp->m_WeightsStripeShape[2];
     const uint32_t weightStripeDepth = GetWeightStripeDepth(weightInfo, mceOp);
 
@@ -611,25 +686,28 @@ void AddWeightBuffersAndDmaOpToMceOp(OwnedOpGraph& opGraph,
     Buffer* mceInput  = opGraph.GetInputs(mceOp)[0];
 
     WeightEncoderCache::Params wp;
-    wp.weightsTensorInfo                  = weightInfo;
-    wp.weightsData                        = weightData;
-    wp.biasTensorInfo                     = biasInfo;
-    wp.biasData                           = biasData;
-    wp.inputQuantizationInfo              = mceInput->m_QuantizationInfo;
-    wp.outputQuantizationInfo             = mceOutput->m_QuantizationInfo;
-    wp.stripeDepth                        = weightStripeDepth;
-    wp.strideY                            = mceOp->m_Stride.m_Y;
-    wp.strideX                            = mceOp->m_Stride.m_X;
-    wp.paddingTop                         = mceOp->m_PadTop;
-    wp.paddingLeft                        = mceOp->m_PadLeft;
-    wp.iterationSize                      = weightStripeSize;
-    wp.operation                          = mceOp->m_Op;
-    wp.algorithm                          = mceOp->m_Algo;
-    weightsBufferInDram->m_EncodedWeights = std::make_unique<EncodedWeights>(weightEncoderCache.Encode(wp));
-
-    // Use the encoded weights to determine the size of the sram and dram buffers
-    weightsBufferInDram->m_SizeInBytes = static_cast<uint32_t>(weightsBufferInDram->m_EncodedWeights->m_Data.size());
-    weightsBufferInSram->m_SizeInBytes = weightsBufferInDram->m_EncodedWeights->m_MaxSize * numWeightStripes;
+    wp.weightsAndBiasHash     = weightsAndBiasHash;
+    wp.weightsTensorInfo      = weightInfo;
+    wp.weightsData            = weightData.data();
+    wp.biasTensorInfo         = biasInfo;
+    wp.biasData               = biasData.data();
+    wp.inputQuantizationInfo  = mceInput->m_QuantizationInfo;
+    wp.outputQuantizationInfo = mceOutput->m_QuantizationInfo;
+    wp.stripeDepth            = weightStripeDepth;
+    wp.strideY                = mceOp->m_Stride.m_Y;
+    wp.strideX                = mceOp->m_Stride.m_X;
+    wp.paddingTop             = mceOp->m_PadTop;
+    wp.paddingLeft            = mceOp->m_PadLeft;
+    wp.iterationSize          = weightStripeSize;
+    wp.operation              = mceOp->m_Op;
+    wp.algorithm              = mceOp->m_Algo;
+
+    weightsBufferInDram->m_EncodedWeightsSize =
+        std::make_unique<EncodedWeightsSize>(weightsSizeCalculator.EstimateEncodedSize(wp));
+
+    // Use the encoded weights size to determine the size of the sram and dram buffers
+    weightsBufferInDram->m_SizeInBytes = weightsBufferInDram->m_EncodedWeightsSize->m_TotalSize;
+    weightsBufferInSram->m_SizeInBytes = weightsBufferInDram->m_EncodedWeightsSize->m_MaxSize * numWeightStripes;
 }
 
 Buffer* Part::AddIdentityMceOpForSubGraph(OwnedOpGraph& opGraph,
@@ -642,7 +720,7 @@ Buffer* Part::AddIdentityMceOpForSubGraph(OwnedOpGraph& opGraph,
                                           TensorShape outputStripe,
                                           NumStripesType numInputStripes,
                                           NumStripesType numWeightStripes,
-                                          WeightEncoderCache& weightEncoderCache)
+                                          WeightsSizeCalculator& weightsSizeCalculator)
 {
     const OpGraph::BufferList& buffers = opGraph.GetBuffers();
     const OpGraph::OpList& ops         = opGraph.GetOps();
@@ -658,6 +736,8 @@ Buffer* Part::AddIdentityMceOpForSubGraph(OwnedOpGraph& opGraph,
 
     std::vector<uint8_t> weightsData(1 * 1 * 1 * numIfm, 2);
     std::vector<int32_t> biasData(numIfm, 0);
+    const WeightEncoderCache::ContentHash weightsAndBiasHash =
+        WeightEncoderCache::HashWeightsAndBias(weightsData.data(), weightsData.size(), biasData.data(), biasData.size());
 
     // Add MceOp.
     opGraph.AddOp(std::make_unique<MceOp>(Lifetime::Atomic, MceOperation::DEPTHWISE_CONVOLUTION,
@@ -678,7 +758,7 @@ Buffer* Part::AddIdentityMceOpForSubGraph(OwnedOpGraph& opGraph,
 
     // Add Weight buffers and DmaOp.
     AddWeightBuffersAndDmaOpToMceOp(opGraph, inputStripe, outputStripe, numWeightStripes, weightInfo, weightsData,
-                                    biasInfo, biasData, lifetime, order, weightEncoderCache);
+                                    biasInfo, biasData, weightsAndBiasHash, lifetime, order, weightsSizeCalculator);
 
     // Set Input & Output buffer shapes and sizes.
     idMceOpOutBuff->m_TensorShape = inpShape;
@@ -702,7 +782,7 @@ void Part::CreatePlanWithIdentityMceOp(FuseOnlyPleOperationNode* node,
                                        TensorShape inputStripe,
                                        TensorShape outputStripe,
                                        NumStripesType numOutputStripes,
-                                       WeightEncoderCache& weightEncoderCache)
+                                       WeightsSizeCalculator& weightsSizeCalculator)
 {
     // By definition MceOp are single input single output
     assert(node->GetInputs().size() == 1);
@@ -733,9 +813,9 @@ void Part::CreatePlanWithIdentityMceOp(FuseOnlyPleOperationNode* node,
             Plan::InputMapping inputMappings;
             Plan::OutputMapping outputMappings;
             // Add Identity MCeOp.
-            auto mceOpOutputBuffer = AddIdentityMceOpForSubGraph(opGraph, inputShape, inputNode->GetQuantizationInfo(),
-                                                                 lifetime, caps, order, mceInputStripe, mceInputStripe,
-                                                                 numInputStripes, numWeightStripes, weightEncoderCache);
+            auto mceOpOutputBuffer = AddIdentityMceOpForSubGraph(
+                opGraph, inputShape, inputNode->GetQuantizationInfo(), lifetime, caps, order, mceInputStripe,
+                mceInputStripe, numInputStripes, numWeightStripes, weightsSizeCalculator);
             // Add PleOp
             opGraph.AddOp(CreateOpFromNode(node));
             Op* op                             = opGraph.GetOps().back();
@@ -775,7 +855,7 @@ void Part::CreatePlanWithIdentityPleOp(Node* node,
                                        NumStripesType numWeightStripes,
                                        Location inputBufferLocation,
                                        Location outputBufferLocation,
-                                       WeightEncoderCache& weightEncoderCache)
+                                       WeightsSizeCalculator& weightsSizeCalculator)
 {
     assert(node->GetInputs().size() > 0);
 
@@ -801,8 +881,8 @@ void Part::CreatePlanWithIdentityPleOp(Node* node,
         MceOperationNode* mceNode = GetObjectAs<MceOperationNode>(node);
         AddWeightBuffersAndDmaOpToMceOp(opGraph, mceInputBuff->m_StripeShape, mceOutputBuff->m_StripeShape,
                                         numWeightStripes, mceNode->GetWeightsInfo(), mceNode->GetWeightsData(),
-                                        mceNode->GetBiasInfo(), mceNode->GetBiasData(), lifetime, order,
-                                        weightEncoderCache);
+                                        mceNode->GetBiasInfo(), mceNode->GetBiasData(),
+                                        mceNode->GetWeightsAndBiasHash(), lifetime, order, weightsSizeCalculator);
 
         // Add Passthrough PleOp.node
         opGraph.AddOp(std::make_unique<PleOp>(Lifetime::Atomic, PleOperation::PASSTHROUGH, BlockConfig{ 1U, 1U }, 1,
@@ -908,7 +988,7 @@ void Part::CreatePlanForNode(Node* node,
                              NumStripesType numWeightStripes,
                              Location inputBufferLocaton,
                              Location outputBufferLocation,
-                             WeightEncoderCache& weightEncoderCache)
+                             WeightsSizeCalculator& weightsSizeCalculator)
 {
     assert(node->GetInputs().size() > 0);
 
@@ -948,8 +1028,9 @@ void Part::CreatePlanForNode(Node* node,
                 Buffer* inBuffer = pair.first;
                 AddWeightBuffersAndDmaOpToMceOp(opGraph, inBuffer->m_StripeShape, outBuffer->m_StripeShape,
                                                 numWeightStripes, mceNode->GetWeightsInfo(), mceNode->GetWeightsData(),
-                                                mceNode->GetBiasInfo(), mceNode->GetBiasData(), lifetime, order,
-                                                weightEncoderCache);
+                                                mceNode->GetBiasInfo(), mceNode->GetBiasData(),
+                                                mceNode->GetWeightsAndBiasHash(), lifetime, order,
+                                                weightsSizeCalculator);
             }
         }
     }
@@ -967,7 +1048,7 @@ void Part::CreatePlanForNode(Node* node,
     {
         // Add another plan with IdMceOp.
         CreatePlanWithIdentityMceOp(GetObjectAs<FuseOnlyPleOperationNode>(node), lifetime, caps, order, inputStripe,
-                                    outputStripe, numOutputStripes, weightEncoderCache);
+                                    outputStripe, numOutputStripes, weightsSizeCalculator);
     }
 
     // Check for only MceOperationNode exists in this part.
@@ -977,7 +1058,7 @@ void Part::CreatePlanForNode(Node* node,
         // Add another plan with IdMceOp
         CreatePlanWithIdentityPleOp(node, lifetime, caps, order, inputStripe, outputStripe, numInputStripes,
                                     numOutputStripes, numWeightStripes, inputBufferLocaton, outputBufferLocation,
-                                    weightEncoderCache);
+                                    weightsSizeCalculator);
     }
 }
 
@@ -1002,10 +1083,10 @@ std::vector<BlockConfig> GenerateBlockConfigs(Node* node)
 
 void Part::GenerateWithTraversalOrders(Node* node,
                                        const HardwareCapabilities& caps,
-                                       WeightEncoderCache& weightEncoderCache)
+                                       WeightsSizeCalculator& weightsSizeCalculator)
 {
     std::vector<BlockConfig> blockConfigs = GenerateBlockConfigs(node);
-    GenerateWithStripeSizes(node, caps, blockConfigs, TraversalOrder::Xyz, weightEncoderCache);
+    GenerateWithStripeSizes(node, caps, blockConfigs, TraversalOrder::Xyz, weightsSizeCalculator);
     // TODO: Add the same function call with traversal order ZXY
 
     auto inputStripe  = CreateStripe(node->GetInputShape(0), TensorShape{ 0, 0, 0, 0 }, caps);
@@ -1017,11 +1098,11 @@ void Part::GenerateWithTraversalOrders(Node* node,
         {
             case CompilerDataFormat::NHWCB:
                 CreatePlanForNode(node, Lifetime::Atomic, caps, TraversalOrder::Xyz, inputStripe, outputStripe, 1U, 1U,
-                                  0u, Location::VirtualSram, Location::Sram, weightEncoderCache);
+                                  0u, Location::VirtualSram, Location::Sram, weightsSizeCalculator);
                 break;
             case CompilerDataFormat::NHWC:
                 CreatePlanForNode(node, Lifetime::Atomic, caps, TraversalOrder::Xyz, inputStripe, outputStripe, 1U, 1U,
-                                  0u, Location::Sram, Location::VirtualSram, weightEncoderCache);
+                                  0u, Location::Sram, Location::VirtualSram, weightsSizeCalculator);
                 break;
             default:
                 throw NotSupportedException(
@@ -1031,9 +1112,9 @@ void Part::GenerateWithTraversalOrders(Node* node,
     else if (IsObjectOfType<ReinterpretNode>(node))
     {
         CreatePlanForNode(node, Lifetime::Atomic, caps, TraversalOrder::Xyz, { 0, 0, 0, 0 }, { 0, 0, 0, 0 }, 0U, 0U, 0u,
-                          Location::Dram, Location::Dram, weightEncoderCache);
+                          Location::Dram, Location::Dram, weightsSizeCalculator);
         CreatePlanForNode(node, Lifetime::Atomic, caps, TraversalOrder::Xyz, inputStripe, outputStripe, 1U, 1U, 0u,
-                          Location::VirtualSram, Location::VirtualSram, weightEncoderCache);
+                          Location::VirtualSram, Location::VirtualSram, weightsSizeCalculator);
     }
 }
 
@@ -1235,7 +1316,7 @@ void Part::GenerateWithStripeSizes(Node* node,
                                    const HardwareCapabilities& caps,
                                    const std::vector<BlockConfig>& blockConfigs,
                                    TraversalOrder order,
-                                   WeightEncoderCache& weightEncoderCache)
+                                   WeightsSizeCalculator& weightsSizeCalculator)
 {
     std::set<Part::StripeInfos> stripeInfos;
     for (auto blockConfig : blockConfigs)
@@ -1244,24 +1325,24 @@ void Part::GenerateWithStripeSizes(Node* node,
         stripeInfos.insert(mceStripes.begin(), mceStripes.end());
     }
 
-    GenerateWithNumStripes(node, caps, order, stripeInfos, weightEncoderCache);
+    GenerateWithNumStripes(node, caps, order, stripeInfos, weightsSizeCalculator);
 }
 
 void Part::GenerateWithNumStripes(Node* node,
                                   const HardwareCapabilities& caps,
                                   TraversalOrder order,
                                   const std::set<Part::StripeInfos>& stripeInfos,
-                                  WeightEncoderCache& weightEncoderCache)
+                                  WeightsSizeCalculator& weightsSizeCalculator)
 {
     if (IsObjectOfType<MceOperationNode>(node))
     {
         GenerateWithNumStripesForLocation(node, caps, order, stripeInfos, Location::Sram, Location::PleInputSram,
-                                          weightEncoderCache);
+                                          weightsSizeCalculator);
     }
     else if (IsObjectOfType<FuseOnlyPleOperationNode>(node))
     {
         GenerateWithNumStripesForLocation(node, caps, order, stripeInfos, Location::PleInputSram, Location::Sram,
-                                          weightEncoderCache);
+                                          weightsSizeCalculator);
     }
     else if (IsObjectOfType<FormatConversionNode>(node))
     {
@@ -1270,11 +1351,11 @@ void Part::GenerateWithNumStripes(Node* node,
         {
             case CompilerDataFormat::NHWC:
                 GenerateWithNumStripesForLocation(node, caps, order, stripeInfos, Location::Sram, Location::Dram,
-                                                  weightEncoderCache);
+                                                  weightsSizeCalculator);
                 break;
             case CompilerDataFormat::NHWCB:
                 GenerateWithNumStripesForLocation(node, caps, order, stripeInfos, Location::Dram, Location::Sram,
-                                                  weightEncoderCache);
+                                                  weightsSizeCalculator);
                 break;
             default:
                 break;
@@ -1288,7 +1369,7 @@ void Part::GenerateWithNumStripesForLocation(Node* node,
                                              const std::set<Part::StripeInfos>& stripeInfos,
                                              Location inputBufferLocaton,
                                              Location outputBufferLocation,
-                                             WeightEncoderCache& weightEncoderCache)
+                                             WeightsSizeCalculator& weightsSizeCalculator)
 {
     for (Part::StripeInfos stripeInfosI : stripeInfos)
     {
@@ -1316,7 +1397,8 @@ void Part::GenerateWithNumStripesForLocation(Node* node,
                 {
                     CreatePlanForNode(node, Lifetime::Atomic, caps, order, stripeInfosI.m_InputStripeShape,
                                       stripeInfosI.m_OutputStripeShape, numInputStripes, numOutputStripes,
-                                      numWeightStripes, inputBufferLocaton, outputBufferLocation, weightEncoderCache);
+                                      numWeightStripes, inputBufferLocaton, outputBufferLocation,
+                                      weightsSizeCalculator);
                 }
             }
         }
@@ -34,7 +34,9 @@ bool IsObjectOfType(const B* obj)
 using Plans          = std::vector<std::unique_ptr<Plan>>;
 using StripeSizeType = TensorShape::value_type;
 
+class ThreadPool;
 class WeightEncoderCache;
+class WeightsSizeCalculator;
 
 class Part : public DebuggableObject
 {
@@ -67,9 +69,19 @@ public:
         : DebuggableObject("Part")
     {}
 
-    void CreatePlans(const HardwareCapabilities& caps);
+    void CreatePlans(const HardwareCapabilities& caps,
+                     const EstimationOptions& estimationOptions,
+                     ThreadPool& threadPool,
+                     WeightEncoderCache& weightEncoderCache);
     const Plan& GetPlan(const PlanId id) const;
     size_t GetNumPlans() const;
+    /// The number of plans which were created but then removed by CreatePlans because another plan of this Part
+    /// was at least as good in every way that matters to the combiner.
+    size_t GetNumDominatedPlans() const;
+    /// Removes every plan which has the same boundary buffers as another plan but uses more SRAM and/or causes more
+    /// DRAM traffic (and no less of either), as combinations using it can never be better. The remaining plans keep
+    /// their relative order. This is called by CreatePlans.
+    void RemoveDominatedPlans(const HardwareCapabilities& caps);
     std::vector<const Edge*> GetInputs() const;
     std::vector<const Edge*> GetOutputs() const;
 
@@ -94,27 +106,27 @@ private:
                            NumStripesType numWeightStripes,
                            Location inputBufferLocaton,
                            Location outputBufferLocation,
-                           WeightEncoderCache& weightEncoderCache);
+                           WeightsSizeCalculator& weightsSizeCalculator);
     void GenerateWithTraversalOrders(Node* node,
                                      const HardwareCapabilities& caps,
-                                     WeightEncoderCache& weightEncoderCache);
+                                     WeightsSizeCalculator& weightsSizeCalculator);
     void GenerateWithStripeSizes(Node* node,
                                  const HardwareCapabilities& caps,
                                  const std::vector<BlockConfig>& blockConfigs,
                                  TraversalOrder order,
-                                 WeightEncoderCache& weightEncoderCache);
+                                 WeightsSizeCalculator& weightsSizeCalculator);
     void GenerateWithNumStripes(Node* node,
                                 const HardwareCapabilities& caps,
                                 TraversalOrder order,
                                 const std::set<StripeInfos>& stripeInfo,
-                                WeightEncoderCache& weightEncoderCache);
+                                WeightsSizeCalculator& weightsSizeCalculator);
     void GenerateWithNumStripesForLocation(Node* node,
                                            const HardwareCapabilities& caps,
                                            TraversalOrder order,
                                            const std::set<StripeInfos>& stripeInfos,
                                            Location inputBufferLocaton,
                                            Location outputBufferLocation,
-                                           WeightEncoderCache& weightEncoderCache);
+                                           WeightsSizeCalculator& weightsSizeCalculator);
 
     Buffer* AddIdentityMceOpForSubGraph(OwnedOpGraph& opGraph,
                                         const TensorShape& inputShape,
@@ -126,7 +138,7 @@ private:
                                         TensorShape outputStripe,
                                         NumStripesType numInputStripes,
                                         NumStripesType numWeightStripes,
-                                        WeightEncoderCache& weightEncoderCache);
+                                        WeightsSizeCalculator& weightsSizeCalculator);
 
     void CreatePlanWithIdentityMceOp(FuseOnlyPleOperationNode* node,
                                      Lifetime lifetime,
@@ -135,7 +147,7 @@ private:
                                      TensorShape inputStripe,
                                      TensorShape outputStripe,
                                      NumStripesType numOutputStripes,
-                                     WeightEncoderCache& weightEncoderCache);
+                                     WeightsSizeCalculator& weightsSizeCalculator);
 
     void AddOpToOpGraphWithInputOutputBuffers(OwnedOpGraph& opGraph,
                                               Node* node,
@@ -162,7 +174,9 @@ private:
                                      NumStripesType numWeightStripes,
                                      Location inputBufferLocaton,
                                      Location outputBufferLocation,
-                                     WeightEncoderCache& weightEncoderCache);
+                                     WeightsSizeCalculator& weightsSizeCalculator);
+
+    size_t m_NumDominatedPlans = 0;
 };
 
 using Parts = std::vector<std::unique_ptr<Part>>;
@@ -24,120 +24,141 @@ const OpGraph::BufferList& OpGraph::GetBuffers() const
 
 bool OpGraph::Contains(Op* op) const
 {
-    return std::find(m_Ops.begin(), m_Ops.end(), op) != m_Ops.end();
+    return m_OpIdxs.find(op) != m_OpIdxs.end();
 }
 
 bool OpGraph::Contains(Buffer* buffer) const
 {
-    return std::find(m_Buffers.begin(), m_Buffers.end(), buffer) != m_Buffers.end();
+    return m_BufferIdxs.find(buffer) != m_BufferIdxs.end();
+}
+
+size_t OpGraph::GetOpIdx(Op* op) const
+{
+    auto it = m_OpIdxs.find(op);
+    return it != m_OpIdxs.end() ? it->second : static_cast<size_t>(-1);
+}
+
+size_t OpGraph::GetBufferIdx(Buffer* buffer) const
+{
+    auto it = m_BufferIdxs.find(buffer);
+    return it != m_BufferIdxs.end() ? it->second : static_cast<size_t>(-1);
 }
 
 ethosn::support_library::Op* OpGraph::GetProducer(Buffer* buffer) const
 {
-    auto it = m_BufferProducers.find(buffer);
-    return it != m_BufferProducers.end() ? it->second : nullptr;
+    const size_t idx = GetBufferIdx(buffer);
+    return idx < m_BufferProducers.size() ? m_BufferProducers[idx] : nullptr;
 }
 
-OpGraph::ConsumersList OpGraph::GetConsumers(Buffer* buffer) const
+const OpGraph::ConsumersList& OpGraph::GetConsumers(Buffer* buffer) const
 {
-    auto it = m_BufferConsumers.find(buffer);
-    return it != m_BufferConsumers.end() ? it->second : OpGraph::ConsumersList{};
+    static const ConsumersList empty;
+    const size_t idx = GetBufferIdx(buffer);
+    return idx < m_BufferConsumers.size() ? m_BufferConsumers[idx] : empty;
 }
 
-OpGraph::BufferList OpGraph::GetInputs(Op* op) const
+const OpGraph::BufferList& OpGraph::GetInputs(Op* op) const
 {
-    auto it = m_OpInputs.find(op);
-    return it != m_OpInputs.end() ? it->second : OpGraph::BufferList{};
+    static const BufferList empty;
+    const size_t idx = GetOpIdx(op);
+    return idx < m_OpInputs.size() ? m_OpInputs[idx] : empty;
 }
 
 Buffer* OpGraph::GetOutput(Op* op) const
 {
-    auto it = m_OpOutputs.find(op);
-    return it != m_OpOutputs.end() ? it->second : nullptr;
+    const size_t idx = GetOpIdx(op);
+    return idx < m_OpOutputs.size() ? m_OpOutputs[idx] : nullptr;
 }
 
 void OpGraph::AddOp(Op* op)
 {
-    if (std::find(m_Ops.begin(), m_Ops.end(), op) != m_Ops.end())
+    if (!m_OpIdxs.emplace(op, m_Ops.size()).second)
     {
         throw std::runtime_error("Cannot add the same Op twice");
     }
     m_Ops.push_back(op);
+    m_OpOutputs.push_back(nullptr);
+    m_OpInputs.emplace_back();
 }
 
 void OpGraph::AddBuffer(Buffer* buffer)
 {
-    if (std::find(m_Buffers.begin(), m_Buffers.end(), buffer) != m_Buffers.end())
+    if (!m_BufferIdxs.emplace(buffer, m_Buffers.size()).second)
     {
         throw std::runtime_error("Cannot add the same Buffer twice");
     }
     m_Buffers.push_back(buffer);
+    m_BufferProducers.push_back(nullptr);
+    m_BufferConsumers.emplace_back();
 }
 
 void OpGraph::SetProducer(Buffer* buffer, Op* producerOp)
 {
-    if (!Contains(buffer))
+    const size_t bufferIdx = GetBufferIdx(buffer);
+    if (bufferIdx >= m_Buffers.size())
     {
         throw std::runtime_error("buffer is not part of this graph (or is nullptr)");
     }
-    if (!Contains(producerOp))
+    const size_t producerIdx = GetOpIdx(producerOp);
+    if (producerIdx >= m_Ops.size())
     {
         throw std::runtime_error("producerOp is not part of this graph (or is nullptr)");
     }
-    auto it = m_BufferProducers.find(buffer);
-    if (it != m_BufferProducers.end() && it->second != nullptr)
+    if (m_BufferProducers[bufferIdx] != nullptr)
     {
         throw std::runtime_error("Buffer is already produced by an Op. It must be disconnected first.");
     }
-    m_BufferProducers[buffer] = producerOp;
-    m_OpOutputs[producerOp]   = buffer;
+    m_BufferProducers[bufferIdx] = producerOp;
+    m_OpOutputs[producerIdx]     = buffer;
 }
 
 void OpGraph::ClearProducer(Buffer* buffer)
 {
-    if (!Contains(buffer))
+    const size_t bufferIdx = GetBufferIdx(buffer);
+    if (bufferIdx >= m_Buffers.size())
     {
         throw std::runtime_error("buffer is not part of this graph (or is nullptr)");
     }
-    auto oldProducerIt = m_BufferProducers.find(buffer);
-    if (oldProducerIt != m_BufferProducers.end())
+    Op* oldProducer = m_BufferProducers[bufferIdx];
+    if (oldProducer != nullptr)
     {
-        m_OpOutputs.erase(oldProducerIt->second);
+        m_OpOutputs[GetOpIdx(oldProducer)] = nullptr;
     }
-    m_BufferProducers.erase(buffer);
+    m_BufferProducers[bufferIdx] = nullptr;
 }
 
 void OpGraph::AddConsumer(Buffer* buffer, Op* consumerOp, uint32_t opInputIdx)
 {
-    if (!Contains(buffer))
+    const size_t bufferIdx = GetBufferIdx(buffer);
+    if (bufferIdx >= m_Buffers.size())
     {
         throw std::runtime_error("buffer is not part of this graph (or is nullptr)");
     }
-    if (!Contains(consumerOp))
+    const size_t consumerIdx = GetOpIdx(consumerOp);
+    if (consumerIdx >= m_Ops.size())
     {
         throw std::runtime_error("consumerOp is not part of this graph (or is nullptr)");
     }
-    auto it = m_OpInputs.find(consumerOp);
-    if (it != m_OpInputs.end() && opInputIdx < it->second.size() && it->second[opInputIdx] != nullptr)
+    BufferList& inputs = m_OpInputs[consumerIdx];
+    if (opInputIdx < inputs.size() && inputs[opInputIdx] != nullptr)
     {
         throw std::runtime_error(
             "consumerOp is already consuming a buffer at opInputIdx. It must be disconnected first.");
     }
-    m_BufferConsumers[buffer].push_back({ consumerOp, opInputIdx });
-    auto& inputs = m_OpInputs[consumerOp];
-    if (opInputIdx < inputs.size())
+    if (opInputIdx > inputs.size())
     {
-        inputs[opInputIdx] = buffer;
+        // Prevent leaving 'dangling' inputs - they must be connected properly first.
+        // This means other code can be sure that input buffers are not set to null and so don't need to check.
+        throw std::runtime_error("Cannot connect to this input index without connecting earlier inputs first.");
     }
-    else if (opInputIdx == inputs.size())
+    m_BufferConsumers[bufferIdx].push_back({ consumerOp, opInputIdx });
+    if (opInputIdx < inputs.size())
     {
-        inputs.push_back(buffer);
+        inputs[opInputIdx] = buffer;
     }
     else
     {
-        // Prevent leaving 'dangling' inputs - they must be connected properly first.
-        // This means other code can be sure that input buffers are not set to null and so don't need to check.
-        throw std::runtime_error("Cannot connect to this input index without connecting earlier inputs first.");
+        inputs.push_back(buffer);
     }
 }
 
@@ -198,16 +219,16 @@ Buffer* OwnedOpGraph::AddBuffer(std::unique_ptr<Buffer> buffer)
     return raw;
 }
 
-int DebuggableObject::ms_IdCounter = 0;
+std::atomic<int> DebuggableObject::ms_IdCounter(0);
 
 DebuggableObject::DebuggableObject(const char* defaultTagPrefix)
 {
     // Generate an arbitrary and unique (but deterministic) default debug tag for this object.
     // This means that if no-one sets anything more useful, we still have a way to identify it.
-    m_DebugTag = std::string(defaultTagPrefix) + " " + std::to_string(ms_IdCounter);
+    // Note that objects created concurrently on different threads are numbered in no particular order.
     //m_DebugId is very useful for conditional breakpoints
-    m_DebugId = ms_IdCounter;
-    ++ms_IdCounter;
+    m_DebugId  = ms_IdCounter++;
+    m_DebugTag = std::string(defaultTagPrefix) + " " + std::to_string(m_DebugId);
 }
 
 Op::Op(const char* defaultTagPrefix)
@@ -11,6 +11,7 @@
 
 #include <ethosn_command_stream/CommandStream.hpp>
 
+#include <atomic>
 #include <map>
 #include <unordered_map>
 
@@ -86,9 +87,13 @@ public:
     bool Contains(Op* op) const;
     bool Contains(Buffer* buffer) const;
 
+    /// GetConsumers and GetInputs return references into the graph (or to an empty list if the Op or Buffer is not
+    /// part of the graph). These references are invalidated by any change to the graph (AddOp, AddBuffer,
+    /// SetProducer, ClearProducer or AddConsumer), so must not be held while changing it, for example while
+    /// iterating over the consumers of a Buffer to connect them to something else in the same graph.
     Op* GetProducer(Buffer* buffer) const;
-    ConsumersList GetConsumers(Buffer* buffer) const;
-    BufferList GetInputs(Op* op) const;
+    const ConsumersList& GetConsumers(Buffer* buffer) const;
+    const BufferList& GetInputs(Op* op) const;
     Buffer* GetOutput(Op* op) const;
     /// @}
 
@@ -104,19 +109,28 @@ public:
     /// @}
 
 private:
-    /// All of the Ops in the graph, in no particular order.
+    /// Gets the index of the given Op or Buffer in m_Ops or m_Buffers, or -1 if it is not part of the graph.
+    size_t GetOpIdx(Op* op) const;
+    size_t GetBufferIdx(Buffer* buffer) const;
+
+    /// All of the Ops in the graph, in the order they were added.
     OpList m_Ops;
-    /// All of the Buffers in the graph, in no particular order.
+    /// All of the Buffers in the graph, in the order they were added.
     BufferList m_Buffers;
 
+    /// The index of each Op and Buffer in m_Ops and m_Buffers, which the connections below are indexed by.
+    /// Ops and Buffers are never removed from a graph, so these don't change.
+    std::unordered_map<Op*, size_t> m_OpIdxs;
+    std::unordered_map<Buffer*, size_t> m_BufferIdxs;
+
     /// For each Buffer in the graph, which Op produces it (if any).
-    std::unordered_map<Buffer*, Op*> m_BufferProducers;
+    std::vector<Op*> m_BufferProducers;
     /// For each Buffer in the graph, which Ops (and which input index of those Ops) consume it (if any).
-    std::unordered_map<Buffer*, ConsumersList> m_BufferConsumers;
+    std::vector<ConsumersList> m_BufferConsumers;
     /// For each Op in the graph, which Buffer does it produce (if any).
-    std::unordered_map<Op*, Buffer*> m_OpOutputs;
+    std::vector<Buffer*> m_OpOutputs;
     /// For each Op in the graph, which Buffers does it consume (if any), ordered by input index.
-    std::unordered_map<Op*, BufferList> m_OpInputs;
+    std::vector<BufferList> m_OpInputs;
 };
 
 /// An extension of OpGraph which additionally manages the lifetime of the Ops and Buffers.
@@ -143,7 +157,7 @@ public:
 
     /// Counter for generating unique debug tags (see DebuggableObject constructor).
     /// This is publicly exposed so can be manipulated by tests.
-    static int ms_IdCounter;
+    static std::atomic<int> ms_IdCounter;
 };
 
 class Plan : public DebuggableObject
@@ -275,7 +289,7 @@ public:
     uint32_t m_NumStripes;
 
     /// Relevant only if this is a weights buffer in Dram.
-    std::unique_ptr<EncodedWeights> m_EncodedWeights;
+    std::unique_ptr<EncodedWeightsSize> m_EncodedWeightsSize;
 };
 
 }    // namespace support_library
@@ -789,7 +789,7 @@ void SaveCombinationToDot(const Combination& combination,
     NodeIds nodeIds;
     std::unordered_map<const Edge*, std::string> edgeInputs;
 
-    for (const Elem& elem : combination.m_Elems)
+    for (const Elem& elem : combination.GetElems())
     {
         const Part& part = graphOfParts.GetPart(elem.m_PartId);
         const Plan& plan = part.GetPlan(elem.m_PlanId);
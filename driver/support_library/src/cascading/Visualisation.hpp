@@ -20,7 +20,7 @@ class Graph;
 class OpGraph;
 class GraphOfParts;
 class Part;
-struct Combination;
+class Combination;
 enum class Location;
 enum class Lifetime;
 enum class CompilerDataFormat;
@@ -27,7 +27,7 @@ NonCascading::NonCascading(const EstimationOptions& estOpt,
 
 NetworkPerformanceData NonCascading::Estimate(Graph& graph)
 {
-    std::vector<Node*> sorted = graph.GetNodesSorted();
+    const std::vector<Node*>& sorted = graph.GetNodesSorted();
 
     for (Node* n : sorted)
     {
@@ -0,0 +1,383 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "TestUtils.hpp"
+
+#include "CapabilitiesInternal.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include "WeightEncoder.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <ethosn_support_library/Support.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace ethosn_lib = ethosn::support_library;
+
+namespace
+{
+
+/// The heap memory allocated through operator new by the whole program, so that the memory used by one piece of work
+/// can be measured without counting what was allocated before it (unlike the peak RSS).
+std::atomic<size_t> g_AllocatedBytes{ 0 };
+std::atomic<size_t> g_PeakAllocatedBytes{ 0 };
+std::atomic<size_t> g_TotalAllocatedBytes{ 0 };
+
+/// The size of each allocation is stored before it, in a header which keeps the alignment of the allocation.
+constexpr size_t g_AllocationHeaderSize = alignof(std::max_align_t);
+
+/// Measures the heap memory allocated from its construction until GetPeakBytes or GetTotalBytes are called.
+class AllocationCounter
+{
+public:
+    AllocationCounter()
+        : m_StartBytes(g_AllocatedBytes.load())
+        , m_StartTotalBytes(g_TotalAllocatedBytes.load())
+    {
+        g_PeakAllocatedBytes = m_StartBytes;
+    }
+
+    /// The most memory held at once, on top of what was held when counting started.
+    size_t GetPeakBytes() const
+    {
+        return g_PeakAllocatedBytes.load() - m_StartBytes;
+    }
+
+    /// The sum of the sizes of every allocation since counting started.
+    size_t GetTotalBytes() const
+    {
+        return g_TotalAllocatedBytes.load() - m_StartTotalBytes;
+    }
+
+private:
+    size_t m_StartBytes;
+    size_t m_StartTotalBytes;
+};
+
+/// Returns random weights of which the given fraction are replaced by the zero point.
+std::vector<uint8_t> GenerateWeights(size_t size, int32_t zeroPoint, float sparsity)
+{
+    std::mt19937 generator(static_cast<uint32_t>(size));
+    std::uniform_int_distribution<uint32_t> byteDistribution(0, 255);
+    std::bernoulli_distribution zeroDistribution(sparsity);
+    std::vector<uint8_t> weights(size);
+    for (uint8_t& weight : weights)
+    {
+        weight = static_cast<uint8_t>(zeroDistribution(generator) ? static_cast<uint32_t>(zeroPoint)
+                                                                  : byteDistribution(generator));
+    }
+    return weights;
+}
+
+/// Creates a network with a single fully connected layer, whose weights are random bytes of which the given fraction
+/// are replaced by the zero point.
+std::shared_ptr<ethosn_lib::Network> CreateFullyConnected(uint32_t numInputs, uint32_t numOutputs, float sparsity)
+{
+    std::shared_ptr<ethosn_lib::Network> network = ethosn_lib::CreateNetwork();
+
+    const ethosn_lib::TensorInfo inputInfo({ 1, 1, 1, numInputs }, ethosn_lib::DataType::UINT8_QUANTIZED,
+                                           ethosn_lib::DataFormat::NHWC, ethosn_lib::QuantizationInfo(0, 1.0f));
+    std::shared_ptr<ethosn_lib::Operand> input = ethosn_lib::AddInput(network, inputInfo).tensor;
+
+    constexpr int32_t weightsZeroPoint = 128;
+    const std::vector<uint8_t> weightsData =
+        GenerateWeights(static_cast<size_t>(numInputs) * numOutputs, weightsZeroPoint, sparsity);
+    const std::vector<int32_t> biasData(numOutputs, 3);
+
+    const ethosn_lib::TensorInfo weightsInfo({ 1, 1, numInputs, numOutputs }, ethosn_lib::DataType::UINT8_QUANTIZED,
+                                             ethosn_lib::DataFormat::HWIO,
+                                             ethosn_lib::QuantizationInfo(weightsZeroPoint, 0.5f));
+    const ethosn_lib::TensorInfo biasInfo({ 1, 1, 1, numOutputs }, ethosn_lib::DataType::INT32_QUANTIZED,
+                                          ethosn_lib::DataFormat::NHWC, ethosn_lib::QuantizationInfo(0, 0.5f));
+    std::shared_ptr<ethosn_lib::Constant> weights =
+        ethosn_lib::AddConstant(network, weightsInfo, weightsData.data()).tensor;
+    std::shared_ptr<ethosn_lib::Constant> bias = ethosn_lib::AddConstant(network, biasInfo, biasData.data()).tensor;
+    std::shared_ptr<ethosn_lib::Operand> output =
+        ethosn_lib::AddFullyConnected(network, *input, *bias, *weights,
+                                      ethosn_lib::FullyConnectedInfo(ethosn_lib::QuantizationInfo(0, 1.1f)))
+            .tensor;
+    ethosn_lib::AddOutput(network, *output);
+    return network;
+}
+
+using testing_utils::CreateCompilationOptions;
+
+/// Compiles the given network and returns the serialized compiled networks, and the time taken.
+std::pair<std::string, std::chrono::milliseconds> CompileAndSerialize(const ethosn_lib::Network& network,
+                                                                      const ethosn_lib::CompilationOptions& options)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<std::unique_ptr<ethosn_lib::CompiledNetwork>> compiledNetworks =
+        ethosn_lib::Compile(network, options);
+    const auto duration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+    std::ostringstream serialized;
+    for (const std::unique_ptr<ethosn_lib::CompiledNetwork>& compiledNetwork : compiledNetworks)
+    {
+        compiledNetwork->Serialize(serialized);
+    }
+    return { serialized.str(), duration };
+}
+
+/// Estimates the performance of the given network and returns the result, and the time taken.
+std::pair<ethosn_lib::NetworkPerformanceData, std::chrono::milliseconds>
+    TimeEstimatePerformance(const ethosn_lib::Network& network, const ethosn_lib::CompilationOptions& options)
+{
+    const auto start = std::chrono::steady_clock::now();
+    ethosn_lib::NetworkPerformanceData performanceData =
+        ethosn_lib::EstimatePerformance(network, options, ethosn_lib::EstimationOptions());
+    const auto duration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return { std::move(performanceData), duration };
+}
+
+}    // Anonymous namespace
+
+void* operator new(size_t size)
+{
+    char* allocation = static_cast<char*>(std::malloc(size + g_AllocationHeaderSize));
+    if (allocation == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(allocation) = size;
+    const size_t allocated                 = (g_AllocatedBytes += size);
+    g_TotalAllocatedBytes += size;
+    size_t peak = g_PeakAllocatedBytes.load();
+    while (allocated > peak && !g_PeakAllocatedBytes.compare_exchange_weak(peak, allocated))
+    {
+    }
+    return allocation + g_AllocationHeaderSize;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+    {
+        char* allocation = static_cast<char*>(ptr) - g_AllocationHeaderSize;
+        g_AllocatedBytes -= *reinterpret_cast<size_t*>(allocation);
+        std::free(allocation);
+    }
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+// The other forms of operator new and delete must all be replaced as well, as memory allocated by one form may be
+// freed by another.
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t& nothrow) noexcept
+{
+    return operator new(size, nothrow);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    operator delete(ptr);
+}
+
+BOOST_AUTO_TEST_SUITE(Benchmarks)
+
+// Benchmarks the graph optimizations on a network of 5000 operations, which they merge into one. Before they were
+// applied from a worklist, each change rescanned the whole graph.
+// The time taken is reported rather than checked, as it depends on the machine.
+BOOST_AUTO_TEST_CASE(OptimizeRequantizeChainBenchmark)
+{
+    constexpr uint32_t numRequantizes = 5000;
+
+    std::shared_ptr<ethosn_lib::Network> network = ethosn_lib::CreateEstimationNetwork();
+    const ethosn_lib::TensorInfo inputInfo({ 1, 8, 8, 16 }, ethosn_lib::DataType::UINT8_QUANTIZED,
+                                           ethosn_lib::DataFormat::NHWC, ethosn_lib::QuantizationInfo(0, 1.0f));
+    std::shared_ptr<ethosn_lib::Operand> operand = ethosn_lib::AddInput(network, inputInfo).tensor;
+    for (uint32_t i = 0; i < numRequantizes; ++i)
+    {
+        const float scale = (i % 2 == 0) ? 1.1f : 1.0f;
+        operand = ethosn_lib::AddRequantize(network, *operand,
+                                            ethosn_lib::RequantizeInfo(ethosn_lib::QuantizationInfo(0, scale)))
+                      .tensor;
+    }
+    ethosn_lib::AddOutput(network, *operand);
+
+    ethosn_lib::CompilationOptions options(
+        ethosn_lib::GetPerformanceEstimatorFwAndHwCapabilities(ethosn_lib::EthosNVariant::ETHOS_N77, 0));
+    options.m_CompilerAlgorithm = ethosn_lib::CompilerAlgorithm::NonCascadingOnly;
+
+    const auto start = std::chrono::steady_clock::now();
+    const ethosn_lib::NetworkPerformanceData performanceData =
+        ethosn_lib::EstimatePerformance(*network, options, ethosn_lib::EstimationOptions());
+    const auto duration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    BOOST_TEST_MESSAGE("Estimating a chain of " << numRequantizes << " requantizes took " << duration.count() << " ms");
+
+    // The requantizes are all merged into one, which is a single pass.
+    BOOST_CHECK_EQUAL(performanceData.m_Stream.size(), 1U);
+}
+
+// Benchmarks compiling a fully connected layer the size of the second one in VGG16, whose weight encoding is most of
+// the compile time, with one thread and with one per core. The weights for different OFMs are encoded concurrently,
+// and the compiled network must be identical either way.
+BOOST_AUTO_TEST_CASE(WeightEncodingThreadsBenchmark)
+{
+    const std::shared_ptr<ethosn_lib::Network> network = CreateFullyConnected(4096, 4096, 0.0f);
+    ethosn_lib::CompilationOptions options             = CreateCompilationOptions();
+
+    options.m_NumThreads                     = 1;
+    const auto serial                        = CompileAndSerialize(*network, options);
+    options.m_NumThreads                     = 0;
+    const auto parallel                      = CompileAndSerialize(*network, options);
+    BOOST_TEST_MESSAGE("Compiling a 4096x4096 fully connected layer took " << serial.second.count() << " ms with one "
+                       << "thread and " << parallel.second.count() << " ms with one per core ("
+                       << std::thread::hardware_concurrency() << ")");
+
+    BOOST_CHECK(!serial.first.empty());
+    BOOST_CHECK(parallel.first == serial.first);
+}
+
+// Benchmarks the throughput of the weight encoder on a fixed 3x3x256x256 convolution, for each version of the weight
+// compression and for random and sparse weights. Only the encoding itself is timed, not the rest of the compilation,
+// and the average over several runs is reported.
+BOOST_AUTO_TEST_CASE(WeightEncoderThroughputBenchmark)
+{
+    using namespace ethosn::support_library;
+
+    constexpr uint32_t channels        = 256;
+    constexpr int32_t weightsZeroPoint = 128;
+    constexpr uint32_t numRepeats      = 10;
+    const TensorInfo weightsInfo({ 3, 3, channels, channels }, DataType::UINT8_QUANTIZED, DataFormat::HWIO,
+                                 QuantizationInfo(weightsZeroPoint, 0.5f));
+    const TensorInfo biasInfo({ 1, 1, 1, channels }, DataType::INT32_QUANTIZED, DataFormat::NHWC,
+                              QuantizationInfo(0, 0.5f));
+    const std::vector<int32_t> biasData(channels, 3);
+    const size_t numBytes = utils::TotalSizeBytes(weightsInfo);
+
+    const std::pair<const char*, HardwareCapabilities> variants[] = {
+        { "N77", HardwareCapabilities(GetEthosN77FwHwCapabilities()) },
+        { "N78", HardwareCapabilities(GetEthosN78FwHwCapabilities(EthosNVariant::ETHOS_N78_4TOPS_4PLE_RATIO, 0)) },
+    };
+    for (const auto& variant : variants)
+    {
+        const HardwareCapabilities& capabilities = variant.second;
+        ThreadPool threadPool(1);
+        std::unique_ptr<WeightEncoder> encoder = WeightEncoder::CreateWeightEncoder(capabilities, &threadPool);
+        for (const float sparsity : { 0.0f, 0.9f })
+        {
+            const std::vector<uint8_t> weightsData = GenerateWeights(numBytes, weightsZeroPoint, sparsity);
+
+            EncodedWeights encodedWeights;
+            const auto start = std::chrono::steady_clock::now();
+            for (uint32_t i = 0; i < numRepeats; ++i)
+            {
+                encodedWeights = encoder->Encode(weightsInfo, weightsData.data(), biasInfo, biasData.data(),
+                                                 QuantizationInfo(0, 1.0f), QuantizationInfo(0, 1.1f),
+                                                 capabilities.GetNumberOfOfm(), 1, 1, 1, 1, channels,
+                                                 ethosn::command_stream::MceOperation::CONVOLUTION,
+                                                 CompilerMceAlgorithm::Direct);
+            }
+            const double seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / numRepeats;
+
+            BOOST_TEST_MESSAGE("Encoding " << numBytes << " bytes of weights for " << variant.first
+                               << " with sparsity " << sparsity << " took " << seconds * 1000.0 << " ms ("
+                               << static_cast<double>(numBytes) / seconds << " bytes/s, compressed to "
+                               << encodedWeights.m_Data.size() << " bytes)");
+            BOOST_CHECK(!encodedWeights.m_Data.empty());
+        }
+    }
+}
+
+// Benchmarks the cascading estimate of a network of 100 convolutions with one thread and with one per core. The
+// plans of different Parts are created concurrently, and the result must be the same either way.
+// On a single core the two times are about the same.
+BOOST_AUTO_TEST_CASE(CascadingPlanCreationThreadsBenchmark)
+{
+    const std::shared_ptr<ethosn_lib::Network> network = testing_utils::CreateConvolutionChain(100);
+    ethosn_lib::CompilationOptions options             = CreateCompilationOptions();
+    options.m_CompilerAlgorithm                        = ethosn_lib::CompilerAlgorithm::CascadingOnly;
+    // A network this deep can't be searched in full, so the plans of each chain of Parts are combined directly.
+    options.m_CascadingDynamicProgramming = true;
+
+    options.m_NumThreads = 1;
+    const auto serial    = TimeEstimatePerformance(*network, options);
+    options.m_NumThreads = 0;
+    const auto parallel  = TimeEstimatePerformance(*network, options);
+    BOOST_TEST_MESSAGE("Cascading estimate of 100 convolutions took " << serial.second.count() << " ms with one thread "
+                       << "and " << parallel.second.count() << " ms with one per core ("
+                       << std::thread::hardware_concurrency() << ")");
+
+    BOOST_CHECK(!serial.first.m_Stream.empty());
+    BOOST_CHECK_EQUAL(parallel.first.m_Stream.size(), serial.first.m_Stream.size());
+    BOOST_CHECK_EQUAL(testing_utils::GetTotalDramTraffic(parallel.first),
+                      testing_utils::GetTotalDramTraffic(serial.first));
+}
+
+// Benchmarks the time and memory taken to search for the best cascaded combination of plans, in full for a network of
+// 3 convolutions and keeping only the most promising combinations for one of 600. Each combination shares the
+// changes made to the combinations it was grown from, and finds those made to a Part through an index, so growing one
+// takes time logarithmic rather than linear in the number of Parts it already has.
+// The memory is counted from the allocations made by the estimate, so does not depend on anything run before it.
+BOOST_AUTO_TEST_CASE(CascadingSearchBenchmark)
+{
+    for (const std::pair<uint32_t, uint32_t>& numConvolutionsAndBeamWidth : { std::make_pair(3U, 0U),
+                                                                              std::make_pair(600U, 64U) })
+    {
+        const uint32_t numConvolutions = numConvolutionsAndBeamWidth.first;
+        const std::shared_ptr<ethosn_lib::Network> network = testing_utils::CreateConvolutionChain(numConvolutions);
+        ethosn_lib::CompilationOptions options             = CreateCompilationOptions();
+        options.m_CompilerAlgorithm                        = ethosn_lib::CompilerAlgorithm::CascadingOnly;
+        options.m_CascadingBeamWidth                       = numConvolutionsAndBeamWidth.second;
+
+        const AllocationCounter allocationCounter;
+        const auto estimated = TimeEstimatePerformance(*network, options);
+        BOOST_TEST_MESSAGE("Searching the cascaded combinations of " << numConvolutions << " convolutions with a beam "
+                           << "width of " << options.m_CascadingBeamWidth << " took " << estimated.second.count()
+                           << " ms, allocating " << allocationCounter.GetTotalBytes() / 1024 << " kB with a peak of "
+                           << allocationCounter.GetPeakBytes() / 1024 << " kB");
+
+        BOOST_CHECK(!estimated.first.m_Stream.empty());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
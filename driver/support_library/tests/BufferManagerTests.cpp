@@ -0,0 +1,296 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "BufferManager.hpp"
+#include "Utils.hpp"
+
+#include <boost/test/unit_test.hpp>
+#include <ethosn_command_stream/CommandStreamBuffer.hpp>
+
+#include <algorithm>
+
+using namespace ethosn::support_library;
+
+namespace
+{
+
+/// Gets the end of the memory used by the intermediate DRAM buffers, which is the size of the intermediate data.
+uint32_t GetIntermediateDataSize(const BufferManager& bufferManager)
+{
+    uint32_t size = 0;
+    for (const auto& internalBufferIt : bufferManager.GetBuffers())
+    {
+        const CompilerBufferInfo& buffer = internalBufferIt.second;
+        if (buffer.m_Location == BufferLocation::Dram && buffer.m_Type == BufferType::Intermediate)
+        {
+            size = std::max(size, buffer.m_Offset + buffer.m_Size);
+        }
+    }
+    return size;
+}
+
+/// Adds an intermediate DRAM buffer which is in use from the given time (inclusive) until the given time (exclusive).
+uint32_t AddIntermediate(BufferManager& bufferManager, uint32_t size, uint32_t startTime, uint32_t endTime)
+{
+    const uint32_t id = bufferManager.AddDram(BufferType::Intermediate, size);
+    bufferManager.MarkBufferUsedAtTime(id, startTime, endTime);
+    return id;
+}
+
+/// A hash for which every piece of data collides.
+Sha256::Digest CollidingHash(const void*, size_t)
+{
+    return Sha256::Digest{};
+}
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(BufferManagerTests)
+
+/// Checks that intermediate buffers which are never in use at the same time are given the same memory.
+BOOST_AUTO_TEST_CASE(IntermediatesWithDisjointLifetimesShareMemory)
+{
+    BufferManager bufferManager;
+    const uint32_t a = AddIntermediate(bufferManager, 1000, 0, 2);
+    const uint32_t b = AddIntermediate(bufferManager, 1000, 2, 4);
+    const uint32_t c = AddIntermediate(bufferManager, 500, 5, 6);
+    bufferManager.Allocate();
+
+    const std::map<uint32_t, CompilerBufferInfo>& buffers = bufferManager.GetBuffers();
+    BOOST_CHECK_EQUAL(buffers.at(a).m_Offset, 0);
+    BOOST_CHECK_EQUAL(buffers.at(b).m_Offset, 0);
+    BOOST_CHECK_EQUAL(buffers.at(c).m_Offset, 0);
+    BOOST_CHECK_EQUAL(GetIntermediateDataSize(bufferManager), 1000);
+    BOOST_CHECK(!bufferManager.HasOverlappingIntermediates());
+}
+
+/// Checks that intermediate buffers which are in use at the same time are given separate, aligned memory, including
+/// buffers which aren't used by any command and so are treated as being in use throughout.
+BOOST_AUTO_TEST_CASE(IntermediatesWithOverlappingLifetimesDontShareMemory)
+{
+    BufferManager bufferManager;
+    const uint32_t a      = AddIntermediate(bufferManager, 1000, 0, 3);
+    const uint32_t b      = AddIntermediate(bufferManager, 1000, 2, 4);
+    const uint32_t unused = bufferManager.AddDram(BufferType::Intermediate, 100);
+    bufferManager.Allocate();
+
+    const std::map<uint32_t, CompilerBufferInfo>& buffers = bufferManager.GetBuffers();
+    BOOST_CHECK_EQUAL(buffers.at(a).m_Offset, 0);
+    BOOST_CHECK_EQUAL(buffers.at(b).m_Offset, 1024);
+    BOOST_CHECK_EQUAL(buffers.at(unused).m_Offset, 2048);
+    BOOST_CHECK_EQUAL(GetIntermediateDataSize(bufferManager), 2148);
+    BOOST_CHECK(!bufferManager.HasOverlappingIntermediates());
+}
+
+/// Checks that the lifetimes are worked out from the commands which use each buffer, so that the output of one
+/// command can reuse the memory of the input of the command before it, but not of its own input.
+BOOST_AUTO_TEST_CASE(IntermediateLifetimesFromCommandStream)
+{
+    BufferManager bufferManager;
+    std::vector<uint32_t> ids;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        ids.push_back(bufferManager.AddDram(BufferType::Intermediate, 1024));
+    }
+    ethosn::command_stream::CommandStreamBuffer cmdStream;
+    for (uint32_t i = 0; i + 1 < ids.size(); ++i)
+    {
+        // Each command reads one buffer and writes the next, and is followed by a command which uses no buffers.
+        ethosn::command_stream::Convert convert;
+        convert.m_InputInfo().m_DramBufferId()  = ids[i];
+        convert.m_OutputInfo().m_DramBufferId() = ids[i + 1];
+        cmdStream.EmplaceBack(convert);
+        cmdStream.EmplaceBack(ethosn::command_stream::Fence());
+    }
+    // A command which dumps the last buffer.
+    ethosn::command_stream::DumpDram dumpDram;
+    dumpDram.m_DramBufferId() = ids.back();
+    cmdStream.EmplaceBack(dumpDram);
+    bufferManager.AddCommandStream(cmdStream);
+    bufferManager.Allocate();
+
+    const std::map<uint32_t, CompilerBufferInfo>& buffers = bufferManager.GetBuffers();
+    BOOST_CHECK_EQUAL(buffers.at(ids[0]).m_LifetimeStart, 0);
+    BOOST_CHECK_EQUAL(buffers.at(ids[0]).m_LifetimeEnd, 1);
+    BOOST_CHECK_EQUAL(buffers.at(ids[1]).m_LifetimeStart, 0);
+    BOOST_CHECK_EQUAL(buffers.at(ids[1]).m_LifetimeEnd, 3);
+    BOOST_CHECK_EQUAL(buffers.at(ids[2]).m_LifetimeStart, 2);
+    BOOST_CHECK_EQUAL(buffers.at(ids[2]).m_LifetimeEnd, 5);
+    BOOST_CHECK_EQUAL(buffers.at(ids[0]).m_Offset, buffers.at(ids[2]).m_Offset);
+    BOOST_CHECK_NE(buffers.at(ids[0]).m_Offset, buffers.at(ids[1]).m_Offset);
+    BOOST_CHECK_EQUAL(GetIntermediateDataSize(bufferManager), 2048);
+    BOOST_CHECK(!bufferManager.HasOverlappingIntermediates());
+}
+
+/// Checks that for many buffers of different sizes and lifetimes, none which are in use at the same time overlap,
+/// and that the intermediate data is never bigger than giving each buffer its own aligned memory.
+BOOST_AUTO_TEST_CASE(IntermediatesAreNoBiggerThanSumOfSizes)
+{
+    for (uint32_t seed = 1; seed <= 50; ++seed)
+    {
+        BufferManager bufferManager;
+        uint32_t sumOfSizes = 0;
+        // A simple linear congruential generator, so that the buffers are the same on every platform.
+        uint32_t random = seed;
+        auto next       = [&random](uint32_t max) {
+            random = random * 1103515245u + 12345u;
+            return (random >> 16) % max;
+        };
+        for (uint32_t i = 0; i < 20; ++i)
+        {
+            const uint32_t size      = 1 + next(5000);
+            const uint32_t startTime = next(30);
+            AddIntermediate(bufferManager, size, startTime, startTime + 1 + next(10));
+            sumOfSizes += (size + 63) / 64 * 64;
+        }
+        bufferManager.Allocate();
+
+        BOOST_CHECK(!bufferManager.HasOverlappingIntermediates());
+        BOOST_CHECK_LE(GetIntermediateDataSize(bufferManager), sumOfSizes);
+        for (const auto& internalBufferIt : bufferManager.GetBuffers())
+        {
+            BOOST_CHECK_EQUAL(internalBufferIt.second.m_Offset % 64, 0);
+        }
+    }
+}
+
+/// Checks that HasOverlappingIntermediates finds buffers which overlap in both memory and time, but not those which
+/// only overlap in one of them, or buffers which aren't intermediates.
+BOOST_AUTO_TEST_CASE(HasOverlappingIntermediates)
+{
+    BufferManager bufferManager;
+    AddIntermediate(bufferManager, 100, 0, 2);
+    AddIntermediate(bufferManager, 100, 2, 4);
+    bufferManager.AddDram(BufferType::Input, 100);
+    bufferManager.AddDram(BufferType::Output, 100);
+    BOOST_CHECK(!bufferManager.HasOverlappingIntermediates());
+
+    AddIntermediate(bufferManager, 100, 1, 3);
+    BOOST_CHECK(bufferManager.HasOverlappingIntermediates());
+
+    bufferManager.Allocate();
+    BOOST_CHECK(!bufferManager.HasOverlappingIntermediates());
+}
+
+/// Checks that the constant data taken after Allocate() is the same as copying the data of each constant buffer in,
+/// in order and aligned to 64 bytes, and that the BufferManager stops sharing the data of the buffers once it has
+/// been laid out.
+BOOST_AUTO_TEST_CASE(TakeConstantDataMatchesCopying)
+{
+    BufferManager bufferManager;
+    std::vector<uint8_t> expectedDma;
+    std::vector<uint8_t> expectedControlUnit;
+    std::vector<std::weak_ptr<const std::vector<uint8_t>>> shared;
+    std::map<uint32_t, uint32_t> expectedOffsets;
+    for (uint32_t i = 0; i < 10; ++i)
+    {
+        const bool isDma               = i % 3 != 0;
+        std::vector<uint8_t>& expected = isDma ? expectedDma : expectedControlUnit;
+        const uint32_t size            = 1 + i * 37;
+        auto data                      = std::make_shared<std::vector<uint8_t>>(size, static_cast<uint8_t>(i + 1));
+        shared.push_back(data);
+        const uint32_t id =
+            bufferManager.AddDramConstant(isDma ? BufferType::ConstantDma : BufferType::ConstantControlUnit, data);
+        expected.resize(utils::RoundUpToNearestMultiple(expected.size(), size_t{ 64 }));
+        expectedOffsets[id] = static_cast<uint32_t>(expected.size());
+        expected.insert(expected.end(), data->begin(), data->end());
+    }
+    bufferManager.Allocate();
+
+    for (const std::pair<const uint32_t, uint32_t>& expectedOffset : expectedOffsets)
+    {
+        BOOST_CHECK_EQUAL(bufferManager.GetBuffers().at(expectedOffset.first).m_Offset, expectedOffset.second);
+        BOOST_CHECK(bufferManager.GetBuffers().at(expectedOffset.first).m_ConstantData == nullptr);
+    }
+    for (const std::weak_ptr<const std::vector<uint8_t>>& data : shared)
+    {
+        BOOST_CHECK(data.expired());
+    }
+    BOOST_CHECK(bufferManager.TakeConstantDmaData() == expectedDma);
+    BOOST_CHECK(bufferManager.TakeConstantControlUnitData() == expectedControlUnit);
+    BOOST_CHECK(bufferManager.TakeConstantDmaData().empty());
+    BOOST_CHECK(bufferManager.TakeConstantControlUnitData().empty());
+}
+
+/// Checks that identical constant data is only stored once, at an offset which is aligned, and that the stats count
+/// the duplicates.
+BOOST_AUTO_TEST_CASE(ConstantDataAppenderSharesIdenticalData)
+{
+    std::vector<uint8_t> dest;
+    BufferManager::ConstantDataStats stats = {};
+    ConstantDataAppender appender(dest, 64, stats);
+    const std::vector<uint8_t> a(10, 1);
+    const std::vector<uint8_t> b(100, 2);
+
+    const uint32_t offsetA = appender.Append(a);
+    const uint32_t offsetB = appender.Append(b);
+    BOOST_CHECK_EQUAL(offsetA, 0);
+    BOOST_CHECK_EQUAL(offsetB, 64);
+    BOOST_CHECK_EQUAL(appender.Append(std::vector<uint8_t>(a)), offsetA);
+    BOOST_CHECK_EQUAL(appender.Append(b), offsetB);
+    BOOST_CHECK_EQUAL(dest.size(), 164);
+
+    BOOST_CHECK_EQUAL(stats.m_NumBuffers, 4);
+    BOOST_CHECK_EQUAL(stats.m_NumDuplicateBuffers, 2);
+    BOOST_CHECK_EQUAL(stats.m_DuplicateBytes, 110);
+    BOOST_CHECK_EQUAL(stats.m_StoredBytes, 164);
+}
+
+/// Checks that data with the same hash but different contents (or sizes) is stored separately, and that each can
+/// still be shared with identical data afterwards.
+BOOST_AUTO_TEST_CASE(ConstantDataAppenderHashCollision)
+{
+    std::vector<uint8_t> dest;
+    BufferManager::ConstantDataStats stats = {};
+    ConstantDataAppender appender(dest, 64, stats, &CollidingHash);
+    const std::vector<uint8_t> a(10, 1);
+    const std::vector<uint8_t> b(10, 2);
+    // The same as a followed by the zeros which pad it to the alignment.
+    std::vector<uint8_t> longerA = a;
+    longerA.resize(20, 0);
+
+    const uint32_t offsetA       = appender.Append(a);
+    const uint32_t offsetB       = appender.Append(b);
+    const uint32_t offsetLongerA = appender.Append(longerA);
+    BOOST_CHECK_EQUAL(offsetA, 0);
+    BOOST_CHECK_EQUAL(offsetB, 64);
+    BOOST_CHECK_EQUAL(offsetLongerA, 128);
+    BOOST_CHECK_EQUAL(appender.Append(b), offsetB);
+    BOOST_CHECK_EQUAL(appender.Append(a), offsetA);
+    BOOST_CHECK_EQUAL(appender.Append(longerA), offsetLongerA);
+    BOOST_CHECK(std::equal(b.begin(), b.end(), dest.begin() + offsetB));
+    BOOST_CHECK_EQUAL(stats.m_NumDuplicateBuffers, 3);
+}
+
+/// Checks that every piece of constant data starts at a multiple of the alignment, with the padding zeroed, whatever
+/// the sizes of the data before it.
+BOOST_AUTO_TEST_CASE(ConstantDataAppenderKeepsAlignment)
+{
+    for (uint32_t alignment : { 1u, 16u, 64u })
+    {
+        BOOST_TEST_CONTEXT(alignment)
+        {
+            std::vector<uint8_t> dest;
+            BufferManager::ConstantDataStats stats = {};
+            ConstantDataAppender appender(dest, alignment, stats);
+            uint32_t end  = 0;
+            uint8_t value = 0;
+            for (uint32_t size : { 1u, 65u, 3u, 64u, 1u, 130u })
+            {
+                // All different, so that none are shared.
+                const std::vector<uint8_t> data(size, ++value);
+                const uint32_t offset = appender.Append(data);
+                BOOST_CHECK_EQUAL(offset % alignment, 0);
+                BOOST_CHECK_EQUAL(offset, utils::RoundUpToNearestMultiple(end, alignment));
+                BOOST_CHECK(std::all_of(dest.begin() + end, dest.begin() + offset, [](uint8_t x) { return x == 0; }));
+                BOOST_CHECK(std::equal(data.begin(), data.end(), dest.begin() + offset));
+                end = std::max(end, offset + size);
+            }
+            BOOST_CHECK_EQUAL(dest.size(), end);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,329 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "TestUtils.hpp"
+
+#include "CapabilitiesInternal.hpp"
+#include "DebuggingContext.hpp"
+#include "Graph.hpp"
+#include "Optimization.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include "cascading/Cascading.hpp"
+#include "cascading/Estimation.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <sstream>
+
+using namespace ethosn::support_library;
+using namespace testing_utils;
+
+namespace
+{
+
+/// Everything a Cascading needs to estimate the given network, which must outlive it.
+class CascadingEstimator
+{
+public:
+    CascadingEstimator(const Network& network,
+                       uint32_t numThreads,
+                       const CompilationOptions& compilationOptions = CreateCompilationOptions())
+        : m_CompilationOptions(compilationOptions)
+        , m_Capabilities(GetEthosN77FwHwCapabilities())
+        , m_DebuggingContext(m_CompilationOptions.m_DebugInfo)
+        , m_ThreadPool(numThreads)
+        , m_WeightEncoderCache(CreateWeightEncoderCache())
+        , m_Graph(network, m_Capabilities, m_EstimationOptions)
+        , m_Cascading(m_EstimationOptions,
+                      m_CompilationOptions,
+                      m_Capabilities,
+                      m_DebuggingContext,
+                      m_ThreadPool,
+                      *m_WeightEncoderCache)
+    {
+        ApplyAllOptimizations(m_Graph);
+    }
+
+    NetworkPerformanceData Estimate()
+    {
+        return m_Cascading.Estimate(m_Graph);
+    }
+
+    /// Creates the Parts of the network and their plans, and returns the complete combinations of them which the
+    /// search finds.
+    Combinations Combine()
+    {
+        m_Parts = CreateGraphOfParts(m_Graph);
+        CreatePlans(m_Parts.m_Parts, m_Capabilities, m_EstimationOptions, m_ThreadPool, *m_WeightEncoderCache, false);
+        return m_Cascading.Combine(m_Parts);
+    }
+
+    /// Estimates one of the combinations returned by Combine, using the given PassStatsCache if there is one.
+    NetworkPerformanceData EstimateCombination(const Combination& combination, PassStatsCache* passStatsCache)
+    {
+        return EstimateOpGraph(GetOpGraphForCombination(combination, m_Parts), m_Capabilities, m_EstimationOptions,
+                               passStatsCache);
+    }
+
+    Cascading& GetCascading()
+    {
+        return m_Cascading;
+    }
+
+private:
+    CompilationOptions m_CompilationOptions;
+    EstimationOptions m_EstimationOptions;
+    HardwareCapabilities m_Capabilities;
+    DebuggingContext m_DebuggingContext;
+    ThreadPool m_ThreadPool;
+    std::shared_ptr<WeightEncoderCache> m_WeightEncoderCache;
+    Graph m_Graph;
+    Cascading m_Cascading;
+    GraphOfParts m_Parts;
+};
+
+/// Returns the index of the first combination with the least metric, estimating each of them in full.
+uint32_t FindBestCombinationInOrder(Cascading& cascading)
+{
+    const Combinations& combinations = cascading.GetValidCombinations();
+    uint32_t result                  = static_cast<uint32_t>(combinations.size());
+    uint64_t bestMetric              = 0;
+    for (uint32_t i = 0; i < combinations.size(); ++i)
+    {
+        uint64_t metric;
+        try
+        {
+            metric = utils::GetMetric(cascading.EstimateCombination(combinations[i]));
+        }
+        catch (const NotSupportedException&)
+        {
+            continue;
+        }
+        if (result == combinations.size() || metric < bestMetric)
+        {
+            result     = i;
+            bestMetric = metric;
+        }
+    }
+    BOOST_REQUIRE_LT(result, combinations.size());
+    return result;
+}
+
+/// Returns the least DRAM traffic (see Scratch::m_MinDramTraffic) of the given combinations.
+uint64_t GetMinDramTraffic(const Combinations& combinations)
+{
+    BOOST_REQUIRE(!combinations.empty());
+    uint64_t result = std::numeric_limits<uint64_t>::max();
+    for (const Combination& combination : combinations)
+    {
+        result = std::min(result, combination.m_Scratch.m_MinDramTraffic);
+    }
+    return result;
+}
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(CascadingTests)
+
+/// Checks that estimating the combinations concurrently, where each estimate stops as soon as it is worse than the
+/// best found so far, chooses the same combination as estimating every one in full in order (taking the first of any
+/// which are equally good), for any number of threads.
+BOOST_AUTO_TEST_CASE(EstimatePerformanceMatchesSerialSearch)
+{
+    const std::shared_ptr<Network> network = CreateConvolutionChain(2);
+
+    CascadingEstimator serial(*network, 1);
+    const NetworkPerformanceData serialResult = serial.Estimate();
+    const utils::Optional<uint32_t>& serialIdx = serial.GetCascading().GetBestCombinationIdx();
+    BOOST_REQUIRE(serialIdx.has_value());
+    BOOST_CHECK_EQUAL(serialIdx.value(), FindBestCombinationInOrder(serial.GetCascading()));
+
+    CascadingEstimator parallel(*network, 4);
+    const NetworkPerformanceData parallelResult = parallel.Estimate();
+    const utils::Optional<uint32_t>& parallelIdx = parallel.GetCascading().GetBestCombinationIdx();
+    BOOST_REQUIRE(parallelIdx.has_value());
+    BOOST_CHECK_EQUAL(parallelIdx.value(), serialIdx.value());
+    BOOST_CHECK_EQUAL(utils::GetMetric(parallelResult), utils::GetMetric(serialResult));
+    BOOST_CHECK_EQUAL(parallel.GetCascading().GetValidCombinations().size(),
+                      serial.GetCascading().GetValidCombinations().size());
+}
+
+/// Checks that creating the plans of different Parts concurrently creates the same plans, in the same order, as
+/// creating them one Part at a time.
+BOOST_AUTO_TEST_CASE(CreatePlansMatchesSerial)
+{
+    const std::shared_ptr<Network> network = CreateConvolutionChain(3);
+    const HardwareCapabilities caps(GetEthosN77FwHwCapabilities());
+    const EstimationOptions estimationOptions;
+    Graph graph(*network, caps, estimationOptions);
+    ApplyAllOptimizations(graph);
+    std::shared_ptr<WeightEncoderCache> weightEncoderCache = CreateWeightEncoderCache();
+
+    GraphOfParts serialParts = CreateGraphOfParts(graph);
+    ThreadPool serialThreadPool(1);
+    CreatePlans(serialParts.m_Parts, caps, estimationOptions, serialThreadPool, *weightEncoderCache, false);
+
+    GraphOfParts parallelParts = CreateGraphOfParts(graph);
+    ThreadPool parallelThreadPool(4);
+    CreatePlans(parallelParts.m_Parts, caps, estimationOptions, parallelThreadPool, *weightEncoderCache, false);
+
+    BOOST_REQUIRE_EQUAL(parallelParts.GetNumParts(), serialParts.GetNumParts());
+    for (PartId p = 0; p < serialParts.GetNumParts(); ++p)
+    {
+        const Part& serialPart   = serialParts.GetPart(p);
+        const Part& parallelPart = parallelParts.GetPart(p);
+        BOOST_REQUIRE_EQUAL(parallelPart.GetNumPlans(), serialPart.GetNumPlans());
+        BOOST_CHECK_EQUAL(parallelPart.GetNumDominatedPlans(), serialPart.GetNumDominatedPlans());
+        for (PlanId i = 0; i < serialPart.GetNumPlans(); ++i)
+        {
+            const OpGraph::BufferList& serialBuffers   = serialPart.GetPlan(i).m_OpGraph.GetBuffers();
+            const OpGraph::BufferList& parallelBuffers = parallelPart.GetPlan(i).m_OpGraph.GetBuffers();
+            BOOST_REQUIRE_EQUAL(parallelBuffers.size(), serialBuffers.size());
+            for (size_t b = 0; b < serialBuffers.size(); ++b)
+            {
+                BOOST_CHECK(parallelBuffers[b]->m_Location == serialBuffers[b]->m_Location);
+                BOOST_CHECK(parallelBuffers[b]->m_StripeShape == serialBuffers[b]->m_StripeShape);
+                BOOST_CHECK_EQUAL(parallelBuffers[b]->m_SizeInBytes, serialBuffers[b]->m_SizeInBytes);
+            }
+        }
+    }
+}
+
+
+/// Checks that the search keeps no more complete combinations than the beam width, and that the best of them is
+/// chosen.
+BOOST_AUTO_TEST_CASE(BeamWidthLimitsCombinations)
+{
+    const std::shared_ptr<Network> network = CreateConvolutionChain(2);
+    CompilationOptions compilationOptions   = CreateCompilationOptions();
+    compilationOptions.m_CascadingBeamWidth = 16;
+
+    CascadingEstimator estimator(*network, 1, compilationOptions);
+    estimator.Estimate();
+    const CombinerSearchReport& report = estimator.GetCascading().GetSearchReport();
+    BOOST_CHECK_EQUAL(report.m_NumRetries, 0);
+    BOOST_CHECK_GT(report.m_NumCombinationsDropped, 0);
+    BOOST_CHECK(!report.m_CombinationBudgetExceeded);
+    BOOST_CHECK_LE(estimator.GetCascading().GetValidCombinations().size(), 16);
+    const utils::Optional<uint32_t>& bestIdx = estimator.GetCascading().GetBestCombinationIdx();
+    BOOST_REQUIRE(bestIdx.has_value());
+    BOOST_CHECK_EQUAL(bestIdx.value(), FindBestCombinationInOrder(estimator.GetCascading()));
+}
+
+/// Checks that once the combination budget is exceeded, every complete combination kept by the search is estimated
+/// and the best of them is chosen, rather than the first which can be estimated.
+BOOST_AUTO_TEST_CASE(CombinationBudgetChoosesBestCombination)
+{
+    const std::shared_ptr<Network> network = CreateConvolutionChain(2);
+    CompilationOptions compilationOptions = CreateCompilationOptions();
+    // Exceeded by the last step of the search, so that many complete combinations are kept.
+    compilationOptions.m_CascadingMaxCombinations = 50000;
+
+    CascadingEstimator estimator(*network, 1, compilationOptions);
+    estimator.Estimate();
+    const CombinerSearchReport& report = estimator.GetCascading().GetSearchReport();
+    BOOST_CHECK(report.m_CombinationBudgetExceeded);
+    BOOST_CHECK_GT(estimator.GetCascading().GetValidCombinations().size(), 1);
+    const utils::Optional<uint32_t>& bestIdx = estimator.GetCascading().GetBestCombinationIdx();
+    BOOST_REQUIRE(bestIdx.has_value());
+    BOOST_CHECK_EQUAL(bestIdx.value(), FindBestCombinationInOrder(estimator.GetCascading()));
+}
+
+/// Checks that when none of the combinations kept by a limited search can be estimated, the search is repeated with
+/// twice the limits until one can be, giving the same result as starting with those limits.
+BOOST_AUTO_TEST_CASE(SearchLimitsAreDoubledUntilACombinationCanBeEstimated)
+{
+    const std::shared_ptr<Network> network = CreateConvolutionChain(2);
+    CompilationOptions compilationOptions   = CreateCompilationOptions();
+    compilationOptions.m_CascadingBeamWidth = 1;
+
+    CascadingEstimator limited(*network, 1, compilationOptions);
+    const NetworkPerformanceData limitedResult = limited.Estimate();
+    const uint32_t numRetries                  = limited.GetCascading().GetSearchReport().m_NumRetries;
+    BOOST_REQUIRE_GT(numRetries, 0);
+    const uint32_t finalBeamWidth = 1U << numRetries;
+    BOOST_CHECK_LE(limited.GetCascading().GetValidCombinations().size(), finalBeamWidth);
+
+    compilationOptions.m_CascadingBeamWidth = finalBeamWidth;
+    CascadingEstimator doubled(*network, 1, compilationOptions);
+    const NetworkPerformanceData doubledResult = doubled.Estimate();
+    BOOST_CHECK_EQUAL(doubled.GetCascading().GetSearchReport().m_NumRetries, 0);
+    BOOST_CHECK_EQUAL(doubled.GetCascading().GetValidCombinations().size(),
+                      limited.GetCascading().GetValidCombinations().size());
+    BOOST_CHECK_EQUAL(doubled.GetCascading().GetBestCombinationIdx().value(),
+                      limited.GetCascading().GetBestCombinationIdx().value());
+    BOOST_CHECK_EQUAL(utils::GetMetric(doubledResult), utils::GetMetric(limitedResult));
+
+    // Half those limits are not enough, so the search is repeated once.
+    compilationOptions.m_CascadingBeamWidth = finalBeamWidth / 2;
+    CascadingEstimator halved(*network, 1, compilationOptions);
+    halved.Estimate();
+    BOOST_CHECK_EQUAL(halved.GetCascading().GetSearchReport().m_NumRetries, 1);
+}
+
+/// Checks that growing the combinations through each chain region by dynamic programming finds a combination with as
+/// little DRAM traffic as the search without it, for a chain of convolutions and for one which branches.
+BOOST_AUTO_TEST_CASE(DynamicProgrammingMatchesSearch)
+{
+    for (const std::shared_ptr<Network>& network :
+         { CreateConvolutionChain(3, 16, 8), CreateBranchedConvolutions(1, 16, 8) })
+    {
+        CompilationOptions compilationOptions            = CreateCompilationOptions();
+        compilationOptions.m_CascadingDynamicProgramming = false;
+        CascadingEstimator searched(*network, 1, compilationOptions);
+        const Combinations searchedCombinations = searched.Combine();
+
+        compilationOptions.m_CascadingDynamicProgramming = true;
+        CascadingEstimator combined(*network, 1, compilationOptions);
+        const Combinations combinedCombinations = combined.Combine();
+
+        BOOST_CHECK_GT(combined.GetCascading().GetSearchReport().m_NumChainRegionsCombined, 0);
+        BOOST_CHECK_EQUAL(GetMinDramTraffic(combinedCombinations), GetMinDramTraffic(searchedCombinations));
+    }
+}
+
+/// Checks that the performance data of the combinations of a network estimated with a PassStatsCache shared between
+/// them is the same as estimating each of them from scratch, both when some of their passes are found in the cache and
+/// when all of them are.
+BOOST_AUTO_TEST_CASE(PassStatsCacheMatchesRecompute)
+{
+    const std::shared_ptr<Network> network = CreateConvolutionChain(3, 16, 8);
+    CascadingEstimator estimator(*network, 1);
+    const Combinations combinations = estimator.Combine();
+    BOOST_REQUIRE_GT(combinations.size(), 1);
+
+    auto toJson = [](const NetworkPerformanceData& performanceData) {
+        std::stringstream ss;
+        PrintNetworkPerformanceDataJson(ss, 0, performanceData);
+        return ss.str();
+    };
+    PassStatsCache passStatsCache;
+    uint32_t numEstimated = 0;
+    // Only some of the combinations are estimated, to keep the test fast. They are spread out so that they include
+    // the same passes with different DMAs at their boundaries. Only every fifth combination in some runs can be
+    // estimated for this network, so the step isn't a multiple of five.
+    for (size_t i = 0; i < combinations.size(); i += 49)
+    {
+        const Combination& combination = combinations[i];
+        std::string recomputed;
+        try
+        {
+            recomputed = toJson(estimator.EstimateCombination(combination, nullptr));
+        }
+        catch (const NotSupportedException&)
+        {
+            BOOST_CHECK_THROW(estimator.EstimateCombination(combination, &passStatsCache), NotSupportedException);
+            continue;
+        }
+        BOOST_CHECK_EQUAL(toJson(estimator.EstimateCombination(combination, &passStatsCache)), recomputed);
+        // Every pass of the combination is now in the cache.
+        BOOST_CHECK_EQUAL(toJson(estimator.EstimateCombination(combination, &passStatsCache)), recomputed);
+        ++numEstimated;
+    }
+    BOOST_CHECK_GT(numEstimated, 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
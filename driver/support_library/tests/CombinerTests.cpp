@@ -0,0 +1,552 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "CapabilitiesInternal.hpp"
+#include "GraphNodes.hpp"
+#include "Utils.hpp"
+#include "WeightEncoder.hpp"
+#include "cascading/Cascading.hpp"
+#include "cascading/Combiner.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <set>
+#include <tuple>
+
+using namespace ethosn::support_library;
+
+namespace
+{
+
+/// Returns the edges of a chain of the given number of nodes, which the Parts of the tests are connected by.
+std::vector<const Edge*> AddChain(Graph& graph, size_t numNodes)
+{
+    std::vector<const Edge*> edges;
+    Node* prev = nullptr;
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        Node* node = graph.CreateAndAddNode<RequantizeNode>(
+            TensorShape{ 1, 8, 8, 16 }, ethosn::support_library::DataType::UINT8_QUANTIZED, QuantizationInfo(0, 1.0f),
+            CompilerDataFormat::NHWCB, std::set<uint32_t>{ 0 });
+        if (prev != nullptr)
+        {
+            graph.Connect(prev, node);
+            edges.push_back(node->GetInput(0));
+        }
+        prev = node;
+    }
+    return edges;
+}
+
+/// A graph with a Part for each node, whose plans differ in where their boundary buffers are and how much SRAM and
+/// DRAM traffic they use, so that there are many ways of combining them. Unlike the Parts of a real network, these can
+/// form any graph.
+class SyntheticParts
+{
+public:
+    SyntheticParts()
+        : m_Capabilities(GetEthosN77FwHwCapabilities())
+    {}
+
+    /// Adds a node which uses the outputs of the given nodes, and returns its index.
+    size_t AddNode(const std::vector<size_t>& inputs)
+    {
+        Node* node = m_Graph.CreateAndAddNode<RequantizeNode>(
+            ms_Shape, ethosn::support_library::DataType::UINT8_QUANTIZED, QuantizationInfo(0, 1.0f),
+            CompilerDataFormat::NHWCB, std::set<uint32_t>{ 0 });
+        for (size_t input : inputs)
+        {
+            m_Graph.Connect(m_Nodes.at(input), node);
+        }
+        m_Nodes.push_back(node);
+        return m_Nodes.size() - 1;
+    }
+
+    /// Creates the Parts, with the given number of plans each.
+    const GraphOfParts& CreateParts(uint32_t numPlans)
+    {
+        m_Parts = CreateGraphOfParts(m_Graph);
+        for (PartId p = 0; p < m_Parts.GetNumParts(); ++p)
+        {
+            Part& part = *m_Parts.m_Parts[p];
+            for (uint32_t k = 0; k < numPlans; ++k)
+            {
+                part.m_Plans.push_back(CreatePlan(part, static_cast<uint32_t>(p), k));
+            }
+        }
+        return m_Parts;
+    }
+
+    const HardwareCapabilities& GetCapabilities() const
+    {
+        return m_Capabilities;
+    }
+
+private:
+    /// Creates a plan whose boundary buffers are in SRAM or DRAM, whose output buffer may be atomic, and which loads
+    /// weights of varying size, depending on the given Part and plan indices.
+    std::unique_ptr<Plan> CreatePlan(const Part& part, uint32_t p, uint32_t k)
+    {
+        const Location inputLocation  = (k & 1U) ? Location::Dram : Location::Sram;
+        const Location outputLocation = (k & 2U) ? Location::Dram : Location::Sram;
+        const Lifetime outputLifetime = ((p + k) % 4U == 1U) ? Lifetime::Atomic : Lifetime::Cascade;
+        const TensorShape stripeShape =
+            ((p + k) % 3U == 0) ? TensorShape{ 1, 8, 16, 16 } : TensorShape{ 1, 16, 16, 16 };
+        const uint32_t weightsSizeInBytes        = ((p * 3U + k * 5U) % 4U + 1U) * 128U * 1024U;
+        const uint32_t encodedWeightsSizeInBytes = ((p * 7U + k * 3U) % 5U + 1U) * 1000U;
+
+        auto plan = std::make_unique<Plan>();
+        std::vector<Buffer*> inputs;
+        for (const Edge* edge : part.GetInputs())
+        {
+            inputs.push_back(AddBoundaryBuffer(*plan, Lifetime::Cascade, inputLocation, stripeShape));
+            plan->m_InputMappings[inputs.back()] = const_cast<Edge*>(edge);
+        }
+        Buffer* output                 = AddBoundaryBuffer(*plan, outputLifetime, outputLocation, stripeShape);
+        plan->m_OutputMappings[output] = part.m_SubGraph.back();
+        if (inputs.empty())
+        {
+            return plan;
+        }
+
+        const TensorShape weightsShape{ 3, 3, 16, 16 };
+        Buffer* weightsDram = plan->m_OpGraph.AddBuffer(
+            std::make_unique<Buffer>(Lifetime::Cascade, Location::Dram, CompilerDataFormat::WEIGHT, weightsShape,
+                                     TensorShape{ 0, 0, 0, 0 }, TraversalOrder::Xyz, 0, QuantizationInfo(0, 1.0f)));
+        weightsDram->m_EncodedWeightsSize = std::make_unique<EncodedWeightsSize>(
+            EncodedWeightsSize{ { { 0, encodedWeightsSizeInBytes } },
+                                encodedWeightsSizeInBytes,
+                                encodedWeightsSizeInBytes });
+        Buffer* weightsSram = plan->m_OpGraph.AddBuffer(
+            std::make_unique<Buffer>(Lifetime::Cascade, Location::Sram, CompilerDataFormat::WEIGHT, weightsShape,
+                                     weightsShape, TraversalOrder::Xyz, weightsSizeInBytes, QuantizationInfo(0, 1.0f)));
+        Op* dma = plan->m_OpGraph.AddOp(std::make_unique<DmaOp>(Lifetime::Cascade, Location::Sram));
+        Op* mce = plan->m_OpGraph.AddOp(std::make_unique<MceOp>());
+        plan->m_OpGraph.AddConsumer(weightsDram, dma, 0);
+        plan->m_OpGraph.SetProducer(weightsSram, dma);
+        plan->m_OpGraph.AddConsumer(inputs[0], mce, 0);
+        plan->m_OpGraph.AddConsumer(weightsSram, mce, 1);
+        plan->m_OpGraph.SetProducer(output, mce);
+        return plan;
+    }
+
+    static Buffer* AddBoundaryBuffer(Plan& plan, Lifetime lifetime, Location location, const TensorShape& stripeShape)
+    {
+        const bool inSram = location == Location::Sram;
+        return plan.m_OpGraph.AddBuffer(std::make_unique<Buffer>(
+            lifetime, location, CompilerDataFormat::NHWCB, ms_Shape, stripeShape, TraversalOrder::Xyz,
+            inSram ? utils::TotalSizeBytesNHWCB(stripeShape) * 2U : 0U, QuantizationInfo(0, 1.0f)));
+    }
+
+    static constexpr TensorShape ms_Shape{ 1, 16, 16, 16 };
+
+    HardwareCapabilities m_Capabilities;
+    Graph m_Graph;
+    std::vector<Node*> m_Nodes;
+    GraphOfParts m_Parts;
+};
+
+constexpr TensorShape SyntheticParts::ms_Shape;
+
+/// The DRAM traffic and number of merges of a way through a chain region to a plan of its last Part, as counted by
+/// CombineChainRegion.
+using PathCost = std::tuple<PlanId, uint64_t, size_t>;
+
+/// Returns the cost of the given plans of the Parts of the given chain region, following the same rules as AddSeed.
+/// Returns nothing if the plans either side of an Edge are incompatible or the plans merged together don't fit in
+/// SRAM.
+utils::Optional<PathCost> GetPathCost(const GraphOfParts& parts,
+                                      const Metadata& metadata,
+                                      const HardwareCapabilities& caps,
+                                      const ChainRegion& region,
+                                      const std::vector<PlanId>& planIds)
+{
+    const uint32_t numSrams        = caps.GetNumberOfSrams();
+    const uint32_t sramSizeInBytes = caps.GetTotalSramSize() / numSrams;
+    auto getSizes                  = [](const Plan& plan) {
+        uint32_t tot    = 0;
+        uint32_t atomic = 0;
+        for (const Buffer* buffer : plan.m_OpGraph.GetBuffers())
+        {
+            tot += buffer->m_SizeInBytes;
+            atomic += (buffer->m_Lifetime == Lifetime::Atomic) ? buffer->m_SizeInBytes : 0;
+        }
+        uint32_t inputs = 0;
+        for (const std::pair<Buffer* const, Edge*>& input : plan.m_InputMappings)
+        {
+            inputs += input.first->m_SizeInBytes;
+        }
+        return std::make_tuple(tot, atomic, inputs);
+    };
+
+    const Plan& firstPlan = parts.GetPart(region.m_First).GetPlan(planIds[0]);
+    uint32_t allocatedSram = std::get<0>(getSizes(firstPlan)) - std::get<1>(getSizes(firstPlan));
+    uint64_t dramTraffic   = metadata[region.m_First].m_PlanDramTraffic[planIds[0]];
+    size_t numMerges       = 0;
+    for (size_t i = 0; i + 1 < planIds.size(); ++i)
+    {
+        const PartId p          = region.m_First + i;
+        const Edge* edge        = metadata[p].m_Destination.begin()->first;
+        const auto comPlsOfPart = metadata[p].m_Comp.find(edge);
+        if (comPlsOfPart == metadata[p].m_Comp.end() || comPlsOfPart->second.count(planIds[i]) == 0)
+        {
+            return {};
+        }
+        const CompatiblePlans& comPls = comPlsOfPart->second.at(planIds[i]);
+        const auto comPl              = std::find_if(comPls.begin(), comPls.end(),
+                                        [&](const CompatiblePlan& c) { return c.m_Id == planIds[i + 1]; });
+        if (comPl == comPls.end())
+        {
+            return {};
+        }
+
+        const Buffer* output = parts.GetPart(p).GetPlan(planIds[i]).GetOutputBuffer(edge->GetSource());
+        const bool canMerge  = comPl->m_Glue->m_Graph.GetOps().empty() && output->m_Location != Location::Dram &&
+                              output->m_Lifetime != Lifetime::Atomic;
+        const auto sizes     = getSizes(parts.GetPart(p + 1).GetPlan(planIds[i + 1]));
+        const uint32_t sizeInBytes =
+            canMerge ? (allocatedSram + std::get<0>(sizes) - std::get<2>(sizes)) : std::get<0>(sizes);
+        if (sizeInBytes / numSrams > sramSizeInBytes)
+        {
+            return {};
+        }
+        allocatedSram = sizeInBytes - std::get<1>(sizes);
+        dramTraffic += comPl->m_GlueDramTraffic + metadata[p + 1].m_PlanDramTraffic[planIds[i + 1]];
+        numMerges += canMerge ? 1 : 0;
+    }
+    dramTraffic -= metadata[region.m_Last].m_PlanDramTraffic[planIds.back()];
+    return PathCost{ planIds.back(), dramTraffic, numMerges };
+}
+
+/// Returns, for each plan of the last Part of the given chain region, the costs of the ways through the region from
+/// the given plan of its first Part which aren't beaten on both DRAM traffic and the number of merges, by trying
+/// every one.
+std::set<PathCost> FindBestPathCostsExhaustively(const GraphOfParts& parts,
+                                                 const Metadata& metadata,
+                                                 const HardwareCapabilities& caps,
+                                                 const ChainRegion& region,
+                                                 PlanId firstPlanId)
+{
+    std::vector<PathCost> costs;
+    std::vector<PlanId> planIds(region.m_Last - region.m_First + 1, 0);
+    planIds[0] = firstPlanId;
+    while (true)
+    {
+        const utils::Optional<PathCost> cost = GetPathCost(parts, metadata, caps, region, planIds);
+        if (cost.has_value())
+        {
+            costs.push_back(cost.value());
+        }
+        // Move on to the next choice of plans for the Parts after the first.
+        size_t i = 1;
+        while (i < planIds.size() && ++planIds[i] == parts.GetPart(region.m_First + i).GetNumPlans())
+        {
+            planIds[i++] = 0;
+        }
+        if (i == planIds.size())
+        {
+            break;
+        }
+    }
+
+    std::set<PathCost> result;
+    for (const PathCost& cost : costs)
+    {
+        const bool isBeaten = std::any_of(costs.begin(), costs.end(), [&cost](const PathCost& other) {
+            return std::get<0>(other) == std::get<0>(cost) && std::get<1>(other) <= std::get<1>(cost) &&
+                   std::get<2>(other) >= std::get<2>(cost) && other != cost;
+        });
+        if (!isBeaten)
+        {
+            result.insert(cost);
+        }
+    }
+    return result;
+}
+
+/// Checks that CombineChainRegion finds the same ways through every chain region of the given Parts, from every plan
+/// of its first Part, as trying every combination of plans, and that the costs of those ways are counted correctly.
+void CheckCombineChainRegionMatchesExhaustiveSearch(const GraphOfParts& parts, const HardwareCapabilities& caps)
+{
+    const Metadata metadata                = CreateMetadata(parts, caps);
+    const std::vector<ChainRegion> regions = FindChainRegions(metadata);
+    BOOST_REQUIRE(!regions.empty());
+    for (const ChainRegion& region : regions)
+    {
+        for (PlanId firstPlanId = 0; firstPlanId < parts.GetPart(region.m_First).GetNumPlans(); ++firstPlanId)
+        {
+            std::set<PathCost> combined;
+            for (const ChainPath& path : CombineChainRegion(parts, metadata, caps, region, firstPlanId))
+            {
+                const utils::Optional<PathCost> cost = GetPathCost(parts, metadata, caps, region, path.m_PlanIds);
+                BOOST_REQUIRE(cost.has_value());
+                BOOST_CHECK_EQUAL(path.m_DramTraffic, std::get<1>(cost.value()));
+                BOOST_CHECK_EQUAL(path.m_NumMerges, std::get<2>(cost.value()));
+                combined.insert(cost.value());
+            }
+            BOOST_CHECK(combined == FindBestPathCostsExhaustively(parts, metadata, caps, region, firstPlanId));
+        }
+    }
+}
+
+/// Creates the same Metadata as CreateMetadata, but by calling ArePlansCompatible for every pair of plans either side
+/// of each Edge, each with a Glue of its own, rather than sharing the results between plans whose buffers on the Edge
+/// are the same.
+Metadata CreateUncachedMetadata(const GraphOfParts& parts, const HardwareCapabilities& caps)
+{
+    Metadata result = CreateMetadata(parts, caps);
+    for (PartId p = 0; p < parts.GetNumParts(); ++p)
+    {
+        result[p].m_Comp.clear();
+        const Part& fPart                      = parts.GetPart(p);
+        const std::vector<const Edge*> dsEdges = fPart.GetOutputs();
+        for (const Edge* dsEdge : dsEdges)
+        {
+            const PartId sPartId = parts.GetInputPart(*dsEdge).second;
+            const Part& sPart    = parts.GetPart(sPartId);
+            const bool reqDram   = (p + 1U != sPartId) || (dsEdges.size() > 1U) || (sPart.GetInputs().size() > 1U);
+            CompatiblePlansOfPart comPlsOfPa;
+            for (PlanId f = 0; f < fPart.GetNumPlans(); ++f)
+            {
+                const Plan& fPl      = fPart.GetPlan(f);
+                const Buffer* output = fPl.GetOutputBuffer(dsEdge->GetSource());
+                CompatiblePlans cPls;
+                for (PlanId s = 0; s < sPart.GetNumPlans(); ++s)
+                {
+                    PlanCompatibilityResult plCompRes = ArePlansCompatible(fPl, sPart.GetPlan(s), *dsEdge);
+                    if (!plCompRes.m_IsCompatible ||
+                        (reqDram && output->m_Location != Location::Dram && !plCompRes.m_RequiresGlue))
+                    {
+                        continue;
+                    }
+                    const OpGraph::OpList& ops = plCompRes.m_Glue.m_Graph.GetOps();
+                    CompatiblePlan cPl;
+                    cPl.m_Id              = s;
+                    cPl.m_GlueDramTraffic = ops.size() * utils::TotalSizeBytes(output->m_TensorShape);
+                    cPl.m_Glue            = std::make_shared<const Glue>(std::move(plCompRes.m_Glue));
+                    cPls.push_back(std::move(cPl));
+                }
+                if (!cPls.empty())
+                {
+                    comPlsOfPa.emplace(f, std::move(cPls));
+                }
+            }
+            if (!comPlsOfPa.empty())
+            {
+                result[p].m_Comp.emplace(dsEdge, std::move(comPlsOfPa));
+            }
+        }
+    }
+    return result;
+}
+
+/// Combines the given Parts using the given Metadata, in the same way as Cascading::Combine when the search isn't
+/// limited.
+Combinations CombineAll(const GraphOfParts& parts, const Metadata& metadata, const HardwareCapabilities& caps)
+{
+    Combinations combinations = CreateSeeds(parts, metadata, caps);
+    GrownSeeds grownSeeds;
+    do
+    {
+        const size_t limit = (grownSeeds.m_BestScore > 1U) ? (grownSeeds.m_BestScore - 1U) : grownSeeds.m_BestScore;
+        grownSeeds         = GrowSeeds(combinations, parts, limit, metadata, caps);
+        combinations       = std::move(grownSeeds.m_Combinations);
+    } while (!grownSeeds.m_Terminated);
+    return combinations;
+}
+
+/// Checks that two Glues have the same Ops and Buffers (which are all DmaOps and DRAM buffers).
+void CheckSameGlue(const Glue* a, const Glue* b)
+{
+    BOOST_REQUIRE_EQUAL(a == nullptr, b == nullptr);
+    if (a != nullptr)
+    {
+        BOOST_CHECK_EQUAL(a->m_Graph.GetOps().size(), b->m_Graph.GetOps().size());
+        BOOST_CHECK_EQUAL(a->m_Graph.GetBuffers().size(), b->m_Graph.GetBuffers().size());
+    }
+}
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(CombinerTests)
+
+/// Checks the lookups of a combination with enough Parts, added out of order, for most of its changes to be found
+/// through its index, and that a copy of it is unaffected by the changes made to it afterwards.
+BOOST_AUTO_TEST_CASE(CombinationLookups)
+{
+    constexpr size_t numParts = 100;
+    Graph graph;
+    const std::vector<const Edge*> edges = AddChain(graph, numParts + 1);
+
+    // Part p is connected to the plan of Part p - 1 along edges[p - 1] and has visited edges[p]
+    std::vector<PartId> order;
+    for (size_t i = 0; i < numParts; ++i)
+    {
+        order.push_back((i * 37) % numParts);
+    }
+    Combination comb;
+    Combination half;
+    for (size_t i = 0; i < numParts; ++i)
+    {
+        const PartId p = order[i];
+        if (p == 0)
+        {
+            comb.AddElem(p, 0);
+        }
+        else
+        {
+            comb.AddLink(p, p % 3, edges[p - 1], Elem::Link{ (p - 1) % 3, nullptr });
+        }
+        comb.AddVisitedEdge(p, edges[p]);
+        if (i + 1 == numParts / 2)
+        {
+            half = comb;
+        }
+    }
+
+    BOOST_CHECK_EQUAL(comb.GetNumElems(), numParts);
+    BOOST_CHECK_EQUAL(half.GetNumElems(), numParts / 2);
+    for (size_t i = 0; i < numParts; ++i)
+    {
+        const PartId p = order[i];
+        BOOST_CHECK(comb.HasElem(p));
+        BOOST_CHECK_EQUAL(half.HasElem(p), i < numParts / 2);
+        BOOST_CHECK(comb.IsEdgeVisited(p, edges[p]));
+        BOOST_CHECK(!comb.IsEdgeVisited(p, edges[(p + 1) % numParts]));
+        BOOST_CHECK_EQUAL(comb.GetNumVisitedEdges(p), 1);
+        BOOST_CHECK(comb.GetLink(p, edges[p]) == nullptr);
+        if (p > 0)
+        {
+            const Elem::Link* link = comb.GetLink(p, edges[p - 1]);
+            BOOST_REQUIRE(link != nullptr);
+            BOOST_CHECK_EQUAL(link->m_Id, (p - 1) % 3);
+        }
+    }
+
+    const std::vector<Elem> elems = comb.GetElems();
+    BOOST_REQUIRE_EQUAL(elems.size(), numParts);
+    for (size_t i = 0; i < numParts; ++i)
+    {
+        const PartId p = order[i];
+        BOOST_CHECK_EQUAL(elems[i].m_PartId, p);
+        BOOST_CHECK_EQUAL(elems[i].m_PlanId, p % 3);
+        BOOST_CHECK_EQUAL(elems[i].m_Glues.size(), p > 0 ? 1 : 0);
+        if (p > 0)
+        {
+            BOOST_CHECK_EQUAL(elems[i].m_Glues.at(edges[p - 1]).m_Id, (p - 1) % 3);
+        }
+    }
+    BOOST_CHECK_EQUAL(half.GetElems().size(), numParts / 2);
+}
+
+/// Checks that a combination with far more changes than would fit on the stack if they were destroyed recursively
+/// can be destroyed.
+BOOST_AUTO_TEST_CASE(DestroyLongCombination)
+{
+    Graph graph;
+    const std::vector<const Edge*> edges = AddChain(graph, 2);
+
+    auto comb = std::make_unique<Combination>();
+    comb->AddElem(0, 0);
+    for (size_t i = 0; i < 1000000; ++i)
+    {
+        comb->AddVisitedEdge(0, edges[0]);
+    }
+    BOOST_CHECK_EQUAL(comb->GetNumVisitedEdges(0), 1000000);
+    comb.reset();
+}
+
+/// Checks that dynamic programming finds the best ways through the chain regions of a graph which branches into two
+/// chains.
+BOOST_AUTO_TEST_CASE(CombineChainRegionMatchesExhaustiveSearchOnBranchedGraph)
+{
+    SyntheticParts synthetic;
+    const size_t fork = synthetic.AddNode({ synthetic.AddNode({ synthetic.AddNode({}) }) });
+    synthetic.AddNode({ synthetic.AddNode({ synthetic.AddNode({ fork }) }) });
+    synthetic.AddNode({ synthetic.AddNode({ fork }) });
+    CheckCombineChainRegionMatchesExhaustiveSearch(synthetic.CreateParts(4), synthetic.GetCapabilities());
+}
+
+/// Checks that dynamic programming finds the best ways through the chain regions of a graph which branches into two
+/// chains which join again. The branches and the join aren't chain regions themselves, so are searched step by step.
+BOOST_AUTO_TEST_CASE(CombineChainRegionMatchesExhaustiveSearchOnSeriesParallelGraph)
+{
+    SyntheticParts synthetic;
+    const size_t fork  = synthetic.AddNode({ synthetic.AddNode({ synthetic.AddNode({}) }) });
+    const size_t left  = synthetic.AddNode({ synthetic.AddNode({ fork }) });
+    const size_t right = synthetic.AddNode({ synthetic.AddNode({ fork }) });
+    synthetic.AddNode({ synthetic.AddNode({ synthetic.AddNode({ left, right }) }) });
+    CheckCombineChainRegionMatchesExhaustiveSearch(synthetic.CreateParts(4), synthetic.GetCapabilities());
+}
+
+/// Checks that sharing the results of ArePlansCompatible between plans with the same buffers on an Edge gives the same
+/// compatible plans, and so the same combinations, as calling it for every pair of plans.
+BOOST_AUTO_TEST_CASE(CachedCompatibilityMatchesUncached)
+{
+    SyntheticParts synthetic;
+    const size_t fork  = synthetic.AddNode({ synthetic.AddNode({ synthetic.AddNode({}) }) });
+    const size_t left  = synthetic.AddNode({ synthetic.AddNode({ fork }) });
+    const size_t right = synthetic.AddNode({ fork });
+    synthetic.AddNode({ synthetic.AddNode({ left, right }) });
+    const GraphOfParts& parts       = synthetic.CreateParts(4);
+    const HardwareCapabilities caps = synthetic.GetCapabilities();
+
+    const Metadata cached   = CreateMetadata(parts, caps);
+    const Metadata uncached = CreateUncachedMetadata(parts, caps);
+    size_t numCompatiblePlans = 0;
+    for (PartId p = 0; p < parts.GetNumParts(); ++p)
+    {
+        BOOST_REQUIRE_EQUAL(cached[p].m_Comp.size(), uncached[p].m_Comp.size());
+        for (const auto& comPlsOfPa : uncached[p].m_Comp)
+        {
+            const CompatiblePlansOfPart& cachedComPlsOfPa = cached[p].m_Comp.at(comPlsOfPa.first);
+            BOOST_REQUIRE_EQUAL(cachedComPlsOfPa.size(), comPlsOfPa.second.size());
+            for (const auto& cPls : comPlsOfPa.second)
+            {
+                const CompatiblePlans& cachedCPls = cachedComPlsOfPa.at(cPls.first);
+                BOOST_REQUIRE_EQUAL(cachedCPls.size(), cPls.second.size());
+                for (size_t i = 0; i < cPls.second.size(); ++i)
+                {
+                    BOOST_CHECK_EQUAL(cachedCPls[i].m_Id, cPls.second[i].m_Id);
+                    BOOST_CHECK_EQUAL(cachedCPls[i].m_GlueDramTraffic, cPls.second[i].m_GlueDramTraffic);
+                    CheckSameGlue(cachedCPls[i].m_Glue.get(), cPls.second[i].m_Glue.get());
+                }
+                numCompatiblePlans += cPls.second.size();
+            }
+        }
+    }
+    BOOST_CHECK_GT(numCompatiblePlans, 0);
+
+    const Combinations cachedCombinations   = CombineAll(parts, cached, caps);
+    const Combinations uncachedCombinations = CombineAll(parts, uncached, caps);
+    BOOST_REQUIRE(!cachedCombinations.empty());
+    BOOST_REQUIRE_EQUAL(cachedCombinations.size(), uncachedCombinations.size());
+    for (size_t c = 0; c < cachedCombinations.size(); ++c)
+    {
+        const Scratch& cachedScratch   = cachedCombinations[c].m_Scratch;
+        const Scratch& uncachedScratch = uncachedCombinations[c].m_Scratch;
+        BOOST_CHECK_EQUAL(cachedScratch.m_AllocatedSram, uncachedScratch.m_AllocatedSram);
+        BOOST_CHECK_EQUAL(cachedScratch.m_Score, uncachedScratch.m_Score);
+        BOOST_CHECK_EQUAL(cachedScratch.m_MinDramTraffic, uncachedScratch.m_MinDramTraffic);
+
+        const std::vector<Elem> cachedElems   = cachedCombinations[c].GetElems();
+        const std::vector<Elem> uncachedElems = uncachedCombinations[c].GetElems();
+        BOOST_REQUIRE_EQUAL(cachedElems.size(), uncachedElems.size());
+        for (size_t i = 0; i < cachedElems.size(); ++i)
+        {
+            BOOST_CHECK_EQUAL(cachedElems[i].m_PartId, uncachedElems[i].m_PartId);
+            BOOST_CHECK_EQUAL(cachedElems[i].m_PlanId, uncachedElems[i].m_PlanId);
+            BOOST_REQUIRE_EQUAL(cachedElems[i].m_Glues.size(), uncachedElems[i].m_Glues.size());
+            for (const auto& link : uncachedElems[i].m_Glues)
+            {
+                const Elem::Link& cachedLink = cachedElems[i].m_Glues.at(link.first);
+                BOOST_CHECK_EQUAL(cachedLink.m_Id, link.second.m_Id);
+                CheckSameGlue(cachedLink.m_Glue, link.second.m_Glue);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
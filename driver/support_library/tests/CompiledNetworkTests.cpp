@@ -0,0 +1,161 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "BufferManager.hpp"
+#include "Compiler.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+#include <sstream>
+
+using namespace ethosn::support_library;
+
+namespace
+{
+
+/// Creates a CompiledNetwork with a few buffers of each type and some constant data.
+std::unique_ptr<CompiledNetworkImpl> CreateCompiledNetwork()
+{
+    BufferManager bufferManager;
+    bufferManager.AddDramInput(100, 7);
+    bufferManager.AddDramInput(200, 8);
+    const uint32_t output = bufferManager.AddDram(BufferType::Output, 300);
+    bufferManager.ChangeToOutput(output, 9, 1);
+    bufferManager.AddDram(BufferType::Intermediate, 400);
+    for (uint8_t i = 1; i <= 3; ++i)
+    {
+        bufferManager.AddDramConstant(BufferType::ConstantDma, std::make_shared<std::vector<uint8_t>>(50 * i, i));
+        bufferManager.AddDramConstant(BufferType::ConstantControlUnit,
+                                      std::make_shared<std::vector<uint8_t>>(10 * i, static_cast<uint8_t>(10 + i)));
+    }
+    bufferManager.Allocate();
+    return std::make_unique<CompiledNetworkImpl>(bufferManager.TakeConstantDmaData(),
+                                                 bufferManager.TakeConstantControlUnitData(),
+                                                 bufferManager.GetBuffers(), std::set<uint32_t>{});
+}
+
+void CheckSameCompiledNetwork(const CompiledNetwork& actual, const CompiledNetwork& expected)
+{
+    BOOST_CHECK(actual.GetConstantDmaData() == expected.GetConstantDmaData());
+    BOOST_CHECK(actual.GetConstantControlUnitData() == expected.GetConstantControlUnitData());
+    BOOST_CHECK(actual.GetInputBufferInfos() == expected.GetInputBufferInfos());
+    BOOST_CHECK(actual.GetOutputBufferInfos() == expected.GetOutputBufferInfos());
+    BOOST_CHECK(actual.GetConstantControlUnitDataBufferInfos() == expected.GetConstantControlUnitDataBufferInfos());
+    BOOST_CHECK(actual.GetConstantDmaDataBufferInfos() == expected.GetConstantDmaDataBufferInfos());
+    BOOST_CHECK(actual.GetIntermediateDataBufferInfos() == expected.GetIntermediateDataBufferInfos());
+}
+
+template <typename T>
+void WriteLegacy(std::ostream& out, const std::vector<T>& data)
+{
+    const uint32_t size = static_cast<uint32_t>(data.size());
+    out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(T)));
+}
+
+/// Serializes the given CompiledNetwork in the format written before the section table was added, by the given
+/// version of the support library.
+std::string SerializeLegacy(const CompiledNetwork& compiledNetwork, const std::string& version)
+{
+    std::stringstream out;
+    const uint32_t versionSize = static_cast<uint32_t>(version.size());
+    out.write(reinterpret_cast<const char*>(&versionSize), sizeof(versionSize));
+    out.write(version.data(), static_cast<std::streamsize>(version.size()));
+    WriteLegacy(out, compiledNetwork.GetConstantDmaData());
+    WriteLegacy(out, compiledNetwork.GetConstantControlUnitData());
+    WriteLegacy(out, compiledNetwork.GetInputBufferInfos());
+    WriteLegacy(out, compiledNetwork.GetOutputBufferInfos());
+    WriteLegacy(out, compiledNetwork.GetConstantControlUnitDataBufferInfos());
+    WriteLegacy(out, compiledNetwork.GetConstantDmaDataBufferInfos());
+    WriteLegacy(out, compiledNetwork.GetIntermediateDataBufferInfos());
+    return out.str();
+}
+
+std::unique_ptr<CompiledNetwork> DeserializeFromStream(const std::string& data)
+{
+    std::stringstream in(data);
+    return DeserializeCompiledNetwork(in);
+}
+
+std::unique_ptr<CompiledNetwork> DeserializeFromMemory(const std::string& data)
+{
+    return DeserializeCompiledNetwork(data.data(), data.size());
+}
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(CompiledNetworkTests)
+
+/// Checks that a CompiledNetwork reads back the same as it was written, from both a stream and memory.
+BOOST_AUTO_TEST_CASE(SerializeRoundTrip)
+{
+    const std::unique_ptr<CompiledNetworkImpl> compiledNetwork = CreateCompiledNetwork();
+    BOOST_REQUIRE_EQUAL(compiledNetwork->GetConstantDmaDataBufferInfos().size(), 3);
+    std::stringstream out;
+    compiledNetwork->Serialize(out);
+    const std::string serialized = out.str();
+
+    CheckSameCompiledNetwork(*DeserializeFromStream(serialized), *compiledNetwork);
+    CheckSameCompiledNetwork(*DeserializeFromMemory(serialized), *compiledNetwork);
+}
+
+/// Checks that data written in the legacy format by 0.x versions of the support library can still be read, but data
+/// claiming to be written in that format by other major versions can't.
+BOOST_AUTO_TEST_CASE(DeserializeLegacy)
+{
+    const std::unique_ptr<CompiledNetworkImpl> compiledNetwork = CreateCompiledNetwork();
+    for (const char* version : { "0.1.1", "0.0.3", "0.2.0" })
+    {
+        BOOST_TEST_CONTEXT(version)
+        {
+            const std::string serialized = SerializeLegacy(*compiledNetwork, version);
+            CheckSameCompiledNetwork(*DeserializeFromStream(serialized), *compiledNetwork);
+            CheckSameCompiledNetwork(*DeserializeFromMemory(serialized), *compiledNetwork);
+        }
+    }
+
+    const std::string serialized = SerializeLegacy(*compiledNetwork, "1.0.0");
+    BOOST_CHECK_THROW(DeserializeFromStream(serialized), VersionMismatchException);
+    BOOST_CHECK_THROW(DeserializeFromMemory(serialized), VersionMismatchException);
+}
+
+/// Checks that every truncation of the data, in either format, is rejected rather than read as zeros or garbage.
+BOOST_AUTO_TEST_CASE(DeserializeTruncated)
+{
+    const std::unique_ptr<CompiledNetworkImpl> compiledNetwork = CreateCompiledNetwork();
+    std::stringstream out;
+    compiledNetwork->Serialize(out);
+    for (const std::string& serialized : { out.str(), SerializeLegacy(*compiledNetwork, "0.1.1") })
+    {
+        for (size_t size = 0; size < serialized.size(); ++size)
+        {
+            BOOST_TEST_CONTEXT(size)
+            {
+                const std::string truncated = serialized.substr(0, size);
+                BOOST_CHECK_THROW(DeserializeFromStream(truncated), std::invalid_argument);
+                BOOST_CHECK_THROW(DeserializeFromMemory(truncated), std::invalid_argument);
+            }
+        }
+    }
+}
+
+/// Checks that a count in the legacy format which is bigger than the rest of the data is rejected before anything
+/// is allocated for it.
+BOOST_AUTO_TEST_CASE(DeserializeLegacyHugeCount)
+{
+    const std::unique_ptr<CompiledNetworkImpl> compiledNetwork = CreateCompiledNetwork();
+    std::string serialized = SerializeLegacy(*compiledNetwork, "0.1.1");
+    // The count of the input buffer infos follows the version string and the constant data.
+    const size_t offset = sizeof(uint32_t) + 5 + sizeof(uint32_t) + compiledNetwork->GetConstantDmaData().size() +
+                          sizeof(uint32_t) + compiledNetwork->GetConstantControlUnitData().size();
+    const uint32_t hugeCount = 0xFFFFFFF0;
+    std::memcpy(&serialized[offset], &hugeCount, sizeof(hugeCount));
+
+    BOOST_CHECK_THROW(DeserializeFromStream(serialized), std::invalid_argument);
+    BOOST_CHECK_THROW(DeserializeFromMemory(serialized), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,268 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "TestUtils.hpp"
+
+#include "CapabilitiesInternal.hpp"
+#include "Compiler.hpp"
+#include "Graph.hpp"
+#include "GraphNodes.hpp"
+#include "McePlePass.hpp"
+#include "Optimization.hpp"
+#include "SramAllocator.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include "WeightEncoderCache.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ethosn::support_library;
+using namespace testing_utils;
+
+namespace
+{
+
+/// Everything needed to create the McePlePass of the convolution in a network of a single convolution.
+class SingleConvolution
+{
+public:
+    SingleConvolution(uint32_t size,
+                      uint32_t channels,
+                      const EstimationOptions& estimationOptions = EstimationOptions())
+        : m_Network(CreateConvolutionChain(1, size, channels))
+        , m_CompilationOptions(CreateCompilationOptions())
+        , m_Capabilities(GetEthosN77FwHwCapabilities())
+        , m_Strategies(GenerateAllowedStrategies(m_CompilationOptions))
+        , m_BlockConfigs(GenerateAllowedBlockConfigs(m_CompilationOptions))
+        , m_EstimationOptions(estimationOptions)
+        , m_ThreadPool(1)
+        , m_WeightEncoderCache(CreateWeightEncoderCache())
+        , m_Graph(*m_Network, m_Capabilities, EstimationOptions())
+    {
+        ApplyAllOptimizations(m_Graph);
+    }
+
+    /// Creates the pass, choosing its strategy and block config by cost or not, and returns its dot label, which
+    /// shows the strategy (and, when chosen by cost, the block config and its cost).
+    std::string CreatePass(bool selectStrategyByCost)
+    {
+        for (Node* node : m_Graph.GetNodesSorted())
+        {
+            if (dynamic_cast<MceOperationNode*>(node) == nullptr)
+            {
+                continue;
+            }
+            SramAllocator sramAllocator(m_Capabilities.GetTotalSramSize() / m_Capabilities.GetNumberOfSrams());
+            std::unique_ptr<McePlePass> pass = McePlePass::CreateGreedily(
+                m_Capabilities, 0, utils::GetRawPointers(m_Strategies), m_BlockConfigs, true, true,
+                selectStrategyByCost, m_EstimationOptions, node, sramAllocator, false, m_ThreadPool,
+                *m_WeightEncoderCache);
+            BOOST_REQUIRE(pass != nullptr);
+            const std::string label = pass->GetDotAttributes().m_Label;
+            // The label starts with the name and id of the pass, which depend on the order the tests run in.
+            return label.substr(label.find("STRATEGY"));
+        }
+        BOOST_FAIL("No convolution");
+        return {};
+    }
+
+private:
+    std::shared_ptr<Network> m_Network;
+    CompilationOptions m_CompilationOptions;
+    HardwareCapabilities m_Capabilities;
+    std::vector<std::unique_ptr<IStrategy>> m_Strategies;
+    std::vector<ethosn::command_stream::BlockConfig> m_BlockConfigs;
+    EstimationOptions m_EstimationOptions;
+    ThreadPool m_ThreadPool;
+    std::shared_ptr<WeightEncoderCache> m_WeightEncoderCache;
+    Graph m_Graph;
+};
+
+/// A strategy which allocates a fixed number of bytes per element of the block, so that how much SRAM each strategy
+/// and block config pair uses is known, and which records the pair in the TensorConfig.
+class FixedSizeStrategy : public IStrategy
+{
+public:
+    FixedSizeStrategy(Strategy strategy, uint32_t bytesPerBlockElement)
+        : m_Strategy(strategy)
+        , m_BytesPerBlockElement(bytesPerBlockElement)
+    {}
+
+    bool TrySetup(TensorConfig& tensorConfig,
+                  SramAllocator& sramAllocator,
+                  const TensorShape&,
+                  const TensorShape&,
+                  DataFormat,
+                  const TensorShape&,
+                  const ethosn::command_stream::BlockConfig& blockConfig,
+                  const HardwareCapabilities&,
+                  const utils::ShapeMultiplier&,
+                  std::pair<bool, uint32_t>,
+                  CompilerMceAlgorithm,
+                  const uint32_t) override
+    {
+        const uint32_t size = m_BytesPerBlockElement * blockConfig.m_BlockWidth() * blockConfig.m_BlockHeight();
+        const std::pair<bool, uint32_t> allocation = sramAllocator.Allocate(size);
+        if (!allocation.first)
+        {
+            return false;
+        }
+        tensorConfig.strategy                    = m_Strategy;
+        tensorConfig.blockWidth                  = blockConfig.m_BlockWidth();
+        tensorConfig.blockHeight                 = blockConfig.m_BlockHeight();
+        tensorConfig.inputAllocation.offset      = allocation.second;
+        tensorConfig.inputAllocation.stripeShape = TensorShape{ 1, 1, 1, size };
+        return true;
+    }
+
+    const char* GetStrategyString() override
+    {
+        return "FIXED_SIZE";
+    }
+
+private:
+    Strategy m_Strategy;
+    uint32_t m_BytesPerBlockElement;
+};
+
+/// Calls ChooseAndSetupStrategyByCost with the given strategies, the 8x8, 16x8 and 8x16 block configs and getCost.
+bool ChooseByCost(SramAllocator& sramAllocator,
+                  const std::vector<IStrategy*>& strategies,
+                  const std::function<uint64_t(const TensorConfig&)>& getCost,
+                  TensorConfig& tensorConfig,
+                  StrategySelectionCost& selectionCost)
+{
+    const std::vector<ethosn::command_stream::BlockConfig> blockConfigs{ { 8u, 8u }, { 16u, 8u }, { 8u, 16u } };
+    const TensorShape shape{ 1, 16, 16, 16 };
+    return McePlePass::ChooseAndSetupStrategyByCost(
+        GetEthosN77FwHwCapabilities(), sramAllocator, strategies, blockConfigs, tensorConfig, shape, shape,
+        DataFormat::HWIO, TensorShape{ 1, 1, 16, 16 }, utils::g_IdentityShapeMultiplier, { false, 0 },
+        CompilerMceAlgorithm::Direct, UINT32_MAX, getCost, selectionCost);
+}
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(McePlePassTests)
+
+/// Checks that the performance metric counts the bytes of inputs, outputs and weights transferred to and from DRAM
+/// once each, and nothing else.
+BOOST_AUTO_TEST_CASE(GetPerformanceDataMetricCountsEachDramTransferOnce)
+{
+    PassStats stats;
+    stats.m_Input.m_MemoryStats.m_DramParallel      = 1;
+    stats.m_Input.m_MemoryStats.m_DramNonParallel   = 10;
+    stats.m_Input.m_MemoryStats.m_Sram              = 100000;
+    stats.m_Output.m_MemoryStats.m_DramParallel     = 100;
+    stats.m_Output.m_MemoryStats.m_DramNonParallel  = 1000;
+    stats.m_Output.m_MemoryStats.m_Sram             = 200000;
+    stats.m_Weights.m_MemoryStats.m_DramParallel    = 10000;
+    stats.m_Weights.m_MemoryStats.m_DramNonParallel = 20000;
+    stats.m_Weights.m_MemoryStats.m_Sram            = 300000;
+    stats.m_Mce.m_CycleCount                        = 400000;
+
+    BOOST_CHECK_EQUAL(utils::GetPerformanceDataMetric(stats), 31111);
+}
+
+/// Checks the strategy and block config chosen by cost for convolutions of different sizes, and their costs, so that
+/// changes to the performance metric which change these choices are noticed.
+BOOST_AUTO_TEST_CASE(SelectStrategyByCost)
+{
+    BOOST_CHECK_EQUAL(SingleConvolution(16, 16).CreatePass(true),
+                      "STRATEGY_3\nBlock 8x16, chosen by cost 1792 of 12 candidates");
+    BOOST_CHECK_EQUAL(SingleConvolution(32, 256).CreatePass(true),
+                      "STRATEGY_0\nBlock 16x8, chosen by cost 488960 of 11 candidates");
+    BOOST_CHECK_EQUAL(SingleConvolution(128, 64).CreatePass(true),
+                      "STRATEGY_0\nBlock 8x16, chosen by cost 1063936 of 9 candidates");
+    BOOST_CHECK_EQUAL(SingleConvolution(64, 256).CreatePass(true),
+                      "STRATEGY_6\nBlock 8x16, chosen by cost 1275392 of 6 candidates");
+
+    // When not chosen by cost, only the strategy is shown.
+    BOOST_CHECK_EQUAL(SingleConvolution(16, 16).CreatePass(false), "STRATEGY_3");
+}
+
+/// Checks that the strategy and block config pair with the lowest cost is set up, from the same state of the
+/// SramAllocator as if it had been the only one tried, and that pairs which don't fit aren't candidates.
+BOOST_AUTO_TEST_CASE(ChooseAndSetupStrategyByCostChoosesTheCheapest)
+{
+    FixedSizeStrategy strategy0(Strategy::STRATEGY_0, 4);
+    FixedSizeStrategy strategy1(Strategy::STRATEGY_1, 2);
+    FixedSizeStrategy strategy3(Strategy::STRATEGY_3, 8);
+    const std::vector<IStrategy*> strategies{ &strategy0, &strategy1, &strategy3 };
+    // The cheapest pair is neither the first nor the last tried, nor the one which uses the least SRAM. The STRATEGY_3
+    // pairs would be cheaper still, but only fit with the 8x8 block config.
+    auto getCost = [](const TensorConfig& tensorConfig) -> uint64_t {
+        if (tensorConfig.strategy == Strategy::STRATEGY_3)
+        {
+            return tensorConfig.blockWidth * tensorConfig.blockHeight == 64 ? 50 : 0;
+        }
+        const uint64_t strategyCost = tensorConfig.strategy == Strategy::STRATEGY_1 ? 100 : 200;
+        return strategyCost - tensorConfig.blockWidth;
+    };
+
+    const uint32_t capacity = 1024;
+    SramAllocator sramAllocator(capacity);
+    const std::pair<bool, uint32_t> existing = sramAllocator.Allocate(128);
+    BOOST_REQUIRE(existing.first);
+    TensorConfig tensorConfig;
+    StrategySelectionCost selectionCost;
+    BOOST_REQUIRE(ChooseByCost(sramAllocator, strategies, getCost, tensorConfig, selectionCost));
+
+    BOOST_CHECK(tensorConfig.strategy == Strategy::STRATEGY_3);
+    BOOST_CHECK_EQUAL(tensorConfig.blockWidth, 8);
+    BOOST_CHECK_EQUAL(tensorConfig.blockHeight, 8);
+    BOOST_CHECK_EQUAL(selectionCost.m_Metric, 50);
+    BOOST_CHECK_EQUAL(selectionCost.m_NumCandidates, 7);
+
+    // The same as setting up only the chosen pair.
+    SramAllocator expectedSramAllocator(capacity);
+    BOOST_REQUIRE(expectedSramAllocator.Allocate(128).first);
+    TensorConfig expectedTensorConfig;
+    StrategySelectionCost expectedSelectionCost;
+    BOOST_REQUIRE(ChooseByCost(expectedSramAllocator, { &strategy3 }, getCost, expectedTensorConfig,
+                               expectedSelectionCost));
+    BOOST_CHECK_EQUAL(tensorConfig.inputAllocation.offset, expectedTensorConfig.inputAllocation.offset);
+    BOOST_CHECK_EQUAL(sramAllocator.GetUsage().m_UsedBytes, expectedSramAllocator.GetUsage().m_UsedBytes);
+    BOOST_CHECK_EQUAL(sramAllocator.GetUsage().m_UsedBytes, 128 + 8 * 8 * 8);
+    BOOST_CHECK_EQUAL(sramAllocator.DumpUsage(), expectedSramAllocator.DumpUsage());
+
+    // Without STRATEGY_3, the cheapest is STRATEGY_1 with the 16x8 block config.
+    SramAllocator otherSramAllocator(capacity);
+    BOOST_REQUIRE(ChooseByCost(otherSramAllocator, { &strategy0, &strategy1 }, getCost, tensorConfig, selectionCost));
+    BOOST_CHECK(tensorConfig.strategy == Strategy::STRATEGY_1);
+    BOOST_CHECK_EQUAL(tensorConfig.blockWidth, 16);
+    BOOST_CHECK_EQUAL(selectionCost.m_Metric, 84);
+    BOOST_CHECK_EQUAL(selectionCost.m_NumCandidates, 6);
+    BOOST_CHECK_EQUAL(otherSramAllocator.GetUsage().m_UsedBytes, 2 * 16 * 8);
+}
+
+/// Checks that the SramAllocator is left as it was when no strategy and block config pair fits.
+BOOST_AUTO_TEST_CASE(ChooseAndSetupStrategyByCostLeavesSramUnchangedWhenNothingFits)
+{
+    FixedSizeStrategy strategy0(Strategy::STRATEGY_0, 16);
+    const std::vector<IStrategy*> strategies{ &strategy0 };
+    SramAllocator sramAllocator(1024);
+    BOOST_REQUIRE(sramAllocator.Allocate(100).first);
+    const std::string before = sramAllocator.DumpUsage();
+
+    TensorConfig tensorConfig;
+    StrategySelectionCost selectionCost;
+    BOOST_CHECK(!ChooseByCost(
+        sramAllocator, strategies, [](const TensorConfig&) -> uint64_t { return 0; }, tensorConfig, selectionCost));
+    BOOST_CHECK_EQUAL(selectionCost.m_NumCandidates, 0);
+    BOOST_CHECK_EQUAL(sramAllocator.DumpUsage(), before);
+    BOOST_CHECK_EQUAL(sramAllocator.GetUsage().m_UsedBytes, 100);
+}
+
+/// Checks that the strategy costs are estimated with the EstimationOptions given, rather than the defaults.
+BOOST_AUTO_TEST_CASE(SelectStrategyByCostUsesEstimationOptions)
+{
+    EstimationOptions estimationOptions;
+    estimationOptions.m_UseWeightCompressionOverride = true;
+    estimationOptions.m_WeightCompressionSaving      = 0.5f;
+    BOOST_CHECK_NE(SingleConvolution(16, 16, estimationOptions).CreatePass(true),
+                   SingleConvolution(16, 16).CreatePass(true));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "GraphNodes.hpp"
+#include "Optimization.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ethosn::support_library;
+
+namespace
+{
+
+Node* AddNode(Graph& graph)
+{
+    return graph.CreateAndAddNode<RequantizeNode>(TensorShape{ 1, 8, 8, 16 }, DataType::UINT8_QUANTIZED,
+                                                  QuantizationInfo(0, 1.0f), CompilerDataFormat::NHWCB,
+                                                  std::set<uint32_t>{ 0 });
+}
+
+std::vector<Node*> AddChain(Graph& graph, size_t length)
+{
+    std::vector<Node*> chain;
+    for (size_t i = 0; i < length; ++i)
+    {
+        chain.push_back(AddNode(graph));
+        if (i > 0)
+        {
+            graph.Connect(chain[i - 1], chain[i]);
+        }
+    }
+    return chain;
+}
+
+/// Checks that the order kept by the worklist is a topological order of the graph as it is now.
+void CheckOrder(const Graph& graph, const OptimizationWorklist& worklist)
+{
+    for (const std::unique_ptr<Edge>& edge : graph.GetEdges())
+    {
+        BOOST_CHECK(worklist.IsBefore(edge->GetSource(), edge->GetDestination()));
+    }
+}
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(OptimizationTests)
+
+/// Checks that the worklist keeps a topological order of the graph as it is changed, and visits the nodes in that
+/// order.
+BOOST_AUTO_TEST_CASE(OptimizationWorklistMaintainsTopologicalOrder)
+{
+    Graph graph;
+    std::vector<Node*> a = AddChain(graph, 4);
+    std::vector<Node*> b = AddChain(graph, 4);
+
+    OptimizationWorklist worklist(graph);
+    CheckOrder(graph, worklist);
+
+    // Join the chains the opposite way to how they were first ordered, so that one of them has to be moved.
+    if (worklist.IsBefore(a.back(), b.front()))
+    {
+        std::swap(a, b);
+    }
+    graph.Connect(a.back(), b.front());
+    CheckOrder(graph, worklist);
+
+    // A new node is placed next to the first node it is connected to.
+    Node* split = AddNode(graph);
+    graph.SplitEdge(b[2]->GetInput(0), split);
+    CheckOrder(graph, worklist);
+
+    Node* inserted = AddNode(graph);
+    graph.InsertNodeAfter(a[0], inserted);
+    CheckOrder(graph, worklist);
+
+    // Adding an edge between two new nodes, and from them into the graph.
+    Node* c0 = AddNode(graph);
+    Node* c1 = AddNode(graph);
+    graph.Connect(c0, c1);
+    graph.Connect(c1, a[0]);
+    CheckOrder(graph, worklist);
+
+    graph.CollapseNode(b[1]);
+    CheckOrder(graph, worklist);
+
+    // Everything still to be visited comes out in order, including the nodes affected by the changes.
+    worklist.QueueAffectedNodes();
+    std::set<Node*> visited;
+    while (Node* node = worklist.Pop())
+    {
+        for (Edge* input : node->GetInputs())
+        {
+            BOOST_CHECK(visited.count(input->GetSource()) > 0);
+        }
+        visited.insert(node);
+    }
+    BOOST_CHECK_EQUAL(visited.size(), graph.GetNodes().size());
+}
+
+/// Checks that ApplyOptimizations keeps applying a rule until it no longer applies anywhere.
+BOOST_AUTO_TEST_CASE(ApplyOptimizationsMergesChain)
+{
+    Graph graph;
+    std::vector<Node*> chain = AddChain(graph, 50);
+    Node* other              = AddNode(graph);
+    graph.Connect(chain[10], other);
+
+    ApplyOptimizations(graph, { MergeRequantizeNodes });
+
+    // The node with two outputs can't be merged, so the chain is merged up to it and after it.
+    BOOST_CHECK_EQUAL(graph.GetNodes().size(), 3);
+    BOOST_CHECK_EQUAL(graph.GetEdges().size(), 2);
+    BOOST_CHECK_EQUAL(chain[10]->GetOutputs().size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
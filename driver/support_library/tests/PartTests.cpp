@@ -0,0 +1,173 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "CapabilitiesInternal.hpp"
+#include "GraphNodes.hpp"
+#include "WeightEncoder.hpp"
+#include "cascading/Part.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+using namespace ethosn::support_library;
+
+namespace
+{
+
+/// The properties of a plan which RemoveDominatedPlans compares.
+struct PlanDesc
+{
+    /// The size of the input buffer, which is a boundary buffer of the plan.
+    uint32_t m_InputSizeInBytes;
+    /// The size and lifetime of the weights buffer in SRAM, which is internal to the plan.
+    uint32_t m_WeightsSizeInBytes;
+    Lifetime m_WeightsLifetime;
+    /// The size of the encoded weights, which are loaded from DRAM.
+    uint32_t m_EncodedWeightsSizeInBytes;
+};
+
+/// Everything the plans of a Part for a single convolution refer to.
+class PartTest
+{
+public:
+    PartTest()
+        : m_Capabilities(GetEthosN77FwHwCapabilities())
+    {
+        Node* input = AddNode();
+        m_Output    = AddNode();
+        m_Graph.Connect(input, m_Output);
+        m_Input = m_Output->GetInput(0);
+        m_Part.m_SubGraph.push_back(m_Output);
+    }
+
+    /// Adds a plan which consumes the input Edge with an MceOp whose weights are loaded from DRAM.
+    const Plan* AddPlan(const PlanDesc& desc)
+    {
+        const TensorShape shape{ 1, 8, 8, 16 };
+        const TensorShape weightsShape{ 3, 3, 16, 16 };
+        auto plan = std::make_unique<Plan>();
+
+        Buffer* input = plan->m_OpGraph.AddBuffer(
+            std::make_unique<Buffer>(Lifetime::Cascade, Location::Sram, CompilerDataFormat::NHWCB, shape, shape,
+                                     TraversalOrder::Xyz, desc.m_InputSizeInBytes, QuantizationInfo(0, 1.0f)));
+        Buffer* weightsDram = plan->m_OpGraph.AddBuffer(
+            std::make_unique<Buffer>(Lifetime::Cascade, Location::Dram, CompilerDataFormat::WEIGHT, weightsShape,
+                                     weightsShape, TraversalOrder::Xyz, 0, QuantizationInfo(0, 1.0f)));
+        weightsDram->m_EncodedWeightsSize = std::make_unique<EncodedWeightsSize>(
+            EncodedWeightsSize{ { { 0, desc.m_EncodedWeightsSizeInBytes } },
+                                desc.m_EncodedWeightsSizeInBytes,
+                                desc.m_EncodedWeightsSizeInBytes });
+        Buffer* weightsSram = plan->m_OpGraph.AddBuffer(std::make_unique<Buffer>(
+            desc.m_WeightsLifetime, Location::Sram, CompilerDataFormat::WEIGHT, weightsShape, weightsShape,
+            TraversalOrder::Xyz, desc.m_WeightsSizeInBytes, QuantizationInfo(0, 1.0f)));
+        Buffer* output = plan->m_OpGraph.AddBuffer(
+            std::make_unique<Buffer>(Lifetime::Cascade, Location::Sram, CompilerDataFormat::NHWCB, shape, shape,
+                                     TraversalOrder::Xyz, 1024, QuantizationInfo(0, 1.0f)));
+
+        Op* dma = plan->m_OpGraph.AddOp(std::make_unique<DmaOp>(Lifetime::Cascade, Location::Sram));
+        Op* mce = plan->m_OpGraph.AddOp(std::make_unique<MceOp>());
+        plan->m_OpGraph.AddConsumer(weightsDram, dma, 0);
+        plan->m_OpGraph.SetProducer(weightsSram, dma);
+        plan->m_OpGraph.AddConsumer(input, mce, 0);
+        plan->m_OpGraph.AddConsumer(weightsSram, mce, 1);
+        plan->m_OpGraph.SetProducer(output, mce);
+
+        plan->m_InputMappings[input]   = m_Input;
+        plan->m_OutputMappings[output] = m_Output;
+        m_Part.m_Plans.push_back(std::move(plan));
+        return m_Part.m_Plans.back().get();
+    }
+
+    /// Removes the dominated plans and returns those which remain, in order.
+    std::vector<const Plan*> RemoveDominatedPlans()
+    {
+        m_Part.RemoveDominatedPlans(m_Capabilities);
+        std::vector<const Plan*> result;
+        for (auto&& plan : m_Part.m_Plans)
+        {
+            result.push_back(plan.get());
+        }
+        return result;
+    }
+
+    const Part& GetPart() const
+    {
+        return m_Part;
+    }
+
+private:
+    Node* AddNode()
+    {
+        return m_Graph.CreateAndAddNode<RequantizeNode>(
+            TensorShape{ 1, 8, 8, 16 }, ethosn::support_library::DataType::UINT8_QUANTIZED, QuantizationInfo(0, 1.0f),
+            CompilerDataFormat::NHWCB, std::set<uint32_t>{ 0 });
+    }
+
+    HardwareCapabilities m_Capabilities;
+    Graph m_Graph;
+    Edge* m_Input;
+    Node* m_Output;
+    Part m_Part;
+};
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(PartTests)
+
+/// Checks that plans which use more SRAM or load more weights from DRAM than another plan with the same boundary
+/// buffers, and no less of the other, are removed and the rest keep their order.
+BOOST_AUTO_TEST_CASE(RemoveDominatedPlansRemovesDominatedPlans)
+{
+    PartTest test;
+    test.AddPlan({ 1024, 2048, Lifetime::Cascade, 1000 });
+    const Plan* best = test.AddPlan({ 1024, 1024, Lifetime::Cascade, 1000 });
+    test.AddPlan({ 1024, 1024, Lifetime::Cascade, 2000 });
+    const Plan* equalBest = test.AddPlan({ 1024, 1024, Lifetime::Cascade, 1000 });
+
+    // Plans which are equally good do not dominate each other.
+    const std::vector<const Plan*> expected{ best, equalBest };
+    const std::vector<const Plan*> remaining = test.RemoveDominatedPlans();
+    BOOST_CHECK(remaining == expected);
+    BOOST_CHECK_EQUAL(test.GetPart().GetNumDominatedPlans(), 2);
+}
+
+/// Checks that plans are kept, however much SRAM or DRAM traffic they use, when they have different boundary buffers
+/// to every better plan or when they are better than it in some other way.
+BOOST_AUTO_TEST_CASE(RemoveDominatedPlansKeepsPlansWhichAreNotDominated)
+{
+    PartTest test;
+    const Plan* small            = test.AddPlan({ 1024, 1024, Lifetime::Cascade, 1000 });
+    const Plan* otherBoundary    = test.AddPlan({ 2048, 2048, Lifetime::Cascade, 2000 });
+    const Plan* moreSramLessDram = test.AddPlan({ 1024, 2048, Lifetime::Cascade, 500 });
+    const Plan* lessSramMoreDram = test.AddPlan({ 1024, 512, Lifetime::Cascade, 4000 });
+
+    const std::vector<const Plan*> expected{ small, otherBoundary, moreSramLessDram, lessSramMoreDram };
+    const std::vector<const Plan*> remaining = test.RemoveDominatedPlans();
+    BOOST_CHECK(remaining == expected);
+    BOOST_CHECK_EQUAL(test.GetPart().GetNumDominatedPlans(), 0);
+}
+
+/// Checks that a plan which uses less SRAM in total does not dominate one which leaves less SRAM allocated for the
+/// plans merged after it because more of its buffers are atomic.
+BOOST_AUTO_TEST_CASE(RemoveDominatedPlansComparesNonAtomicSize)
+{
+    PartTest test;
+    const Plan* atomic  = test.AddPlan({ 1024, 2048, Lifetime::Atomic, 1000 });
+    const Plan* cascade = test.AddPlan({ 1024, 1024, Lifetime::Cascade, 1000 });
+
+    const std::vector<const Plan*> expected{ atomic, cascade };
+    const std::vector<const Plan*> remaining = test.RemoveDominatedPlans();
+    BOOST_CHECK(remaining == expected);
+
+    // When the total sizes are equal, the plan with the smaller non-atomic size does dominate.
+    PartTest equalSizeTest;
+    const Plan* equalAtomic = equalSizeTest.AddPlan({ 1024, 1024, Lifetime::Atomic, 1000 });
+    equalSizeTest.AddPlan({ 1024, 1024, Lifetime::Cascade, 1000 });
+
+    const std::vector<const Plan*> expectedEqualSize{ equalAtomic };
+    const std::vector<const Plan*> remainingEqualSize = equalSizeTest.RemoveDominatedPlans();
+    BOOST_CHECK(remainingEqualSize == expectedEqualSize);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
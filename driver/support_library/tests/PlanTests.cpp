@@ -0,0 +1,238 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "GraphNodes.hpp"
+#include "cascading/Cascading.hpp"
+#include "cascading/Combiner.hpp"
+#include "cascading/Plan.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+using namespace ethosn::support_library;
+
+namespace
+{
+
+/// Creates a Buffer of a fixed shape in the given location, which only takes up space if it is in SRAM.
+std::unique_ptr<Buffer> CreateBuffer(Location location)
+{
+    const TensorShape shape{ 1, 8, 8, 16 };
+    return std::make_unique<Buffer>(Lifetime::Cascade, location, CompilerDataFormat::NHWCB, shape, shape,
+                                    TraversalOrder::Xyz, location == Location::Sram ? 1024 : 0,
+                                    QuantizationInfo(0, 1.0f));
+}
+
+/// Checks that every connection of the given graph can be found from both of the Op and the Buffer it connects, and
+/// that everything it connects is part of the graph.
+void CheckConnectionsAreConsistent(const OpGraph& graph)
+{
+    size_t numInputs = 0;
+    for (Op* op : graph.GetOps())
+    {
+        BOOST_CHECK(graph.Contains(op));
+        const OpGraph::BufferList& inputs = graph.GetInputs(op);
+        for (uint32_t i = 0; i < inputs.size(); ++i)
+        {
+            BOOST_REQUIRE(inputs[i] != nullptr);
+            BOOST_CHECK(graph.Contains(inputs[i]));
+            const OpGraph::ConsumersList& consumers = graph.GetConsumers(inputs[i]);
+            BOOST_CHECK(std::find(consumers.begin(), consumers.end(), std::make_pair(op, i)) != consumers.end());
+        }
+        numInputs += inputs.size();
+
+        Buffer* output = graph.GetOutput(op);
+        if (output != nullptr)
+        {
+            BOOST_CHECK(graph.Contains(output));
+            BOOST_CHECK(graph.GetProducer(output) == op);
+        }
+    }
+
+    size_t numConsumers = 0;
+    for (Buffer* buffer : graph.GetBuffers())
+    {
+        BOOST_CHECK(graph.Contains(buffer));
+        Op* producer = graph.GetProducer(buffer);
+        if (producer != nullptr)
+        {
+            BOOST_CHECK(graph.Contains(producer));
+            BOOST_CHECK(graph.GetOutput(producer) == buffer);
+        }
+        for (const std::pair<Op*, uint32_t>& consumer : graph.GetConsumers(buffer))
+        {
+            BOOST_REQUIRE(graph.Contains(consumer.first));
+            BOOST_REQUIRE_LT(consumer.second, graph.GetInputs(consumer.first).size());
+            BOOST_CHECK(graph.GetInputs(consumer.first)[consumer.second] == buffer);
+        }
+        numConsumers += graph.GetConsumers(buffer).size();
+    }
+    BOOST_CHECK_EQUAL(numInputs, numConsumers);
+}
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(PlanTests)
+
+/// Checks that Ops and Buffers are indexed in the order they are added, start with no connections and can't be added
+/// twice, and that Ops and Buffers which aren't part of the graph have no connections.
+BOOST_AUTO_TEST_CASE(OpGraphAddOpAndAddBuffer)
+{
+    OwnedOpGraph graph;
+    std::vector<Op*> ops;
+    std::vector<Buffer*> buffers;
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        ops.push_back(graph.AddOp(std::make_unique<MceOp>()));
+        buffers.push_back(graph.AddBuffer(CreateBuffer(Location::Sram)));
+    }
+
+    BOOST_CHECK(graph.GetOps() == ops);
+    BOOST_CHECK(graph.GetBuffers() == buffers);
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        BOOST_CHECK(graph.GetInputs(ops[i]).empty());
+        BOOST_CHECK(graph.GetOutput(ops[i]) == nullptr);
+        BOOST_CHECK(graph.GetProducer(buffers[i]) == nullptr);
+        BOOST_CHECK(graph.GetConsumers(buffers[i]).empty());
+    }
+    BOOST_CHECK_THROW(graph.OpGraph::AddOp(ops[3]), std::runtime_error);
+    BOOST_CHECK_THROW(graph.OpGraph::AddBuffer(buffers[3]), std::runtime_error);
+    BOOST_CHECK(graph.GetOps() == ops);
+    BOOST_CHECK(graph.GetBuffers() == buffers);
+
+    MceOp otherOp;
+    std::unique_ptr<Buffer> otherBuffer = CreateBuffer(Location::Sram);
+    BOOST_CHECK(!graph.Contains(&otherOp));
+    BOOST_CHECK(!graph.Contains(otherBuffer.get()));
+    BOOST_CHECK(graph.GetInputs(&otherOp).empty());
+    BOOST_CHECK(graph.GetOutput(&otherOp) == nullptr);
+    BOOST_CHECK(graph.GetProducer(otherBuffer.get()) == nullptr);
+    BOOST_CHECK(graph.GetConsumers(otherBuffer.get()).empty());
+    CheckConnectionsAreConsistent(graph);
+}
+
+/// Checks that connections made with SetProducer and AddConsumer can be found from both ends, including after more
+/// Ops and Buffers have been added, and that a connection which is rejected leaves the graph unchanged.
+BOOST_AUTO_TEST_CASE(OpGraphAddConsumerAndSetProducer)
+{
+    OwnedOpGraph graph;
+    Buffer* input   = graph.AddBuffer(CreateBuffer(Location::Sram));
+    Buffer* weights = graph.AddBuffer(CreateBuffer(Location::Sram));
+    Op* mce         = graph.AddOp(std::make_unique<MceOp>());
+    Buffer* output  = graph.AddBuffer(CreateBuffer(Location::Sram));
+    graph.AddConsumer(input, mce, 0);
+    graph.AddConsumer(weights, mce, 1);
+    graph.SetProducer(output, mce);
+    CheckConnectionsAreConsistent(graph);
+
+    // Adding many more Ops and Buffers grows the storage of the connections.
+    Op* prev = mce;
+    for (uint32_t i = 0; i < 100; ++i)
+    {
+        Op* op         = graph.AddOp(std::make_unique<MceOp>());
+        Buffer* buffer = graph.AddBuffer(CreateBuffer(Location::Sram));
+        graph.AddConsumer(graph.GetOutput(prev), op, 0);
+        graph.SetProducer(buffer, op);
+        prev = op;
+    }
+    CheckConnectionsAreConsistent(graph);
+    const OpGraph::BufferList expectedInputs{ input, weights };
+    BOOST_CHECK(graph.GetInputs(mce) == expectedInputs);
+    BOOST_CHECK(graph.GetOutput(mce) == output);
+    BOOST_CHECK(graph.GetProducer(output) == mce);
+    BOOST_REQUIRE_EQUAL(graph.GetConsumers(output).size(), 1);
+    BOOST_CHECK(graph.GetConsumers(output)[0].first == graph.GetOps()[1]);
+
+    // Rejected connections: an input index which is already connected, an input index which would leave a gap, an
+    // Op which isn't part of the graph and a Buffer which already has a producer.
+    MceOp otherOp;
+    BOOST_CHECK_THROW(graph.AddConsumer(output, mce, 1), std::runtime_error);
+    BOOST_CHECK_THROW(graph.AddConsumer(output, mce, 3), std::runtime_error);
+    BOOST_CHECK_THROW(graph.AddConsumer(output, &otherOp, 0), std::runtime_error);
+    BOOST_CHECK_THROW(graph.SetProducer(output, graph.GetOps()[1]), std::runtime_error);
+    BOOST_CHECK(graph.GetInputs(mce) == expectedInputs);
+    BOOST_CHECK_EQUAL(graph.GetConsumers(output).size(), 1);
+    BOOST_CHECK(graph.GetProducer(output) == mce);
+    CheckConnectionsAreConsistent(graph);
+
+    graph.ClearProducer(output);
+    BOOST_CHECK(graph.GetProducer(output) == nullptr);
+    BOOST_CHECK(graph.GetOutput(mce) == nullptr);
+    CheckConnectionsAreConsistent(graph);
+}
+
+/// Checks the connections of the graph which the plans and glues of a combination are merged into, where the first
+/// two plans share a Buffer and the last two are connected by a glue.
+BOOST_AUTO_TEST_CASE(OpGraphForCombination)
+{
+    Graph graph;
+    std::vector<Node*> nodes;
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        nodes.push_back(graph.CreateAndAddNode<RequantizeNode>(
+            TensorShape{ 1, 8, 8, 16 }, ethosn::support_library::DataType::UINT8_QUANTIZED, QuantizationInfo(0, 1.0f),
+            CompilerDataFormat::NHWCB, std::set<uint32_t>{ 0 }));
+        if (i > 0)
+        {
+            graph.Connect(nodes[i - 1], nodes[i]);
+        }
+    }
+    GraphOfParts parts = CreateGraphOfParts(graph);
+    BOOST_REQUIRE_EQUAL(parts.GetNumParts(), 3);
+
+    std::vector<Buffer*> inputs;
+    std::vector<Buffer*> outputs;
+    std::vector<Op*> ops;
+    for (PartId p = 0; p < 3; ++p)
+    {
+        auto plan = std::make_unique<Plan>();
+        outputs.push_back(plan->m_OpGraph.AddBuffer(CreateBuffer(Location::Sram)));
+        plan->m_OutputMappings[outputs.back()] = nodes[p];
+        if (p > 0)
+        {
+            inputs.push_back(plan->m_OpGraph.AddBuffer(CreateBuffer(Location::Sram)));
+            ops.push_back(plan->m_OpGraph.AddOp(std::make_unique<MceOp>()));
+            plan->m_OpGraph.AddConsumer(inputs.back(), ops.back(), 0);
+            plan->m_OpGraph.SetProducer(outputs.back(), ops.back());
+            plan->m_InputMappings[inputs.back()] = nodes[p]->GetInput(0);
+        }
+        parts.m_Parts[p]->m_Plans.push_back(std::move(plan));
+    }
+
+    const Glue noGlue;
+    Glue glue;
+    Op* dmaToDram = glue.m_Graph.AddOp(std::make_unique<DmaOp>());
+    Buffer* dram  = glue.m_Graph.AddBuffer(CreateBuffer(Location::Dram));
+    Op* dmaToSram = glue.m_Graph.AddOp(std::make_unique<DmaOp>());
+    glue.m_Graph.SetProducer(dram, dmaToDram);
+    glue.m_Graph.AddConsumer(dram, dmaToSram, 0);
+    glue.m_InputSlot = { dmaToDram, 0 };
+    glue.m_Output    = dmaToSram;
+
+    Combination combination;
+    combination.AddElem(0, 0);
+    combination.AddLink(0, 0, nodes[1]->GetInput(0), Elem::Link{ 0, &noGlue });
+    combination.AddElem(1, 0);
+    combination.AddLink(1, 0, nodes[2]->GetInput(0), Elem::Link{ 0, &glue });
+    combination.AddElem(2, 0);
+
+    const OpGraph merged = GetOpGraphForCombination(combination, parts);
+    CheckConnectionsAreConsistent(merged);
+
+    // The input Buffer of the second plan is replaced by the output Buffer of the first.
+    const OpGraph::BufferList expectedBuffers{ outputs[0], outputs[1], dram, outputs[2], inputs[1] };
+    const OpGraph::OpList expectedOps{ ops[0], dmaToDram, dmaToSram, ops[1] };
+    BOOST_CHECK(merged.GetBuffers() == expectedBuffers);
+    BOOST_CHECK(merged.GetOps() == expectedOps);
+    BOOST_CHECK(!merged.Contains(inputs[0]));
+    BOOST_CHECK(merged.GetInputs(ops[0]) == OpGraph::BufferList{ outputs[0] });
+    BOOST_CHECK(merged.GetInputs(dmaToDram) == OpGraph::BufferList{ outputs[1] });
+    BOOST_CHECK(merged.GetProducer(inputs[1]) == dmaToSram);
+    BOOST_CHECK(merged.GetInputs(ops[1]) == OpGraph::BufferList{ inputs[1] });
+}
+
+BOOST_AUTO_TEST_SUITE_END()
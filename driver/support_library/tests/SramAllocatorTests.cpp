@@ -0,0 +1,283 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "SramAllocator.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <map>
+#include <random>
+
+using namespace ethosn::support_library;
+
+namespace
+{
+
+/// A simple model of the allocator, which keeps a sorted list of the free regions and searches all of them.
+class ReferenceAllocator
+{
+public:
+    ReferenceAllocator(uint32_t capacity, AllocationPolicy policy)
+        : m_Policy(policy)
+        , m_Free{ { 0, capacity } }
+    {}
+
+    std::pair<bool, uint32_t> Allocate(uint32_t size, AllocationPreference pref)
+    {
+        auto chosen = m_Free.end();
+        for (auto it = m_Free.begin(); it != m_Free.end(); ++it)
+        {
+            const uint32_t regionSize = it->second - it->first;
+            if (regionSize < size)
+            {
+                continue;
+            }
+            if (chosen == m_Free.end())
+            {
+                chosen = it;
+            }
+            else if (m_Policy == AllocationPolicy::BestFit && regionSize != chosen->second - chosen->first)
+            {
+                chosen = regionSize < chosen->second - chosen->first ? it : chosen;
+            }
+            else if (pref == AllocationPreference::End)
+            {
+                // Of the regions which are equally good, prefer the last one.
+                chosen = it;
+            }
+        }
+        if (chosen == m_Free.end())
+        {
+            return { false, 0 };
+        }
+        const uint32_t begin = pref == AllocationPreference::Start ? chosen->first : chosen->second - size;
+        const uint32_t end   = begin + size;
+        const std::pair<uint32_t, uint32_t> region = *chosen;
+        m_Free.erase(chosen);
+        if (region.first < begin)
+        {
+            m_Free.emplace(region.first, begin);
+        }
+        if (end < region.second)
+        {
+            m_Free.emplace(end, region.second);
+        }
+        m_Used.emplace(begin, end);
+        return { true, begin };
+    }
+
+    void Free(uint32_t offset)
+    {
+        // Of several chunks at the same offset, the one allocated first is freed, as SramAllocator does.
+        auto used      = m_Used.lower_bound(offset);
+        uint32_t begin = used->first;
+        uint32_t end   = used->second;
+        m_Used.erase(used);
+        if (begin == end)
+        {
+            return;
+        }
+        auto next = m_Free.lower_bound(begin);
+        if (next != m_Free.end() && next->first == end)
+        {
+            end  = next->second;
+            next = m_Free.erase(next);
+        }
+        if (next != m_Free.begin() && std::prev(next)->second == begin)
+        {
+            begin = std::prev(next)->first;
+            m_Free.erase(std::prev(next));
+        }
+        m_Free.emplace(begin, end);
+    }
+
+    const std::multimap<uint32_t, uint32_t>& GetUsed() const
+    {
+        return m_Used;
+    }
+
+private:
+    AllocationPolicy m_Policy;
+    std::map<uint32_t, uint32_t> m_Free;
+    std::multimap<uint32_t, uint32_t> m_Used;
+};
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(SramAllocatorTests)
+
+BOOST_AUTO_TEST_CASE(FirstFit)
+{
+    SramAllocator allocator(100, AllocationPolicy::FirstFit);
+    BOOST_CHECK(allocator.IsEmpty());
+
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start, "a") == std::make_pair(true, 0u));
+    BOOST_CHECK(allocator.Allocate(20, AllocationPreference::Start, "b") == std::make_pair(true, 10u));
+    BOOST_CHECK(allocator.Allocate(30, AllocationPreference::End, "c") == std::make_pair(true, 70u));
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start, "d") == std::make_pair(true, 30u));
+    // Free: [40, 70)
+
+    // Leave a hole of 10 at the start, and make the biggest free region [30, 70).
+    BOOST_CHECK(allocator.Free(0));
+    BOOST_CHECK(allocator.Free(30));
+    BOOST_CHECK(!allocator.Free(35));
+    BOOST_CHECK_EQUAL(allocator.GetUsage().m_UsedBytes, 50);
+    BOOST_CHECK_EQUAL(allocator.GetUsage().m_FreeBytes, 50);
+    BOOST_CHECK_EQUAL(allocator.GetUsage().m_LargestFreeRegion, 40);
+
+    // The first region which is big enough is used, from whichever end is preferred.
+    BOOST_CHECK(allocator.Allocate(5, AllocationPreference::Start) == std::make_pair(true, 0u));
+    BOOST_CHECK(allocator.Allocate(5, AllocationPreference::End) == std::make_pair(true, 65u));
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start) == std::make_pair(true, 30u));
+    BOOST_CHECK(allocator.Allocate(26, AllocationPreference::Start).first == false);
+    BOOST_CHECK(allocator.Allocate(25, AllocationPreference::End) == std::make_pair(true, 40u));
+    BOOST_CHECK(allocator.Allocate(5, AllocationPreference::End) == std::make_pair(true, 5u));
+    BOOST_CHECK(allocator.IsFull());
+
+    // Freeing everything merges the free regions back into one.
+    for (uint32_t offset : { 0u, 5u, 10u, 30u, 40u, 65u, 70u })
+    {
+        BOOST_CHECK(allocator.Free(offset));
+    }
+    BOOST_CHECK(allocator.IsEmpty());
+    BOOST_CHECK_EQUAL(allocator.GetUsage().m_LargestFreeRegion, 100);
+    BOOST_CHECK_EQUAL(allocator.GetPeakUsage().m_UsedBytes, 100);
+}
+
+BOOST_AUTO_TEST_CASE(BestFit)
+{
+    SramAllocator allocator(100, AllocationPolicy::BestFit);
+    // Make free regions of sizes 20, 10 and 10, at [0, 20), [40, 50) and [80, 90).
+    BOOST_CHECK(allocator.Allocate(20, AllocationPreference::Start) == std::make_pair(true, 0u));
+    BOOST_CHECK(allocator.Allocate(20, AllocationPreference::Start) == std::make_pair(true, 20u));
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start) == std::make_pair(true, 40u));
+    BOOST_CHECK(allocator.Allocate(30, AllocationPreference::Start) == std::make_pair(true, 50u));
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start) == std::make_pair(true, 80u));
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start) == std::make_pair(true, 90u));
+    BOOST_CHECK(allocator.Free(0));
+    BOOST_CHECK(allocator.Free(40));
+    BOOST_CHECK(allocator.Free(80));
+
+    // The smallest region which is big enough is used, taking the one nearest the preferred end if there are several.
+    BOOST_CHECK(allocator.Allocate(8, AllocationPreference::Start) == std::make_pair(true, 40u));
+    BOOST_CHECK(allocator.Allocate(8, AllocationPreference::End) == std::make_pair(true, 82u));
+    BOOST_CHECK(allocator.Allocate(3, AllocationPreference::Start) == std::make_pair(true, 0u));
+    BOOST_CHECK(allocator.Allocate(2, AllocationPreference::End) == std::make_pair(true, 80u));
+    BOOST_CHECK(allocator.Allocate(18, AllocationPreference::Start).first == false);
+    BOOST_CHECK(allocator.Allocate(17, AllocationPreference::End) == std::make_pair(true, 3u));
+}
+
+/// Checks both policies against a simple model of the allocator, with a random sequence of allocations and frees.
+BOOST_AUTO_TEST_CASE(MatchesReference)
+{
+    for (AllocationPolicy policy : { AllocationPolicy::FirstFit, AllocationPolicy::BestFit })
+    {
+        BOOST_TEST_CONTEXT("policy=" << static_cast<int>(policy))
+        {
+            constexpr uint32_t capacity = 1 << 16;
+            SramAllocator allocator(capacity, policy);
+            ReferenceAllocator reference(capacity, policy);
+            std::mt19937 generator(1);
+            std::vector<uint32_t> allocated;
+            for (uint32_t i = 0; i < 5000; ++i)
+            {
+                if (!allocated.empty() && generator() % 3 == 0)
+                {
+                    const size_t idx      = generator() % allocated.size();
+                    const uint32_t offset = allocated[idx];
+                    allocated.erase(allocated.begin() + static_cast<std::ptrdiff_t>(idx));
+                    BOOST_REQUIRE(allocator.Free(offset));
+                    reference.Free(offset);
+                }
+                else
+                {
+                    // Mostly small allocations, sometimes empty or too big ones.
+                    const uint32_t size = generator() % 16 == 0 ? generator() % (capacity / 4) : generator() % 512;
+                    const AllocationPreference pref =
+                        generator() % 2 == 0 ? AllocationPreference::Start : AllocationPreference::End;
+                    const std::pair<bool, uint32_t> result = allocator.Allocate(size, pref);
+                    BOOST_REQUIRE(result == reference.Allocate(size, pref));
+                    if (result.first)
+                    {
+                        allocated.push_back(result.second);
+                    }
+                }
+            }
+
+            uint32_t usedBytes = 0;
+            for (const auto& used : reference.GetUsed())
+            {
+                usedBytes += used.second - used.first;
+            }
+            BOOST_CHECK_EQUAL(allocator.GetUsage().m_UsedBytes, usedBytes);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(CheckpointAndRollback)
+{
+    SramAllocator allocator(100);
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start, "a") == std::make_pair(true, 0u));
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start, "b") == std::make_pair(true, 10u));
+    const std::string before                   = allocator.DumpUsage();
+    const SramAllocator::UsageStats beforePeak = allocator.GetPeakUsage();
+
+    // Everything done after a checkpoint is undone by rolling back to it, including nested checkpoints which were
+    // committed.
+    SramAllocator::Checkpoint outer = allocator.CreateCheckpoint();
+    BOOST_CHECK(allocator.Free(0));
+    BOOST_CHECK(allocator.Allocate(50, AllocationPreference::End, "c") == std::make_pair(true, 50u));
+    SramAllocator::Checkpoint inner = allocator.CreateCheckpoint();
+    BOOST_CHECK(allocator.Allocate(30, AllocationPreference::Start, "d") == std::make_pair(true, 20u));
+    BOOST_CHECK(allocator.Free(10));
+    allocator.Commit(inner);
+    BOOST_CHECK_EQUAL(allocator.GetPeakUsage().m_UsedBytes, 90);
+    allocator.Rollback(outer);
+
+    BOOST_CHECK_EQUAL(allocator.DumpUsage(), before);
+    BOOST_CHECK_EQUAL(allocator.GetUsage().m_UsedBytes, 20);
+    BOOST_CHECK_EQUAL(allocator.GetPeakUsage().m_UsedBytes, beforePeak.m_UsedBytes);
+
+    // A rolled back inner checkpoint only undoes the changes made after it.
+    outer = allocator.CreateCheckpoint();
+    BOOST_CHECK(allocator.Allocate(10, AllocationPreference::Start, "e") == std::make_pair(true, 20u));
+    const std::string afterOuter = allocator.DumpUsage();
+    inner                        = allocator.CreateCheckpoint();
+    BOOST_CHECK(allocator.Free(20));
+    BOOST_CHECK(allocator.Free(0));
+    BOOST_CHECK(allocator.Allocate(40, AllocationPreference::Start, "f") == std::make_pair(true, 20u));
+    allocator.Rollback(inner);
+    BOOST_CHECK_EQUAL(allocator.DumpUsage(), afterOuter);
+    allocator.Commit(outer);
+    BOOST_CHECK_EQUAL(allocator.DumpUsage(), afterOuter);
+    BOOST_CHECK(allocator.Allocate(70, AllocationPreference::Start).first);
+    BOOST_CHECK(allocator.IsFull());
+}
+
+BOOST_AUTO_TEST_CASE(DebugNames)
+{
+    SramAllocator allocator(100);
+    allocator.Allocate(10, AllocationPreference::Start, "input");
+    allocator.Allocate(20, AllocationPreference::Start, "weights");
+    allocator.Allocate(30, AllocationPreference::Start, "input");
+
+    // Copies of the allocator have their own names.
+    SramAllocator copy = allocator;
+    allocator.Reset();
+    allocator.Allocate(40, AllocationPreference::Start, "outputs");
+
+    BOOST_CHECK_EQUAL(copy.DumpUsage(), "Sram Used Memory: \n"
+                                        "range=0---10 input\n"
+                                        "range=10---30 weights\n"
+                                        "range=30---60 input\n"
+                                        "Sram Free Memory: \n"
+                                        "range=60---100\n");
+    BOOST_CHECK_EQUAL(allocator.DumpUsage(), "Sram Used Memory: \n"
+                                             "range=0---40 outputs\n"
+                                             "Sram Free Memory: \n"
+                                             "range=40---100\n");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
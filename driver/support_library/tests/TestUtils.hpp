@@ -0,0 +1,109 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#pragma once
+
+#include <ethosn_support_library/Support.hpp>
+
+#include <numeric>
+#include <vector>
+
+namespace testing_utils
+{
+
+namespace ethosn_lib = ethosn::support_library;
+
+inline ethosn_lib::CompilationOptions CreateCompilationOptions()
+{
+    return ethosn_lib::CompilationOptions(
+        ethosn_lib::GetPerformanceEstimatorFwAndHwCapabilities(ethosn_lib::EthosNVariant::ETHOS_N77, 0));
+}
+
+/// Adds a 3x3 convolution with the given number of output channels to the given network, with weights which depend
+/// on the given seed.
+inline std::shared_ptr<ethosn_lib::Operand> AddConvolution(const std::shared_ptr<ethosn_lib::Network>& network,
+                                                           ethosn_lib::Operand& input,
+                                                           uint32_t inputChannels,
+                                                           uint32_t outputChannels,
+                                                           uint32_t seed)
+{
+    const ethosn_lib::TensorInfo weightsInfo({ 3, 3, inputChannels, outputChannels },
+                                             ethosn_lib::DataType::UINT8_QUANTIZED, ethosn_lib::DataFormat::HWIO,
+                                             ethosn_lib::QuantizationInfo(128, 0.5f));
+    const ethosn_lib::TensorInfo biasInfo({ 1, 1, 1, outputChannels }, ethosn_lib::DataType::INT32_QUANTIZED,
+                                          ethosn_lib::DataFormat::NHWC, ethosn_lib::QuantizationInfo(0, 0.5f));
+    const ethosn_lib::ConvolutionInfo convInfo({ 1, 1, 1, 1 }, { 1, 1 }, ethosn_lib::QuantizationInfo(0, 1.0f));
+
+    std::vector<uint8_t> weightsData(3 * 3 * inputChannels * outputChannels);
+    std::iota(weightsData.begin(), weightsData.end(), static_cast<uint8_t>(seed));
+    const std::vector<int32_t> biasData(outputChannels, 7);
+
+    std::shared_ptr<ethosn_lib::Constant> weights =
+        ethosn_lib::AddConstant(network, weightsInfo, weightsData.data()).tensor;
+    std::shared_ptr<ethosn_lib::Constant> bias = ethosn_lib::AddConstant(network, biasInfo, biasData.data()).tensor;
+    return ethosn_lib::AddConvolution(network, input, *bias, *weights, convInfo).tensor;
+}
+
+/// Creates a network which is a chain of 3x3 convolutions, small enough for every combination of its cascaded plans
+/// to be searched.
+inline std::shared_ptr<ethosn_lib::Network> CreateConvolutionChain(uint32_t numConvolutions,
+                                                                   uint32_t size     = 16,
+                                                                   uint32_t channels = 16)
+{
+    std::shared_ptr<ethosn_lib::Network> network = ethosn_lib::CreateEstimationNetwork();
+
+    const ethosn_lib::TensorInfo inputInfo({ 1, size, size, channels }, ethosn_lib::DataType::UINT8_QUANTIZED,
+                                           ethosn_lib::DataFormat::NHWC, ethosn_lib::QuantizationInfo(0, 1.0f));
+    std::shared_ptr<ethosn_lib::Operand> operand = ethosn_lib::AddInput(network, inputInfo).tensor;
+    for (uint32_t i = 0; i < numConvolutions; ++i)
+    {
+        operand = AddConvolution(network, *operand, channels, channels, i);
+    }
+    ethosn_lib::AddOutput(network, *operand);
+    return network;
+}
+
+/// Creates a network where the output of a 3x3 convolution is used by two chains of 3x3 convolutions, each with its
+/// own output.
+inline std::shared_ptr<ethosn_lib::Network> CreateBranchedConvolutions(uint32_t branchLength,
+                                                                       uint32_t size     = 16,
+                                                                       uint32_t channels = 16)
+{
+    std::shared_ptr<ethosn_lib::Network> network = ethosn_lib::CreateEstimationNetwork();
+
+    const ethosn_lib::TensorInfo inputInfo({ 1, size, size, channels }, ethosn_lib::DataType::UINT8_QUANTIZED,
+                                           ethosn_lib::DataFormat::NHWC, ethosn_lib::QuantizationInfo(0, 1.0f));
+    std::shared_ptr<ethosn_lib::Operand> input = ethosn_lib::AddInput(network, inputInfo).tensor;
+    std::shared_ptr<ethosn_lib::Operand> stem  = AddConvolution(network, *input, channels, channels, 0);
+    for (uint32_t b = 0; b < 2; ++b)
+    {
+        std::shared_ptr<ethosn_lib::Operand> operand = stem;
+        for (uint32_t i = 0; i < branchLength; ++i)
+        {
+            operand = AddConvolution(network, *operand, channels, channels, 1 + b * branchLength + i);
+        }
+        ethosn_lib::AddOutput(network, *operand);
+    }
+    return network;
+}
+
+inline uint64_t GetDramTraffic(const ethosn_lib::MemoryStats& stats)
+{
+    return stats.m_DramNonParallel + stats.m_DramParallel;
+}
+
+inline uint64_t GetTotalDramTraffic(const ethosn_lib::NetworkPerformanceData& performanceData)
+{
+    uint64_t result = 0;
+    for (const ethosn_lib::PassPerformanceData& pass : performanceData.m_Stream)
+    {
+        result += GetDramTraffic(pass.m_Stats.m_Input.m_MemoryStats) +
+                  GetDramTraffic(pass.m_Stats.m_Output.m_MemoryStats) +
+                  GetDramTraffic(pass.m_Stats.m_Weights.m_MemoryStats);
+    }
+    return result;
+}
+
+}    // namespace testing_utils
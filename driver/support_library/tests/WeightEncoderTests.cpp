@@ -0,0 +1,345 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#include "BufferManager.hpp"
+#include "CapabilitiesInternal.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include "WeightEncoder.hpp"
+#include "WeightEncoderCache.hpp"
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+using namespace ethosn::support_library;
+
+namespace
+{
+
+/// Returns random weights of which the given fraction are replaced by the zero point. If numValues is non-zero then
+/// the other weights only take that many different values, so that they can be compressed with a LUT.
+std::vector<uint8_t> GenerateWeights(size_t size, int32_t zeroPoint, float sparsity, uint32_t numValues = 0)
+{
+    std::mt19937 generator(static_cast<uint32_t>(size));
+    std::uniform_int_distribution<uint32_t> byteDistribution(0, numValues == 0 ? 255 : numValues - 1);
+    std::bernoulli_distribution zeroDistribution(sparsity);
+    std::vector<uint8_t> weights(size);
+    for (uint8_t& weight : weights)
+    {
+        const uint32_t value = numValues == 0 ? byteDistribution(generator) : byteDistribution(generator) * 7;
+        weight = static_cast<uint8_t>(zeroDistribution(generator) ? static_cast<uint32_t>(zeroPoint) : value);
+    }
+    return weights;
+}
+
+struct EncoderTestCase
+{
+    const char* m_Name;
+    TensorInfo m_WeightsInfo;
+    uint32_t m_Stride;
+    uint32_t m_Padding;
+    uint32_t m_IterationSize;
+    ethosn::command_stream::MceOperation m_Operation;
+    CompilerMceAlgorithm m_Algorithm;
+};
+
+std::vector<EncoderTestCase> GetEncoderTestCases()
+{
+    const QuantizationInfo weightsQuantInfo(128, 0.5f);
+    return {
+        { "Convolution",
+          TensorInfo({ 3, 3, 48, 40 }, DataType::UINT8_QUANTIZED, DataFormat::HWIO, weightsQuantInfo), 1, 1, 48,
+          ethosn::command_stream::MceOperation::CONVOLUTION, CompilerMceAlgorithm::Direct },
+        { "ConvolutionStrided",
+          TensorInfo({ 3, 3, 16, 24 }, DataType::UINT8_QUANTIZED, DataFormat::HWIO, weightsQuantInfo), 2, 1, 64,
+          ethosn::command_stream::MceOperation::CONVOLUTION, CompilerMceAlgorithm::Direct },
+        { "ConvolutionWinograd",
+          TensorInfo({ 3, 3, 32, 20 }, DataType::UINT8_QUANTIZED, DataFormat::HWIO, weightsQuantInfo), 1, 1, 32,
+          ethosn::command_stream::MceOperation::CONVOLUTION, CompilerMceAlgorithm::Winograd },
+        { "DepthwiseConvolution",
+          TensorInfo({ 3, 3, 40, 1 }, DataType::UINT8_QUANTIZED, DataFormat::HWIM, weightsQuantInfo), 1, 1, 40,
+          ethosn::command_stream::MceOperation::DEPTHWISE_CONVOLUTION, CompilerMceAlgorithm::Direct },
+        { "FullyConnected",
+          TensorInfo({ 1, 1, 2048, 24 }, DataType::UINT8_QUANTIZED, DataFormat::HWIO, weightsQuantInfo), 1, 0,
+          g_WeightsChannelVecProd, ethosn::command_stream::MceOperation::FULLY_CONNECTED,
+          CompilerMceAlgorithm::Direct },
+    };
+}
+
+std::vector<std::pair<const char*, HardwareCapabilities>> GetVariants()
+{
+    return {
+        { "N77", HardwareCapabilities(GetEthosN77FwHwCapabilities()) },
+        { "N57", HardwareCapabilities(GetEthosN57FwHwCapabilities()) },
+        { "N78_4TOPS_4PLE",
+          HardwareCapabilities(GetEthosN78FwHwCapabilities(EthosNVariant::ETHOS_N78_4TOPS_4PLE_RATIO, 0)) },
+        { "N78_1TOPS_2PLE",
+          HardwareCapabilities(GetEthosN78FwHwCapabilities(EthosNVariant::ETHOS_N78_1TOPS_2PLE_RATIO, 0)) },
+    };
+}
+
+uint32_t GetNumOfms(const TensorInfo& weightsInfo)
+{
+    return weightsInfo.m_DataFormat == DataFormat::HWIM ? weightsInfo.m_Dimensions[2] * weightsInfo.m_Dimensions[3]
+                                                        : weightsInfo.m_Dimensions[3];
+}
+
+EncodedWeightsSize EstimateEncodedSize(WeightEncoder& encoder,
+                                       const EncoderTestCase& testCase,
+                                       const std::vector<uint8_t>& weightsData,
+                                       uint32_t stripeDepth,
+                                       const utils::Optional<float>& compressionSaving = utils::EmptyOptional())
+{
+    const uint32_t numOfms = GetNumOfms(testCase.m_WeightsInfo);
+    const TensorInfo biasInfo({ 1, 1, 1, numOfms }, DataType::INT32_QUANTIZED, DataFormat::NHWC,
+                              QuantizationInfo(0, 0.5f));
+    const std::vector<int32_t> biasData(numOfms, 3);
+    return encoder.EstimateEncodedSize(testCase.m_WeightsInfo, weightsData.data(), biasInfo, biasData.data(),
+                                       QuantizationInfo(0, 1.0f), QuantizationInfo(0, 1.1f), stripeDepth,
+                                       testCase.m_Stride, testCase.m_Stride, testCase.m_Padding, testCase.m_Padding,
+                                       testCase.m_IterationSize, testCase.m_Operation, testCase.m_Algorithm,
+                                       compressionSaving);
+}
+
+EncodedWeights Encode(WeightEncoder& encoder,
+                      const EncoderTestCase& testCase,
+                      const std::vector<uint8_t>& weightsData,
+                      uint32_t stripeDepth)
+{
+    const uint32_t numOfms = GetNumOfms(testCase.m_WeightsInfo);
+    const TensorInfo biasInfo({ 1, 1, 1, numOfms }, DataType::INT32_QUANTIZED, DataFormat::NHWC,
+                              QuantizationInfo(0, 0.5f));
+    const std::vector<int32_t> biasData(numOfms, 3);
+    return encoder.Encode(testCase.m_WeightsInfo, weightsData.data(), biasInfo, biasData.data(),
+                          QuantizationInfo(0, 1.0f), QuantizationInfo(0, 1.1f), stripeDepth, testCase.m_Stride,
+                          testCase.m_Stride, testCase.m_Padding, testCase.m_Padding, testCase.m_IterationSize,
+                          testCase.m_Operation, testCase.m_Algorithm);
+}
+
+/// Gets the params for the WeightEncoderCache to encode the given weights and biases as in the given test case.
+/// The data must outlive the params.
+WeightEncoderCache::Params GetCacheParams(const EncoderTestCase& testCase,
+                                          const std::vector<uint8_t>& weightsData,
+                                          const std::vector<int32_t>& biasData,
+                                          uint32_t stripeDepth)
+{
+    const uint32_t numOfms = GetNumOfms(testCase.m_WeightsInfo);
+    WeightEncoderCache::Params params;
+    params.weightsAndBiasHash =
+        WeightEncoderCache::HashWeightsAndBias(weightsData.data(), weightsData.size(), biasData.data(), numOfms);
+    params.weightsTensorInfo = testCase.m_WeightsInfo;
+    params.weightsData       = weightsData.data();
+    params.biasTensorInfo =
+        TensorInfo({ 1, 1, 1, numOfms }, DataType::INT32_QUANTIZED, DataFormat::NHWC, QuantizationInfo(0, 0.5f));
+    params.biasData               = biasData.data();
+    params.inputQuantizationInfo  = QuantizationInfo(0, 1.0f);
+    params.outputQuantizationInfo = QuantizationInfo(0, 1.1f);
+    params.stripeDepth            = stripeDepth;
+    params.strideY                = testCase.m_Stride;
+    params.strideX                = testCase.m_Stride;
+    params.paddingTop             = testCase.m_Padding;
+    params.paddingLeft            = testCase.m_Padding;
+    params.iterationSize          = testCase.m_IterationSize;
+    params.operation              = testCase.m_Operation;
+    params.algorithm              = testCase.m_Algorithm;
+    return params;
+}
+
+}    // namespace
+
+BOOST_AUTO_TEST_SUITE(WeightEncoderTests)
+
+/// Checks that EstimateEncodedSize gives exactly the layout of the weights that Encode produces, for every weight
+/// compression version and for weights which are best compressed in different ways.
+BOOST_AUTO_TEST_CASE(EstimateEncodedSizeMatchesEncode)
+{
+    struct WeightSet
+    {
+        const char* m_Name;
+        float m_Sparsity;
+        uint32_t m_NumValues;
+    };
+    const WeightSet weightSets[] = {
+        { "Random", 0.0f, 0 },
+        { "Sparse", 0.6f, 0 },
+        { "VerySparse", 0.97f, 0 },
+        { "FewValues", 0.0f, 6 },
+        { "SparseFewValues", 0.5f, 20 },
+        { "AllZeroPoint", 1.0f, 0 },
+    };
+
+    for (const auto& variant : GetVariants())
+    {
+        const HardwareCapabilities& capabilities = variant.second;
+        std::unique_ptr<WeightEncoder> encoder   = WeightEncoder::CreateWeightEncoder(capabilities);
+        for (const EncoderTestCase& testCase : GetEncoderTestCases())
+        {
+            for (const WeightSet& weightSet : weightSets)
+            {
+                const std::vector<uint8_t> weightsData =
+                    GenerateWeights(utils::TotalSizeBytes(testCase.m_WeightsInfo),
+                                    testCase.m_WeightsInfo.m_QuantizationInfo.GetZeroPoint(), weightSet.m_Sparsity,
+                                    weightSet.m_NumValues);
+                const uint32_t numOfms = GetNumOfms(testCase.m_WeightsInfo);
+                for (const uint32_t stripeDepth : { capabilities.GetNumberOfOfm(), numOfms })
+                {
+                    BOOST_TEST_CONTEXT(variant.first << " " << testCase.m_Name << " " << weightSet.m_Name
+                                                     << " stripeDepth=" << stripeDepth)
+                    {
+                        const EncodedWeights encoded = Encode(*encoder, testCase, weightsData, stripeDepth);
+                        const EncodedWeightsSize estimate =
+                            EstimateEncodedSize(*encoder, testCase, weightsData, stripeDepth);
+
+                        BOOST_CHECK_EQUAL(estimate.m_TotalSize, encoded.m_Data.size());
+                        BOOST_CHECK_EQUAL(estimate.m_MaxSize, encoded.m_MaxSize);
+                        BOOST_REQUIRE_EQUAL(estimate.m_Metadata.size(), encoded.m_Metadata.size());
+                        for (size_t i = 0; i < estimate.m_Metadata.size(); ++i)
+                        {
+                            BOOST_CHECK_EQUAL(estimate.m_Metadata[i].m_Offset, encoded.m_Metadata[i].m_Offset);
+                            BOOST_CHECK_EQUAL(estimate.m_Metadata[i].m_Size, encoded.m_Metadata[i].m_Size);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Checks that when a compression saving is given, the estimate depends only on the size of the weights and the
+/// saving, rather than on the values of the weights.
+BOOST_AUTO_TEST_CASE(EstimateEncodedSizeWithCompressionSaving)
+{
+    for (const auto& variant : GetVariants())
+    {
+        const HardwareCapabilities& capabilities = variant.second;
+        std::unique_ptr<WeightEncoder> encoder   = WeightEncoder::CreateWeightEncoder(capabilities);
+        for (const EncoderTestCase& testCase : GetEncoderTestCases())
+        {
+            BOOST_TEST_CONTEXT(variant.first << " " << testCase.m_Name)
+            {
+                const size_t numWeights = utils::TotalSizeBytes(testCase.m_WeightsInfo);
+                const int32_t zeroPoint = testCase.m_WeightsInfo.m_QuantizationInfo.GetZeroPoint();
+                const std::vector<uint8_t> randomWeights    = GenerateWeights(numWeights, zeroPoint, 0.0f);
+                const std::vector<uint8_t> zeroPointWeights = GenerateWeights(numWeights, zeroPoint, 1.0f);
+                const uint32_t stripeDepth                  = capabilities.GetNumberOfOfm();
+
+                const EncodedWeightsSize random =
+                    EstimateEncodedSize(*encoder, testCase, randomWeights, stripeDepth, 0.5f);
+                const EncodedWeightsSize zeroPoint50 =
+                    EstimateEncodedSize(*encoder, testCase, zeroPointWeights, stripeDepth, 0.5f);
+                const EncodedWeightsSize zeroPoint0 =
+                    EstimateEncodedSize(*encoder, testCase, zeroPointWeights, stripeDepth, 0.0f);
+
+                BOOST_CHECK_EQUAL(random.m_TotalSize, zeroPoint50.m_TotalSize);
+                BOOST_CHECK_EQUAL(random.m_MaxSize, zeroPoint50.m_MaxSize);
+                BOOST_REQUIRE_EQUAL(random.m_Metadata.size(), zeroPoint50.m_Metadata.size());
+                for (size_t i = 0; i < random.m_Metadata.size(); ++i)
+                {
+                    BOOST_CHECK_EQUAL(random.m_Metadata[i].m_Size, zeroPoint50.m_Metadata[i].m_Size);
+                }
+
+                // Without any saving the weights are at least as big as they are uncompressed. A saving can be
+                // lost in the alignment of the streams when there are only a few weights per OFM.
+                BOOST_CHECK_GE(zeroPoint0.m_TotalSize, numWeights);
+                BOOST_CHECK_LE(zeroPoint50.m_TotalSize, zeroPoint0.m_TotalSize);
+                if (numWeights / GetNumOfms(testCase.m_WeightsInfo) >= 256)
+                {
+                    BOOST_CHECK_LT(zeroPoint50.m_TotalSize, zeroPoint0.m_TotalSize);
+                }
+            }
+        }
+    }
+}
+
+/// Checks that the WeightEncoderCache only reuses an encoding for the same weights, parameters and capabilities,
+/// and that it evicts encodings once it is full.
+BOOST_AUTO_TEST_CASE(WeightEncoderCacheReusesEncodings)
+{
+    const EncoderTestCase testCase = GetEncoderTestCases()[0];
+    const uint32_t numOfms         = GetNumOfms(testCase.m_WeightsInfo);
+    const std::vector<uint8_t> weightsData =
+        GenerateWeights(utils::TotalSizeBytes(testCase.m_WeightsInfo),
+                        testCase.m_WeightsInfo.m_QuantizationInfo.GetZeroPoint(), 0.5f);
+    const std::vector<int32_t> biasData(numOfms, 3);
+    const std::vector<int32_t> otherBiasData(numOfms, 4);
+
+    const HardwareCapabilities n77Caps(GetEthosN77FwHwCapabilities());
+    const HardwareCapabilities n57Caps(GetEthosN57FwHwCapabilities());
+    ThreadPool threadPool(1);
+
+    const WeightEncoderCache::Params params =
+        GetCacheParams(testCase, weightsData, biasData, n77Caps.GetNumberOfOfm());
+    const WeightEncoderCache::Params otherBiasParams =
+        GetCacheParams(testCase, weightsData, otherBiasData, n77Caps.GetNumberOfOfm());
+    BOOST_CHECK(otherBiasParams.weightsAndBiasHash != params.weightsAndBiasHash);
+
+    WeightEncoderCache cache(SIZE_MAX);
+    std::shared_ptr<const EncodedWeights> encoded = cache.Encode(n77Caps, threadPool, params);
+    BOOST_CHECK(cache.Encode(n77Caps, threadPool, params) == encoded);
+    BOOST_CHECK(cache.Encode(n57Caps, threadPool, params) != encoded);
+    std::shared_ptr<const EncodedWeights> otherBiasEncoded = cache.Encode(n77Caps, threadPool, otherBiasParams);
+    BOOST_CHECK(otherBiasEncoded != encoded);
+    BOOST_CHECK(otherBiasEncoded->m_Data != encoded->m_Data);
+    BOOST_CHECK(cache.Encode(n77Caps, threadPool, params) == encoded);
+
+    // A cache too small to hold two encodings must encode the weights again once another encoding has replaced them.
+    WeightEncoderCache smallCache(encoded->m_Data.size() * 3 / 2);
+    std::shared_ptr<const EncodedWeights> first = smallCache.Encode(n77Caps, threadPool, params);
+    BOOST_CHECK(smallCache.Encode(n77Caps, threadPool, params) == first);
+    smallCache.Encode(n77Caps, threadPool, otherBiasParams);
+    std::shared_ptr<const EncodedWeights> second = smallCache.Encode(n77Caps, threadPool, params);
+    BOOST_CHECK(second != first);
+    BOOST_CHECK(second->m_Data == first->m_Data);
+}
+
+/// Checks that encoded weights which are shared with a BufferManager, as McePlePass does, stay valid after the
+/// WeightEncoderCache has evicted them, and are only released once the BufferManager has laid them out.
+BOOST_AUTO_TEST_CASE(WeightEncoderCacheEncodingsOutliveEviction)
+{
+    const EncoderTestCase testCase = GetEncoderTestCases()[0];
+    const uint32_t numOfms         = GetNumOfms(testCase.m_WeightsInfo);
+    const std::vector<uint8_t> weightsData =
+        GenerateWeights(utils::TotalSizeBytes(testCase.m_WeightsInfo),
+                        testCase.m_WeightsInfo.m_QuantizationInfo.GetZeroPoint(), 0.5f);
+    const std::vector<int32_t> biasData(numOfms, 3);
+    const std::vector<int32_t> otherBiasData(numOfms, 4);
+    const HardwareCapabilities caps(GetEthosN77FwHwCapabilities());
+    ThreadPool threadPool(1);
+    const WeightEncoderCache::Params params = GetCacheParams(testCase, weightsData, biasData, caps.GetNumberOfOfm());
+    const WeightEncoderCache::Params otherBiasParams =
+        GetCacheParams(testCase, weightsData, otherBiasData, caps.GetNumberOfOfm());
+
+    BufferManager bufferManager;
+    std::vector<uint8_t> expected;
+    std::weak_ptr<const EncodedWeights> weak;
+    uint32_t bufferId;
+    {
+        // A cache too small to hold two encodings.
+        const size_t encodedSize = WeightEncoderCache(SIZE_MAX).Encode(caps, threadPool, params)->m_Data.size();
+        WeightEncoderCache cache(encodedSize * 3 / 2);
+        std::shared_ptr<const EncodedWeights> encoded = cache.Encode(caps, threadPool, params);
+        expected                                      = encoded->m_Data;
+        weak                                          = encoded;
+        // Shared in the same way as McePlePass does, aliasing the encoded weights.
+        bufferId = bufferManager.AddDramConstant(BufferType::ConstantDma, { encoded, &encoded->m_Data });
+        encoded.reset();
+
+        // Encoding other weights evicts the first encoding, after which only the BufferManager refers to it.
+        cache.Encode(caps, threadPool, otherBiasParams);
+        BOOST_CHECK(cache.Encode(caps, threadPool, params) != weak.lock());
+    }
+    BOOST_CHECK_EQUAL(weak.use_count(), 1);
+    BOOST_CHECK(*bufferManager.GetBuffers().at(bufferId).m_ConstantData == expected);
+
+    bufferManager.Allocate();
+    BOOST_CHECK(weak.expired());
+    const std::vector<uint8_t> constantDmaData = bufferManager.TakeConstantDmaData();
+    const uint32_t offset                      = bufferManager.GetBuffers().at(bufferId).m_Offset;
+    BOOST_REQUIRE_LE(offset + expected.size(), constantDmaData.size());
+    BOOST_CHECK(std::equal(expected.begin(), expected.end(), constantDmaData.begin() + offset));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
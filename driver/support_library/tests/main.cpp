@@ -0,0 +1,7 @@
+//
+// Copyright © 2020 Arm Limited. All rights reserved.
+// SPDX-License-Identifier: Apache-2.0
+//
+
+#define BOOST_TEST_MODULE EthosNSupportLibrary
+#include <boost/test/included/unit_test.hpp>